@@ -660,6 +660,22 @@ var authCommandsLib = {
                 }
             ]
         },
+        {
+            testname: "cpuSamples",
+            command: {cpuSamples: 1},
+            skipSharded: true,
+            testcases: [
+                {
+                    runOnDb: adminDbName,
+                    roles: roles_hostManager,
+                    privileges: [
+                        { resource: {cluster: true}, actions: ["cpuProfiler"] }
+                    ]
+                },
+                { runOnDb: firstDbName, roles: {} },
+                { runOnDb: secondDbName, roles: {} }
+            ]
+        },
         {
             testname: "create",
             command: {create: "x"},
@@ -2572,6 +2588,22 @@ var authCommandsLib = {
                 }
             ]
         },
+        {
+            testname: "trafficTrace",
+            command: {trafficTrace: 0},
+            skipSharded: true,
+            testcases: [
+                {
+                    runOnDb: adminDbName,
+                    roles: roles_hostManager,
+                    privileges: [
+                        { resource: {cluster: true}, actions: ["diagLogging"] }
+                    ]
+                },
+                { runOnDb: firstDbName, roles: {} },
+                { runOnDb: secondDbName, roles: {} }
+            ]
+        },
         {
             testname: "unsetSharding",
             command: {unsetSharding: "x"},
@@ -0,0 +1,49 @@
+// Tests the latency percentiles reported by benchRun, and its open loop mode.
+t = db.bench_test_latency;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } );
+
+ops = [
+    { op : "findOne" , ns : t.getFullName() , query : { _id : 1 } } ,
+    { op : "update" , ns : t.getFullName() , query : { _id : 1 } , update : { $inc : { x : 1 } } }
+];
+
+benchArgs = { ops : ops , parallel : 2 , seconds : 1 , host : db.getMongo().host };
+
+if (jsTest.options().auth) {
+    benchArgs['db'] = 'admin';
+    benchArgs['username'] = jsTest.options().adminUser;
+    benchArgs['password'] = jsTest.options().adminPassword;
+}
+
+function checkPercentiles( p , avg , msg ) {
+    assert( p , msg + ": no percentiles" );
+    assert.lte( p.p50 , p.p95 , msg + ": p50 > p95" );
+    assert.lte( p.p95 , p.p99 , msg + ": p95 > p99" );
+    assert.lte( p.p99 , p.p99_9 , msg + ": p99 > p99.9" );
+    assert.lte( p.p99_9 , p.max , msg + ": p99.9 > max" );
+    assert.lte( avg , p.max , msg + ": average > max" );
+}
+
+res = benchRun( benchArgs );
+printjson( res );
+checkPercentiles( res.findOneLatencyPercentilesMicros , res.findOneLatencyAverageMicros , "A1" );
+checkPercentiles( res.updateLatencyPercentilesMicros , res.updateLatencyAverageMicros , "A2" );
+assert.isnull( res.insertLatencyPercentilesMicros , "A3" );
+
+// In open loop mode each thread starts ops at a fixed rate, so the throughput is bounded by it.
+benchArgs['opsPerSecondPerThread'] = 50;
+benchArgs['seconds'] = 2;
+before = t.findOne( { _id : 1 } ).x;
+res = benchRun( benchArgs );
+printjson( res );
+checkPercentiles( res.findOneLatencyPercentilesMicros , res.findOneLatencyAverageMicros , "B1" );
+checkPercentiles( res.updateLatencyPercentilesMicros , res.updateLatencyAverageMicros , "B2" );
+updates = t.findOne( { _id : 1 } ).x - before;
+// 2 threads * 50 ops/s * 2 s, half of them updates, with some slack for the end of the run.
+assert.lte( updates , 110 , "B3" );
+assert.gt( updates , 0 , "B4" );
+
+benchArgs['opsPerSecondPerThread'] = -1;
+assert.throws( function() { benchRun( benchArgs ); } , [] , "C1" );
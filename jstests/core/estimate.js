@@ -0,0 +1,85 @@
+// Tests count and distinct with estimate: true, which return approximate answers with an error
+// bound instead of exact ones.
+
+var t = db.jstests_estimate;
+t.drop();
+
+function countEstimate(cmd) {
+    cmd.count = t.getName();
+    cmd.estimate = true;
+    var res = db.runCommand(cmd);
+    assert.commandWorked(res);
+    return res;
+}
+
+function distinctEstimate(cmd) {
+    cmd.distinct = t.getName();
+    cmd.estimate = true;
+    var res = db.runCommand(cmd);
+    assert.commandWorked(res);
+    return res;
+}
+
+// A missing collection is exactly empty.
+var res = countEstimate({query: {a: 1}});
+assert.eq(0, res.n);
+res = distinctEstimate({key: "a"});
+assert.eq(0, res.n);
+assert.eq("exact", res.estimate.method);
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 5000; i++) {
+    bulk.insert({a: i % 4, b: i, c: [i % 7, (i + 1) % 7]});
+}
+assert.writeOK(bulk.execute());
+
+// Collections no larger than the sample are counted exactly.
+res = countEstimate({query: {a: 1}, sampleSize: 10000});
+assert.eq(1250, res.n);
+assert.eq("exact", res.estimate.method);
+assert.eq(0, res.estimate.errorBound);
+
+// Larger ones are sampled if the storage engine can position on random records, and counted
+// exactly otherwise. Either way the answer is within the error bound. Allow twice the 95% bound
+// so that the test is not flaky.
+res = countEstimate({query: {a: 1}, sampleSize: 1000});
+assert.contains(res.estimate.method, ["randomSample", "exact"]);
+if ("randomSample" == res.estimate.method) {
+    assert.eq(1000, res.estimate.examined);
+    assert.eq(0.95, res.estimate.confidence);
+    assert.gt(res.estimate.errorBound, 0);
+}
+assert.lte(Math.abs(res.n - 1250), 2 * res.estimate.errorBound, tojson(res));
+
+// Limit applies to the estimate.
+res = countEstimate({query: {a: {$gte: 0}}, sampleSize: 1000, limit: 10});
+assert.eq(10, res.n);
+
+// Invalid sample sizes are rejected.
+assert.commandFailed(db.runCommand({count: t.getName(), query: {a: 1}, estimate: true,
+                                    sampleSize: 0}));
+assert.commandFailed(db.runCommand({count: t.getName(), query: {a: 1}, estimate: true,
+                                    sampleSize: "big"}));
+
+// Distinct estimates count array elements individually and never return the values.
+res = distinctEstimate({key: "b"});
+assert.eq("hyperLogLog", res.estimate.method);
+assert.eq(true, res.estimate.complete);
+assert.eq(undefined, res.values);
+assert.eq(undefined, res.estimate.sketch);
+assert.lte(Math.abs(res.n - 5000), 2 * res.estimate.errorBound, tojson(res));
+
+res = distinctEstimate({key: "c"});
+assert.eq(7, res.n);
+
+res = distinctEstimate({key: "b", query: {a: 1}});
+assert.lte(Math.abs(res.n - 1250), 2 * res.estimate.errorBound, tojson(res));
+
+// The cost budget stops the scan early.
+res = distinctEstimate({key: "b", maxScan: 100});
+assert.eq(false, res.estimate.complete);
+assert.eq(100, res.estimate.examined);
+assert.lte(Math.abs(res.n - 100), 2 * res.estimate.errorBound, tojson(res));
+
+assert.commandFailed(db.runCommand({distinct: t.getName(), key: "b", estimate: true,
+                                    maxScan: -1}));
@@ -119,3 +119,32 @@ assert.eq(1, db.runCommand({count: collName, query: {a: 2}, limit: 2}).n);
 explain = db.runCommand({explain: {count: collName, query: {a: 2}, limit: 2},
                          verbosity: "executionStats"});
 checkCountExplain(explain, 1);
+
+/**
+ * Runs an executionStats explain of a count with query 'query', checks the result against
+ * 'nCounted', and checks that the COUNT stage reports 'countMode'.
+ */
+function checkCountMode(query, nCounted, countMode) {
+    var explain = db.runCommand({explain: {count: collName, query: query},
+                                 verbosity: "executionStats"});
+    checkCountExplain(explain, nCounted);
+
+    var countStage = explain.executionStats.executionStages;
+    if ("SINGLE_SHARD" == countStage.stage) {
+        countStage = countStage.shards[0].executionStages;
+    }
+    assert.eq(countStage.countMode, countMode, "wrong count mode");
+}
+
+// Each way of producing the results to count is reported by explain.
+t.drop();
+t.ensureIndex({a: 1, b: 1});
+for (var i = 0; i < 10; i++) {
+    t.insert({a: i, b: i % 2, c: i % 3});
+}
+
+checkCountMode({}, 10, "TRIVIAL");
+checkCountMode({a: {$gte: 5}}, 5, "COUNT_SCAN");
+checkCountMode({a: {$gte: 5}, b: 1}, 3, "INDEX_ONLY");
+checkCountMode({a: {$gte: 5}, c: 0}, 2, "FETCH");
+checkCountMode({c: 0}, 4, "COLLSCAN");
@@ -0,0 +1,46 @@
+// Tests the wait time breakdown in system.profile and the latency histograms in serverStatus.
+
+var t = db.jstests_profile_waits;
+t.drop();
+
+function checkHistogram(h, msg) {
+    assert(h, msg + ": missing");
+    assert.gte(h.count, 1, msg + ": count");
+    assert.gte(h.totalMicros, 0, msg + ": totalMicros");
+    assert.lte(h.p50Micros, h.p99Micros, msg + ": p50 > p99");
+    var bucketed = 0;
+    h.buckets.forEach(function(b) { bucketed += b.count; });
+    assert.eq(h.count, bucketed, msg + ": bucket counts");
+}
+
+// Turn off profiling so that we can drop the profiler's collection. Then
+// enable profiling again. This is OK because this test is blacklisted for the
+// parallel suite.
+db.setProfilingLevel(0);
+db.system.profile.drop();
+db.setProfilingLevel(2);
+
+t.insert({_id: 1, x: 1});
+t.update({_id: 1}, {$inc: {x: 1}});
+assert.eq(2, t.findOne().x);
+
+db.setProfilingLevel(0);
+
+var prof = db.system.profile.findOne({op: "update", ns: t.getFullName()});
+printjson(prof);
+assert(prof, "no update in system.profile");
+assert(prof.waits, "no waits in the profile entry");
+["lockMicros", "storageMicros", "writeConcernMicros"].forEach(
+    function(field) {
+        assert.gte(prof.waits[field], 0, "waits." + field);
+    });
+assert.lte(prof.waits.storageMicros, prof.millis * 1000 + 1000, "storage time exceeds the total");
+
+var status = db.serverStatus();
+checkHistogram(status.opLatencies.command, "opLatencies.command");
+checkHistogram(status.metrics.commands.profile.latency, "profile command latency");
+if (db.isMaster().msg != "isdbgrid") {
+    checkHistogram(status.opLatencies.replyWrite, "opLatencies.replyWrite");
+}
+
+db.system.profile.drop();
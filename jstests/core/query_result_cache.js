@@ -0,0 +1,56 @@
+// Tests that the query result cache, enabled with collMod, returns the same results as running
+// the query and never returns results that a write has made stale.
+
+var t = db.query_result_cache;
+t.drop();
+
+var isMongos = ("isdbgrid" == db.runCommand("ismaster").msg);
+
+assert.commandWorked(db.createCollection(t.getName()));
+for (var i = 0; i < 10; i++) {
+    assert.writeOK(t.insert({_id: i, a: i % 3}));
+}
+
+var res = db.runCommand({collMod: t.getName(), queryResultCache: true});
+assert.commandWorked(res);
+assert.eq(false, res.queryResultCache_old);
+assert.eq(true, res.queryResultCache_new);
+
+function resultCacheStats() {
+    return t.stats().queryResultCache;
+}
+
+function query() {
+    return t.find({a: 1}, {_id: 1}).sort({_id: 1}).toArray();
+}
+
+var expected = [{_id: 1}, {_id: 4}, {_id: 7}];
+assert.eq(expected, query());
+assert.eq(expected, query());
+if (!isMongos) {
+    assert.eq(1, resultCacheStats().hits);
+}
+
+// Every kind of write invalidates the cached reply.
+assert.writeOK(t.insert({_id: 10, a: 1}));
+expected.push({_id: 10});
+assert.eq(expected, query());
+
+assert.writeOK(t.update({_id: 10}, {$set: {a: 2}}));
+expected.pop();
+assert.eq(expected, query());
+
+assert.writeOK(t.remove({_id: 4}));
+expected.splice(1, 1);
+assert.eq(expected, query());
+assert.eq(expected, query());
+
+// Disabling the cache drops its replies.
+res = db.runCommand({collMod: t.getName(), queryResultCache: false});
+assert.commandWorked(res);
+if (!isMongos) {
+    assert.eq(undefined, resultCacheStats());
+}
+assert.eq(expected, query());
+
+t.drop();
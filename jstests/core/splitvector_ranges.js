@@ -0,0 +1,130 @@
+// Tests the 'ranges' and 'estimate' options of splitVector, which look up the split points of
+// several chunks at once and pick approximate split points from a sample of the collection.
+
+var t = db.jstests_splitvector_ranges;
+t.drop();
+t.ensureIndex({x: 1});
+
+var ns = t.getFullName();
+var numDocs = 20000;
+
+var filler = "";
+while (filler.length < 500) {
+    filler += "a";
+}
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < numDocs; i++) {
+    bulk.insert({x: i, y: filler});
+}
+assert.writeOK(bulk.execute());
+
+function splitVector(cmd) {
+    cmd.splitVector = ns;
+    cmd.keyPattern = {x: 1};
+    return db.runCommand(cmd);
+}
+
+// Checks that 'splitKeys' are in order, inside [min, max) and split it into chunks of roughly
+// half of 'maxChunkSizeBytes' each, which is what splitVector aims for.
+function assertSplitsRange(splitKeys, min, max, maxChunkSizeBytes, msg) {
+    var bounds = [min].concat(splitKeys).concat([max]);
+    for (var i = 0; i < bounds.length - 1; i++) {
+        assert.lt(bounds[i].x, bounds[i + 1].x, msg + " keys out of order at " + i);
+
+        // The last chunk holds whatever is left over.
+        if (i == bounds.length - 2) {
+            continue;
+        }
+
+        var size = db.runCommand({datasize: ns, keyPattern: {x: 1},
+                                  min: bounds[i], max: bounds[i + 1]}).size;
+        assert.gt(size, 0.3 * maxChunkSizeBytes / 2, msg + " chunk " + i + " too small");
+        assert.lt(size, 2.5 * maxChunkSizeBytes / 2, msg + " chunk " + i + " too large");
+    }
+}
+
+//
+// ranges
+//
+
+var ranges = [{min: {x: 0}, max: {x: 5000}},
+              {min: {x: 5000}, max: {x: 15000}, maxChunkSizeBytes: 512 * 1024},
+              {min: {x: 15000}, max: {x: 15050}},
+              {min: {x: MinKey}, max: {x: MaxKey}}];
+
+var res = splitVector({maxChunkSize: 1, ranges: ranges});
+assert.commandWorked(res);
+assert.eq(ranges.length, res.rangeSplitKeys.length);
+assert(!res.rangeErrors, tojson(res));
+
+// Each range gets the split keys it would get if it was looked up on its own.
+ranges.forEach(function(range, i) {
+    var cmd = {min: range.min, max: range.max, maxChunkSize: 1};
+    if (range.maxChunkSizeBytes) {
+        delete cmd.maxChunkSize;
+        cmd.maxChunkSizeBytes = range.maxChunkSizeBytes;
+    }
+    var single = splitVector(cmd);
+    assert.commandWorked(single);
+    assert.eq(single.splitKeys, res.rangeSplitKeys[i], "range " + i);
+});
+assert.gt(res.rangeSplitKeys[1].length, res.rangeSplitKeys[0].length);
+assert.eq([], res.rangeSplitKeys[2]);
+
+// A range which fails doesn't fail the others, and its error is reported.
+res = splitVector({maxChunkSize: 1,
+                   ranges: [{min: {x: 0}, max: {x: 5000}},
+                            {min: {x: numDocs + 10}, max: {x: numDocs + 20}}]});
+assert.commandWorked(res);
+assert.eq(2, res.rangeSplitKeys.length);
+assert.gt(res.rangeSplitKeys[0].length, 0);
+assert.eq([], res.rangeSplitKeys[1]);
+assert.eq(1, res.rangeErrors.length, tojson(res));
+assert.eq(1, res.rangeErrors[0].index);
+assert(res.rangeErrors[0].code);
+assert(res.rangeErrors[0].errmsg);
+
+// Malformed ranges fail the whole command, even after a well formed one.
+[[{min: {x: 0}, max: {x: 10}}, 5],
+ [{min: {x: 0}, max: {x: 10}}, {min: {x: 10}}],
+ {min: {x: 0}, max: {x: 10}}].forEach(function(badRanges) {
+    res = splitVector({maxChunkSize: 1, ranges: badRanges});
+    assert.commandFailed(res, tojson(badRanges));
+    assert(!res.rangeSplitKeys, tojson(res));
+});
+
+//
+// estimate
+//
+
+// The estimated split points divide the collection about as evenly as the exact ones, whether or
+// not the storage engine can sample it.
+var exact = splitVector({maxChunkSize: 1});
+assert.commandWorked(exact);
+res = splitVector({maxChunkSize: 1, estimate: true});
+assert.commandWorked(res);
+assert.close(exact.splitKeys.length, res.splitKeys.length, "number of split keys", -1);
+assertSplitsRange(res.splitKeys, {x: -1}, {x: numDocs + 1}, 1024 * 1024, "whole collection");
+
+// Same for a range and with a limit on the number of split points.
+res = splitVector({min: {x: 5000}, max: {x: 15000}, maxChunkSize: 1, estimate: true});
+assert.commandWorked(res);
+assertSplitsRange(res.splitKeys, {x: 5000}, {x: 15000}, 1024 * 1024, "range");
+
+res = splitVector({maxChunkSize: 1, maxSplitPoints: 2, estimate: true});
+assert.commandWorked(res);
+assert.eq(2, res.splitKeys.length);
+
+// A chunk too small to split is left alone.
+res = splitVector({min: {x: 15000}, max: {x: 15050}, maxChunkSize: 1, estimate: true});
+assert.commandWorked(res);
+assert.eq([], res.splitKeys);
+
+// Estimates work through ranges too.
+res = splitVector({maxChunkSize: 1, estimate: true, ranges: ranges});
+assert.commandWorked(res);
+assert.eq(ranges.length, res.rangeSplitKeys.length);
+assertSplitsRange(res.rangeSplitKeys[0], {x: 0}, {x: 5000}, 1024 * 1024, "estimated range 0");
+assertSplitsRange(res.rangeSplitKeys[1], {x: 5000}, {x: 15000}, 512 * 1024, "estimated range 1");
+assert.eq([], res.rangeSplitKeys[2]);
@@ -0,0 +1,58 @@
+// Tests that mongos merges the estimates of its shards for count and distinct with
+// estimate: true.
+
+var s = new ShardingTest({name: "estimate", shards: 2, mongos: 1});
+s.stopBalancer();
+
+var db = s.getDB("test");
+var t = db.foo;
+
+s.adminCommand({enablesharding: "test"});
+s.ensurePrimaryShard("test", "shard0001");
+s.adminCommand({shardcollection: "test.foo", key: {_id: 1}});
+
+// Give each shard half of the documents. Every value of "a" and "b" appears on both shards.
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 4000; i++) {
+    bulk.insert({_id: i, a: i % 4, b: i % 2000});
+}
+assert.writeOK(bulk.execute());
+
+s.adminCommand({split: "test.foo", middle: {_id: 2000}});
+s.adminCommand({movechunk: "test.foo", find: {_id: 0}, to: "shard0000",
+                _waitForDelete: true});
+
+// Counts are estimated by each shard and summed.
+var res = db.runCommand({count: t.getName(), query: {a: 1}, estimate: true, sampleSize: 500});
+assert.commandWorked(res);
+assert.contains(res.estimate.method, ["randomSample", "exact"]);
+assert.eq(2, Object.keySet(res.shards).length, tojson(res));
+assert.lte(Math.abs(res.n - 1000), 2 * res.estimate.errorBound, tojson(res));
+if ("randomSample" == res.estimate.method) {
+    assert.eq(1000, res.estimate.examined, tojson(res));
+}
+
+assert.commandFailed(db.runCommand({count: t.getName(), query: {a: 1}, estimate: true,
+                                    sampleSize: 0}));
+
+// Distinct sketches are merged, so values found on both shards are counted once rather than
+// once per shard.
+res = db.runCommand({distinct: t.getName(), key: "b", estimate: true});
+assert.commandWorked(res);
+assert.eq("hyperLogLog", res.estimate.method);
+assert.eq(true, res.estimate.complete);
+assert.eq(4000, res.estimate.examined);
+assert.eq(undefined, res.estimate.sketch);
+assert.lte(Math.abs(res.n - 2000), 2 * res.estimate.errorBound, tojson(res));
+
+res = db.runCommand({distinct: t.getName(), key: "a", estimate: true});
+assert.commandWorked(res);
+assert.eq(4, res.n);
+
+// The cost budget applies to each shard.
+res = db.runCommand({distinct: t.getName(), key: "b", estimate: true, maxScan: 100});
+assert.commandWorked(res);
+assert.eq(false, res.estimate.complete);
+assert.eq(200, res.estimate.examined);
+
+s.stop();
@@ -0,0 +1,248 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bson_field_lookup.h"
+#include "mongo/bson/bson_validate.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using mongo::BSONElement;
+    using mongo::BSONFieldLookup;
+    using mongo::BSONObj;
+    using mongo::BSONObjBuilder;
+    using mongo::BSONObjIterator;
+    using mongo::OID;
+    using mongo::unittest::Benchmark;
+    using mongo::unittest::doNotOptimizeAway;
+
+    /**
+     * A document shaped like a typical small collection document.
+     */
+    BSONObj makeDocument() {
+        BSONObjBuilder b;
+        b.append("_id", OID::gen());
+        b.append("name", "some name for the document");
+        b.append("count", 42);
+        b.append("total", 1234567890123LL);
+        b.append("ratio", 0.25);
+        b.append("active", true);
+        b.append("address", BSON("street" << "1 Main St" << "city" << "Springfield"
+                                          << "zip" << 12345));
+        b.append("tags", BSON_ARRAY("a" << "b" << "c" << "d"));
+        b.append("last", "the last field");
+        return b.obj();
+    }
+
+    class DocumentFixture : public Benchmark {
+    protected:
+        virtual void setUp() {
+            doc = makeDocument();
+            setBytesPerIteration(doc.objsize());
+        }
+
+        BSONObj doc;
+    };
+
+    BENCHMARK(BSONBench, BuildSmallObject) {
+        for (long long i = 0; i < iterations(); ++i) {
+            BSONObj obj = BSON("a" << 1 << "b" << "two" << "c" << 3.0);
+            doNotOptimizeAway(obj.objdata());
+        }
+    }
+
+    BENCHMARK(BSONBench, BuildDocument) {
+        for (long long i = 0; i < iterations(); ++i) {
+            BSONObj obj = makeDocument();
+            doNotOptimizeAway(obj.objdata());
+        }
+    }
+
+    BENCHMARK(BSONBench, BuildManyFields) {
+        for (long long i = 0; i < iterations(); ++i) {
+            BSONObjBuilder b;
+            for (int field = 0; field < 100; ++field) {
+                b.append("field", field);
+            }
+            BSONObj obj = b.obj();
+            doNotOptimizeAway(obj.objdata());
+        }
+    }
+
+    BENCHMARK_F(DocumentFixture, BSONBench, IterateFields) {
+        for (long long i = 0; i < iterations(); ++i) {
+            for (BSONObjIterator it(doc); it.more();) {
+                BSONElement e = it.next();
+                doNotOptimizeAway(e);
+            }
+        }
+    }
+
+    BENCHMARK_F(DocumentFixture, BSONBench, GetLastField) {
+        for (long long i = 0; i < iterations(); ++i) {
+            BSONElement e = doc["last"];
+            doNotOptimizeAway(e);
+        }
+    }
+
+    BENCHMARK_F(DocumentFixture, BSONBench, GetFields) {
+        const char* names[] = {"count", "active", "last"};
+        BSONElement fields[3];
+        for (long long i = 0; i < iterations(); ++i) {
+            doc.getFields(3, names, fields);
+            doNotOptimizeAway(fields);
+        }
+    }
+
+    BENCHMARK_F(DocumentFixture, BSONBench, GetFieldDotted) {
+        for (long long i = 0; i < iterations(); ++i) {
+            BSONElement e = doc.getFieldDotted("address.zip");
+            doNotOptimizeAway(e);
+        }
+    }
+
+    BENCHMARK_F(DocumentFixture, BSONBench, Compare) {
+        BSONObj copy = doc.copy();
+        for (long long i = 0; i < iterations(); ++i) {
+            int cmp = doc.woCompare(copy);
+            doNotOptimizeAway(cmp);
+        }
+    }
+
+    BENCHMARK_F(DocumentFixture, BSONBench, Validate) {
+        for (long long i = 0; i < iterations(); ++i) {
+            mongo::Status status = mongo::validateBSON(doc.objdata(), doc.objsize());
+            doNotOptimizeAway(status);
+        }
+    }
+
+    /**
+     * A large document made mostly of string and binary payloads, like those which dominate
+     * the cost of validating inbound inserts.
+     */
+    BSONObj makePayloadDocument() {
+        const std::string text(4000, 't');
+        const std::string bytes(16000, 'b');
+        BSONObjBuilder b;
+        b.append("_id", OID::gen());
+        for (int i = 0; i < 8; ++i) {
+            b.append(std::string(1, 'a' + i) + "_description_field", text);
+        }
+        b.appendBinData("attachment", bytes.size(), mongo::BinDataGeneral, bytes.data());
+        return b.obj();
+    }
+
+    class PayloadDocumentFixture : public Benchmark {
+    protected:
+        virtual void setUp() {
+            doc = makePayloadDocument();
+            setBytesPerIteration(doc.objsize());
+        }
+
+        BSONObj doc;
+    };
+
+    BENCHMARK_F(PayloadDocumentFixture, BSONBench, ValidatePayloads) {
+        for (long long i = 0; i < iterations(); ++i) {
+            mongo::Status status = mongo::validateBSON(doc.objdata(), doc.objsize());
+            doNotOptimizeAway(status);
+        }
+    }
+
+    BENCHMARK_F(PayloadDocumentFixture, BSONBench, ValidatePayloadsUTF8) {
+        for (long long i = 0; i < iterations(); ++i) {
+            mongo::Status status = mongo::validateBSON(doc.objdata(),
+                                                       doc.objsize(),
+                                                       mongo::kValidateStructureAndUTF8);
+            doNotOptimizeAway(status);
+        }
+    }
+
+    BENCHMARK(BSONBench, ValidateManyFields) {
+        BSONObjBuilder b;
+        for (int field = 0; field < 100; ++field) {
+            b.append("a_somewhat_long_field_name", field);
+        }
+        const BSONObj obj = b.obj();
+        setBytesPerIteration(obj.objsize());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            mongo::Status status = mongo::validateBSON(obj.objdata(), obj.objsize());
+            doNotOptimizeAway(status);
+        }
+    }
+
+    /**
+     * A wide document, and the names of a handful of its fields spread across it, to compare
+     * repeated getField() calls against a BSONFieldLookup.
+     */
+    class WideDocumentFixture : public Benchmark {
+    protected:
+        virtual void setUp() {
+            BSONObjBuilder b;
+            b.append("_id", OID::gen());
+            for (int field = 0; field < 200; ++field) {
+                b.append(std::string(mongo::str::stream() << "field_" << field), field);
+            }
+            doc = b.obj();
+            for (int field = 20; field < 200; field += 45) {
+                names.push_back(mongo::str::stream() << "field_" << field);
+            }
+            setBytesPerIteration(doc.objsize());
+        }
+
+        BSONObj doc;
+        std::vector<std::string> names;
+    };
+
+    BENCHMARK_F(WideDocumentFixture, BSONBench, GetFieldsOfWideDocument) {
+        for (long long i = 0; i < iterations(); ++i) {
+            for (size_t n = 0; n < names.size(); ++n) {
+                BSONElement e = doc.getField(names[n]);
+                doNotOptimizeAway(e);
+            }
+        }
+    }
+
+    BENCHMARK_F(WideDocumentFixture, BSONBench, GetFieldsOfWideDocumentWithLookup) {
+        for (long long i = 0; i < iterations(); ++i) {
+            BSONFieldLookup lookup(doc);
+            for (size_t n = 0; n < names.size(); ++n) {
+                BSONElement e = lookup.getField(names[n]);
+                doNotOptimizeAway(e);
+            }
+        }
+    }
+
+} // namespace
@@ -0,0 +1,215 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bson_field_lookup.h"
+
+#include <cstring>
+
+namespace mongo {
+
+    BSONFieldLookup::BSONFieldLookup(const BSONObj& obj)
+        : _obj(obj.objdata()),
+          _unindexed(_obj),
+          _nFields(0),
+          _mask(kInlineSlots - 1),
+          _slots(_inlineSlots) {
+        memset(_inlineSlots, 0, sizeof(_inlineSlots));
+    }
+
+    uint32_t BSONFieldLookup::hashFieldName(const char* name, size_t len) {
+        // Field names are short, so mix them in a word at a time with a single multiply per
+        // word. This needs to be cheap more than it needs to be strong, since every element
+        // walked past gets hashed.
+        const uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+        uint64_t hash = len * kMul;
+        while (len >= sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, name, sizeof(word));
+            hash = (hash ^ word) * kMul;
+            name += sizeof(word);
+            len -= sizeof(word);
+        }
+        if (len > 0) {
+            uint64_t word = 0;
+            memcpy(&word, name, len);
+            hash = (hash ^ word) * kMul;
+        }
+        // The multiplies only carry each byte's bits upwards, so fold the high half back down
+        // and multiply once more before taking the high half.
+        hash = (hash ^ (hash >> 32)) * kMul;
+        return static_cast<uint32_t>(hash >> 32);
+    }
+
+    bool BSONFieldLookup::_matches(const Slot& slot, uint32_t hash, StringData name) const {
+        return slot.hash == hash &&
+               slot.fieldNameLen == name.size() &&
+               memcmp(_obj.objdata() + slot.offset + 1, name.rawData(), name.size()) == 0;
+    }
+
+    void BSONFieldLookup::_insert(uint32_t hash, uint32_t offset, StringData fieldName) {
+        for (size_t i = hash & _mask; ; i = (i + 1) & _mask) {
+            Slot& slot = _slots[i];
+            if (slot.offset == 0) {
+                slot.hash = hash;
+                slot.offset = offset;
+                slot.fieldNameLen = fieldName.size();
+                break;
+            }
+
+            // Keep only the first occurrence of a duplicated field name, as getField() would.
+            if (_matches(slot, hash, fieldName)) {
+                return;
+            }
+        }
+
+        // Keep the load factor at or below one half so that probe sequences stay short.
+        if (++_nFields * 2 > _mask + 1) {
+            _grow(offset);
+        }
+    }
+
+    void BSONFieldLookup::_grow(size_t bytesIndexed) {
+        // Extrapolate the number of fields in the whole object from the ones indexed so far, so
+        // that indexing a large object doesn't regrow the table over and over.
+        const size_t expectedFields = _nFields * _obj.objsize() / bytesIndexed;
+        size_t newSize = (_mask + 1) * 2;
+        while (newSize < expectedFields * 2) {
+            newSize *= 2;
+        }
+
+        std::vector<Slot> newSlots(newSize);
+        const size_t newMask = newSlots.size() - 1;
+
+        for (size_t i = 0; i <= _mask; ++i) {
+            const Slot& slot = _slots[i];
+            if (slot.offset == 0) {
+                continue;
+            }
+            size_t j = slot.hash & newMask;
+            while (newSlots[j].offset != 0) {
+                j = (j + 1) & newMask;
+            }
+            newSlots[j] = slot;
+        }
+
+        _heapSlots.swap(newSlots);
+        _slots = &_heapSlots[0];
+        _mask = newMask;
+    }
+
+    BSONElement BSONFieldLookup::_indexNext(uint32_t* hash) {
+        BSONElement e = _unindexed.next();
+        // The iterator has already computed the field name size, so this is free.
+        const StringData fieldName = e.fieldNameStringData();
+        *hash = hashFieldName(fieldName.rawData(), fieldName.size());
+        _insert(*hash, static_cast<uint32_t>(e.rawdata() - _obj.objdata()), fieldName);
+        return e;
+    }
+
+    size_t BSONFieldLookup::nFields() {
+        while (_unindexed.more()) {
+            uint32_t hash;
+            _indexNext(&hash);
+        }
+        return _nFields;
+    }
+
+    BSONElement BSONFieldLookup::getField(StringData name) {
+        const uint32_t hash = hashFieldName(name.rawData(), name.size());
+
+        for (size_t i = hash & _mask; ; i = (i + 1) & _mask) {
+            const Slot& slot = _slots[i];
+            if (slot.offset == 0) {
+                break;
+            }
+            if (_matches(slot, hash, name)) {
+                return BSONElement(_obj.objdata() + slot.offset,
+                                   name.size() + 1,
+                                   BSONElement::FieldNameSizeTag());
+            }
+        }
+
+        // Not indexed yet. Since no earlier element has this name, the first one we come across
+        // while indexing the rest of the object is the one getField() would return.
+        while (_unindexed.more()) {
+            uint32_t elementHash;
+            BSONElement e = _indexNext(&elementHash);
+            if (elementHash == hash && name == e.fieldNameStringData()) {
+                return e;
+            }
+        }
+
+        return BSONElement();
+    }
+
+    BSONElement BSONFieldLookup::getFieldDotted(StringData name) {
+        BSONElement e = getField(name);
+        if (e.eoo()) {
+            size_t dot_offset = name.find('.');
+            if (dot_offset != std::string::npos) {
+                BSONElement left = getField(name.substr(0, dot_offset));
+                if (left.type() != Object && left.type() != Array) {
+                    return BSONElement();
+                }
+                BSONObj sub = left.embeddedObject();
+                return sub.isEmpty() ? BSONElement() :
+                                       sub.getFieldDotted(name.substr(dot_offset + 1));
+            }
+        }
+
+        return e;
+    }
+
+    BSONElement BSONFieldLookup::getFieldDottedOrArray(const char*& name) {
+        const char* p = strchr(name, '.');
+
+        BSONElement sub;
+
+        if (p) {
+            sub = getField(StringData(name, p - name));
+            name = p + 1;
+        }
+        else {
+            const size_t len = strlen(name);
+            sub = getField(StringData(name, len));
+            name = name + len;
+        }
+
+        if (sub.eoo())
+            return BSONElement();
+        else if (sub.type() == Array || name[0] == '\0')
+            return sub;
+        else if (sub.type() == Object)
+            return sub.embeddedObject().getFieldDottedOrArray(name);
+        else
+            return BSONElement();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,136 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+    /**
+     * Answers repeated top-level field lookups on a single BSONObj without rescanning it.
+     *
+     * BSONObj::getField() walks the object from its first element on every call, so looking up
+     * k fields of an object with n fields costs O(k * n). A BSONFieldLookup instead remembers
+     * every element it walks past, hashing its field name into an open addressing table of
+     * element offsets. A lookup first probes that table, and only on a miss resumes walking the
+     * object from wherever the previous walk stopped. No lookup walks further than getField()
+     * would have, and the object is walked at most once in total.
+     *
+     * The table lives inside the BSONFieldLookup itself until more than kMaxInlineFields
+     * fields have been indexed, so it is meant to be declared on the stack right where the
+     * lookups happen. Indexing more fields than that spills the table to the heap.
+     *
+     * Lookup semantics match BSONObj: if a field name occurs more than once, the first
+     * occurrence is returned. The BSONFieldLookup does not take a reference on the object's
+     * buffer, so the object must outlive it.
+     */
+    class BSONFieldLookup {
+        MONGO_DISALLOW_COPYING(BSONFieldLookup);
+    public:
+        static const size_t kMaxInlineFields = 32;
+
+        explicit BSONFieldLookup(const BSONObj& obj);
+
+        const BSONObj& getObject() const { return _obj; }
+
+        /**
+         * @return the number of distinct top-level field names in the object. Indexes the rest
+         * of the object if it hasn't been walked to the end yet.
+         */
+        size_t nFields();
+
+        /** Equivalent to getObject().getField(name). */
+        BSONElement getField(StringData name);
+
+        BSONElement operator[](StringData name) { return getField(name); }
+
+        bool hasField(StringData name) { return !getField(name).eoo(); }
+
+        /** Equivalent to getObject().getFieldDotted(name). */
+        BSONElement getFieldDotted(StringData name);
+
+        /** Equivalent to getObject().getFieldDottedOrArray(name). */
+        BSONElement getFieldDottedOrArray(const char*& name);
+
+    private:
+        static const size_t kInlineSlots = kMaxInlineFields * 2;
+
+        /**
+         * One entry of the hash table. An offset of 0 marks an empty slot, since no element can
+         * start at the beginning of an object.
+         */
+        struct Slot {
+            uint32_t hash;
+            uint32_t offset;
+            uint32_t fieldNameLen;
+        };
+
+        static uint32_t hashFieldName(const char* name, size_t len);
+
+        bool _matches(const Slot& slot, uint32_t hash, StringData name) const;
+
+        /**
+         * Adds the element at 'offset' to the table, unless an earlier element with the same
+         * field name is already there.
+         */
+        void _insert(uint32_t hash, uint32_t offset, StringData fieldName);
+
+        /**
+         * Indexes the next unindexed element and returns it. Stores the hash of its field name
+         * in 'hash'. Must only be called while _unindexed.more().
+         */
+        BSONElement _indexNext(uint32_t* hash);
+
+
+        /**
+         * Doubles the size of the table, or more if the first 'bytesIndexed' bytes of the
+         * object suggest that it has many more fields still to be indexed.
+         */
+        void _grow(size_t bytesIndexed);
+
+        // An unowned view of the object, so that construction doesn't touch its refcount.
+        const BSONObj _obj;
+
+        // Position of the first element not yet indexed.
+        BSONObjIterator _unindexed;
+
+        size_t _nFields;
+        size_t _mask;
+        Slot* _slots;
+        std::vector<Slot> _heapSlots;
+        Slot _inlineSlots[kInlineSlots];
+    };
+
+}  // namespace mongo
@@ -0,0 +1,133 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+
+#include "mongo/bson/bson_field_lookup.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using namespace mongo;
+
+    TEST(BSONFieldLookup, EmptyObject) {
+        BSONFieldLookup lookup((BSONObj()));
+        ASSERT_EQUALS(0U, lookup.nFields());
+        ASSERT(lookup.getField("a").eoo());
+        ASSERT(lookup.getField("").eoo());
+    }
+
+    TEST(BSONFieldLookup, FindsEveryField) {
+        BSONObj obj = fromjson("{_id: 1, a: 'x', bb: 2.5, '': null, ccc: {d: 1}}");
+        BSONFieldLookup lookup(obj);
+        ASSERT_EQUALS(5U, lookup.nFields());
+
+        BSONObjIterator it(obj);
+        while (it.more()) {
+            BSONElement e = it.next();
+            BSONElement found = lookup.getField(e.fieldNameStringData());
+            ASSERT_EQUALS(static_cast<const void*>(e.rawdata()),
+                          static_cast<const void*>(found.rawdata()));
+            ASSERT_EQUALS(e.size(), found.size());
+            ASSERT_EQUALS(e.fieldNameStringData(), found.fieldNameStringData());
+        }
+
+        ASSERT(lookup.getField("c").eoo());
+        ASSERT(lookup.getField("cccc").eoo());
+        ASSERT(lookup["b"].eoo());
+        ASSERT(lookup.hasField("bb"));
+        ASSERT(!lookup.hasField("d"));
+    }
+
+    TEST(BSONFieldLookup, DuplicateFieldReturnsFirst) {
+        BSONObj obj = BSON("a" << 1 << "b" << 2 << "a" << 3);
+        BSONFieldLookup lookup(obj);
+        ASSERT_EQUALS(2U, lookup.nFields());
+        ASSERT_EQUALS(1, lookup.getField("a").numberInt());
+        ASSERT_EQUALS(static_cast<const void*>(obj.getField("a").rawdata()),
+                      static_cast<const void*>(lookup.getField("a").rawdata()));
+    }
+
+    TEST(BSONFieldLookup, ManyFieldsSpillToHeap) {
+        const int numFields = BSONFieldLookup::kMaxInlineFields * 10;
+        BSONObjBuilder b;
+        for (int i = 0; i < numFields; ++i) {
+            b.append(std::string(str::stream() << "f" << i), i);
+        }
+        BSONObj obj = b.obj();
+
+        BSONFieldLookup lookup(obj);
+        ASSERT_EQUALS(static_cast<size_t>(numFields), lookup.nFields());
+        for (int i = 0; i < numFields; ++i) {
+            ASSERT_EQUALS(i, lookup.getField(std::string(str::stream() << "f" << i)).numberInt());
+        }
+        ASSERT(lookup.getField(std::string(str::stream() << "f" << numFields)).eoo());
+    }
+
+    TEST(BSONFieldLookup, GetFieldDotted) {
+        BSONObj obj = fromjson("{a: {b: {c: 1}}, 'x.y': 2, x: {y: 3}, arr: [{z: 4}], s: 5}");
+        BSONFieldLookup lookup(obj);
+
+        const char* paths[] = {"a", "a.b", "a.b.c", "a.c", "x.y", "x", "arr.0.z", "arr.z",
+                               "s.t", "missing.field", "a."};
+        for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+            BSONElement expected = obj.getFieldDotted(paths[i]);
+            BSONElement actual = lookup.getFieldDotted(paths[i]);
+            ASSERT_EQUALS(expected.eoo(), actual.eoo()) << paths[i];
+            if (!expected.eoo()) {
+                ASSERT_EQUALS(static_cast<const void*>(expected.rawdata()),
+                              static_cast<const void*>(actual.rawdata())) << paths[i];
+            }
+        }
+    }
+
+    TEST(BSONFieldLookup, GetFieldDottedOrArray) {
+        BSONObj obj = fromjson("{a: {b: [{c: 1}]}, d: [1, 2], e: 1, f: {g: {h: 2}}}");
+        BSONFieldLookup lookup(obj);
+
+        const char* paths[] = {"a.b.c", "a.b", "d", "d.0", "e.x", "f.g.h", "f.x", "missing"};
+        for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+            const char* expectedRest = paths[i];
+            const char* actualRest = paths[i];
+            BSONElement expected = obj.getFieldDottedOrArray(expectedRest);
+            BSONElement actual = lookup.getFieldDottedOrArray(actualRest);
+            ASSERT_EQUALS(expected.eoo(), actual.eoo()) << paths[i];
+            if (!expected.eoo()) {
+                ASSERT_EQUALS(static_cast<const void*>(expected.rawdata()),
+                              static_cast<const void*>(actual.rawdata())) << paths[i];
+                ASSERT_EQUALS(std::string(expectedRest), std::string(actualRest)) << paths[i];
+            }
+        }
+    }
+
+} // namespace
@@ -28,8 +28,12 @@
  */
 
 #include <cstring>
-#include <deque>
 #include <limits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "mongo/base/data_view.h"
 #include "mongo/bson/bson_validate.h"
@@ -54,10 +58,82 @@ namespace mongo {
             return Status(ErrorCodes::InvalidBSON, baseMsg);
         }
 
+        /**
+         * Returns the first NUL byte of the 'length' bytes at 'start', or NULL if there is none.
+         * Most c-strings in BSON are short field names, so with SSE2 the first 16 bytes are
+         * checked inline before handing over to memchr.
+         */
+        inline const char* findCStringEnd(const char* start, uint64_t length) {
+#if defined(__SSE2__) && defined(__GNUC__)
+            if (length >= 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(start));
+                const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_setzero_si128()));
+                if (mask)
+                    return start + __builtin_ctz(mask);
+                return static_cast<const char*>(memchr(start + 16, 0, length - 16));
+            }
+#endif
+            return static_cast<const char*>(memchr(start, 0, length));
+        }
+
+        /**
+         * Returns true if the 'length' bytes at 'data' are valid UTF-8, by the same rules as
+         * isValidUTF8() in util/text.h, except that NUL bytes are allowed. Runs of ASCII are
+         * skipped a block at a time.
+         */
+        bool isValidUTF8Block(const char* data, uint64_t length) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+            const unsigned char* const end = p + length;
+            while (p < end) {
+#if defined(__SSE2__)
+                while (end - p >= 16 &&
+                       !_mm_movemask_epi8(
+                           _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))) {
+                    p += 16;
+                }
+#else
+                uint64_t word;
+                while (end - p >= 8 &&
+                       !(memcpy(&word, p, sizeof(word)), word & 0x8080808080808080ULL)) {
+                    p += 8;
+                }
+#endif
+                if (p == end)
+                    break;
+
+                const unsigned char c = *p++;
+                if (c < 0x80)
+                    continue;
+
+                // Reject continuation bytes, 2-byte encodings of ASCII and codepoints past
+                // 0x10FFFF as lead bytes.
+                int continuations;
+                if (c < 0xC2)
+                    return false;
+                else if (c < 0xE0)
+                    continuations = 1;
+                else if (c < 0xF0)
+                    continuations = 2;
+                else if (c <= 0xF4)
+                    continuations = 3;
+                else
+                    return false;
+
+                if (end - p < continuations)
+                    return false;
+                for (; continuations > 0; --continuations, ++p) {
+                    if ((*p & 0xC0) != 0x80)
+                        return false;
+                }
+            }
+            return true;
+        }
+
         class Buffer {
         public:
-            Buffer( const char* buffer, uint64_t maxLength )
-                : _buffer( buffer ), _position( 0 ), _maxLength( maxLength ) {
+            Buffer( const char* buffer, uint64_t maxLength, BSONValidationLevel level )
+                : _buffer( buffer ), _position( 0 ), _maxLength( maxLength ),
+                  _checkUTF8( level == kValidateStructureAndUTF8 ) {
             }
 
             template<typename N>
@@ -72,10 +148,13 @@ namespace mongo {
             }
 
             Status readCString( StringData* out ) {
-                const void* x = memchr( _buffer + _position, 0, _maxLength - _position );
+                const char* x = findCStringEnd( _buffer + _position, _maxLength - _position );
                 if ( !x )
                     return makeError("no end of c-string", _idElem);
-                uint64_t len = static_cast<uint64_t>( static_cast<const char*>(x) - ( _buffer + _position ) );
+                uint64_t len = static_cast<uint64_t>( x - ( _buffer + _position ) );
+
+                if ( _checkUTF8 && !isValidUTF8Block( _buffer + _position, len ) )
+                    return makeError("invalid UTF-8 in c-string", _idElem);
 
                 StringData data( _buffer + _position, len );
                 _position += len + 1;
@@ -100,6 +179,7 @@ namespace mongo {
                     *out = StringData( _buffer + _position, sz );
                 }
 
+                const char* start = _buffer + _position;
                 if ( !skip( sz - 1 ) )
                     return makeError("invalid bson", _idElem);
 
@@ -110,6 +190,11 @@ namespace mongo {
                 if ( c != 0 )
                     return makeError("not null terminated string", _idElem);
 
+                // The contents are only read when asked to, otherwise the string is skipped by
+                // its length.
+                if ( _checkUTF8 && !isValidUTF8Block( start, sz - 1 ) )
+                    return makeError("invalid UTF-8 in string", _idElem);
+
                 return Status::OK();
             }
 
@@ -137,6 +222,7 @@ namespace mongo {
             const char* _buffer;
             uint64_t _position;
             uint64_t _maxLength;
+            bool _checkUTF8;
             BSONElement _idElem;
         };
 
@@ -173,6 +259,43 @@ namespace mongo {
             int _startPosition;
         };
 
+        /**
+         * The objects being validated, innermost last. Documents are rarely nested deeply, so
+         * the first frames are kept inline and validation normally doesn't allocate.
+         */
+        class ValidationFrameStack {
+        public:
+            ValidationFrameStack() : _size(0) {}
+
+            void push_back(const ValidationObjectFrame& frame) {
+                if (_size < kInlineFrames)
+                    _inline[_size] = frame;
+                else
+                    _overflow.push_back(frame);
+                ++_size;
+            }
+
+            void pop_back() {
+                if (_size > kInlineFrames)
+                    _overflow.pop_back();
+                --_size;
+            }
+
+            ValidationObjectFrame& back() {
+                return _size <= kInlineFrames ? _inline[_size - 1] : _overflow.back();
+            }
+
+            size_t size() const { return _size; }
+            bool empty() const { return _size == 0; }
+
+        private:
+            static const size_t kInlineFrames = 32;
+
+            ValidationObjectFrame _inline[kInlineFrames];
+            std::vector<ValidationObjectFrame> _overflow;
+            size_t _size;
+        };
+
         /**
          * WARNING: only pass in a non-EOO idElem if it has been fully validated already!
          */
@@ -275,7 +398,7 @@ namespace mongo {
         }
 
         Status validateBSONIterative(Buffer* buffer) {
-            std::deque<ValidationObjectFrame> frames;
+            ValidationFrameStack frames;
             ValidationObjectFrame* curr = NULL;
             ValidationState::State state = ValidationState::BeginObj;
 
@@ -374,12 +497,14 @@ namespace mongo {
 
     }  // namespace
 
-    Status validateBSON( const char* originalBuffer, uint64_t maxLength ) {
+    Status validateBSON( const char* originalBuffer,
+                         uint64_t maxLength,
+                         BSONValidationLevel level ) {
         if ( maxLength < 5 ) {
             return Status( ErrorCodes::InvalidBSON, "bson data has to be at least 5 bytes" );
         }
 
-        Buffer buf( originalBuffer, maxLength );
+        Buffer buf( originalBuffer, maxLength, level );
         return validateBSONIterative( &buf );
     }
 
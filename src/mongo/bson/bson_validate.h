@@ -38,12 +38,25 @@ namespace mongo {
     class BSONObj;
     class Status;
 
+    /**
+     * How much of the data validateBSON checks. The structure is always validated. Checking
+     * the UTF-8 encoding of field names and strings has to read all their bytes, whereas
+     * otherwise strings are skipped by their length.
+     */
+    enum BSONValidationLevel {
+        kValidateStructure,
+        kValidateStructureAndUTF8
+    };
+
     /**
      * @param buf - bson data
      * @param maxLength - maxLength of buffer
      *                    this is NOT the bson size, but how far we know the buffer is valid
+     * @param level - whether to also validate UTF-8
      */
-    Status validateBSON( const char* buf, uint64_t maxLength );
+    Status validateBSON( const char* buf,
+                         uint64_t maxLength,
+                         BSONValidationLevel level = kValidateStructure );
 
     template<> struct Validator<BSONObj> {
         static Status validateLoad(const char* ptr, size_t length);
@@ -308,4 +308,53 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize()));
     }
 
+    TEST(BSONValidateFast, LongFieldNames) {
+        // Field names around the 16 byte block used to find the end of c-strings.
+        for (int len = 1; len < 40; ++len) {
+            const std::string name(len, 'f');
+            const BSONObj x = BSON(name << 1 << "y" << "z");
+            ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+            ASSERT_NOT_OK(validateBSON(x.objdata(), 4 + 1 + len));
+        }
+    }
+
+    TEST(BSONValidateUTF8, ValidStrings) {
+        const BSONObj x = BSON("_id" << 1 <<
+                               "ascii" << std::string(100, 'a') <<
+                               "two" << "caf\xc3\xa9" <<
+                               "three" << "\xe2\x82\xac" <<
+                               "four" << "\xf0\x9f\x98\x80 and some more ascii text" <<
+                               "n\xc3\xa4me" << 1);
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize(), kValidateStructureAndUTF8));
+    }
+
+    TEST(BSONValidateUTF8, InvalidStrings) {
+        const char* bad[] = {
+            "\x80",                            // unexpected continuation byte
+            "\xc0\x80",                        // 2-byte encoding of ASCII
+            "\xc3",                            // truncated codepoint
+            "\xe2\x82",                        // truncated codepoint
+            "\xe2\x28\xa1",                    // bad continuation byte
+            "\xf5\x80\x80\x80",                // past 0x10FFFF
+            "a long enough ascii prefix \xff",  // invalid byte after a full ascii block
+        };
+        for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+            const BSONObj x = BSON("_id" << 1 << "s" << bad[i]);
+            // Structurally valid, so only rejected when asked to check UTF-8.
+            ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+            const Status status =
+                validateBSON(x.objdata(), x.objsize(), kValidateStructureAndUTF8);
+            ASSERT_NOT_OK(status);
+            ASSERT_EQUALS(status.reason(), "invalid UTF-8 in string in object with _id: 1");
+        }
+    }
+
+    TEST(BSONValidateUTF8, InvalidFieldName) {
+        const BSONObj x = BSON("a\xff" << 1);
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+        const Status status = validateBSON(x.objdata(), x.objsize(), kValidateStructureAndUTF8);
+        ASSERT_NOT_OK(status);
+        ASSERT_EQUALS(status.reason(), "invalid UTF-8 in c-string in object with unknown _id");
+    }
+
 }
@@ -41,6 +41,7 @@
 #include "mongo/base/data_view.h"
 #include "mongo/base/string_data.h"
 #include "mongo/bson/inline_decls.h"
+#include "mongo/util/buffer_pool.h"
 #include "mongo/util/allocator.h"
 #include "mongo/util/assert_util.h"
 
@@ -76,21 +77,39 @@ namespace mongo {
     template <typename Allocator>
     class StringBuilderImpl;
 
+    /**
+     * Allocates from the thread's BufferPool cache when the pool is enabled, and from malloc
+     * otherwise.
+     */
     class TrivialAllocator { 
     public:
-        void* Malloc(size_t sz) { return mongoMalloc(sz); }
-        void* Realloc(void *p, size_t sz) { return mongoRealloc(p, sz); }
-        void Free(void *p) { free(p); }
+        size_t goodSize(size_t sz) { return BufferPool::goodSize(sz); }
+        void* Malloc(size_t sz) {
+            void* p = BufferPool::tryAcquire(sz);
+            return p ? p : mongoMalloc(sz);
+        }
+        void* Realloc(void *p, size_t oldSz, size_t sz) {
+            void* d = BufferPool::tryAcquire(sz);
+            if ( !d )
+                return mongoRealloc(p, sz);
+            if ( p ) {
+                memcpy(d, p, oldSz < sz ? oldSz : sz);
+                BufferPool::release(p, oldSz);
+            }
+            return d;
+        }
+        void Free(void *p, size_t sz) { BufferPool::release(p, sz); }
     };
 
     class StackAllocator {
     public:
         enum { SZ = 512 };
+        size_t goodSize(size_t sz) { return sz; }
         void* Malloc(size_t sz) {
             if( sz <= SZ ) return buf;
             return mongoMalloc(sz);
         }
-        void* Realloc(void *p, size_t sz) { 
+        void* Realloc(void *p, size_t oldSz, size_t sz) { 
             if( p == buf ) {
                 if( sz <= SZ ) return buf;
                 void *d = mongoMalloc(sz);
@@ -101,7 +120,7 @@ namespace mongo {
             }
             return mongoRealloc(p, sz);
         }
-        void Free(void *p) { 
+        void Free(void *p, size_t sz) { 
             if( p != buf )
                 free(p); 
         }
@@ -118,6 +137,7 @@ namespace mongo {
     public:
         _BufBuilder(int initsize = 512) : size(initsize) {
             if ( size > 0 ) {
+                size = static_cast<int>(al.goodSize(size));
                 data = (char *) al.Malloc(size);
                 if( data == 0 )
                     msgasserted(10000, "out of memory BufBuilder");
@@ -132,7 +152,7 @@ namespace mongo {
 
         void kill() {
             if ( data ) {
-                al.Free(data);
+                al.Free(data, size);
                 data = 0;
             }
         }
@@ -145,11 +165,11 @@ namespace mongo {
             l = 0;
             reservedBytes = 0;
             if ( maxSize && size > maxSize ) {
-                al.Free(data);
-                data = (char*)al.Malloc(maxSize);
+                al.Free(data, size);
+                size = static_cast<int>(al.goodSize(maxSize));
+                data = (char*)al.Malloc(size);
                 if ( data == 0 )
                     msgasserted( 15913 , "out of memory BufBuilder::reset" );
-                size = maxSize;
             }
         }
 
@@ -278,7 +298,8 @@ namespace mongo {
                 ss << "BufBuilder attempted to grow() to " << a << " bytes, past the 64MB limit.";
                 msgasserted(13548, ss.str().c_str());
             }
-            data = (char *) al.Realloc(data, a);
+            a = static_cast<int>(al.goodSize(a));
+            data = (char *) al.Realloc(data, size, a);
             if ( data == NULL )
                 msgasserted( 16070 , "out of memory BufBuilder::grow_reallocate" );
             size = a;
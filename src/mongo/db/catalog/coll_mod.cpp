@@ -137,12 +137,13 @@ namespace mongo {
                     errorStatus = std::move(status);
             }
             else {
-                // As of SERVER-17312 we only support these two options. When SERVER-17320 is
+                // As of SERVER-17312 we only support these user flags. When SERVER-17320 is
                 // resolved this will need to be enhanced to handle other options.
                 typedef CollectionOptions CO;
                 const StringData name = e.fieldNameStringData();
                 const int flag = (name == "usePowerOf2Sizes") ? CO::Flag_UsePowerOf2Sizes :
                                  (name == "noPadding") ? CO::Flag_NoPadding :
+                                 (name == "queryResultCache") ? CO::Flag_QueryResultCache :
                                  0;
                 if (!flag) {
                     errorStatus = Status(ErrorCodes::InvalidOptions,
@@ -150,6 +151,14 @@ namespace mongo {
                     continue;
                 }
 
+                // Oplog entries are inserted without notifying the collection info cache, which is
+                // what keeps the query result cache up to date.
+                if (flag == CO::Flag_QueryResultCache && ns.isOplog() && e.trueValue()) {
+                    errorStatus = Status(ErrorCodes::InvalidOptions,
+                                         "cannot enable the query result cache on the oplog");
+                    continue;
+                }
+
                 CollectionCatalogEntry* cce = coll->getCatalogEntry();
 
                 const int oldFlags = cce->getCollectionOptions(txn).flags;
@@ -182,6 +191,11 @@ namespace mongo {
                                                               cmdObj);
 
         wunit.commit();
+
+        const int flags = coll->getCatalogEntry()->getCollectionOptions(txn).flags;
+        coll->infoCache()->getQueryResultCache()->setEnabled(
+            flags & CollectionOptions::Flag_QueryResultCache);
+
         return Status::OK();
     }
 } // namespace mongo
@@ -165,6 +165,10 @@ namespace {
         if ( isCapped() )
             _recordStore->setCappedDeleteCallback( this );
         _infoCache.reset(txn);
+
+        const int flags = _details->getCollectionOptions(txn).flags;
+        _infoCache.getQueryResultCache()->setEnabled(
+            flags & CollectionOptions::Flag_QueryResultCache);
     }
 
     Collection::~Collection() {
@@ -172,6 +176,18 @@ namespace {
         _magic = 0;
     }
 
+    namespace {
+        /**
+         * Where to count time the current operation spends in record store and index calls.
+         */
+        long long* storageWaitTicks(OperationContext* txn) {
+            if (!txn->getClient()) {
+                return NULL;
+            }
+            return &CurOp::get(txn)->debug().storageWaitTicks;
+        }
+    } // namespace
+
     bool Collection::requiresIdIndex() const {
 
         if ( _ns.ns().find( '$' ) != string::npos ) {
@@ -283,9 +299,11 @@ namespace {
         dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
         invariant( !_indexCatalog.haveAnyIndexes() ); // eventually can implement, just not done
 
-        StatusWith<RecordId> loc = _recordStore->insertRecord( txn,
-                                                              doc,
-                                                              _enforceQuota( enforceQuota ) );
+        StatusWith<RecordId> loc = StatusWith<RecordId>( RecordId() );
+        {
+            ScopedWaitTimer storageTimer( storageWaitTicks( txn ) );
+            loc = _recordStore->insertRecord( txn, doc, _enforceQuota( enforceQuota ) );
+        }
         if ( !loc.isOK() )
             return loc;
 
@@ -347,17 +365,23 @@ namespace {
 
         dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
 
-        StatusWith<RecordId> loc = _recordStore->insertRecord( txn,
-                                                              doc.objdata(),
-                                                              doc.objsize(),
-                                                              _enforceQuota(enforceQuota) );
+        StatusWith<RecordId> loc = StatusWith<RecordId>( RecordId() );
+        {
+            ScopedWaitTimer storageTimer( storageWaitTicks( txn ) );
+            loc = _recordStore->insertRecord( txn,
+                                              doc.objdata(),
+                                              doc.objsize(),
+                                              _enforceQuota(enforceQuota) );
 
-        if ( !loc.isOK() )
-            return loc;
+            if ( !loc.isOK() )
+                return loc;
 
-        Status status = indexBlock->insert( doc, loc.getValue() );
-        if ( !status.isOK() )
-            return StatusWith<RecordId>( status );
+            Status status = indexBlock->insert( doc, loc.getValue() );
+            if ( !status.isOK() )
+                return StatusWith<RecordId>( status );
+        }
+
+        _infoCache.notifyOfWriteOp(txn);
 
         getGlobalServiceContext()->getOpObserver()->onInsert(txn, ns(), doc);
 
@@ -382,6 +406,8 @@ namespace {
                                                      bool enforceQuota ) {
         dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
 
+        ScopedWaitTimer storageTimer( storageWaitTicks( txn ) );
+
         // TODO: for now, capped logic lives inside NamespaceDetails, which is hidden
         //       under the RecordStore, this feels broken since that should be a
         //       collection access method probably
@@ -396,7 +422,7 @@ namespace {
         invariant( RecordId::min() < loc.getValue() );
         invariant( loc.getValue() < RecordId::max() );
 
-        _infoCache.notifyOfWriteOp();
+        _infoCache.notifyOfWriteOp(txn);
 
         Status s = _indexCatalog.indexRecord(txn, docToInsert, loc.getValue());
         if (!s.isOK())
@@ -443,11 +469,13 @@ namespace {
         /* check if any cursors point to us.  if so, advance them. */
         _cursorManager.invalidateDocument(txn, loc, INVALIDATION_DELETION);
 
-        _indexCatalog.unindexRecord(txn, doc.value(), loc, noWarn);
-
-        _recordStore->deleteRecord(txn, loc);
+        {
+            ScopedWaitTimer storageTimer( storageWaitTicks( txn ) );
+            _indexCatalog.unindexRecord(txn, doc.value(), loc, noWarn);
+            _recordStore->deleteRecord(txn, loc);
+        }
 
-        _infoCache.notifyOfWriteOp();
+        _infoCache.notifyOfWriteOp(txn);
 
         if (!id.isEmpty()) {
             getGlobalServiceContext()->getOpObserver()->onDelete(txn, ns().ns(), id);
@@ -513,14 +541,20 @@ namespace {
             }
         }
 
+        long long* const storageTicks = storageWaitTicks( txn );
+
         // This can call back into Collection::recordStoreGoingToMove.  If that happens, the old
         // object is removed from all indexes.
-        StatusWith<RecordId> newLocation = _recordStore->updateRecord( txn,
-                                                                      oldLocation,
-                                                                      newDoc.objdata(),
-                                                                      newDoc.objsize(),
-                                                                      _enforceQuota( enforceQuota ),
-                                                                      this );
+        StatusWith<RecordId> newLocation = StatusWith<RecordId>( RecordId() );
+        {
+            ScopedWaitTimer storageTimer( storageTicks );
+            newLocation = _recordStore->updateRecord( txn,
+                                                      oldLocation,
+                                                      newDoc.objdata(),
+                                                      newDoc.objsize(),
+                                                      _enforceQuota( enforceQuota ),
+                                                      this );
+        }
 
         if ( !newLocation.isOK() ) {
             return newLocation;
@@ -529,7 +563,7 @@ namespace {
         // At this point, the old object may or may not still be indexed, depending on if it was
         // moved.
 
-        _infoCache.notifyOfWriteOp();
+        _infoCache.notifyOfWriteOp(txn);
 
         // If the object did move, we need to add the new location to all indexes.
         if ( newLocation.getValue() != oldLocation ) {
@@ -541,7 +575,11 @@ namespace {
                     debug->nmoved += 1;
             }
 
-            Status s = _indexCatalog.indexRecord(txn, newDoc, newLocation.getValue());
+            Status s = Status::OK();
+            {
+                ScopedWaitTimer storageTimer( storageTicks );
+                s = _indexCatalog.indexRecord(txn, newDoc, newLocation.getValue());
+            }
             if (!s.isOK())
                 return StatusWith<RecordId>(s);
             invariant( sid == txn->recoveryUnit()->getSnapshotId() );
@@ -557,6 +595,7 @@ namespace {
             debug->keyUpdates = 0;
 
         if ( indexesAffected ) {
+            ScopedWaitTimer storageTimer( storageTicks );
             IndexCatalog::IndexIterator ii = _indexCatalog.getIndexIterator( txn, true );
             while ( ii.more() ) {
                 IndexDescriptor* descriptor = ii.next();
@@ -604,7 +643,8 @@ namespace {
         return _recordStore->updateWithDamagesSupported();
     }
 
-    Status Collection::updateDocumentWithDamages( OperationContext* txn,
+    StatusWith<RecordData> Collection::updateDocumentWithDamages(
+                                                  OperationContext* txn,
                                                   const RecordId& loc,
                                                   const Snapshotted<RecordData>& oldRec,
                                                   const char* damageSource,
@@ -617,14 +657,20 @@ namespace {
         // Broadcast the mutation so that query results stay correct.
         _cursorManager.invalidateDocument(txn, loc, INVALIDATION_MUTATION);
 
-        Status status = 
-            _recordStore->updateWithDamages(txn, loc, oldRec.value(), damageSource, damages);
+        StatusWith<RecordData> newRec(ErrorCodes::InternalError, "");
+        {
+            ScopedWaitTimer storageTimer( storageWaitTicks( txn ) );
+            newRec = _recordStore->updateWithDamages(txn, loc, oldRec.value(), damageSource,
+                                                     damages);
+        }
+
+        if (newRec.isOK()) {
+            _infoCache.notifyOfWriteOp(txn);
 
-        if (status.isOK()) {
             args.ns = ns().ns();
             getGlobalServiceContext()->getOpObserver()->onUpdate(txn, args);
         }
-        return status;
+        return newRec;
     }
 
     bool Collection::_enforceQuota( bool userEnforeQuota ) const {
@@ -736,6 +782,7 @@ namespace {
 
         _cursorManager.invalidateAll(false, "capped collection truncated");
         _recordStore->temp_cappedTruncateAfter( txn, end, inclusive );
+        _infoCache.getQueryResultCache()->clear();
     }
 
     Status Collection::setValidator(OperationContext* txn, BSONObj validatorDoc) {
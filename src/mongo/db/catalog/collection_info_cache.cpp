@@ -50,11 +50,13 @@ namespace mongo {
         : _collection( collection ),
           _keysComputed( false ),
           _planCache(new PlanCache(collection->ns().ns())),
-          _querySettings(new QuerySettings()) { }
+          _querySettings(new QuerySettings()),
+          _queryResultCache(new QueryResultCache()) { }
 
     void CollectionInfoCache::reset( OperationContext* txn ) {
         LOG(1) << _collection->ns().ns() << ": clearing plan cache - collection info cache reset";
         clearQueryCache();
+        _queryResultCache->clear();
         _keysComputed = false;
         computeIndexKeys( txn );
         updatePlanCacheIndexEntries( txn );
@@ -126,10 +128,11 @@ namespace mongo {
 
     }
 
-    void CollectionInfoCache::notifyOfWriteOp() {
+    void CollectionInfoCache::notifyOfWriteOp(OperationContext* txn) {
         if (NULL != _planCache.get()) {
             _planCache->notifyOfWriteOp();
         }
+        _queryResultCache->notifyOfWriteOp(txn);
     }
 
     void CollectionInfoCache::clearQueryCache() {
@@ -146,6 +149,10 @@ namespace mongo {
         return _querySettings.get();
     }
 
+    QueryResultCache* CollectionInfoCache::getQueryResultCache() const {
+        return _queryResultCache.get();
+    }
+
     void CollectionInfoCache::updatePlanCacheIndexEntries(OperationContext* txn) {
         std::vector<IndexEntry> indexEntries;
 
@@ -33,6 +33,7 @@
 #include <boost/scoped_ptr.hpp>
 
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
 
@@ -68,6 +69,11 @@ namespace mongo {
          */
         QuerySettings* getQuerySettings() const;
 
+        /**
+         * Get the QueryResultCache for this collection.
+         */
+        QueryResultCache* getQueryResultCache() const;
+
         // -------------------
 
         /* get set of index keys for this namespace.  handy to quickly check if a given
@@ -84,8 +90,9 @@ namespace mongo {
 
         void clearQueryCache();
 
-        /* you must notify the cache if you are doing writes, as query plan utility will change */
-        void notifyOfWriteOp();
+        /* you must notify the cache if you are doing writes, as query plan utility will change
+           and cached query results become stale. must be called inside the write's unit of work */
+        void notifyOfWriteOp(OperationContext* txn);
 
     private:
 
@@ -102,6 +109,9 @@ namespace mongo {
         // Includes index filters.
         boost::scoped_ptr<QuerySettings> _querySettings;
 
+        // A cache for query replies. Only used if enabled for this collection.
+        boost::scoped_ptr<QueryResultCache> _queryResultCache;
+
         /**
          * Must be called under exclusive DB lock.
          */
@@ -87,6 +87,7 @@ namespace mongo {
         enum UserFlags {
             Flag_UsePowerOf2Sizes = 1 << 0,
             Flag_NoPadding = 1 << 1,
+            Flag_QueryResultCache = 1 << 2,
         };
         int flags; // a bitvector of UserFlags
         bool flagsSet;
@@ -43,6 +43,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/concurrency/sharded_counter.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/startup_test.h"
 
@@ -316,11 +317,16 @@ namespace mongo {
     // --------------------------
 
 
+    CursorManager::Partition::Partition() : mutex( "CursorManager" ) { }
+
+    CursorManager::Partition::~Partition() { }
+
     CursorManager::CursorManager( StringData ns )
-        : _nss( ns ),
-          _mutex( "CursorManager" ) {
+        : _nss( ns ) {
         _collectionCacheRuntimeId = globalCursorIdCache->created( _nss.ns() );
-        _random.reset( new PseudoRandom( globalCursorIdCache->nextSeed() ) );
+        for ( unsigned i = 0; i < kNumPartitions; i++ ) {
+            _partitions[i].random.reset( new PseudoRandom( globalCursorIdCache->nextSeed() ) );
+        }
     }
 
     CursorManager::~CursorManager() {
@@ -330,71 +336,80 @@ namespace mongo {
 
     void CursorManager::invalidateAll(bool collectionGoingAway,
                                       const std::string& reason) {
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        for ( ExecSet::iterator it = _nonCachedExecutors.begin();
-              it != _nonCachedExecutors.end();
-              ++it ) {
-
-            // we kill the executor, but it deletes itself
-            PlanExecutor* exec = *it;
-            exec->kill(reason);
-            invariant( exec->collection() == NULL );
-        }
-        _nonCachedExecutors.clear();
-
-        if ( collectionGoingAway ) {
-            // we're going to wipe out the world
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+
+            for ( ExecSet::iterator it = partition.nonCachedExecutors.begin();
+                  it != partition.nonCachedExecutors.end();
+                  ++it ) {
+
+                // we kill the executor, but it deletes itself
+                PlanExecutor* exec = *it;
+                exec->kill(reason);
+                invariant( exec->collection() == NULL );
+            }
+            partition.nonCachedExecutors.clear();
 
-                cc->kill();
+            if ( collectionGoingAway ) {
+                // we're going to wipe out the world
+                for ( CursorMap::const_iterator i = partition.cursors.begin();
+                      i != partition.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
 
-                invariant( cc->getExecutor() == NULL || cc->getExecutor()->collection() == NULL );
+                    cc->kill();
 
-                // If the CC is pinned, somebody is actively using it and we do not delete it.
-                // Instead we notify the holder that we killed it.  The holder will then delete the
-                // CC.
-                //
-                // If the CC is not pinned, there is nobody actively holding it.  We can safely
-                // delete it.
-                if (!cc->isPinned()) {
-                    delete cc;
+                    invariant( cc->getExecutor() == NULL ||
+                               cc->getExecutor()->collection() == NULL );
+
+                    // If the CC is pinned, somebody is actively using it and we do not delete
+                    // it. Instead we notify the holder that we killed it.  The holder will then
+                    // delete the CC.
+                    //
+                    // If the CC is not pinned, there is nobody actively holding it.  We can
+                    // safely delete it.
+                    if (!cc->isPinned()) {
+                        delete cc;
+                    }
                 }
             }
-        }
-        else {
-            CursorMap newMap;
+            else {
+                CursorMap newMap;
+
+                // collection will still be around, just all PlanExecutors are invalid
+                for ( CursorMap::const_iterator i = partition.cursors.begin();
+                      i != partition.cursors.end();
+                      ++i ) {
+                    ClientCursor* cc = i->second;
+
+                    // Note that a valid ClientCursor state is "no cursor no executor."  This is
+                    // because the set of active cursor IDs in ClientCursor is used as
+                    // representation of query state.  See sharding_block.h.  TODO(greg,hk): Move
+                    // this out.
+                    if (NULL == cc->getExecutor() ) {
+                        newMap.insert( *i );
+                        continue;
+                    }
+
+                    if (cc->isPinned() || cc->isAggCursor()) {
+                        // Pinned cursors need to stay alive, so we leave them around.
+                        // Aggregation cursors also can stay alive (since they don't have their
+                        // lifetime bound to the underlying collection).  However, if they have
+                        // an associated executor, we need to kill it, because it's now invalid.
+                        if ( cc->getExecutor() )
+                            cc->getExecutor()->kill(reason);
+                        newMap.insert( *i );
+                    }
+                    else {
+                        cc->kill();
+                        delete cc;
+                    }
 
-            // collection will still be around, just all PlanExecutors are invalid
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-                ClientCursor* cc = i->second;
-
-                // Note that a valid ClientCursor state is "no cursor no executor."  This is because
-                // the set of active cursor IDs in ClientCursor is used as representation of query
-                // state.  See sharding_block.h.  TODO(greg,hk): Move this out.
-                if (NULL == cc->getExecutor() ) {
-                    newMap.insert( *i );
-                    continue;
-                }
-
-                if (cc->isPinned() || cc->isAggCursor()) {
-                    // Pinned cursors need to stay alive, so we leave them around.  Aggregation
-                    // cursors also can stay alive (since they don't have their lifetime bound to
-                    // the underlying collection).  However, if they have an associated executor, we
-                    // need to kill it, because it's now invalid.
-                    if ( cc->getExecutor() )
-                        cc->getExecutor()->kill(reason);
-                    newMap.insert( *i );
-                }
-                else {
-                    cc->kill();
-                    delete cc;
                 }
 
+                partition.cursors = newMap;
             }
-
-            _cursors = newMap;
         }
     }
 
@@ -407,61 +422,79 @@ namespace mongo {
             return;
         }
 
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        for ( ExecSet::iterator it = _nonCachedExecutors.begin();
-              it != _nonCachedExecutors.end();
-              ++it ) {
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-            PlanExecutor* exec = *it;
-            exec->invalidate(txn, dl, type);
-        }
+            for ( ExecSet::iterator it = partition.nonCachedExecutors.begin();
+                  it != partition.nonCachedExecutors.end();
+                  ++it ) {
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            PlanExecutor* exec = i->second->getExecutor();
-            if ( exec ) {
+                PlanExecutor* exec = *it;
                 exec->invalidate(txn, dl, type);
             }
+
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                PlanExecutor* exec = i->second->getExecutor();
+                if ( exec ) {
+                    exec->invalidate(txn, dl, type);
+                }
+            }
         }
     }
 
     std::size_t CursorManager::timeoutCursors( int millisSinceLastCall ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        size_t numTimedOut = 0;
 
-        vector<ClientCursor*> toDelete;
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            if ( cc->shouldTimeout( millisSinceLastCall ) )
-                toDelete.push_back( cc );
-        }
+            vector<ClientCursor*> toDelete;
+
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                if ( cc->shouldTimeout( millisSinceLastCall ) )
+                    toDelete.push_back( cc );
+            }
+
+            for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
+                    i != toDelete.end(); ++i ) {
+                ClientCursor* cc = *i;
+                partition.cursors.erase( cc->cursorid() );
+                cc->kill();
+                delete cc;
+            }
 
-        for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
-                i != toDelete.end(); ++i ) {
-            ClientCursor* cc = *i;
-            _deregisterCursor_inlock( cc );
-            cc->kill();
-            delete cc;
+            numTimedOut += toDelete.size();
         }
 
-        return toDelete.size();
+        return numTimedOut;
     }
 
     void CursorManager::registerExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
-        const std::pair<ExecSet::iterator, bool> result = _nonCachedExecutors.insert(exec);
+        Partition& partition = _getPartition( exec );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        const std::pair<ExecSet::iterator, bool> result =
+            partition.nonCachedExecutors.insert(exec);
         invariant(result.second); // make sure this was inserted
     }
 
     void CursorManager::deregisterExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
-        _nonCachedExecutors.erase(exec);
+        Partition& partition = _getPartition( exec );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        partition.nonCachedExecutors.erase(exec);
     }
 
     ClientCursor* CursorManager::find( CursorId id, bool pin ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorMap::const_iterator it = _cursors.find( id );
-        if ( it == _cursors.end() )
+        Partition& partition = _getPartition( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        CursorMap::const_iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() )
             return NULL;
 
         ClientCursor* cursor = it->second;
@@ -476,7 +509,8 @@ namespace mongo {
     }
 
     void CursorManager::unpin( ClientCursor* cursor ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        Partition& partition = _getPartition( cursor->cursorid() );
+        SimpleMutex::scoped_lock lk( partition.mutex );
 
         invariant( cursor->isPinned() );
         cursor->unsetPinned();
@@ -487,24 +521,47 @@ namespace mongo {
     }
 
     void CursorManager::getCursorIds( std::set<CursorId>* openCursors ) const {
-        SimpleMutex::scoped_lock lk( _mutex );
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            const Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            openCursors->insert( cc->cursorid() );
+            for ( CursorMap::const_iterator i = partition.cursors.begin();
+                  i != partition.cursors.end();
+                  ++i ) {
+                ClientCursor* cc = i->second;
+                openCursors->insert( cc->cursorid() );
+            }
         }
     }
 
     size_t CursorManager::numCursors() const {
-        SimpleMutex::scoped_lock lk( _mutex );
-        return _cursors.size();
+        size_t num = 0;
+        for ( unsigned p = 0; p < kNumPartitions; p++ ) {
+            const Partition& partition = _partitions[p];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            num += partition.cursors.size();
+        }
+        return num;
+    }
+
+    CursorManager::Partition& CursorManager::_getPartition( const PlanExecutor* exec ) {
+        // Executors are heap allocated, so the low bits carry no information
+        const uintptr_t x = reinterpret_cast<uintptr_t>( exec );
+        return _partitions[( x >> 6 ) % kNumPartitions];
     }
 
-    CursorId CursorManager::_allocateCursorId_inlock() {
+    CursorManager::Partition& CursorManager::_getPartition( CursorId id ) {
+        return _partitions[static_cast<uint64_t>( id ) % kNumPartitions];
+    }
+
+    CursorId CursorManager::_allocateCursorId_inlock( Partition* partition,
+                                                      unsigned partitionIndex ) {
         for ( int i = 0; i < 10000; i++ ) {
-            unsigned mypart = static_cast<unsigned>( _random->nextInt32() );
+            // The low bits of the id select the partition, so they cannot be random
+            unsigned mypart = static_cast<unsigned>( partition->random->nextInt32() );
+            mypart = ( mypart & ~( kNumPartitions - 1 ) ) | partitionIndex;
             CursorId id = cursorIdFromParts( _collectionCacheRuntimeId, mypart );
-            if ( _cursors.count( id ) == 0 )
+            if ( partition->cursors.count( id ) == 0 )
                 return id;
         }
         fassertFailed( 17360 );
@@ -512,22 +569,31 @@ namespace mongo {
 
     CursorId CursorManager::registerCursor( ClientCursor* cc ) {
         invariant( cc );
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorId id = _allocateCursorId_inlock();
-        _cursors[id] = cc;
+
+        // Spread the cursors of concurrent clients across the partitions
+        const unsigned partitionIndex = getCounterShardForThread() % kNumPartitions;
+        Partition& partition = _partitions[partitionIndex];
+
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        CursorId id = _allocateCursorId_inlock( &partition, partitionIndex );
+        invariant( &_getPartition( id ) == &partition );
+        partition.cursors[id] = cc;
         return id;
     }
 
     void CursorManager::deregisterCursor( ClientCursor* cc ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        _deregisterCursor_inlock( cc );
+        invariant( cc );
+        Partition& partition = _getPartition( cc->cursorid() );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        partition.cursors.erase( cc->cursorid() );
     }
 
     bool CursorManager::eraseCursor(OperationContext* txn, CursorId id, bool checkAuth) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        Partition& partition = _getPartition( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
 
-        CursorMap::iterator it = _cursors.find( id );
-        if ( it == _cursors.end() ) {
+        CursorMap::iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() ) {
             if ( checkAuth )
                 audit::logKillCursorsAuthzCheck( txn->getClient(),
                                                  _nss,
@@ -549,15 +615,9 @@ namespace mongo {
                  !cursor->isPinned() );
 
         cursor->kill();
-        _deregisterCursor_inlock( cursor );
+        partition.cursors.erase( it );
         delete cursor;
         return true;
     }
 
-    void CursorManager::_deregisterCursor_inlock( ClientCursor* cc ) {
-        invariant( cc );
-        CursorId id = cc->cursorid();
-        _cursors.erase( id );
-    }
-
 }
@@ -139,20 +139,39 @@ namespace mongo {
         static std::size_t timeoutCursorsGlobal(OperationContext* txn, int millisSinceLastCall);
 
     private:
-        CursorId _allocateCursorId_inlock();
-        void _deregisterCursor_inlock( ClientCursor* cc );
+        typedef unordered_set<PlanExecutor*> ExecSet;
+        typedef std::map<CursorId,ClientCursor*> CursorMap;
 
-        NamespaceString _nss;
-        unsigned _collectionCacheRuntimeId;
-        boost::scoped_ptr<PseudoRandom> _random;
+        /**
+         * Executors and cursors are spread across partitions, each with its own mutex, so that
+         * the many short queries on a busy collection don't all serialize on registering and
+         * deregistering. Operations on a single executor or cursor lock only its partition,
+         * operations on all of them visit the partitions one after the other.
+         */
+        struct Partition {
+            Partition();
+            ~Partition();
 
-        mutable SimpleMutex _mutex;
+            mutable SimpleMutex mutex;
+            ExecSet nonCachedExecutors;
+            CursorMap cursors;
 
-        typedef unordered_set<PlanExecutor*> ExecSet;
-        ExecSet _nonCachedExecutors;
+            // Generates the ids of the cursors registered through this partition
+            boost::scoped_ptr<PseudoRandom> random;
+        };
 
-        typedef std::map<CursorId,ClientCursor*> CursorMap;
-        CursorMap _cursors;
+        // Must be a power of two, the low bits of a cursor id select its partition
+        static const unsigned kNumPartitions = 16;
+
+        Partition& _getPartition( const PlanExecutor* exec );
+        Partition& _getPartition( CursorId id );
+
+        CursorId _allocateCursorId_inlock( Partition* partition, unsigned partitionIndex );
+
+        NamespaceString _nss;
+        unsigned _collectionCacheRuntimeId;
+
+        Partition _partitions[kNumPartitions];
     };
 
 }
@@ -251,9 +251,13 @@ namespace mutablebson {
         Counter64 _commandsExecuted;
         Counter64 _commandsFailed;
 
+        // How long executions of this command took
+        LatencyHistogram _latency;
+
         // Pointers to hold the metrics tree references
         ServerStatusMetricField<Counter64> _commandsExecutedMetric;
         ServerStatusMetricField<Counter64> _commandsFailedMetric;
+        LatencyHistogramMetric _latencyMetric;
 
     public:
 
@@ -41,6 +41,8 @@
 #include "mongo/db/exec/count.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/query_estimate.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/range_preserver.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/util/log.h"
@@ -122,6 +124,21 @@ namespace mongo {
                 return appendCommandStatus(result, parseStatus);
             }
 
+            // An estimated count samples random records where it can, and otherwise counts
+            // exactly.
+            const bool estimate = cmdObj["estimate"].trueValue();
+            long long sampleSize = 0;
+            if (estimate) {
+                Status budgetStatus = parseEstimateBudget(cmdObj,
+                                                          "sampleSize",
+                                                          internalQueryEstimateSampleSize,
+                                                          kMaxEstimateSampleSize,
+                                                          &sampleSize);
+                if (!budgetStatus.isOK()) {
+                    return appendCommandStatus(result, budgetStatus);
+                }
+            }
+
             AutoGetCollectionForRead ctx(txn, request.ns);
             Collection* collection = ctx.getCollection();
 
@@ -129,6 +146,28 @@ namespace mongo {
             // version on initial entry into count.
             RangePreserver preserver(collection);
 
+            if (estimate) {
+                bool sampled;
+                QueryEstimate sampledEstimate;
+                Status sampleStatus = sampleCount(txn,
+                                                  collection,
+                                                  request,
+                                                  sampleSize,
+                                                  &sampled,
+                                                  &sampledEstimate);
+                if (!sampleStatus.isOK()) {
+                    return appendCommandStatus(result, sampleStatus);
+                }
+
+                if (sampled) {
+                    if (NULL != CurOp::get(txn)) {
+                        CurOp::get(txn)->debug().planSummary = "RANDOM_SAMPLE";
+                    }
+                    sampledEstimate.appendToBuilder(&result);
+                    return true;
+                }
+            }
+
             PlanExecutor* rawExec;
             Status getExecStatus = getExecutorCount(txn,
                                                     collection,
@@ -157,6 +196,11 @@ namespace mongo {
             const CountStats* countStats =
                 static_cast<const CountStats*>(countStage->getSpecificStats());
 
+            if (estimate) {
+                QueryEstimate::exact(countStats->nCounted).appendToBuilder(&result);
+                return true;
+            }
+
             result.appendNumber("n", countStats->nCounted);
             return true;
         }
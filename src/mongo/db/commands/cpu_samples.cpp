@@ -0,0 +1,118 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/base/init.h"
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/stats/cpu_sampler.h"
+
+namespace {
+
+    using namespace mongo;
+
+    /**
+     * Reports where the CPU went over a recent window, as the most sampled stacks of the busiest
+     * operations and namespaces:
+     *
+     *     { cpuSamples: 1, windowSecs: <default 60>, limit: <groups, default 10>,
+     *       stacks: <stacks per group, default 5> }
+     *
+     * Samples are only taken while the cpuSamplingHz server parameter is non-zero.
+     */
+    class CpuSamplesCommand : public Command {
+    public:
+        CpuSamplesCommand() : Command("cpuSamples") {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual void help(std::stringstream& help) const {
+            help << "most sampled stacks by operation and namespace, over the last windowSecs "
+                    "seconds; enable sampling with the cpuSamplingHz parameter";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::cpuProfiler);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+        virtual bool run(OperationContext* txn,
+                         const std::string& db,
+                         BSONObj& cmdObj,
+                         int options,
+                         std::string& errmsg,
+                         BSONObjBuilder& result) {
+            int windowSecs = 60;
+            int limit = 10;
+            int stacks = 5;
+
+            if (cmdObj.hasField("windowSecs")) {
+                windowSecs = cmdObj["windowSecs"].numberInt();
+            }
+            if (cmdObj.hasField("limit")) {
+                limit = cmdObj["limit"].numberInt();
+            }
+            if (cmdObj.hasField("stacks")) {
+                stacks = cmdObj["stacks"].numberInt();
+            }
+
+            if (windowSecs <= 0 || windowSecs > CpuSampleAggregator::kRetentionSecs) {
+                errmsg = str::stream() << "windowSecs must be between 1 and "
+                                       << CpuSampleAggregator::kRetentionSecs;
+                return false;
+            }
+            if (limit <= 0 || stacks <= 0) {
+                errmsg = "limit and stacks must be positive";
+                return false;
+            }
+
+            appendCpuSamples(windowSecs, limit, stacks, &result);
+            return true;
+        }
+
+    };
+
+    //
+    // Command instance.
+    // Registers command with the command system and make command
+    // available to the client.
+    //
+
+    MONGO_INITIALIZER(RegisterCpuSamplesCommand)(InitializerContext* context) {
+
+        new CpuSamplesCommand();
+
+        return Status::OK();
+    }
+} // namespace
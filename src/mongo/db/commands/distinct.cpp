@@ -28,6 +28,7 @@
 *    it in the license file.
 */
 
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -42,6 +43,8 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/query_estimate.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/util/timer.h"
 
@@ -68,7 +71,9 @@ namespace mongo {
         }
 
         virtual void help( stringstream &help ) const {
-            help << "{ distinct : 'collection name' , key : 'a.b' , query : {} }";
+            help << "{ distinct : 'collection name' , key : 'a.b' , query : {} }\n"
+                 << "with estimate : true, returns the approximate number of distinct values "
+                 << "instead of the values, examining at most maxScan results";
         }
 
         bool run(OperationContext* txn,
@@ -99,6 +104,20 @@ namespace mongo {
 
             BSONObj query = getQuery( cmdObj );
 
+            const bool estimate = cmdObj["estimate"].trueValue();
+            long long maxScan = 0;
+            if (estimate) {
+                Status budgetStatus =
+                    parseEstimateBudget(cmdObj,
+                                        "maxScan",
+                                        internalQueryEstimateMaxScan,
+                                        std::numeric_limits<long long>::max(),
+                                        &maxScan);
+                if (!budgetStatus.isOK()) {
+                    return appendCommandStatus(result, budgetStatus);
+                }
+            }
+
             int bufSize = BSONObjMaxUserSize - 4096;
             BufBuilder bb( bufSize );
             char * start = bb.buf();
@@ -111,7 +130,12 @@ namespace mongo {
 
             Collection* collection = ctx.getCollection();
             if (!collection) {
-                result.appendArray( "values" , BSONObj() );
+                if (estimate) {
+                    QueryEstimate::exact(0).appendToBuilder(&result);
+                }
+                else {
+                    result.appendArray( "values" , BSONObj() );
+                }
                 result.append("stats", BSON("n" << 0 <<
                                             "nscanned" << 0 <<
                                             "nscannedObjects" << 0));
@@ -133,6 +157,22 @@ namespace mongo {
 
             auto_ptr<PlanExecutor> exec(rawExec);
 
+            if (estimate) {
+                QueryEstimate distinctEstimate;
+                Status estimateStatus = estimateDistinct(exec.get(),
+                                                         key,
+                                                         maxScan,
+                                                         cmdObj["includeSketch"].trueValue(),
+                                                         &distinctEstimate);
+                if (!estimateStatus.isOK()) {
+                    return appendCommandStatus(result, estimateStatus);
+                }
+
+                distinctEstimate.appendToBuilder(&result);
+                appendStats(exec.get(), t, &result);
+                return true;
+            }
+
             BSONObj obj;
             PlanExecutor::ExecState state;
             while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
@@ -158,26 +198,30 @@ namespace mongo {
                 }
             }
 
-            // Get summary information about the plan.
-            PlanSummaryStats stats;
-            Explain::getSummaryStats(exec.get(), &stats);
-
             verify( start == bb.buf() );
 
             result.appendArray( "values" , arr.done() );
-
-            {
-                BSONObjBuilder b;
-                b.appendNumber( "n" , stats.nReturned );
-                b.appendNumber( "nscanned" , stats.totalKeysExamined );
-                b.appendNumber( "nscannedObjects" , stats.totalDocsExamined );
-                b.appendNumber( "timems" , t.millis() );
-                b.append( "planSummary" , Explain::getPlanSummary(exec.get()) );
-                result.append( "stats" , b.obj() );
-            }
+            appendStats(exec.get(), t, &result);
 
             return true;
         }
+
+    private:
+        /**
+         * Appends summary information about the plan run by 'exec', which started at 't'.
+         */
+        static void appendStats(PlanExecutor* exec, const Timer& t, BSONObjBuilder* result) {
+            PlanSummaryStats stats;
+            Explain::getSummaryStats(exec, &stats);
+
+            BSONObjBuilder b;
+            b.appendNumber( "n" , stats.nReturned );
+            b.appendNumber( "nscanned" , stats.totalKeysExamined );
+            b.appendNumber( "nscannedObjects" , stats.totalDocsExamined );
+            b.appendNumber( "timems" , t.millis() );
+            b.append( "planSummary" , Explain::getPlanSummary(exec) );
+            result->append( "stats" , b.obj() );
+        }
     } distinctCmd;
 
 }  // namespace mongo
@@ -42,6 +42,7 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/logger/parse_log_component_settings.h"
+#include "mongo/util/buffer_pool.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
@@ -599,6 +600,88 @@ namespace mongo {
                                                              false, // allowedToChangeAtStartup
                                                              true); // allowedToChangeAtRuntime
 
+        bool bufBuilderPoolEnabled = false;
+
+        class BufBuilderPoolEnabledSetting : public ExportedServerParameter<bool> {
+        public:
+            BufBuilderPoolEnabledSetting() :
+                ExportedServerParameter<bool>(ServerParameterSet::getGlobal(),
+                                              "bufBuilderPoolEnabled",
+                                              &bufBuilderPoolEnabled,
+                                              true,
+                                              true) {}
+
+            using ExportedServerParameter<bool>::set;
+
+            virtual Status set( const bool& newValue ) {
+                Status status = ExportedServerParameter<bool>::set(newValue);
+                if (status.isOK()) {
+                    BufferPool::setEnabled(newValue);
+                }
+                return status;
+            }
+        } bufBuilderPoolEnabledSetting;
+
+        int bufBuilderPoolMaxBytesPerThread = 16 * 1024 * 1024;
+
+        class BufBuilderPoolMaxBytesPerThreadSetting : public ExportedServerParameter<int> {
+        public:
+            BufBuilderPoolMaxBytesPerThreadSetting() :
+                ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                             "bufBuilderPoolMaxBytesPerThread",
+                                             &bufBuilderPoolMaxBytesPerThread,
+                                             true,
+                                             true) {}
+
+            virtual Status validate( const int& potentialNewValue ) {
+                if (potentialNewValue < 0) {
+                    return Status(ErrorCodes::BadValue,
+                                  "bufBuilderPoolMaxBytesPerThread cannot be negative");
+                }
+                return Status::OK();
+            }
+
+            using ExportedServerParameter<int>::set;
+
+            virtual Status set( const int& newValue ) {
+                Status status = ExportedServerParameter<int>::set(newValue);
+                if (status.isOK()) {
+                    BufferPool::setMaxBytesPerThread(newValue);
+                }
+                return status;
+            }
+        } bufBuilderPoolMaxBytesPerThreadSetting;
+
+        long long bufBuilderPoolMaxBytes = 256 * 1024 * 1024;
+
+        class BufBuilderPoolMaxBytesSetting : public ExportedServerParameter<long long> {
+        public:
+            BufBuilderPoolMaxBytesSetting() :
+                ExportedServerParameter<long long>(ServerParameterSet::getGlobal(),
+                                                   "bufBuilderPoolMaxBytes",
+                                                   &bufBuilderPoolMaxBytes,
+                                                   true,
+                                                   true) {}
+
+            virtual Status validate( const long long& potentialNewValue ) {
+                if (potentialNewValue < 0) {
+                    return Status(ErrorCodes::BadValue,
+                                  "bufBuilderPoolMaxBytes cannot be negative");
+                }
+                return Status::OK();
+            }
+
+            using ExportedServerParameter<long long>::set;
+
+            virtual Status set( const long long& newValue ) {
+                Status status = ExportedServerParameter<long long>::set(newValue);
+                if (status.isOK()) {
+                    BufferPool::setMaxBytes(newValue);
+                }
+                return status;
+            }
+        } bufBuilderPoolMaxBytesSetting;
+
 
     }
 
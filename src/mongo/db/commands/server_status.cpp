@@ -44,7 +44,9 @@
 #include "mongo/db/commands/server_status_internal.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/util/buffer_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/ssl_manager.h"
@@ -204,6 +206,25 @@ namespace mongo {
     
     OpCounterServerStatusSection globalOpCounterServerStatusSection( "opcounters", &globalOpCounters );
 
+    namespace {
+
+        class OpLatencies : public ServerStatusSection {
+        public:
+            OpLatencies() : ServerStatusSection( "opLatencies" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+
+                BSONObjBuilder b;
+                globalOpLatencies.append( &b );
+                return b.obj();
+            }
+
+        } opLatencies;
+
+    } // namespace
+
 
     namespace {
         
@@ -281,6 +302,28 @@ namespace mongo {
                 
         } network;
 
+        class BufferPoolSection : public ServerStatusSection {
+        public:
+            BufferPoolSection() : ServerStatusSection( "bufferPool" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+
+                const BufferPool::Stats stats = BufferPool::getStats();
+
+                BSONObjBuilder b;
+                b.appendBool( "enabled" , BufferPool::isEnabled() );
+                b.append( "acquired" , stats.acquired );
+                b.append( "reused" , stats.reused );
+                b.append( "returned" , stats.returned );
+                b.append( "discarded" , stats.discarded );
+                b.append( "cachedBytes" , stats.cachedBytes );
+                return b.obj();
+            }
+
+        } bufferPoolSection;
+
 #ifdef MONGO_CONFIG_SSL
         class Security : public ServerStatusSection {
         public:
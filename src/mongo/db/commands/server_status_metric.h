@@ -33,6 +33,7 @@
 #include <string>
 
 #include "mongo/db/jsobj.h"
+#include "mongo/db/stats/latency_histogram.h"
 
 namespace mongo {
 
@@ -87,5 +88,23 @@ namespace mongo {
         const T* _t;
     };
 
+    /**
+     * Publishes a LatencyHistogram as a sub-document of the metrics tree.
+     */
+    class LatencyHistogramMetric : public ServerStatusMetric {
+    public:
+        LatencyHistogramMetric( const std::string& name, const LatencyHistogram* histogram )
+            : ServerStatusMetric(name), _histogram(histogram) {
+        }
+
+        virtual void appendAtLeaf( BSONObjBuilder& b ) const {
+            BSONObjBuilder sub( b.subobjStart( _leafName ) );
+            _histogram->append( &sub );
+        }
+
+    private:
+        const LatencyHistogram* _histogram;
+    };
+
 }
 
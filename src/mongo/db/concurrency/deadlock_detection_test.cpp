@@ -188,4 +188,32 @@ namespace mongo {
         writer.unlock(resIdFlush);
     }
 
+    TEST(Deadlock, IntentHolderOnFastPath) {
+        const ResourceId resIdA(RESOURCE_DATABASE, std::string("A"));
+        const ResourceId resIdB(RESOURCE_DATABASE, std::string("B"));
+
+        LockerForTests locker1(MODE_IX);
+        LockerForTests locker2(MODE_IX);
+
+        // Intent locks on databases are granted without being put on the lock head
+        ASSERT_EQUALS(LOCK_OK, locker1.lockBegin(resIdA, MODE_IX));
+        ASSERT_EQUALS(LOCK_OK, locker2.lockBegin(resIdB, MODE_X));
+
+        // 2 -> 1
+        ASSERT_EQUALS(LOCK_WAITING, locker2.lockBegin(resIdA, MODE_X));
+
+        // 1 -> 2, which must make the intent lock on A visible before waiting
+        ASSERT_EQUALS(LOCK_WAITING, locker1.lockBegin(resIdB, MODE_X));
+
+        DeadlockDetector wfg1(*getGlobalLockManager(), &locker1);
+        ASSERT(wfg1.check().hasCycle());
+
+        DeadlockDetector wfg2(*getGlobalLockManager(), &locker2);
+        ASSERT(wfg2.check().hasCycle());
+
+        // Cleanup, so that LockerImpl doesn't complain about leaked locks
+        locker1.unlock(resIdB);
+        locker2.unlock(resIdA);
+    }
+
 } // namespace mongo
@@ -36,6 +36,8 @@
 
 #include "mongo/config.h"
 #include "mongo/db/concurrency/locker.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/compiler.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/stringutils.h"
@@ -135,9 +137,134 @@ namespace {
         (sizeof(LockRequestStatusNames) / sizeof(LockRequestStatusNames[0]))
                                                                 == LockRequest::StatusCount);
 
+    // Number of counter shards per fast path lock. Lockers are spread across the shards by id in
+    // the same way as across the partitions.
+    const unsigned numFastPathShards = 32;
+
 } // namespace
 
 
+    /**
+     * The FastPathLock allows granting the intent modes MODE_IS and MODE_IX on the global and
+     * database resources without taking any mutex. Every operation acquires these resources in
+     * an intent mode, so even the PartitionedLockHead mutexes and hash lookups show up at high
+     * operation rates.
+     *
+     * A granted fast path request is only recorded as an increment of its mode's counter in the
+     * shard of its locker. A conflicting (S or X) request first sets 'blocked', after which new
+     * intent requests fall back to the LockHead, and then treats the modes with non-zero counters
+     * as granted. Since these can only drain, the conflicting request is granted once the last
+     * fast path holder releases and observes 'blocked', which makes it re-evaluate the conflict
+     * queue under the bucket mutex. The increment/check in tryLock and the set/count sequence of
+     * the conflicting request ensure that at least one of the two sides observes the other.
+     *
+     * Fast path holders are not on any LockHead and thus invisible to deadlock detection, so a
+     * holder which is about to wait on another resource while its fast path lock is blocked moves
+     * itself onto the LockHead first (see LockManager::migrateFastPathRequest).
+     *
+     * Each FastPathLock is permanently bound to the first resource which claims it.
+     */
+    struct FastPathLock {
+        FastPathLock() : claimed(0), boundId(0), blocked(0) { }
+
+        /**
+         * Attempts to grant the request without a mutex. Fails if there are conflicting requests
+         * on the resource, in which case the caller must use the LockHead and re-evaluate its
+         * conflict queue, since the request may have been counted as granted in the meantime.
+         */
+        bool tryLock(LockRequest* request, LockMode mode) {
+            AtomicUInt32& count = shardFor(request).counts[mode];
+            count.fetchAndAdd(1);
+
+            if (MONGO_unlikely(blocked.load())) {
+                count.fetchAndSubtract(1);
+                return false;
+            }
+
+            request->lock = NULL;
+            request->partitionedLock = NULL;
+            request->fastPathLock = this;
+            request->recursiveCount = 1;
+            request->status = LockRequest::STATUS_GRANTED;
+            request->partitioned = false;
+            request->mode = mode;
+
+            return true;
+        }
+
+        /**
+         * Attempts to convert a granted request to another intent mode without a mutex. Fails
+         * under the same conditions as tryLock, leaving the request unchanged.
+         */
+        bool tryConvert(LockRequest* request, LockMode newMode) {
+            Shard& shard = shardFor(request);
+            shard.counts[newMode].fetchAndAdd(1);
+
+            if (MONGO_unlikely(blocked.load())) {
+                shard.counts[newMode].fetchAndSubtract(1);
+                return false;
+            }
+
+            // The request still holds newMode, so this cannot unblock any conflicting request
+            shard.counts[request->mode].fetchAndSubtract(1);
+            request->mode = newMode;
+
+            return true;
+        }
+
+        /**
+         * Releases one grant of the specified mode for the request's locker. Returns true if
+         * there may be conflicting requests waiting for it.
+         */
+        bool unlock(LockRequest* request, LockMode mode) {
+            shardFor(request).counts[mode].fetchAndSubtract(1);
+            return blocked.load() != 0;
+        }
+
+        /**
+         * Returns the mask of modes currently granted through this fast path lock.
+         */
+        uint32_t grantedModes() const {
+            uint32_t modes = 0;
+            for (unsigned i = 0; i < numFastPathShards; i++) {
+                if (shards[i].counts[MODE_IS].load()) modes |= modeMask(MODE_IS);
+                if (shards[i].counts[MODE_IX].load()) modes |= modeMask(MODE_IX);
+            }
+
+            return modes;
+        }
+
+        void setBlocked(bool value) {
+            // Only ever written under the bucket mutex of the bound resource, so avoid dirtying
+            // the cache line, which all fast path requests read, if nothing changes.
+            if (blocked.loadRelaxed() != static_cast<uint32_t>(value)) {
+                blocked.store(value);
+            }
+        }
+
+        struct MONGO_COMPILER_ALIGN_TYPE(64) Shard {
+            AtomicUInt32 counts[LockModesCount];
+        };
+
+        Shard& shardFor(const LockRequest* request) {
+            return shards[request->locker->getId() % numFastPathShards];
+        }
+
+        Shard shards[numFastPathShards];
+
+        // Set to 1 by the first resource which binds this lock and never reset
+        AtomicUInt32 claimed;
+
+        // Full hash of the bound resource or zero if not bound yet. Written after 'resourceId'.
+        AtomicUInt64 boundId;
+        ResourceId resourceId;
+
+        // Whether there are requests with non-intent modes on the bound resource's LockHead.
+        // Maintained under the bucket mutex of the bound resource.
+        AtomicUInt32 blocked;
+    };
+
+
     /**
      * There is one of these objects for each resource that has a lock request. Empty objects
      * (i.e. LockHead with no requests) are allowed to exist on the lock manager's hash table.
@@ -166,6 +293,8 @@ namespace {
 
             conversionsCount = 0;
             compatibleFirstCount = 0;
+
+            fastPath = NULL;
         }
 
         /**
@@ -176,6 +305,33 @@ namespace {
             return !partitions.empty();
         }
 
+        /**
+         * Granted modes including these of the requests granted through the fast path.
+         */
+        uint32_t grantedModesWithFastPath() const {
+            return fastPath ? (grantedModes | fastPath->grantedModes()) : grantedModes;
+        }
+
+        /**
+         * Stops intent requests from being granted through the fast path. Must be called before
+         * checking a conflicting mode against grantedModesWithFastPath.
+         */
+        void blockFastPath() {
+            if (fastPath) {
+                fastPath->setBlocked(true);
+            }
+        }
+
+        /**
+         * Re-opens the fast path if there are no more requests with non-intent modes. Must be
+         * called whenever such a request leaves the lock.
+         */
+        void updateFastPathBlocked() {
+            if (fastPath) {
+                fastPath->setBlocked(((grantedModes | conflictModes) & ~intentModes) != 0);
+            }
+        }
+
         /**
          * Locates the request corresponding to the particular locker or returns NULL. Must be
          * called with the bucket holding this lock head locked.
@@ -214,8 +370,11 @@ namespace {
             // indicates if a request was initially partitioned.
 
             // New lock request. Queue after all granted modes and after any already requested
-            // conflicting modes.
-            if (conflicts(mode, grantedModes) ||
+            // conflicting modes. Requests granted through the fast path only hold intent modes,
+            // so they need to be counted only for the non-intent ones.
+            const uint32_t modes =
+                (modeMask(mode) & intentModes) ? grantedModes : grantedModesWithFastPath();
+            if (conflicts(mode, modes) ||
                     (!compatibleFirstCount && conflicts(mode, conflictModes))) {
                 request->status = LockRequest::STATUS_WAITING;
 
@@ -329,6 +488,10 @@ namespace {
         // TODO: Remove this vector and make LockHead a POD
         std::vector<LockManager::Partition *> partitions;
 
+        // The fast path lock bound to this resource, if any. Set by the LockManager whenever it
+        // looks up the lock head for acquiring it.
+        FastPathLock* fastPath;
+
         //
         // Conversion
         //
@@ -433,9 +596,14 @@ namespace {
     // The exact value doesn't appear very important, but should be power of two
     const unsigned LockManager::_numPartitions = 32;
 
+    // There is one global resource and usually only a handful of hot databases. Resources which
+    // don't get a fast path lock use the partitions instead.
+    const unsigned LockManager::_numFastPathLocks = 64;
+
     LockManager::LockManager() {
         _lockBuckets = new LockBucket[_numLockBuckets];
         _partitions = new Partition[_numPartitions];
+        _fastPathLocks = new FastPathLock[_numFastPathLocks];
     }
 
     LockManager::~LockManager() {
@@ -446,8 +614,13 @@ namespace {
             invariant(_lockBuckets[i].data.empty());
         }
 
+        for (unsigned i = 0; i < _numFastPathLocks; i++) {
+            invariant(_fastPathLocks[i].grantedModes() == 0);
+        }
+
         delete[] _lockBuckets;
         delete[] _partitions;
+        delete[] _fastPathLocks;
     }
 
     LockResult LockManager::lock(ResourceId resId, LockRequest* request, LockMode mode) {
@@ -456,6 +629,20 @@ namespace {
 
         request->partitioned = (mode == MODE_IX || mode == MODE_IS);
 
+        // For intent modes on global and database resources, try the fast path first. Requests,
+        // which change the grant policy of the lock must be on the LockHead.
+        bool fastPathBackedOff = false;
+        if (request->partitioned && !request->compatibleFirst) {
+            FastPathLock* fastPath = _getFastPath(resId);
+            if (fastPath) {
+                if (fastPath->tryLock(request, mode)) {
+                    return LOCK_OK;
+                }
+
+                fastPathBackedOff = true;
+            }
+        }
+
         // For intent modes, try the PartitionedLockHead
         if (request->partitioned) {
             Partition* partition = _getPartition(request);
@@ -478,10 +665,29 @@ namespace {
         SimpleMutex::scoped_lock scopedLock(bucket->mutex);
 
         LockHead* lock = bucket->findOrInsert(resId);
+        lock->fastPath = _getFastPath(resId);
+
+        // A conflicting request may have counted the backed off fast path request as granted
+        if (fastPathBackedOff) {
+            _onLockModeChanged(lock, true);
+        }
 
         // Start a partitioned lock if possible
         if (request->partitioned && !(lock->grantedModes & (~intentModes))
             && !lock->conflictModes) {
+            if (!request->compatibleFirst) {
+                FastPathLock* fastPath = _bindFastPath(resId);
+                if (fastPath) {
+                    lock->fastPath = fastPath;
+
+                    // Conflicting requests are serialized on the bucket mutex, so this can only
+                    // fail if the blocked flag has not been cleared yet.
+                    if (fastPath->tryLock(request, mode)) {
+                        return LOCK_OK;
+                    }
+                }
+            }
+
             Partition* partition = _getPartition(request);
             SimpleMutex::scoped_lock scopedLock(partition->mutex);
             PartitionedLockHead* partitionedLock = partition->findOrInsert(resId);
@@ -497,6 +703,11 @@ namespace {
         }
 
         request->partitioned = false;
+
+        if (!(modeMask(mode) & intentModes)) {
+            lock->blockFastPath();
+        }
+
         return lock->newRequest(request, mode);
     }
 
@@ -523,18 +734,39 @@ namespace {
         invariant((LockConflictsTable[request->mode] | LockConflictsTable[newMode]) ==
                                                         LockConflictsTable[newMode]);
 
+        // Intent upgrades of fast path requests (IS -> IX) can stay on the fast path
+        if (request->fastPathLock && (modeMask(newMode) & intentModes)) {
+            if (request->fastPathLock->tryConvert(request, newMode)) {
+                return LOCK_OK;
+            }
+        }
+
         LockBucket* bucket = _getBucket(resId);
         SimpleMutex::scoped_lock scopedLock(bucket->mutex);
 
-        LockBucket::Map::iterator it = bucket->data.find(resId);
-        invariant(it != bucket->data.end());
+        LockHead* lock;
+        if (request->fastPathLock) {
+            // Fast path requests don't need a LockHead to exist
+            lock = bucket->findOrInsert(resId);
+            lock->fastPath = request->fastPathLock;
+            _migrateFastPathRequest(lock, request);
+        }
+        else {
+            LockBucket::Map::iterator it = bucket->data.find(resId);
+            invariant(it != bucket->data.end());
 
-        LockHead* const lock = it->second;
+            lock = it->second;
+            lock->fastPath = _getFastPath(resId);
+        }
 
         if (lock->partitioned()) {
             lock->migratePartitionedLockHeads();
         }
 
+        if (!(modeMask(newMode) & intentModes)) {
+            lock->blockFastPath();
+        }
+
         // Construct granted mask without our current mode, so that it is not counted as
         // conflicting
         uint32_t grantedModesWithoutCurrentRequest = 0;
@@ -550,6 +782,10 @@ namespace {
             }
         }
 
+        if (lock->fastPath) {
+            grantedModesWithoutCurrentRequest |= lock->fastPath->grantedModes();
+        }
+
         // This check favours conversion requests over pending requests. For example:
         //
         // T1 requests lock L in IS
@@ -588,6 +824,14 @@ namespace {
             return false;
         }
 
+        if (request->fastPathLock) {
+            FastPathLock* fastPath = request->fastPathLock;
+            request->fastPathLock = NULL;
+
+            _unlockFastPath(fastPath, request, request->mode);
+            return true;
+        }
+
         if (request->partitioned) {
             // Unlocking a lock that was acquired as partitioned. The lock request may since have
             // moved to the lock head, but there is no safe way to find out without synchronizing
@@ -652,11 +896,12 @@ namespace {
             invariant(false);
         }
 
+        lock->updateFastPathBlocked();
+
         return (request->recursiveCount == 0);
     }
 
     void LockManager::downgrade(LockRequest* request, LockMode newMode) {
-        invariant(request->lock);
         invariant(request->status == LockRequest::STATUS_GRANTED);
         invariant(request->recursiveCount > 0);
 
@@ -665,6 +910,20 @@ namespace {
         invariant((LockConflictsTable[request->mode] | LockConflictsTable[newMode]) 
                                 == LockConflictsTable[request->mode]);
 
+        if (request->fastPathLock) {
+            // Only IX -> IS is possible here. Count the new mode before releasing the old one.
+            FastPathLock* fastPath = request->fastPathLock;
+            const LockMode oldMode = request->mode;
+
+            fastPath->shardFor(request).counts[newMode].fetchAndAdd(1);
+            request->mode = newMode;
+
+            _unlockFastPath(fastPath, request, oldMode);
+            return;
+        }
+
+        invariant(request->lock);
+
         LockHead* lock = request->lock;
 
         LockBucket* bucket = _getBucket(lock->resourceId);
@@ -675,6 +934,24 @@ namespace {
         request->mode = newMode;
 
         _onLockModeChanged(lock, true);
+        lock->updateFastPathBlocked();
+    }
+
+    void LockManager::migrateFastPathRequest(LockRequest* request) {
+        FastPathLock* fastPath = request->fastPathLock;
+
+        // Nothing can be waiting on this request unless its fast path lock is blocked
+        if (!fastPath || !fastPath->blocked.load()) {
+            return;
+        }
+
+        LockBucket* bucket = _getBucket(fastPath->resourceId);
+        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+
+        LockHead* lock = bucket->findOrInsert(fastPath->resourceId);
+        lock->fastPath = fastPath;
+
+        _migrateFastPathRequest(lock, request);
     }
 
     void LockManager::cleanupUnusedLocks() {
@@ -689,7 +966,9 @@ namespace {
                 if (lock->partitioned()) {
                     lock->migratePartitionedLockHeads();
                 }
-                if (lock->grantedModes == 0) {
+                // Requests may be waiting only for fast path holders, in which case there is
+                // nothing granted on the lock itself
+                if (lock->grantedModes == 0 && lock->conflictModes == 0) {
                     invariant(lock->grantedModes == 0);
                     invariant(lock->grantedList._front == NULL);
                     invariant(lock->grantedList._back == NULL);
@@ -711,6 +990,14 @@ namespace {
     }
 
     void LockManager::_onLockModeChanged(LockHead* lock, bool checkConflictQueue) {
+        // Counting the fast path holders touches all their shards, so only do it if there is
+        // anything waiting.
+        uint32_t fastPathModes = 0;
+        if (lock->fastPath &&
+                (lock->conversionsCount > 0 || (checkConflictQueue && !lock->conflictList.empty()))) {
+            fastPathModes = lock->fastPath->grantedModes();
+        }
+
         // Unblock any converting requests (because conversions are still counted as granted and
         // are on the granted queue).
         for (LockRequest* iter = lock->grantedList._front;
@@ -723,7 +1010,7 @@ namespace {
 
                 // Construct granted mask without our current mode, so that it is not accounted as
                 // a conflict
-                uint32_t grantedModesWithoutCurrentRequest = 0;
+                uint32_t grantedModesWithoutCurrentRequest = fastPathModes;
 
                 // We start the counting at 1 below, because LockModesCount also includes
                 // MODE_NONE at position 0, which can never be acquired/granted.
@@ -777,7 +1064,7 @@ namespace {
             // the granted queue.
             iterNext = iter->next;
 
-            if (conflicts(iter->mode, lock->grantedModes)) {
+            if (conflicts(iter->mode, lock->grantedModes | fastPathModes)) {
                 continue;
             }
 
@@ -816,6 +1103,75 @@ namespace {
         return &_partitions[request->locker->getId() % _numPartitions];
     }
 
+    FastPathLock* LockManager::_getFastPath(ResourceId resId) const {
+        const ResourceType resType = resId.getType();
+        if (resType != RESOURCE_GLOBAL && resType != RESOURCE_DATABASE) {
+            return NULL;
+        }
+
+        FastPathLock* fastPath = &_fastPathLocks[resId % _numFastPathLocks];
+        return (fastPath->boundId.load() == resId) ? fastPath : NULL;
+    }
+
+    FastPathLock* LockManager::_bindFastPath(ResourceId resId) {
+        const ResourceType resType = resId.getType();
+        if (resType != RESOURCE_GLOBAL && resType != RESOURCE_DATABASE) {
+            return NULL;
+        }
+
+        FastPathLock* fastPath = &_fastPathLocks[resId % _numFastPathLocks];
+        if (fastPath->boundId.load() == resId) {
+            return fastPath;
+        }
+
+        // Already taken by another resource, which hashes to the same lock
+        if (fastPath->claimed.compareAndSwap(0, 1) != 0) {
+            return NULL;
+        }
+
+        fastPath->resourceId = resId;
+        fastPath->boundId.store(resId);
+
+        return fastPath;
+    }
+
+    void LockManager::_migrateFastPathRequest(LockHead* lock, LockRequest* request) {
+        FastPathLock* fastPath = request->fastPathLock;
+        invariant(fastPath);
+        invariant(request->status == LockRequest::STATUS_GRANTED);
+
+        // Make the request visible on the lock head before it stops being counted, so that it
+        // is never considered released.
+        request->lock = lock;
+        request->fastPathLock = NULL;
+        request->partitioned = false;
+
+        lock->grantedList.push_back(request);
+        lock->incGrantedModeCount(request->mode);
+
+        // The request is still granted, so there is no need to look at the conflict queue
+        fastPath->unlock(request, request->mode);
+    }
+
+    void LockManager::_unlockFastPath(FastPathLock* fastPath,
+                                      LockRequest* request,
+                                      LockMode mode) {
+        if (!fastPath->unlock(request, mode)) {
+            return;
+        }
+
+        // There are conflicting requests, which may be waiting only for this grant to go away
+        LockBucket* bucket = _getBucket(fastPath->resourceId);
+        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+
+        LockBucket::Map::iterator it = bucket->data.find(fastPath->resourceId);
+        if (it != bucket->data.end()) {
+            LockHead* lock = it->second;
+            lock->fastPath = fastPath;
+            _onLockModeChanged(lock, true);
+        }
+    }
+
     void LockManager::dump() const {
         log() << "Dumping LockManager @ " << static_cast<const void*>(this) << '\n';
 
@@ -1121,6 +1477,7 @@ namespace {
         recursiveCount = 0;
 
         lock = NULL;
+        fastPathLock = NULL;
         prev = NULL;
         next = NULL;
         status = STATUS_NEW;
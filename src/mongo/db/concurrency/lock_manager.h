@@ -116,6 +116,17 @@ namespace mongo {
          */
         void cleanupUnusedLocks();
 
+        /**
+         * Requests for intent modes on global and database resources may be granted through
+         * per-locker counters, which are invisible to deadlock detection. If the specified
+         * request was granted this way and a conflicting request is pending on its resource,
+         * this call moves the request onto the resource's LockHead so that it becomes visible.
+         * Otherwise it does nothing.
+         *
+         * Must only be called by the thread which owns the request, before it goes to wait.
+         */
+        void migrateFastPathRequest(LockRequest* request);
+
         /**
          * Dumps the contents of all locks to the log.
          */
@@ -128,6 +139,9 @@ namespace mongo {
         // The lockheads need access to the partitions
         friend struct LockHead;
 
+        // The fast path counters need to look up the lock head when they are drained
+        friend struct FastPathLock;
+
         // These types describe the locks hash table
 
         struct LockBucket {
@@ -162,6 +176,33 @@ namespace mongo {
          */
         Partition* _getPartition(LockRequest* request) const;
 
+        /**
+         * Retrieves the fast path counters bound to the specified resource or NULL if intent
+         * requests for it cannot be granted through the fast path. There is no need to hold a
+         * lock when calling this function.
+         */
+        FastPathLock* _getFastPath(ResourceId resId) const;
+
+        /**
+         * Same as _getFastPath, except binds a free set of counters to the resource if there is
+         * one. Must be called under the resource's bucket mutex and only while the resource is
+         * not held in any mode other than an intent mode and has no conflicts.
+         */
+        FastPathLock* _bindFastPath(ResourceId resId);
+
+        /**
+         * Moves a request granted through the fast path onto the specified lock head, preserving
+         * its mode and recursive count. Must be called under the lock's bucket mutex.
+         */
+        void _migrateFastPathRequest(LockHead* lock, LockRequest* request);
+
+        /**
+         * Releases one reference of a fast path request's mode and, if there are conflicting
+         * requests which could be waiting on it, re-evaluates the resource's conflict queue.
+         * Must not be called with any bucket mutex held.
+         */
+        void _unlockFastPath(FastPathLock* fastPath, LockRequest* request, LockMode mode);
+
         /**
          * Prints the contents of a bucket to the log.
          */
@@ -185,6 +226,11 @@ namespace mongo {
 
         static const unsigned _numPartitions;
         Partition* _partitions;
+
+        // Counters for granting intent modes on global and database resources without taking
+        // any mutex. Each set is permanently bound to the first resource which claims it.
+        static const unsigned _numFastPathLocks;
+        FastPathLock* _fastPathLocks;
     };
 
 
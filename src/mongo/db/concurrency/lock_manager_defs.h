@@ -41,6 +41,7 @@ namespace mongo {
 
     class Locker;
 
+    struct FastPathLock;
     struct LockHead;
     struct PartitionedLockHead;
 
@@ -371,6 +372,12 @@ namespace mongo {
         // only transition from 'partitionedLock' to 'lock', never the other way around.
         PartitionedLockHead* partitionedLock;
 
+        // Pointer to the fast path counters through which this request was granted, or null if
+        // it is on a LockHead or a PartitionedLockHead. Only requests with intent modes on global
+        // and database resources are granted this way. A request can only transition from
+        // 'fastPathLock' to 'lock', never the other way around.
+        FastPathLock* fastPathLock;
+
         // The reason intrusive linked list is used instead of the std::list class is to allow
         // for entries to be removed from the middle of the list in O(1) time, if they are known
         // instead of having to search for them and we cannot persist iterators, because the list
@@ -819,4 +819,76 @@ namespace mongo {
         ASSERT(lockMgr.unlock(&requestX));
     }
 
+    TEST(LockManager, FastPathConflictWaitsForIntentHolders) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_DATABASE, std::string("TestDB"));
+
+        MMAPV1LockerImpl locker1;
+        LockRequestCombo request1(&locker1);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request1, MODE_IX));
+
+        MMAPV1LockerImpl locker2;
+        LockRequestCombo request2(&locker2);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request2, MODE_IS));
+
+        MMAPV1LockerImpl lockerX;
+        LockRequestCombo requestX(&lockerX);
+        ASSERT(LOCK_WAITING == lockMgr.lock(resId, &requestX, MODE_X));
+
+        // While X is pending, intent requests must queue up behind it
+        MMAPV1LockerImpl lockerIS;
+        LockRequestCombo requestIS(&lockerIS);
+        ASSERT(LOCK_WAITING == lockMgr.lock(resId, &requestIS, MODE_IS));
+
+        // X is granted only after the last intent holder goes away
+        ASSERT(lockMgr.unlock(&request1));
+        ASSERT(requestX.numNotifies == 0);
+
+        ASSERT(lockMgr.unlock(&request2));
+        ASSERT(requestX.numNotifies == 1);
+        ASSERT(requestX.lastResult == LOCK_OK);
+        ASSERT(requestIS.numNotifies == 0);
+
+        ASSERT(lockMgr.unlock(&requestX));
+        ASSERT(requestIS.numNotifies == 1);
+        ASSERT(requestIS.lastResult == LOCK_OK);
+        ASSERT(lockMgr.unlock(&requestIS));
+
+        // Without conflicts intent requests are granted right away again
+        LockRequestCombo request3(&locker1);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request3, MODE_IX));
+        ASSERT(lockMgr.unlock(&request3));
+    }
+
+    TEST(LockManager, FastPathConvertWaitsForIntentHolders) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_DATABASE, std::string("TestDB"));
+
+        MMAPV1LockerImpl locker1;
+        LockRequestCombo request1(&locker1);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request1, MODE_IS));
+
+        MMAPV1LockerImpl locker2;
+        LockRequestCombo request2(&locker2);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request2, MODE_IX));
+
+        // Upgrades between intent modes never conflict
+        ASSERT(LOCK_OK == lockMgr.convert(resId, &request1, MODE_IX));
+        ASSERT(request1.mode == MODE_IX);
+        ASSERT(request1.recursiveCount == 2);
+
+        // Upgrading to X has to wait for the other intent holder
+        ASSERT(LOCK_WAITING == lockMgr.convert(resId, &request1, MODE_X));
+        ASSERT(request1.numNotifies == 0);
+
+        ASSERT(lockMgr.unlock(&request2));
+        ASSERT(request1.numNotifies == 1);
+        ASSERT(request1.lastResult == LOCK_OK);
+        ASSERT(request1.mode == MODE_X);
+
+        ASSERT(!lockMgr.unlock(&request1));
+        ASSERT(!lockMgr.unlock(&request1));
+        ASSERT(lockMgr.unlock(&request1));
+    }
+
 } // namespace mongo
@@ -655,6 +655,8 @@ namespace {
             _requestStartTime = curTimeMicros64();
             globalStats.recordWait(_id, resId, mode);
             _stats.recordWait(resId, mode);
+
+            _migrateFastPathRequests();
         }
 
         return result;
@@ -694,6 +696,9 @@ namespace {
 
             if (result == LOCK_OK) break;
 
+            // Intent locks held through the fast path may have become blocked while waiting
+            _migrateFastPathRequests();
+
             if (checkDeadlock) {
                 DeadlockDetector wfg(globalLockManager, this);
                 if (wfg.check().hasCycle()) {
@@ -756,6 +761,18 @@ namespace {
         return false;
     }
 
+    template<bool IsForMMAPV1>
+    void LockerImpl<IsForMMAPV1>::_migrateFastPathRequests() {
+        LockRequestsMap::Iterator it = _requests.begin();
+        while (!it.finished()) {
+            if (it->status == LockRequest::STATUS_GRANTED) {
+                globalLockManager.migrateFastPathRequest(it.objAddr());
+            }
+
+            it.next();
+        }
+    }
+
     template<bool IsForMMAPV1>
     LockMode LockerImpl<IsForMMAPV1>::_getModeForMMAPV1FlushLock() const {
         invariant(IsForMMAPV1);
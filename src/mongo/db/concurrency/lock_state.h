@@ -187,6 +187,12 @@ namespace mongo {
          */
         LockMode _getModeForMMAPV1FlushLock() const;
 
+        /**
+         * Makes the requests, which were granted through the lock manager's fast path and have
+         * conflicts pending, visible to deadlock detection. Called before waiting for a lock.
+         */
+        void _migrateFastPathRequests();
+
 
         // Used to disambiguate different lockers
         const LockerId _id;
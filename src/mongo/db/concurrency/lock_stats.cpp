@@ -137,6 +137,18 @@ namespace mongo {
         }
     }
 
+    template<typename CounterType>
+    int64_t LockStats<CounterType>::getCombinedWaitTimeMicros() const {
+        int64_t total = 0;
+        for (int mode = 1; mode < LockModesCount; mode++) {
+            for (int i = 0; i < ResourceTypesCount; i++) {
+                total += CounterOps::get(_stats[i].modeStats[mode].combinedWaitTimeMicros);
+            }
+            total += CounterOps::get(_oplogStats.modeStats[mode].combinedWaitTimeMicros);
+        }
+        return total;
+    }
+
     template<typename CounterType>
     void LockStats<CounterType>::reset() {
         for (int i = 0; i < ResourceTypesCount; i++) {
@@ -162,6 +162,11 @@ namespace mongo {
         void report(BSONObjBuilder* builder) const;
         void reset();
 
+        /**
+         * Time spent waiting for locks on any resource in any mode, in microseconds.
+         */
+        int64_t getCombinedWaitTimeMicros() const;
+
     private:
         // Necessary for the append call, which accepts argument of type different than our
         // template parameter.
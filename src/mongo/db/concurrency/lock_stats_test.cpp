@@ -80,6 +80,9 @@ namespace mongo {
         ASSERT_EQUALS(1, stats.get(resId, MODE_S).numAcquisitions);
         ASSERT_EQUALS(1, stats.get(resId, MODE_S).numWaits);
         ASSERT_GREATER_THAN(stats.get(resId, MODE_S).combinedWaitTimeMicros, 0);
+
+        ASSERT_GREATER_THAN_OR_EQUALS(stats.getCombinedWaitTimeMicros(),
+                                      stats.get(resId, MODE_S).combinedWaitTimeMicros);
     }
 
     TEST(LockStats, Reporting) {
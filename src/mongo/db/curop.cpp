@@ -32,7 +32,6 @@
 
 #include "mongo/db/curop.h"
 
-#include "mongo/base/counter.h"
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/db/client.h"
@@ -40,9 +39,12 @@
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/json.h"
 #include "mongo/db/service_context.h"
+#include "mongo/db/stats/cpu_sampler.h"
 #include "mongo/db/stats/top.h"
+#include "mongo/util/concurrency/sharded_counter.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/net/message.h"
 
 namespace mongo {
 
@@ -66,6 +68,11 @@ namespace mongo {
          */
         CurOp* top() const { return _top; }
 
+        /**
+         * Returns the Client owning the stack, or NULL before the first operation is pushed.
+         */
+        Client* client() const { return _client; }
+
         /**
          * Adds "curOp" to the top of the CurOp stack for a client. Called by CurOp's constructor.
          */
@@ -140,6 +147,34 @@ namespace mongo {
     MONGO_FP_DECLARE(maxTimeNeverTimeOut);
 
 
+    namespace {
+
+        // Name under which CPU samples of an operation are reported
+        const char* cpuSampleOperationName(const Command* command, int op) {
+            if (command) {
+                return command->name.c_str();
+            }
+
+            switch (op) {
+            case 0:
+            case opReply:
+            case dbMsg:
+            case dbUpdate:
+            case dbInsert:
+            case dbQuery:
+            case dbGetMore:
+            case dbDelete:
+            case dbKillCursors:
+            case dbCommand:
+            case dbCommandReply:
+                return opToString(op);
+            default:
+                return "unknown";
+            }
+        }
+
+    } // namespace
+
     BSONObj CachedBSONObjBase::_tooBig =
                                     fromjson("{\"$msg\":\"query not recording (too large)\"}");
 
@@ -174,6 +209,9 @@ namespace mongo {
     CurOp::CurOp(Client* client, int op) : CurOp(client, &_curopStack(client)) {
         _op = op;
         _active = true;
+        if (_ownsCpuSampleTag()) {
+            _publishCpuSampleTag(StringData());
+        }
     }
 
     void CurOp::_reset() {
@@ -202,6 +240,9 @@ namespace mongo {
     void CurOp::reset(int op) {
         reset();
         _op = op;
+        if (_ownsCpuSampleTag()) {
+            _publishCpuSampleTag(StringData());
+        }
     }
 
     ProgressMeter& CurOp::setMessage(const char * msg,
@@ -225,11 +266,48 @@ namespace mongo {
 
     CurOp::~CurOp() {
         invariant(this == _stack->pop());
+
+        // Samples go back to the operation this one was nested in
+        if (_parent && _parent->_ownsCpuSampleTag()) {
+            if (_parent->_active) {
+                _parent->_publishCpuSampleTag(_parent->_ns.toString());
+            }
+            else {
+                clearCpuSampleOperation();
+            }
+        }
     }
 
     void CurOp::setNS( StringData ns ) {
         // _ns copies the data in the null-terminated ptr it's given
         _ns = ns;
+        if (_ownsCpuSampleTag()) {
+            setCpuSampleNamespace(ns);
+        }
+    }
+
+    void CurOp::done() {
+        _active = false;
+        _end = curTimeMicros64();
+        if (_ownsCpuSampleTag()) {
+            clearCpuSampleOperation();
+        }
+    }
+
+    void CurOp::setCommand(Command* command) {
+        _command = command;
+        if (_ownsCpuSampleTag()) {
+            _publishCpuSampleTag(_ns.toString());
+        }
+    }
+
+    bool CurOp::_ownsCpuSampleTag() const {
+        return _stack->top() == this && haveClient() && _stack->client() == &cc();
+    }
+
+    void CurOp::_publishCpuSampleTag(StringData ns) const {
+        setCpuSampleOperation(_opNum, cpuSampleOperationName(_command, _op));
+        setCpuSampleNamespace(ns);
     }
 
     void CurOp::ensureStarted() {
@@ -248,6 +326,9 @@ namespace mongo {
     void CurOp::enter(const char* ns, int dbProfileLevel) {
         ensureStarted();
         _ns = ns;
+        if (_ownsCpuSampleTag()) {
+            setCpuSampleNamespace(ns);
+        }
         _dbprofile = std::max(dbProfileLevel, _dbprofile);
     }
 
@@ -418,31 +499,42 @@ namespace mongo {
 
     AtomicUInt32 CurOp::_nextOpNum;
 
-    static Counter64 returnedCounter;
-    static Counter64 insertedCounter;
-    static Counter64 updatedCounter;
-    static Counter64 deletedCounter;
-    static Counter64 scannedCounter;
-    static Counter64 scannedObjectCounter;
-
-    static ServerStatusMetricField<Counter64> displayReturned( "document.returned", &returnedCounter );
-    static ServerStatusMetricField<Counter64> displayUpdated( "document.updated", &updatedCounter );
-    static ServerStatusMetricField<Counter64> displayInserted( "document.inserted", &insertedCounter );
-    static ServerStatusMetricField<Counter64> displayDeleted( "document.deleted", &deletedCounter );
-    static ServerStatusMetricField<Counter64> displayScanned( "queryExecutor.scanned", &scannedCounter );
-    static ServerStatusMetricField<Counter64> displayScannedObjects( "queryExecutor.scannedObjects",
-                                                                     &scannedObjectCounter );
-
-    static Counter64 idhackCounter;
-    static Counter64 scanAndOrderCounter;
-    static Counter64 fastmodCounter;
-    static Counter64 writeConflictsCounter;
-
-    static ServerStatusMetricField<Counter64> displayIdhack( "operation.idhack", &idhackCounter );
-    static ServerStatusMetricField<Counter64> displayScanAndOrder( "operation.scanAndOrder", &scanAndOrderCounter );
-    static ServerStatusMetricField<Counter64> displayFastMod( "operation.fastmod", &fastmodCounter );
-    static ServerStatusMetricField<Counter64> displayWriteConflicts( "operation.writeConflicts",
-                                                                     &writeConflictsCounter );
+    // Sharded since every operation bumps several of these.
+    static ShardedCounter64 returnedCounter;
+    static ShardedCounter64 insertedCounter;
+    static ShardedCounter64 updatedCounter;
+    static ShardedCounter64 deletedCounter;
+    static ShardedCounter64 scannedCounter;
+    static ShardedCounter64 scannedObjectCounter;
+
+    static ServerStatusMetricField<ShardedCounter64> displayReturned( "document.returned",
+                                                                      &returnedCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayUpdated( "document.updated",
+                                                                     &updatedCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayInserted( "document.inserted",
+                                                                      &insertedCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayDeleted( "document.deleted",
+                                                                     &deletedCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayScanned( "queryExecutor.scanned",
+                                                                     &scannedCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayScannedObjects(
+                                                                "queryExecutor.scannedObjects",
+                                                                &scannedObjectCounter );
+
+    static ShardedCounter64 idhackCounter;
+    static ShardedCounter64 scanAndOrderCounter;
+    static ShardedCounter64 fastmodCounter;
+    static ShardedCounter64 writeConflictsCounter;
+
+    static ServerStatusMetricField<ShardedCounter64> displayIdhack( "operation.idhack",
+                                                                    &idhackCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayScanAndOrder( "operation.scanAndOrder",
+                                                                          &scanAndOrderCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayFastMod( "operation.fastmod",
+                                                                     &fastmodCounter );
+    static ServerStatusMetricField<ShardedCounter64> displayWriteConflicts(
+                                                                "operation.writeConflicts",
+                                                                &writeConflictsCounter );
 
     void OpDebug::recordStats() {
         if ( nreturned > 0 )
@@ -505,8 +597,29 @@ namespace mongo {
         executionTime = 0;
         nreturned = -1;
         responseLength = -1;
+
+        storageWaitTicks = 0;
+        writeConcernWaitTicks = 0;
     }
 
+    namespace {
+        /**
+         * Appends where an operation's time went, e.g.
+         *     { lockMicros: 12, storageMicros: 250, writeConcernMicros: 0 }
+         */
+        void appendWaitMicros(const OpDebug& debug,
+                              const SingleThreadedLockStats& lockStats,
+                              BSONObjBuilder* builder) {
+            const long long lockMicros = lockStats.getCombinedWaitTimeMicros();
+            const long long storageMicros = CycleClock::toMicros(debug.storageWaitTicks);
+            const long long writeConcernMicros = CycleClock::toMicros(debug.writeConcernWaitTicks);
+
+            builder->appendNumber("lockMicros", lockMicros);
+            builder->appendNumber("storageMicros", storageMicros);
+            builder->appendNumber("writeConcernMicros", writeConcernMicros);
+        }
+    } // namespace
+
 
 #define OPDEBUG_TOSTRING_HELP(x) if( x >= 0 ) s << " " #x ":" << (x)
 #define OPDEBUG_TOSTRING_HELP_BOOL(x) if( x ) s << " " #x ":" << (x)
@@ -591,6 +704,12 @@ namespace mongo {
             s << " locks:" << locks.obj().toString();
         }
 
+        {
+            BSONObjBuilder waits;
+            appendWaitMicros(*this, lockStats, &waits);
+            s << " waits:" << waits.obj().toString();
+        }
+
         s << " " << executionTime << "ms";
 
         return s.str();
@@ -683,6 +802,11 @@ namespace mongo {
             lockStats.report(&locks);
         }
 
+        {
+            BSONObjBuilder waits(b.subobjStart("waits"));
+            appendWaitMicros(*this, lockStats, &waits);
+        }
+
         if (!exceptionInfo.empty()) {
             exceptionInfo.append(b, "exception", "exceptionCode");
         }
@@ -38,6 +38,7 @@
 #include "mongo/db/server_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/cycle_clock.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/thread_safe_string.h"
@@ -189,6 +190,31 @@ namespace mongo {
         int executionTime;
         int nreturned;
         int responseLength;
+
+        // time spent waiting, in CycleClock ticks; lock waits come from the lock stats instead
+        long long storageWaitTicks;      // in storage engine calls
+        long long writeConcernWaitTicks; // for write concern to be satisfied
+    };
+
+    /**
+     * Adds the CycleClock ticks between its construction and destruction to "*waitTicks",
+     * usually one of the wait counters of an OpDebug.  Does nothing if "waitTicks" is NULL.
+     */
+    class ScopedWaitTimer {
+        MONGO_DISALLOW_COPYING(ScopedWaitTimer);
+    public:
+        explicit ScopedWaitTimer(long long* waitTicks)
+            : _waitTicks(waitTicks), _start(CycleClock::now()) { }
+
+        ~ScopedWaitTimer() {
+            if (_waitTicks) {
+                *_waitTicks += CycleClock::now() - _start;
+            }
+        }
+
+    private:
+        long long* const _waitTicks;
+        const int64_t _start;
     };
 
     /* Current operation (for the current Client).
@@ -273,10 +299,7 @@ namespace mongo {
             ensureStarted();
             return _start;
         }
-        void done() {
-            _active = false;
-            _end = curTimeMicros64();
-        }
+        void done();
 
         long long totalTimeMicros() {
             massert( 12601 , "CurOp not marked done yet" , ! _active );
@@ -294,7 +317,7 @@ namespace mongo {
         void setQuery(const BSONObj& query) { _query.set( query ); }
 
         Command * getCommand() const { return _command; }
-        void setCommand(Command* command) { _command = command; }
+        void setCommand(Command* command);
 
         void reportState(BSONObjBuilder* builder);
 
@@ -332,6 +355,17 @@ namespace mongo {
 
         void _reset();
 
+        /**
+         * Whether this is the innermost operation of the client running on the current thread,
+         * which is the one CPU samples taken on the thread are attributed to.
+         */
+        bool _ownsCpuSampleTag() const;
+
+        /**
+         * Attributes the CPU samples taken on the current thread to this operation.
+         */
+        void _publishCpuSampleTag(StringData ns) const;
+
         static AtomicUInt32 _nextOpNum;
         ClientCuropStack* _stack;
         CurOp* _parent = nullptr;
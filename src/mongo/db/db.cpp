@@ -57,6 +57,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/db.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
@@ -88,6 +89,8 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/startup_warnings_mongod.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/cpu_sampler.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage/storage_engine.h"
@@ -100,6 +103,7 @@
 #include "mongo/util/cmdline_utils/censor_cmdline.h"
 #include "mongo/util/concurrency/task.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/cycle_clock.h"
 #include "mongo/util/exception_filter_win32.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
@@ -169,7 +173,15 @@ namespace mongo {
                 assembleResponse(&txn, m, dbresponse, port->remote());
 
                 if ( dbresponse.response ) {
-                    port->reply(m, *dbresponse.response, dbresponse.responseTo);
+                    // The operation was logged and profiled already, so the time spent sending
+                    // the reply is only counted server wide
+                    long long networkWriteTicks = 0;
+                    {
+                        ScopedWaitTimer networkTimer(&networkWriteTicks);
+                        port->reply(m, *dbresponse.response, dbresponse.responseTo);
+                    }
+                    globalOpLatencies.recordReplyWrite(CycleClock::toMicros(networkWriteTicks));
+
                     if( dbresponse.exhaustNS.size() > 0 ) {
                         MsgData::View header = dbresponse.response->header();
                         QueryResult::View qr = header.view2ptr();
@@ -593,6 +605,8 @@ namespace mongo {
 
         startClientCursorMonitor();
 
+        startCpuSampler();
+
         PeriodicTask::startRunningPeriodicTasks();
 
         logStartup();
@@ -32,6 +32,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/filesystem/path.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <time.h>
 
@@ -89,6 +90,7 @@
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/write_concern.h"
@@ -98,6 +100,7 @@
 #include "mongo/s/d_state.h"
 #include "mongo/s/stale_exception.h"  // for SendStaleConfigException
 #include "mongo/scripting/engine.h"
+#include "mongo/util/cycle_clock.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/md5.hpp"
@@ -438,6 +441,102 @@ namespace mongo {
         }
     } cmddiaglogging;
 
+    // Directory traffic traces are written to, the dbpath if empty
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(trafficTraceDirectory, std::string, "");
+
+    /**
+     * Starts or stops recording the messages clients send to this server, for replay with
+     * mongoreplay.
+     *
+     * {trafficTrace: 1, file: <name>} starts a new trace in the trafficTraceDirectory, or the
+     * dbpath if that isn't set.  The name must be a plain file name which doesn't exist yet, a
+     * name is made up if none is given.  {trafficTrace: 0} stops the trace.
+     */
+    class CmdTrafficTrace : public Command {
+    public:
+        CmdTrafficTrace() : Command("trafficTrace") { }
+        virtual bool slaveOk() const {
+            return true;
+        }
+        virtual bool adminOnly() const {
+            return true;
+        }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual void help(stringstream& h) const {
+            h << "record client messages for replay with mongoreplay\n"
+              << "{ trafficTrace : 1, file : <name> } to start, { trafficTrace : 0 } to stop";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::diagLogging);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        bool run(OperationContext* txn,
+                 const string& dbname,
+                 BSONObj& cmdObj,
+                 int,
+                 string& errmsg,
+                 BSONObjBuilder& result) {
+            const string was = _trafficTrace.getPath();
+            if (!was.empty()) {
+                result.append("was", was);
+            }
+
+            if (!cmdObj.firstElement().trueValue()) {
+                _trafficTrace.close();
+                if (!was.empty()) {
+                    const long long dropped = _trafficTrace.getDroppedCount();
+                    log() << "stopped traffic trace " << was << ", dropped " << dropped
+                          << " messages";
+                    result.append("dropped", dropped);
+                }
+                return true;
+            }
+
+            string file;
+            BSONElement fileElt = cmdObj["file"];
+            if (fileElt.eoo()) {
+                stringstream ss;
+                ss << "traffic." << std::hex << time(0);
+                file = ss.str();
+            }
+            else {
+                if (fileElt.type() != String) {
+                    return appendCommandStatus(result,
+                                               Status(ErrorCodes::TypeMismatch,
+                                                      "file must be a string"));
+                }
+                file = fileElt.String();
+            }
+
+            // Traces may only be written to the trace directory
+            if (file.empty() || file == "." || file == ".."
+                    || file.find_first_of("/\\") != string::npos) {
+                return appendCommandStatus(result,
+                                           Status(ErrorCodes::BadValue,
+                                                  str::stream() << "invalid trace file name '"
+                                                                << file << "', must be a plain "
+                                                                << "file name"));
+            }
+
+            const string dir = trafficTraceDirectory.empty() ? storageGlobalParams.dbpath
+                                                             : trafficTraceDirectory;
+            const string path = (boost::filesystem::path(dir) / file).string();
+
+            Status status = _trafficTrace.open(path);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+
+            log() << "recording traffic trace to " << path;
+            result.append("path", path);
+            return true;
+        }
+    } cmdTrafficTrace;
+
     /* drop collection */
     class CmdDrop : public Command {
     public:
@@ -936,6 +1035,13 @@ namespace mongo {
             result.appendNumber("totalIndexSize", indexSize / scale);
             result.append("indexSizes", indexSizes.obj());
 
+            const QueryResultCache* resultCache = collection->infoCache()->getQueryResultCache();
+            if (resultCache->isEnabled()) {
+                BSONObjBuilder resultCacheStats;
+                resultCache->appendStats(&resultCacheStats);
+                result.append("queryResultCache", resultCacheStats.obj());
+            }
+
             return true;
         }
 
@@ -1403,6 +1509,7 @@ namespace {
 
         command->_commandsExecuted.increment();
 
+        const int64_t startTicks = CycleClock::now();
         retval = _execCommand(txn, command, interposedCmd, request, replyBuilder);
 
         dassert(replyBuilder->getState() == rpc::ReplyBuilderInterface::State::kOutputDocs);
@@ -1410,6 +1517,7 @@ namespace {
         if (!retval) {
             command->_commandsFailed.increment();
         }
+        command->_latency.record(CycleClock::toMicros(CycleClock::now() - startTicks));
 
         return;
     }
@@ -0,0 +1,201 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <cstring>
+#include <vector>
+
+#include "mongo/db/dedup/chunking/rabin_chunking.h"
+#include "mongo/db/dedup/chunking/sha1.h"
+#include "mongo/db/dedup/indexing/chunk_index.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/unittest/temp_dir.h"
+
+namespace mongo {
+namespace dedup {
+
+    // Normally defined in dedup_setup.cpp, which also starts the server's dedup engine.  Defining
+    // them here keeps that out of the benchmark.
+    bool verboseDedupLogging = false;
+    bool verboseDedupDebugging = false;
+
+} // namespace dedup
+} // namespace mongo
+
+namespace {
+
+    using boost::scoped_ptr;
+    using mongo::dedup::ChunkHash;
+    using mongo::dedup::ChunkIndex;
+    using mongo::dedup::DiskLoc;
+    using mongo::dedup::MetaData;
+    using mongo::dedup::RabinChunking;
+    using mongo::unittest::Benchmark;
+    using mongo::unittest::TempDir;
+    using mongo::unittest::doNotOptimizeAway;
+
+    // Same parameters as the server's dedup engine.
+    const int64_t kAvgChunkSize = 256;
+    const int64_t kChunkBufferSize = 64 * 1024;
+
+    const int kBlobSize = 16 * 1024;
+
+    std::vector<unsigned char> randomBytes(size_t size, int64_t seed) {
+        mongo::PseudoRandom random(seed);
+        std::vector<unsigned char> bytes(size);
+        for (size_t i = 0; i < size; ++i)
+            bytes[i] = static_cast<unsigned char>(random.nextInt32());
+        return bytes;
+    }
+
+    /**
+     * Computes the index entry of a blob the way PDedup::processBlob does: the sha1 of the whole
+     * blob, and the smallest hashes of its chunks as features.
+     */
+    int sketch(RabinChunking& chunker, std::vector<unsigned char>& blob, ChunkHash* cHash) {
+        std::vector<int64_t> chunkOffset, chunkLen;
+        chunker.rabinChunk(&blob[0], blob.size(), chunkOffset, chunkLen);
+
+        ::sha1(&blob[0], blob.size(), cHash->sha1);
+
+        std::vector<uint64_t> features;
+        for (size_t i = 0; i < chunkOffset.size(); ++i) {
+            features.push_back(
+                mongo::dedup::MurmurHash64A(&blob[0] + chunkOffset[i], chunkLen[i], 0));
+        }
+        std::sort(features.begin(), features.end());
+        features.erase(std::unique(features.begin(), features.end()), features.end());
+
+        const int numFeatures = std::min<int>(features.size(), NUM_FEATURES);
+        for (int i = 0; i < numFeatures; ++i)
+            memcpy(cHash->features[i], &features[i], FEATURE_LENGTH);
+        return numFeatures;
+    }
+
+    class ChunkerFixture : public Benchmark {
+    protected:
+        ChunkerFixture()
+            : chunker(kAvgChunkSize >> 4, kAvgChunkSize << 4, kAvgChunkSize, kChunkBufferSize) {
+        }
+
+        virtual void setUp() {
+            blob = randomBytes(kBlobSize, 1);
+            setBytesPerIteration(kBlobSize);
+        }
+
+        RabinChunking chunker;
+        std::vector<unsigned char> blob;
+    };
+
+    /**
+     * A chunk index sized for the number of iterations.  The index keeps its pages in a file,
+     * which goes into a temporary directory.
+     */
+    class ChunkIndexFixture : public Benchmark {
+    protected:
+        ChunkIndexFixture() : tempDir("dedupBench") {}
+
+        virtual void setUp() {
+            const uint64_t numDocs = std::max(2 * iterations(), 1024LL);
+            index.reset(new ChunkIndex(tempDir.path() + "/flash", numDocs));
+        }
+
+        virtual void tearDown() {
+            index.reset();
+        }
+
+        /**
+         * An entry with random sha1 and features, so it neither duplicates nor resembles others.
+         */
+        static ChunkHash randomHash(mongo::PseudoRandom& random) {
+            ChunkHash cHash;
+            for (int i = 0; i < SHA1_LENGTH; ++i)
+                cHash.sha1[i] = static_cast<unsigned char>(random.nextInt32());
+            for (int f = 0; f < NUM_FEATURES; ++f) {
+                for (int i = 0; i < FEATURE_LENGTH; ++i)
+                    cHash.features[f][i] = static_cast<unsigned char>(random.nextInt32());
+            }
+            return cHash;
+        }
+
+        TempDir tempDir;
+        scoped_ptr<ChunkIndex> index;
+        mongo::dedup::objMap cache;
+    };
+
+    BENCHMARK_F(ChunkerFixture, DedupBench, RabinChunk16KB) {
+        for (long long i = 0; i < iterations(); ++i) {
+            std::vector<int64_t> chunkOffset, chunkLen;
+            chunker.rabinChunk(&blob[0], blob.size(), chunkOffset, chunkLen);
+            doNotOptimizeAway(chunkOffset.size());
+        }
+    }
+
+    BENCHMARK_F(ChunkerFixture, DedupBench, Sketch16KB) {
+        for (long long i = 0; i < iterations(); ++i) {
+            ChunkHash cHash;
+            int numFeatures = sketch(chunker, blob, &cHash);
+            doNotOptimizeAway(numFeatures);
+            doNotOptimizeAway(cHash);
+        }
+    }
+
+    BENCHMARK_F(ChunkIndexFixture, DedupBench, IndexNewBlobs) {
+        mongo::PseudoRandom random(1);
+        std::vector<ChunkHash> hashes;
+        for (long long i = 0; i < iterations(); ++i)
+            hashes.push_back(randomHash(random));
+
+        DiskLoc dLoc("test.bench", mongo::OID::gen());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            MetaData similar;
+            int code = index->index(hashes[i], NUM_FEATURES, dLoc, similar, true, cache);
+            doNotOptimizeAway(code);
+        }
+    }
+
+    BENCHMARK_F(ChunkIndexFixture, DedupBench, IndexDuplicateBlob) {
+        mongo::PseudoRandom random(1);
+        const ChunkHash cHash = randomHash(random);
+        DiskLoc dLoc("test.bench", mongo::OID::gen());
+        MetaData similar;
+        index->index(cHash, NUM_FEATURES, dLoc, similar, true, cache);
+
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            int code = index->index(cHash, NUM_FEATURES, dLoc, similar, false, cache);
+            doNotOptimizeAway(code);
+        }
+    }
+
+} // namespace
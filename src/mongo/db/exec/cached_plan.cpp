@@ -32,6 +32,8 @@
 
 #include "mongo/db/exec/cached_plan.h"
 
+#include <map>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/multi_plan.h"
@@ -49,6 +51,52 @@
 
 namespace mongo {
 
+namespace {
+
+    /**
+     * How many times a plan was worked, and advanced, before a trial period.
+     */
+    struct PlanPrior {
+        PlanPrior() : works(0), advanced(0) { }
+
+        size_t works;
+        size_t advanced;
+    };
+
+    typedef std::map<std::string, PlanPrior> PlanPriorMap;
+
+    /**
+     * Fills 'priors' with how each plan in the cache entry for 'query' fared during the trial
+     * period that created the entry, keyed by the string form of the plan's SolutionCacheData.
+     * The winning plan is also credited with every cached run that provided feedback, plus
+     * 'winnerWorks' and 'winnerAdvanced'. Leaves 'priors' empty if there is no cache entry.
+     */
+    void getPlanPriors(const PlanCache& cache,
+                       const CanonicalQuery& query,
+                       size_t winnerWorks,
+                       size_t winnerAdvanced,
+                       PlanPriorMap* priors) {
+        PlanCacheEntry* rawEntry;
+        if (!cache.getEntry(query, &rawEntry).isOK()) {
+            return;
+        }
+        std::unique_ptr<PlanCacheEntry> entry(rawEntry);
+
+        // Entry's planner data and decision stats are both sorted by score, best first.
+        const std::vector<PlanStageStats*>& decisionStats = entry->decision->stats.vector();
+        for (size_t i = 0; i < entry->plannerData.size() && i < decisionStats.size(); ++i) {
+            PlanPrior& prior = (*priors)[entry->plannerData[i]->toString()];
+            prior.works += decisionStats[i]->common.works;
+            prior.advanced += decisionStats[i]->common.advanced;
+            if (0 == i) {
+                prior.works += entry->feedbackWorks + winnerWorks;
+                prior.advanced += entry->feedbackAdvanced + winnerAdvanced;
+            }
+        }
+    }
+
+} // namespace
+
     // static
     const char* CachedPlanStage::kStageType = "CACHED_PLAN";
 
@@ -198,6 +246,11 @@ namespace mongo {
     }
 
     Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
+        // Remember how the cached plan did during the trial period that is making us replan.
+        const CommonStats* cachedPlanStats = _root->getCommonStats();
+        const size_t cachedPlanWorks = cachedPlanStats->works;
+        const size_t cachedPlanAdvanced = cachedPlanStats->advanced;
+
         // We're going to start over with a new plan. No need for only old buffered results.
         _results.clear();
 
@@ -242,14 +295,25 @@ namespace mongo {
             return Status::OK();
         }
 
+        // Rather than having the new trial period start from scratch, seed it with what the
+        // plan cache has seen of these plans so that it can end as soon as the trial agrees.
+        PlanPriorMap priors;
+        getPlanPriors(*_collection->infoCache()->getPlanCache(),
+                      *_canonicalQuery,
+                      cachedPlanWorks,
+                      cachedPlanAdvanced,
+                      &priors);
+
         // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
         // and so on. The working set will be shared by all candidate plans.
         _root.reset(new MultiPlanStage(_txn, _collection, _canonicalQuery, shouldCache));
         MultiPlanStage* multiPlanStage = static_cast<MultiPlanStage*>(_root.get());
 
         for (size_t ix = 0; ix < solutions.size(); ++ix) {
+            PlanPriorMap::const_iterator prior = priors.end();
             if (solutions[ix]->cacheData.get()) {
                 solutions[ix]->cacheData->indexFilterApplied = _plannerParams.indexFiltersApplied;
+                prior = priors.find(solutions[ix]->cacheData->toString());
             }
 
             PlanStage* nextPlanRoot;
@@ -257,6 +321,10 @@ namespace mongo {
 
             // Takes ownership of 'solutions[ix]' and 'nextPlanRoot'.
             multiPlanStage->addPlan(solutions.releaseAt(ix), nextPlanRoot, _ws);
+
+            if (prior != priors.end()) {
+                multiPlanStage->setPriorForLastPlan(prior->second.works, prior->second.advanced);
+            }
         }
 
         // Delegate to the MultiPlanStage's plan selection facility.
@@ -357,8 +425,10 @@ namespace mongo {
     }
 
     void CachedPlanStage::updatePlanCache() {
+        // The trial period works '_root' directly rather than going through work(), so our own
+        // stats don't reflect it. Report the cached plan's stats instead.
         std::unique_ptr<PlanCacheEntryFeedback> feedback(new PlanCacheEntryFeedback());
-        feedback->stats.reset(getStats());
+        feedback->stats.reset(_root->getStats());
         feedback->score = PlanRanker::scoreTree(feedback->stats.get());
 
         PlanCache* cache = _collection->infoCache()->getPlanCache();
@@ -32,7 +32,6 @@
 
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/exec/collection_scan_common.h"
-#include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
@@ -168,30 +167,34 @@ namespace mongo {
             return PlanStage::NEED_YIELD;
         }
 
-        WorkingSetID id = _workingSet->allocate();
-        WorkingSetMember* member = _workingSet->get(id);
-        member->loc = curr;
-        member->obj = obj;
-        member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-
-        return returnIfMatches(member, id, out);
+        return returnIfMatches(curr, obj, out);
     }
 
-    PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
-                                                          WorkingSetID memberID,
+    PlanStage::StageState CollectionScan::returnIfMatches(const RecordId& loc,
+                                                          const Snapshotted<BSONObj>& obj,
                                                           WorkingSetID* out) {
         ++_specificStats.docsTested;
 
-        if (Filter::passes(member, _filter)) {
-            *out = memberID;
-            ++_commonStats.advanced;
-            return PlanStage::ADVANCED;
-        }
-        else {
-            _workingSet->free(memberID);
+        if (NULL != _filter && !_filter->matchesBSON(obj.value())) {
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
         }
+
+        ++_commonStats.advanced;
+
+        if (_params.countOnly) {
+            *out = WorkingSet::INVALID_ID;
+            return PlanStage::ADVANCED;
+        }
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->loc = loc;
+        member->obj = obj;
+        member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+
+        *out = id;
+        return PlanStage::ADVANCED;
     }
 
     bool CollectionScan::isEOF() {
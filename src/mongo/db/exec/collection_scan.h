@@ -34,6 +34,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/storage/snapshot.h"
 
 namespace mongo {
 
@@ -75,11 +76,14 @@ namespace mongo {
 
     private:
         /**
-         * If the member (with id memberID) passes our filter, set *out to memberID and return that
-         * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
+         * If the record 'obj' at 'loc' passes our filter, place it in a new working set member,
+         * set *out to that member's id and return ADVANCED. Otherwise return NEED_TIME. The filter
+         * is evaluated against the raw record data, so records which do not match never touch the
+         * working set. In count-only mode, matching records don't either: *out is set to
+         * WorkingSet::INVALID_ID.
          */
-        StageState returnIfMatches(WorkingSetMember* member,
-                                   WorkingSetID memberID,
+        StageState returnIfMatches(const RecordId& loc,
+                                   const Snapshotted<BSONObj>& obj,
                                    WorkingSetID* out);
 
         // transactional context for read locks. Not owned by us
@@ -44,7 +44,8 @@ namespace mongo {
                                  start(RecordId()),
                                  direction(FORWARD),
                                  tailable(false),
-                                 maxScan(0) { }
+                                 maxScan(0),
+                                 countOnly(false) { }
 
         // What collection?
         // not owned
@@ -61,6 +62,10 @@ namespace mongo {
 
         // If non-zero, how many documents will we look at?
         size_t maxScan;
+
+        // If true, matching records are reported as ADVANCED with an invalid WorkingSetID rather
+        // than being copied into the working set. Only valid when the parent is a CountStage.
+        bool countOnly;
     };
 
 }  // namespace mongo
@@ -30,6 +30,8 @@
 
 #include "mongo/db/exec/count.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -39,6 +41,58 @@ namespace mongo {
     using std::auto_ptr;
     using std::vector;
 
+    namespace {
+
+        // The ways in which a count's child can produce results, from cheapest to dearest.
+        enum CountMode {
+            kCountModeNone,
+            kCountModeCountScan,
+            kCountModeIndexOnly,
+            kCountModeCollScan,
+            kCountModeFetch,
+        };
+
+        const char* countModeName(CountMode mode) {
+            switch (mode) {
+            case kCountModeCountScan: return "COUNT_SCAN";
+            case kCountModeIndexOnly: return "INDEX_ONLY";
+            case kCountModeCollScan: return "COLLSCAN";
+            case kCountModeFetch: return "FETCH";
+            default: return "";
+            }
+        }
+
+        /**
+         * Classifies the plan rooted at 'stage' by the most expensive way it reads data.
+         */
+        CountMode getCountMode(PlanStage* stage) {
+            switch (stage->stageType()) {
+            case STAGE_COUNT_SCAN:
+                return kCountModeCountScan;
+            case STAGE_IXSCAN:
+                return kCountModeIndexOnly;
+            case STAGE_COLLSCAN:
+                return kCountModeCollScan;
+            case STAGE_FETCH:
+            case STAGE_GEO_NEAR_2D:
+            case STAGE_GEO_NEAR_2DSPHERE:
+            case STAGE_TEXT:
+                // These stages load whole documents regardless of what is beneath them.
+                return kCountModeFetch;
+            default:
+                break;
+            }
+
+            CountMode mode = kCountModeNone;
+            const vector<PlanStage*> children = stage->getChildren();
+            for (size_t i = 0; i < children.size(); ++i) {
+                mode = std::max(mode, getCountMode(children[i]));
+            }
+            return mode;
+        }
+
+    }  // namespace
+
     // static
     const char* CountStage::kStageType = "COUNT";
 
@@ -201,6 +255,12 @@ namespace mongo {
     PlanStageStats* CountStage::getStats() {
         _commonStats.isEOF = isEOF();
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_COUNT));
+        if (_specificStats.trivialCount) {
+            _specificStats.countMode = "TRIVIAL";
+        }
+        else if (_child.get()) {
+            _specificStats.countMode = countModeName(getCountMode(_child.get()));
+        }
         CountStats* countStats = new CountStats(_specificStats);
         ret->specific.reset(countStats);
         if (_child.get()) {
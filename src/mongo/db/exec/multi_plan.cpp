@@ -33,6 +33,7 @@
 #include "mongo/db/exec/multi_plan.h"
 
 #include <algorithm>
+#include <cmath>
 #include <math.h>
 
 #include "mongo/base/owned_pointer_vector.h"
@@ -45,6 +46,7 @@
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/log.h"
@@ -56,6 +58,29 @@ namespace mongo {
     using std::list;
     using std::vector;
 
+namespace {
+
+    // Never end the trial period early before every plan has been worked this many times.
+    const size_t kMinWorksBeforeEarlyCutoff = 20;
+
+    // ln(1 / delta), where delta bounds the chance that a plan's productivity during the trial
+    // is off from its true productivity by more than the margin we allow for it.
+    const double kEarlyCutoffLogInverseConfidence = std::log(100.0);
+
+    // A plan's history from before the trial period counts for at most this many works, so that
+    // the trial itself quickly outweighs history gathered before the data changed.
+    const size_t kMaxPriorWorks = 100;
+
+    /**
+     * Half the width of a Hoeffding confidence interval around a productivity measured over
+     * 'works' works.
+     */
+    double productivityMargin(double works) {
+        return std::sqrt(kEarlyCutoffLogInverseConfidence / (2 * works));
+    }
+
+} // namespace
+
     // static
     const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
@@ -88,6 +113,14 @@ namespace mongo {
         _candidates.push_back(CandidatePlan(solution, root, ws));
     }
 
+    void MultiPlanStage::setPriorForLastPlan(size_t works, size_t advanced) {
+        invariant(!_candidates.empty());
+        invariant(advanced <= works);
+        CandidatePlan& candidate = _candidates.back();
+        candidate.priorWorks = works;
+        candidate.priorAdvanced = advanced;
+    }
+
     bool MultiPlanStage::isEOF() {
         if (_failure) { return true; }
 
@@ -235,6 +268,11 @@ namespace mongo {
         for (size_t ix = 0; ix < numWorks; ++ix) {
             bool moreToDo = workAllPlans(numResults, yieldPolicy);
             if (!moreToDo) { break; }
+
+            if (canEndTrialEarly(numResults)) {
+                LOG(2) << "Ending plan trial period early after " << (ix + 1) << " works";
+                break;
+            }
         }
 
         if (_failure) {
@@ -324,6 +362,82 @@ namespace mongo {
         return candidateStats.release();
     }
 
+    bool MultiPlanStage::canEndTrialEarly(size_t numResults) const {
+        if (!internalQueryPlanEvaluationEarlyCutoff || internalQueryForceIntersectionPlans) {
+            return false;
+        }
+
+        // Find the plan that the ranker would pick on productivity alone if the trial ended now.
+        // A plan with a blocking stage produces nothing until it unblocks, so its productivity
+        // so far says nothing about how it will do; let the trial run its course.
+        int leaderIdx = kNoSuchPlan;
+        double leaderProductivity = -1;
+        for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+            const CandidatePlan& candidate = _candidates[ix];
+            if (candidate.solution->hasBlockingStage) {
+                return false;
+            }
+            if (candidate.failed) {
+                continue;
+            }
+
+            const CommonStats* stats = candidate.root->getCommonStats();
+            if (stats->works < kMinWorksBeforeEarlyCutoff) {
+                return false;
+            }
+
+            const double productivity = static_cast<double>(stats->advanced) / stats->works;
+            if (productivity > leaderProductivity) {
+                leaderIdx = ix;
+                leaderProductivity = productivity;
+            }
+        }
+        if (kNoSuchPlan == leaderIdx) {
+            return false;
+        }
+
+        // The cached plan gets evicted if it later takes internalQueryCacheEvictionRatio times
+        // as many works as we spend here to produce a trial period's worth of results. Keep
+        // trialing at least long enough that the winner won't be evicted for that alone.
+        const CommonStats* leaderStats = _candidates[leaderIdx].root->getCommonStats();
+        if (leaderStats->advanced * internalQueryCacheEvictionRatio <= numResults) {
+            return false;
+        }
+
+        // End the trial if the leader's productivity is ahead of every other plan's even when
+        // each estimate is moved against the leader by its confidence margin. History from before
+        // the trial narrows those margins, but only within the budget of kMaxPriorWorks.
+        double leaderLowerBound = 0;
+        double othersUpperBound = 0;
+        for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+            const CandidatePlan& candidate = _candidates[ix];
+            if (candidate.failed) {
+                continue;
+            }
+            const CommonStats* stats = candidate.root->getCommonStats();
+
+            double works = stats->works;
+            double advanced = stats->advanced;
+            if (candidate.priorWorks > 0) {
+                const size_t priorWorks = std::min(candidate.priorWorks, kMaxPriorWorks);
+                works += priorWorks;
+                advanced += static_cast<double>(priorWorks) * candidate.priorAdvanced
+                                / candidate.priorWorks;
+            }
+
+            const double productivity = advanced / works;
+            const double margin = productivityMargin(works);
+            if (static_cast<int>(ix) == leaderIdx) {
+                leaderLowerBound = productivity - margin;
+            }
+            else {
+                othersUpperBound = std::max(othersUpperBound, productivity + margin);
+            }
+        }
+
+        return leaderLowerBound > othersUpperBound;
+    }
+
     bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy) {
         bool doneWorking = false;
 
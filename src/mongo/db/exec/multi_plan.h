@@ -90,6 +90,13 @@ namespace mongo {
          */
         void addPlan(QuerySolution* solution, PlanStage* root, WorkingSet* sharedWs);
 
+        /**
+         * Tells the trial period that the plan most recently passed to addPlan() has already
+         * advanced 'advanced' times in 'works' calls to work() before this trial, so that the
+         * trial can end sooner if that history agrees with what the trial sees.
+         */
+        void setPriorForLastPlan(size_t works, size_t advanced);
+
         /**
          * Runs all plans added by addPlan, ranks them, and picks a best.
          * All further calls to work(...) will return results from the best plan.
@@ -163,6 +170,14 @@ namespace mongo {
          */
         bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+        /**
+         * Returns true if one candidate is more productive than every other candidate by a large
+         * enough margin, given how many times they have been worked, that further works are
+         * unlikely to change which plan wins. 'numResults' is the number of results which ends
+         * the trial period.
+         */
+        bool canEndTrialEarly(size_t numResults) const;
+
         /**
          * Checks whether we need to perform either a timing-based yield or a yield for a document
          * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
@@ -226,6 +226,8 @@ namespace mongo {
     struct CountStats : public SpecificStats {
         CountStats() : nCounted(0), nSkipped(0), trivialCount(false) { }
 
+        virtual ~CountStats() { }
+
         virtual SpecificStats* clone() const {
             CountStats* specific = new CountStats(*this);
             return specific;
@@ -240,6 +242,11 @@ namespace mongo {
         // A "trivial count" is one that we can answer by calling numRecords() on the
         // collection, without actually going through any query logic.
         bool trivialCount;
+
+        // How the counted results are produced: "TRIVIAL", "COUNT_SCAN" (skipping through index
+        // keys), "INDEX_ONLY" (filtering index keys without a fetch), "COLLSCAN" (filtering raw
+        // records) or "FETCH". Empty if there is nothing beneath the count to describe.
+        std::string countMode;
     };
 
     struct CountScanStats : public SpecificStats {
@@ -525,7 +532,7 @@ namespace mongo {
     };
 
     struct ShardingFilterStats : public SpecificStats {
-        ShardingFilterStats() : chunkSkips(0) { }
+        ShardingFilterStats() : chunkSkips(0), indexRangeOwned(false) { }
 
         virtual SpecificStats* clone() const {
             ShardingFilterStats* specific = new ShardingFilterStats(*this);
@@ -533,6 +540,10 @@ namespace mongo {
         }
 
         size_t chunkSkips;
+
+        // True if the whole index range feeding this stage is owned by the shard, in which case
+        // documents aren't checked individually.
+        bool indexRangeOwned;
     };
 
     struct SkipStats : public SpecificStats {
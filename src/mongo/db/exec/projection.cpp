@@ -83,24 +83,19 @@ namespace mongo {
                 _coveredKeyObj = params.coveredKeyObj;
                 invariant(_coveredKeyObj.isOwned());
 
+                size_t keyIndex = 0;
                 BSONObjIterator kpIt(_coveredKeyObj);
                 while (kpIt.more()) {
                     BSONElement elt = kpIt.next();
-                    unordered_set<StringData, StringData::Hasher>::iterator fieldIt;
-                    fieldIt = _includedFields.find(elt.fieldNameStringData());
-
-                    if (_includedFields.end() == fieldIt) {
-                        // Push an unused value on the back to keep _includeKey and _keyFieldNames
-                        // in sync.
-                        _keyFieldNames.push_back(StringData());
-                        _includeKey.push_back(false);
-                    }
-                    else {
-                        // If we are including this key field store its field name.
-                        _keyFieldNames.push_back(*fieldIt);
-                        _includeKey.push_back(true);
+                    if (_includedFields.count(elt.fieldNameStringData())) {
+                        CoveredField field;
+                        field.keyIndex = keyIndex;
+                        field.fieldName = elt.fieldNameStringData();
+                        _coveredFields.push_back(field);
                     }
+                    ++keyIndex;
                 }
+                _coveredElts.resize(_coveredFields.size());
             }
             else {
                 invariant(ProjectionStageParams::SIMPLE_DOC == params.projImpl);
@@ -157,7 +152,7 @@ namespace mongo {
             return _exec->transform(member);
         }
 
-        BSONObjBuilder bob;
+        BSONObj out;
 
         // Note that even if our fast path analysis is bug-free something that is
         // covered might be invalidated and just be an obj.  In this case we just go
@@ -170,34 +165,63 @@ namespace mongo {
             invariant(member->hasObj());
 
             // Apply the SIMPLE_DOC projection.
+            BSONObjBuilder bob;
             transformSimpleInclusion(member->obj.value(), _includedFields, bob);
+            out = bob.obj();
         }
         else {
             invariant(ProjectionStageParams::COVERED_ONE_INDEX == _projImpl);
             // We're pulling data out of the key.
             invariant(1 == member->keyData.size());
-            size_t keyIndex = 0;
-
-            // Look at every key element...
-            BSONObjIterator keyIterator(member->keyData[0].keyData);
-            while (keyIterator.more()) {
-                BSONElement elt = keyIterator.next();
-                // If we're supposed to include it...
-                if (_includeKey[keyIndex]) {
-                    // Do so.
-                    bob.appendAs(elt, _keyFieldNames[keyIndex]);
-                }
-                ++keyIndex;
-            }
+            out = transformCoveredOneIndex(member->keyData[0].keyData);
         }
 
         member->state = WorkingSetMember::OWNED_OBJ;
         member->keyData.clear();
         member->loc = RecordId();
-        member->obj = Snapshotted<BSONObj>(SnapshotId(), bob.obj());
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), out);
         return Status::OK();
     }
 
+    BSONObj ProjectionStage::transformCoveredOneIndex(const BSONObj& keyData) {
+        // Pick out the included key elements, and add up how big the output will be: the length
+        // and EOO bytes, then a type byte, field name, NUL and value for each element.
+        size_t outSize = sizeof(int) + 1;
+        size_t keyIndex = 0;
+        BSONObjIterator keyIterator(keyData);
+        for (size_t i = 0; i < _coveredFields.size(); ++i) {
+            for (; keyIndex < _coveredFields[i].keyIndex; ++keyIndex) {
+                keyIterator.next();
+            }
+            _coveredElts[i] = keyIterator.next();
+            ++keyIndex;
+
+            outSize += 1 + _coveredFields[i].fieldName.size() + 1 + _coveredElts[i].valuesize();
+        }
+
+        SharedBuffer buffer = SharedBuffer::allocate(outSize);
+        char* cursor = buffer.get();
+
+        DataView(cursor).write(tagLittleEndian(static_cast<int>(outSize)));
+        cursor += sizeof(int);
+
+        for (size_t i = 0; i < _coveredFields.size(); ++i) {
+            const BSONElement& elt = _coveredElts[i];
+            const StringData fieldName = _coveredFields[i].fieldName;
+
+            *cursor++ = elt.type();
+            fieldName.copyTo(cursor, true);
+            cursor += fieldName.size() + 1;
+            memcpy(cursor, elt.value(), elt.valuesize());
+            cursor += elt.valuesize();
+        }
+
+        *cursor++ = EOO;
+        dassert(cursor == buffer.get() + outSize);
+
+        return BSONObj(buffer);
+    }
+
     ProjectionStage::~ProjectionStage() { }
 
     bool ProjectionStage::isEOF() { return _child->isEOF(); }
@@ -124,6 +124,12 @@ namespace mongo {
     private:
         Status transform(WorkingSetMember* member);
 
+        /**
+         * Applies a COVERED_ONE_INDEX projection to the index key 'keyData'. The output is sized
+         * up front and written straight from the key's bytes, with no BSONObjBuilder.
+         */
+        BSONObj transformCoveredOneIndex(const BSONObj& keyData);
+
         boost::scoped_ptr<ProjectionExec> _exec;
 
         // _ws is not owned by us.
@@ -149,12 +155,22 @@ namespace mongo {
         //
         BSONObj _coveredKeyObj;
 
-        // Field names can be empty in 2.4 and before so we can't use them as a sentinel value.
-        // If the i-th entry is true we include the i-th field in the key.
-        std::vector<bool> _includeKey;
+        // A key field that the projection includes.
+        struct CoveredField {
+            // The position of the field in the key.
+            size_t keyIndex;
+
+            // The output field name. Points into _coveredKeyObj.
+            StringData fieldName;
+        };
+
+        // The included key fields in key order, so that a transform only has to walk the key up
+        // to the last one.
+        std::vector<CoveredField> _coveredFields;
 
-        // If the i-th entry of _includeKey is true this is the field name for the i-th key field.
-        std::vector<StringData> _keyFieldNames;
+        // Holds the key elements named by _coveredFields while transforming a key. Reused across
+        // results to avoid an allocation per result.
+        std::vector<BSONElement> _coveredElts;
     };
 
 }  // namespace mongo
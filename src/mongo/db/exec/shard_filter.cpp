@@ -46,8 +46,17 @@ namespace mongo {
 
     ShardFilterStage::ShardFilterStage(const CollectionMetadataPtr& metadata,
                                        WorkingSet* ws,
-                                       PlanStage* child)
-        : _ws(ws), _child(child), _commonStats(kStageType), _metadata(metadata) { }
+                                       PlanStage* child,
+                                       bool childRangeOwned)
+        : _ws(ws),
+          _child(child),
+          _commonStats(kStageType),
+          _metadata(metadata),
+          _shardKeyPattern(metadata ? metadata->getKeyPattern() : BSONObj()),
+          _childRangeOwned(childRangeOwned) {
+
+        _specificStats.indexRangeOwned = childRangeOwned;
+    }
 
     ShardFilterStage::~ShardFilterStage() { }
 
@@ -69,12 +78,11 @@ namespace mongo {
             // If we're sharded make sure that we don't return data that is not owned by us,
             // including pending documents from in-progress migrations and orphaned documents from
             // aborted migrations
-            if (_metadata) {
+            if (_metadata && !_childRangeOwned) {
 
-                ShardKeyPattern shardKeyPattern(_metadata->getKeyPattern());
                 WorkingSetMember* member = _ws->get(*out);
                 WorkingSetMatchableDocument matchable(member);
-                BSONObj shardKey = shardKeyPattern.extractShardKeyFromMatchable(matchable);
+                BSONObj shardKey = _shardKeyPattern.extractShardKeyFromMatchable(matchable);
 
                 if (shardKey.isEmpty()) {
 
@@ -164,4 +172,70 @@ namespace mongo {
         return &_specificStats;
     }
 
+    // static
+    bool ShardFilterStage::indexBoundsOwned(const CollectionMetadataPtr& metadata,
+                                            const BSONObj& keyPattern,
+                                            const IndexBounds& bounds) {
+        if (!metadata) {
+            return false;
+        }
+
+        const BSONObj shardKeyPattern = metadata->getKeyPattern();
+        if (shardKeyPattern.isEmpty() || ShardKeyPattern(shardKeyPattern).isHashedPattern()) {
+            return false;
+        }
+
+        if (bounds.isSimpleRange) {
+            return false;
+        }
+
+        // Every index key has all its shard key values within the smallest and largest values
+        // the intervals of each shard key field allow, so the shard keys of the scanned keys all
+        // lie between the two keys built from those extremes.
+        BSONObjBuilder minKeyBuilder;
+        BSONObjBuilder maxKeyBuilder;
+        bool maxKeyInclusive = true;
+
+        BSONObjIterator indexIt(keyPattern);
+        BSONObjIterator shardKeyIt(shardKeyPattern);
+        size_t fieldIndex = 0;
+        while (shardKeyIt.more()) {
+            if (!indexIt.more() || fieldIndex >= bounds.fields.size()) {
+                return false;
+            }
+
+            const BSONElement shardKeyField = shardKeyIt.next();
+            const BSONElement indexField = indexIt.next();
+            if (!indexField.isNumber()
+                || shardKeyField.fieldNameStringData() != indexField.fieldNameStringData()) {
+                return false;
+            }
+
+            const OrderedIntervalList& oil = bounds.fields[fieldIndex++];
+            if (oil.intervals.empty()) {
+                return false;
+            }
+
+            // Intervals are oriented in the direction the index is traversed.
+            const Interval& first = oil.intervals.front();
+            const Interval& last = oil.intervals.back();
+            if (first.start.woCompare(last.end, false) <= 0) {
+                minKeyBuilder.appendAs(first.start, shardKeyField.fieldName());
+                maxKeyBuilder.appendAs(last.end, shardKeyField.fieldName());
+                maxKeyInclusive = maxKeyInclusive && last.endInclusive;
+            }
+            else {
+                minKeyBuilder.appendAs(last.end, shardKeyField.fieldName());
+                maxKeyBuilder.appendAs(first.start, shardKeyField.fieldName());
+                maxKeyInclusive = maxKeyInclusive && first.startInclusive;
+            }
+        }
+
+        // If any field's upper extreme is excluded, every scanned shard key sorts strictly
+        // before the key built from the upper extremes.
+        return metadata->rangeBelongsToMe(minKeyBuilder.obj(),
+                                          maxKeyBuilder.obj(),
+                                          maxKeyInclusive);
+    }
+
 }  // namespace mongo
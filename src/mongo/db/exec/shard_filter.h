@@ -32,8 +32,10 @@
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
 #include "mongo/s/d_state.h"
+#include "mongo/s/shard_key_pattern.h"
 
 namespace mongo {
 
@@ -74,7 +76,15 @@ namespace mongo {
      */
     class ShardFilterStage : public PlanStage {
     public:
-        ShardFilterStage(const CollectionMetadataPtr& metadata, WorkingSet* ws, PlanStage* child);
+        /**
+         * If 'childRangeOwned' is true, the caller guarantees that every result of 'child' has a
+         * shard key owned according to 'metadata' (see indexBoundsOwned()), and the per-document
+         * ownership checks are skipped.
+         */
+        ShardFilterStage(const CollectionMetadataPtr& metadata,
+                         WorkingSet* ws,
+                         PlanStage* child,
+                         bool childRangeOwned = false);
         virtual ~ShardFilterStage();
 
         virtual bool isEOF();
@@ -96,6 +106,19 @@ namespace mongo {
 
         static const char* kStageType;
 
+        /**
+         * Returns true if every key that an index scan over 'keyPattern' with 'bounds' can produce
+         * maps to a shard key inside a single range owned according to 'metadata'. Documents
+         * reached through such a scan can't be orphans or pending, so a ShardFilterStage above it
+         * doesn't need to look at them.
+         *
+         * Conservatively returns false whenever the shard key isn't a prefix of the index, the
+         * shard key is hashed, or the bounds aren't plain interval lists.
+         */
+        static bool indexBoundsOwned(const CollectionMetadataPtr& metadata,
+                                     const BSONObj& keyPattern,
+                                     const IndexBounds& bounds);
+
     private:
         WorkingSet* _ws;
         boost::scoped_ptr<PlanStage> _child;
@@ -107,6 +130,12 @@ namespace mongo {
         // Note: it is important that this is the metadata from the time this stage is constructed.
         // See class comment for details.
         const CollectionMetadataPtr _metadata;
+
+        // Extracts shard keys from the child's results, parsed once from '_metadata'
+        const ShardKeyPattern _shardKeyPattern;
+
+        // True if all of the child's results are known to be owned, see indexBoundsOwned()
+        const bool _childRangeOwned;
     };
 
 }  // namespace mongo
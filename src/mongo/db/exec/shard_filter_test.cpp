@@ -0,0 +1,438 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+//
+// This file contains tests for mongo/db/exec/shard_filter.cpp
+//
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/shard_filter.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/dbtests/mock/mock_conn_registry.h"
+#include "mongo/dbtests/mock/mock_remote_db_server.h"
+#include "mongo/s/catalog/legacy/catalog_manager_legacy.h"
+#include "mongo/s/catalog/type_chunk.h"
+#include "mongo/s/catalog/type_collection.h"
+#include "mongo/s/chunk_version.h"
+#include "mongo/s/collection_metadata.h"
+#include "mongo/s/metadata_loader.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/hostandport.h"
+
+using namespace mongo;
+
+namespace {
+
+    using boost::scoped_ptr;
+    using std::string;
+    using std::vector;
+
+    const std::string CONFIG_HOST_PORT = "$dummy_config:27017";
+    const std::string kNs = "test.foo";
+    const std::string kThisShard = "shard0000";
+    const std::string kOtherShard = "shard0001";
+
+    BSONObj chunk(const BSONObj& min, const BSONObj& max, const string& shard) {
+        return BSON("min" << min << "max" << max << "shard" << shard);
+    }
+
+    /**
+     * Interval [start, end] of a single index field, with the given inclusivity.
+     */
+    Interval interval(const BSONElement& start,
+                      const BSONElement& end,
+                      bool startInclusive = true,
+                      bool endInclusive = true) {
+        BSONObjBuilder bob;
+        bob.appendAs(start, "");
+        bob.appendAs(end, "");
+        return Interval(bob.obj(), startInclusive, endInclusive);
+    }
+
+    Interval interval(int start, int end, bool startInclusive = true, bool endInclusive = true) {
+        const BSONObj obj = BSON("" << start << "" << end);
+        return Interval(obj, startInclusive, endInclusive);
+    }
+
+    Interval allValues() {
+        BSONObjBuilder bob;
+        bob.appendMinKey("");
+        bob.appendMaxKey("");
+        return Interval(bob.obj(), true, true);
+    }
+
+    OrderedIntervalList oil(const string& name, const vector<Interval>& intervals) {
+        OrderedIntervalList list(name);
+        list.intervals = intervals;
+        return list;
+    }
+
+    OrderedIntervalList oil(const string& name, const Interval& only) {
+        return oil(name, vector<Interval>(1, only));
+    }
+
+    class ShardFilterStageTest : public mongo::unittest::Test {
+    protected:
+        void tearDown() {
+            MockConnRegistry::get()->clear();
+        }
+
+        /**
+         * Loads the metadata of a collection sharded on 'keyPattern' from a mock config server
+         * holding 'chunks', which are documents made by chunk() above, as seen by kThisShard.
+         */
+        CollectionMetadataPtr loadMetadata(const BSONObj& keyPattern,
+                                           const vector<BSONObj>& chunks) {
+            MockConnRegistry::get()->clear();
+            _dummyConfig.reset(new MockRemoteDBServer(CONFIG_HOST_PORT));
+            mongo::ConnectionString::setConnectionHook(MockConnRegistry::get()->getConnStrHook());
+            MockConnRegistry::get()->addServer(_dummyConfig.get());
+
+            OID epoch = OID::gen();
+
+            CollectionType collType;
+            collType.setNs(NamespaceString{kNs});
+            collType.setKeyPattern(keyPattern);
+            collType.setUnique(false);
+            collType.setUpdatedAt(Date_t::fromMillisSinceEpoch(1));
+            collType.setEpoch(epoch);
+            ASSERT_OK(collType.validate());
+            _dummyConfig->insert(CollectionType::ConfigNS, collType.toBSON());
+
+            for (size_t i = 0; i < chunks.size(); i++) {
+                ChunkType chunkType;
+                chunkType.setNS(kNs);
+                chunkType.setShard(chunks[i]["shard"].str());
+                chunkType.setMin(chunks[i]["min"].Obj());
+                chunkType.setMax(chunks[i]["max"].Obj());
+                chunkType.setVersion(ChunkVersion(1, i, epoch));
+                chunkType.setName(OID::gen().toString());
+                _dummyConfig->insert(ChunkType::ConfigNS, chunkType.toBSON());
+            }
+
+            ConnectionString configLoc = ConnectionString(HostAndPort(CONFIG_HOST_PORT));
+            ASSERT(configLoc.isValid());
+            CatalogManagerLegacy catalogManager;
+            catalogManager.init(configLoc);
+
+            CollectionMetadata* metadata = new CollectionMetadata();
+            CollectionMetadataPtr metadataPtr(metadata);
+
+            MetadataLoader loader;
+            ASSERT_OK(loader.makeCollectionMetadata(&catalogManager,
+                                                    kNs,
+                                                    kThisShard,
+                                                    NULL,
+                                                    metadata));
+            return metadataPtr;
+        }
+
+        /**
+         * Shard key {a: 1}. This shard owns [MinKey, 10), [10, 20) and [30, MaxKey), and
+         * [20, 30) belongs to the other shard.
+         */
+        CollectionMetadataPtr loadSingleFieldMetadata() {
+            vector<BSONObj> chunks;
+            chunks.push_back(chunk(BSON("a" << MINKEY), BSON("a" << 10), kThisShard));
+            chunks.push_back(chunk(BSON("a" << 10), BSON("a" << 20), kThisShard));
+            chunks.push_back(chunk(BSON("a" << 20), BSON("a" << 30), kOtherShard));
+            chunks.push_back(chunk(BSON("a" << 30), BSON("a" << MAXKEY), kThisShard));
+            return loadMetadata(BSON("a" << 1), chunks);
+        }
+
+        /**
+         * Index bounds with a single interval on 'a'.
+         */
+        static IndexBounds boundsOnA(const Interval& onA) {
+            IndexBounds bounds;
+            bounds.fields.push_back(oil("a", onA));
+            return bounds;
+        }
+
+    private:
+        scoped_ptr<MockRemoteDBServer> _dummyConfig;
+    };
+
+    TEST_F(ShardFilterStageTest, NoMetadataIsNotOwned) {
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(CollectionMetadataPtr(),
+                                                        BSON("a" << 1),
+                                                        boundsOnA(interval(12, 15))));
+    }
+
+    TEST_F(ShardFilterStageTest, BoundsInsideOneChunk) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+        const BSONObj keyPattern = BSON("a" << 1);
+
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                       keyPattern,
+                                                       boundsOnA(interval(12, 15))));
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                       keyPattern,
+                                                       boundsOnA(interval(10, 10))));
+
+        // The chunk's max is not part of it
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                       keyPattern,
+                                                       boundsOnA(interval(12, 20, true, false))));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        keyPattern,
+                                                        boundsOnA(interval(12, 20))));
+    }
+
+    TEST_F(ShardFilterStageTest, BoundsAcrossAdjacentOwnedChunks) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+
+        BSONObjBuilder bob;
+        bob.appendMinKey("");
+        bob.append("", 15);
+        const BSONObj fromMinKey = bob.obj();
+
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                       BSON("a" << 1),
+                                                       boundsOnA(interval(5, 15))));
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                       BSON("a" << 1),
+                                                       boundsOnA(Interval(fromMinKey,
+                                                                          true,
+                                                                          true))));
+    }
+
+    TEST_F(ShardFilterStageTest, BoundsSpanningUnownedGap) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+        const BSONObj keyPattern = BSON("a" << 1);
+
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        keyPattern,
+                                                        boundsOnA(interval(15, 35))));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        keyPattern,
+                                                        boundsOnA(interval(22, 25))));
+
+        // Each interval is owned, but not what lies between them
+        vector<Interval> intervals;
+        intervals.push_back(interval(5, 6));
+        intervals.push_back(interval(35, 40));
+        IndexBounds bounds;
+        bounds.fields.push_back(oil("a", intervals));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata, keyPattern, bounds));
+
+        // MaxKey itself is past the last chunk
+        const BSONObj from31 = BSON("" << 31);
+        const Interval toMaxKey = interval(from31.firstElement(), allValues().end);
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        keyPattern,
+                                                        boundsOnA(toMaxKey)));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata, keyPattern,
+                                                        boundsOnA(allValues())));
+    }
+
+    TEST_F(ShardFilterStageTest, DescendingIndexBounds) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+        const BSONObj keyPattern = BSON("a" << -1);
+
+        // Intervals of a descending scan go from the high end to the low end
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                       keyPattern,
+                                                       boundsOnA(interval(15, 12))));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        keyPattern,
+                                                        boundsOnA(interval(35, 15))));
+    }
+
+    TEST_F(ShardFilterStageTest, CompoundShardKey) {
+        vector<BSONObj> chunks;
+        chunks.push_back(chunk(BSON("a" << MINKEY << "b" << MINKEY),
+                               BSON("a" << 10 << "b" << MINKEY),
+                               kThisShard));
+        chunks.push_back(chunk(BSON("a" << 10 << "b" << MINKEY),
+                               BSON("a" << MAXKEY << "b" << MAXKEY),
+                               kOtherShard));
+        CollectionMetadataPtr metadata = loadMetadata(BSON("a" << 1 << "b" << 1), chunks);
+
+        const BSONObj keyPattern = BSON("a" << 1 << "b" << 1 << "c" << 1);
+
+        IndexBounds owned;
+        owned.fields.push_back(oil("a", interval(1, 5)));
+        owned.fields.push_back(oil("b", allValues()));
+        owned.fields.push_back(oil("c", interval(7, 7)));
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata, keyPattern, owned));
+
+        // {a: 10, b: <anything but MinKey>} is on the other shard
+        IndexBounds spanning;
+        spanning.fields.push_back(oil("a", interval(5, 10)));
+        spanning.fields.push_back(oil("b", allValues()));
+        spanning.fields.push_back(oil("c", allValues()));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata, keyPattern, spanning));
+
+        // An index on just the first shard key field can't tell where the shard keys fall
+        IndexBounds prefixOnly;
+        prefixOnly.fields.push_back(oil("a", interval(1, 5)));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata, BSON("a" << 1), prefixOnly));
+    }
+
+    TEST_F(ShardFilterStageTest, HashedShardKeyIsNeverOwned) {
+        vector<BSONObj> chunks;
+        chunks.push_back(chunk(BSON("a" << MINKEY), BSON("a" << 0LL), kThisShard));
+        chunks.push_back(chunk(BSON("a" << 0LL), BSON("a" << MAXKEY), kOtherShard));
+        CollectionMetadataPtr metadata = loadMetadata(BSON("a" << "hashed"), chunks);
+
+        IndexBounds bounds;
+        bounds.fields.push_back(oil("a", interval(BSON("" << -100LL).firstElement(),
+                                                  BSON("" << -10LL).firstElement())));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        BSON("a" << "hashed"),
+                                                        bounds));
+    }
+
+    TEST_F(ShardFilterStageTest, NonPrefixIndexIsNotOwned) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+
+        // The shard key is in the index, but not first
+        IndexBounds bounds;
+        bounds.fields.push_back(oil("b", interval(1, 1)));
+        bounds.fields.push_back(oil("a", interval(12, 15)));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        BSON("b" << 1 << "a" << 1),
+                                                        bounds));
+
+        // Simple ranges don't have per-field intervals
+        IndexBounds simpleRange;
+        simpleRange.isSimpleRange = true;
+        simpleRange.startKey = BSON("" << 12);
+        simpleRange.endKey = BSON("" << 15);
+        simpleRange.endKeyInclusive = true;
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata, BSON("a" << 1), simpleRange));
+    }
+
+    TEST_F(ShardFilterStageTest, MultikeyIndexOnOtherFields) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+
+        // Shard key values are never arrays, so only the fields after the shard key can be
+        // multikey, and their bounds don't matter.
+        vector<Interval> tags;
+        tags.push_back(interval(1, 1));
+        tags.push_back(interval(3, 3));
+        IndexBounds bounds;
+        bounds.fields.push_back(oil("a", interval(12, 15)));
+        bounds.fields.push_back(oil("tags", tags));
+        ASSERT_TRUE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                       BSON("a" << 1 << "tags" << 1),
+                                                       bounds));
+
+        bounds.fields[0] = oil("a", interval(15, 25));
+        ASSERT_FALSE(ShardFilterStage::indexBoundsOwned(metadata,
+                                                        BSON("a" << 1 << "tags" << 1),
+                                                        bounds));
+    }
+
+    /**
+     * Runs a ShardFilterStage over documents with the given values of 'a' and returns the
+     * values it lets through.
+     */
+    vector<int> runFilter(const CollectionMetadataPtr& metadata,
+                          const vector<int>& values,
+                          bool childRangeOwned,
+                          ShardingFilterStats* statsOut) {
+        WorkingSet ws;
+        QueuedDataStage* queued = new QueuedDataStage(&ws);
+        for (size_t i = 0; i < values.size(); i++) {
+            WorkingSetMember member;
+            member.state = WorkingSetMember::OWNED_OBJ;
+            member.obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << values[i] << "x" << 1));
+            queued->pushBack(member);
+        }
+
+        ShardFilterStage stage(metadata, &ws, queued, childRangeOwned);
+
+        vector<int> results;
+        while (!stage.isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = stage.work(&id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                results.push_back(ws.get(id)->obj.value()["a"].numberInt());
+                ws.free(id);
+            }
+        }
+
+        *statsOut = *static_cast<const ShardingFilterStats*>(stage.getSpecificStats());
+        return results;
+    }
+
+    TEST_F(ShardFilterStageTest, FiltersOrphansWhenBoundsNotOwned) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+
+        // A scan over [5, 35] crosses the other shard's chunk, so each document is checked
+        const IndexBounds bounds = boundsOnA(interval(5, 35));
+        const bool childRangeOwned =
+            ShardFilterStage::indexBoundsOwned(metadata, BSON("a" << 1), bounds);
+        ASSERT_FALSE(childRangeOwned);
+
+        vector<int> values;
+        values.push_back(5);
+        values.push_back(25);
+        values.push_back(35);
+
+        ShardingFilterStats stats;
+        vector<int> results = runFilter(metadata, values, childRangeOwned, &stats);
+        ASSERT_EQUALS(2U, results.size());
+        ASSERT_EQUALS(5, results[0]);
+        ASSERT_EQUALS(35, results[1]);
+        ASSERT_EQUALS(1U, stats.chunkSkips);
+        ASSERT_FALSE(stats.indexRangeOwned);
+    }
+
+    TEST_F(ShardFilterStageTest, SkipsChecksWhenBoundsOwned) {
+        CollectionMetadataPtr metadata = loadSingleFieldMetadata();
+
+        const IndexBounds bounds = boundsOnA(interval(12, 15));
+        const bool childRangeOwned =
+            ShardFilterStage::indexBoundsOwned(metadata, BSON("a" << 1), bounds);
+        ASSERT_TRUE(childRangeOwned);
+
+        vector<int> values;
+        values.push_back(12);
+        values.push_back(15);
+
+        ShardingFilterStats stats;
+        vector<int> results = runFilter(metadata, values, childRangeOwned, &stats);
+        ASSERT_EQUALS(2U, results.size());
+        ASSERT_EQUALS(0U, stats.chunkSkips);
+        ASSERT_TRUE(stats.indexRangeOwned);
+    }
+
+}  // namespace
@@ -462,73 +462,102 @@ namespace mongo {
         // If asked to return new doc, default to the oldObj, in case nothing changes.
         BSONObj newObj = oldObj.value();
 
-        // Ask the driver to apply the mods. It may be that the driver can apply those "in
-        // place", that is, some values of the old document just get adjusted without any
-        // change to the binary layout on the bson layer. It may be that a whole new document
-        // is needed to accomodate the new bson layout of the resulting document. In any event,
-        // only enable in-place mutations if the underlying storage engine offers support for
-        // writing damage events.
-        _doc.reset(oldObj.value(),
-                   (_collection->updateWithDamagesSupported() ?
-                    mutablebson::Document::kInPlaceEnabled :
-                    mutablebson::Document::kInPlaceDisabled));
-
         BSONObj logObj;
 
         FieldRefSet updatedFields;
         bool docWasModified = false;
 
-        Status status = Status::OK();
-        if (!driver->needMatchDetails()) {
-            // If we don't need match details, avoid doing the rematch
-            status = driver->update(StringData(), &_doc, &logObj, &updatedFields, &docWasModified);
+        const char* source = NULL;
+        bool inPlace = false;
+
+        // Updates made only of top-level $set, $inc and $unset over fields which are not
+        // indexed are first offered to the driver, which splices them into a copy of the
+        // document without building the mutable one. It also describes the change as damages
+        // when the storage engine can write them and the layout of the document is kept.
+        BSONObj simpleObj;
+        bool usedSimplePlan = false;
+        _damages.clear();
+        if (driver->hasSimplePlan()) {
+            usedSimplePlan = driver->updateSimple(
+                    oldObj.value(),
+                    lifecycle ? lifecycle->getImmutableFields() : NULL,
+                    &simpleObj,
+                    &logObj,
+                    &docWasModified,
+                    _collection->updateWithDamagesSupported() ? &_damages : NULL);
+        }
+
+        if (usedSimplePlan) {
+            inPlace = !_damages.empty();
+            source = simpleObj.objdata();
         }
         else {
-            // If there was a matched field, obtain it.
-            MatchDetails matchDetails;
-            matchDetails.requestElemMatchKey();
+            // Ask the driver to apply the mods. It may be that the driver can apply those "in
+            // place", that is, some values of the old document just get adjusted without any
+            // change to the binary layout on the bson layer. It may be that a whole new
+            // document is needed to accomodate the new bson layout of the resulting document.
+            // In any event, only enable in-place mutations if the underlying storage engine
+            // offers support for writing damage events.
+            _doc.reset(oldObj.value(),
+                       (_collection->updateWithDamagesSupported() ?
+                        mutablebson::Document::kInPlaceEnabled :
+                        mutablebson::Document::kInPlaceDisabled));
+
+            Status status = Status::OK();
+            if (!driver->needMatchDetails()) {
+                // If we don't need match details, avoid doing the rematch
+                status = driver->update(StringData(), &_doc, &logObj, &updatedFields,
+                                        &docWasModified);
+            }
+            else {
+                // If there was a matched field, obtain it.
+                MatchDetails matchDetails;
+                matchDetails.requestElemMatchKey();
 
-            dassert(cq);
-            verify(cq->root()->matchesBSON(oldObj.value(), &matchDetails));
+                dassert(cq);
+                verify(cq->root()->matchesBSON(oldObj.value(), &matchDetails));
 
-            string matchedField;
-            if (matchDetails.hasElemMatchKey())
-                matchedField = matchDetails.elemMatchKey();
+                string matchedField;
+                if (matchDetails.hasElemMatchKey())
+                    matchedField = matchDetails.elemMatchKey();
 
-            // TODO: Right now, each mod checks in 'prepare' that if it needs positional
-            // data, that a non-empty StringData() was provided. In principle, we could do
-            // that check here in an else clause to the above conditional and remove the
-            // checks from the mods.
+                // TODO: Right now, each mod checks in 'prepare' that if it needs positional
+                // data, that a non-empty StringData() was provided. In principle, we could do
+                // that check here in an else clause to the above conditional and remove the
+                // checks from the mods.
 
-            status = driver->update(matchedField, &_doc, &logObj, &updatedFields, &docWasModified);
-        }
+                status = driver->update(matchedField, &_doc, &logObj, &updatedFields,
+                                        &docWasModified);
+            }
 
-        if (!status.isOK()) {
-            uasserted(16837, status.reason());
-        }
+            if (!status.isOK()) {
+                uasserted(16837, status.reason());
+            }
 
-        // Ensure _id exists and is first
-        uassertStatusOK(ensureIdAndFirst(_doc));
+            // Ensure _id exists and is first
+            uassertStatusOK(ensureIdAndFirst(_doc));
 
-        // See if the changes were applied in place
-        const char* source = NULL;
-        const bool inPlace = _doc.getInPlaceUpdates(&_damages, &source);
+            // See if the changes were applied in place
+            inPlace = _doc.getInPlaceUpdates(&_damages, &source);
 
-        if (inPlace && _damages.empty()) {
-            // An interesting edge case. A modifier didn't notice that it was really a no-op
-            // during its 'prepare' phase. That represents a missed optimization, but we still
-            // shouldn't do any real work. Toggle 'docWasModified' to 'false'.
-            //
-            // Currently, an example of this is '{ $pushAll : { x : [] } }' when the 'x' array
-            // exists.
-            docWasModified = false;
+            if (inPlace && _damages.empty()) {
+                // An interesting edge case. A modifier didn't notice that it was really a
+                // no-op during its 'prepare' phase. That represents a missed optimization, but
+                // we still shouldn't do any real work. Toggle 'docWasModified' to 'false'.
+                //
+                // Currently, an example of this is '{ $pushAll : { x : [] } }' when the 'x'
+                // array exists.
+                docWasModified = false;
+            }
         }
 
         if (docWasModified) {
 
-            // Verify that no immutable fields were changed and data is valid for storage.
+            // Verify that no immutable fields were changed and data is valid for storage. The
+            // driver only takes the simple path for updates where neither can go wrong.
 
-            if (!(!_txn->writesAreReplicated() || request->isFromMigration())) {
+            if (!usedSimplePlan &&
+                !(!_txn->writesAreReplicated() || request->isFromMigration())) {
                 const std::vector<FieldRef*>* immutableFields = NULL;
                 if (lifecycle)
                     immutableFields = lifecycle->getImmutableFields();
@@ -550,20 +579,23 @@ namespace mongo {
                 // Don't actually do the write if this is an explain.
                 if (!request->isExplain()) {
                     invariant(_collection);
-                    newObj = oldObj.value();
                     const RecordData oldRec(oldObj.value().objdata(), oldObj.value().objsize());
-                    BSONObj idQuery = driver->makeOplogEntryQuery(newObj, request->isMulti());
+                    BSONObj idQuery = driver->makeOplogEntryQuery(oldObj.value(),
+                                                                  request->isMulti());
                     oplogUpdateEntryArgs args;
                     args.update = logObj;
                     args.criteria = idQuery;
                     args.fromMigrate = request->isFromMigration();
-                    _collection->updateDocumentWithDamages(
+                    // The record store may write the damages to a copy of the old record
+                    // rather than in place, so take the new document from what it returns.
+                    StatusWith<RecordData> newRec = _collection->updateDocumentWithDamages(
                             _txn,
                             loc,
                             Snapshotted<RecordData>(oldObj.snapshotId(), oldRec),
                             source,
                             _damages,
                             args);
+                    newObj = uassertStatusOK(std::move(newRec)).releaseToBson();
                 }
 
                 _specificStats.fastmod = true;
@@ -572,7 +604,7 @@ namespace mongo {
             else {
                 // The updates were not in place. Apply them through the file manager.
 
-                newObj = _doc.getObject();
+                newObj = usedSimplePlan ? simpleObj : _doc.getObject();
                 uassert(17419,
                         str::stream() << "Resulting document after update is larger than "
                         << BSONObjMaxUserSize,
@@ -26,6 +26,7 @@
 *    it in the license file.
 */
 
+#include "mongo/bson/bson_field_lookup.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/index/btree_key_generator.h"
 #include "mongo/util/mongoutils/str.h"
@@ -222,11 +223,13 @@ namespace {
     }
 
     BSONElement BtreeKeyGeneratorV1::extractNextElement(const BSONObj &obj,
+                                                        BSONFieldLookup* objFields,
                                                         const PositionalPathInfo& positionalInfo,
                                                         const char** field,
                                                         bool* arrayNestedArray) const {
         std::string firstField = mongoutils::str::before(*field, '.');
-        bool haveObjField = !obj.getField(firstField).eoo();
+        bool haveObjField = objFields ? objFields->hasField(firstField) :
+                                        !obj.getField(firstField).eoo();
         BSONElement arrField = positionalInfo.positionallyIndexedElt;
 
         // An index component field name cannot exist in both a document
@@ -240,7 +243,8 @@ namespace {
 
         *arrayNestedArray = false;
         if ( haveObjField ) {
-            return obj.getFieldDottedOrArray(*field);
+            return objFields ? objFields->getFieldDottedOrArray(*field) :
+                               obj.getFieldDottedOrArray(*field);
         }
         else if (positionalInfo.hasPositionallyIndexedElt()) {
             if ( arrField.type() == Array ) {
@@ -274,6 +278,7 @@ namespace {
         getKeysImplWithArray(*fieldNames,
                              *fixed,
                              arrEntry.type() == Object ? arrEntry.embeddedObject() : BSONObj(),
+                             NULL,
                              keys,
                              numNotFound,
                              positionalInfo);
@@ -283,13 +288,23 @@ namespace {
                                           std::vector<BSONElement> fixed,
                                           const BSONObj& obj,
                                           BSONObjSet* keys) const {
-        getKeysImplWithArray(fieldNames, fixed, obj, keys, 0, _emptyPositionalInfo);
+        // Each field of a compound key pattern is looked up in the document at least twice, so
+        // index the document's top-level fields as they are walked past rather than rescanning
+        // it from the start for every lookup.
+        if (fieldNames.size() > 1) {
+            BSONFieldLookup objFields(obj);
+            getKeysImplWithArray(fieldNames, fixed, obj, &objFields, keys, 0,
+                                 _emptyPositionalInfo);
+            return;
+        }
+        getKeysImplWithArray(fieldNames, fixed, obj, NULL, keys, 0, _emptyPositionalInfo);
     }
 
     void BtreeKeyGeneratorV1::getKeysImplWithArray(
             std::vector<const char*> fieldNames,
             std::vector<BSONElement> fixed,
             const BSONObj& obj,
+            BSONFieldLookup* objFields,
             BSONObjSet* keys,
             unsigned numNotFound,
             const std::vector<PositionalPathInfo>& positionalInfo) const {
@@ -304,6 +319,7 @@ namespace {
             bool arrayNestedArray;
             // Extract element matching fieldName[ i ] from object xor array.
             BSONElement e = extractNextElement(obj,
+                                               objFields,
                                                positionalInfo[i],
                                                &fieldNames[i],
                                                &arrayNestedArray);
@@ -34,6 +34,8 @@
 
 namespace mongo {
 
+    class BSONFieldLookup;
+
     /**
      * Internal class used by BtreeAccessMethod to generate keys for indexed documents.
      * This class is meant to be kept under the index access layer.
@@ -160,16 +162,21 @@ namespace mongo {
 
         /**
          * This recursive method does the heavy-lifting for getKeysImpl().
+         *
+         * If 'objFields' is non-NULL, it is a BSONFieldLookup over 'obj' which is used for
+         * looking up the top-level fields of 'obj'.
          */
         void getKeysImplWithArray(std::vector<const char*> fieldNames,
                                   std::vector<BSONElement> fixed,
                                   const BSONObj& obj,
+                                  BSONFieldLookup* objFields,
                                   BSONObjSet* keys,
                                   unsigned numNotFound,
                                   const std::vector<PositionalPathInfo>& positionalInfo) const;
         /**
          * A call to getKeysImplWithArray() begins by calling this for each field in the key
-         * pattern. It uses getFieldDottedOrArray() to traverse the path '*field' in 'obj'.
+         * pattern. It uses getFieldDottedOrArray() to traverse the path '*field' in 'obj', going
+         * through 'objFields' if it is non-NULL.
          *
          * The 'positionalInfo' arg is used for handling a field path where 'obj' has an
          * array indexed by position. See the comments for PositionalPathInfo for more detail.
@@ -200,6 +207,7 @@ namespace mongo {
          *   the second array element.
          */
         BSONElement extractNextElement(const BSONObj& obj,
+                                       BSONFieldLookup* objFields,
                                        const PositionalPathInfo& positionalInfo,
                                        const char** field,
                                        bool* arrayNestedArray) const;
@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/index/btree_key_generator.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/db/json.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using boost::scoped_ptr;
+    using mongo::BSONElement;
+    using mongo::BSONObj;
+    using mongo::BSONObjIterator;
+    using mongo::BSONObjSet;
+    using mongo::BtreeKeyGenerator;
+    using mongo::BtreeKeyGeneratorV1;
+    using mongo::fromjson;
+    using mongo::unittest::Benchmark;
+    using mongo::unittest::doNotOptimizeAway;
+
+    /**
+     * Generates the keys of "doc" for the index "keyPattern" on every iteration.
+     */
+    class KeyGenFixture : public Benchmark {
+    protected:
+        void generateAll(const char* keyPatternJson, const char* docJson) {
+            keyPattern = fromjson(keyPatternJson);
+            doc = fromjson(docJson);
+
+            std::vector<const char*> fieldNames;
+            std::vector<BSONElement> fixed;
+            for (BSONObjIterator it(keyPattern); it.more();) {
+                fieldNames.push_back(it.next().fieldName());
+                fixed.push_back(BSONElement());
+            }
+            scoped_ptr<BtreeKeyGenerator> keyGen(new BtreeKeyGeneratorV1(fieldNames, fixed,
+                                                                         false));
+
+            resetTiming();
+            for (long long i = 0; i < iterations(); ++i) {
+                BSONObjSet keys;
+                keyGen->getKeys(doc, &keys);
+                doNotOptimizeAway(keys);
+            }
+        }
+
+        BSONObj keyPattern;
+        BSONObj doc;
+    };
+
+    BENCHMARK_F(KeyGenFixture, BtreeKeyGeneratorBench, SingleField) {
+        generateAll("{a: 1}", "{_id: 1, a: 5, b: 'some string', c: {d: 1}}");
+    }
+
+    BENCHMARK_F(KeyGenFixture, BtreeKeyGeneratorBench, Compound) {
+        generateAll("{a: 1, b: 1, c: 1}", "{_id: 1, a: 5, b: 'some string', c: 3.5}");
+    }
+
+    BENCHMARK_F(KeyGenFixture, BtreeKeyGeneratorBench, CompoundOnWideDocument) {
+        mongo::str::stream doc;
+        doc << "{_id: 1";
+        for (int i = 0; i < 200; ++i) {
+            doc << ", field_" << i << ": " << i;
+        }
+        doc << "}";
+        generateAll("{field_150: 1, field_100: 1, field_199: 1}", std::string(doc).c_str());
+    }
+
+    BENCHMARK_F(KeyGenFixture, BtreeKeyGeneratorBench, Dotted) {
+        generateAll("{'a.b.c': 1}", "{_id: 1, a: {x: 1, b: {y: 2, c: 'value'}}}");
+    }
+
+    BENCHMARK_F(KeyGenFixture, BtreeKeyGeneratorBench, MissingField) {
+        generateAll("{z: 1}", "{_id: 1, a: 5, b: 'some string', c: {d: 1}}");
+    }
+
+    BENCHMARK_F(KeyGenFixture, BtreeKeyGeneratorBench, ArrayOf10) {
+        generateAll("{a: 1}", "{_id: 1, a: [0, 1, 2, 3, 4, 5, 6, 7, 8, 9]}");
+    }
+
+    BENCHMARK_F(KeyGenFixture, BtreeKeyGeneratorBench, ArrayOfSubdocuments) {
+        generateAll("{'a.b': 1, c: 1}",
+                    "{_id: 1, a: [{b: 1}, {b: 2}, {b: 3}, {b: 4}, {b: 5}], c: 'x'}");
+    }
+
+} // namespace
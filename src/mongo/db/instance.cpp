@@ -84,6 +84,7 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/platform/atomic_word.h"
@@ -452,6 +453,10 @@ namespace {
 
         Client& c = *txn->getClient();
         if (!c.isInDirectClient()) {
+            if (_trafficTrace.isOpen()) {
+                _trafficTrace.append(c.getConnectionId(), curTimeMicros64(), m);
+            }
+
             LastError::get(c).startRequest();
             AuthorizationSession::get(c)->startRequest(txn);
 
@@ -642,10 +647,15 @@ namespace {
                 shouldLog = true;
             }
         }
+
         currentOp.ensureStarted();
         currentOp.done();
         debug.executionTime = currentOp.totalTimeMillis();
 
+        if (!c.isInDirectClient()) {
+            globalOpLatencies.record(op, isCommand, currentOp.totalTimeMicros());
+        }
+
         logThreshold += currentOp.getExpectedLatencyMs();
 
         if ( shouldLog || debug.executionTime > logThreshold ) {
@@ -926,6 +936,7 @@ namespace {
         int pass = 0;
         bool exhaust = false;
         QueryResult::View msgdata = 0;
+        int msgdataCapacity = 0;
         Timestamp last;
         while( 1 ) {
             bool isCursorAuthorized = false;
@@ -958,7 +969,8 @@ namespace {
                                   curop,
                                   pass,
                                   exhaust,
-                                  &isCursorAuthorized);
+                                  &isCursorAuthorized,
+                                  &msgdataCapacity);
             }
             catch ( AssertionException& e ) {
                 if ( isCursorAuthorized ) {
@@ -1246,7 +1258,7 @@ namespace {
         
         // no ResultFlag_Dedup in resultFlags
         else {
-            resp->setData(msgdata.view2ptr(), true);
+            resp->setPooledData(msgdata.view2ptr(), msgdataCapacity);
         }
 
         curop.debug().nreturned = msgdata.getNReturned();
@@ -1773,4 +1785,6 @@ namespace {
 
     // ----- END Diaglog -----
 
+    MessageTraceWriter _trafficTrace;
+
 } // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/util/net/message_trace.h"
 
 namespace mongo {
 
@@ -67,6 +68,9 @@ namespace mongo {
 
     extern DiagLog _diaglog;
 
+    /** inbound messages of client connections, for replay with mongoreplay */
+    extern MessageTraceWriter _trafficTrace;
+
     void assembleResponse( OperationContext* txn,
                            Message& m,
                            DbResponse& dbresponse,
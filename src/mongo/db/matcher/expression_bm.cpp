@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/expression_parser.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/assert_util.h"
+
+namespace {
+
+    using boost::scoped_ptr;
+    using mongo::BSONObj;
+    using mongo::MatchExpression;
+    using mongo::MatchExpressionParser;
+    using mongo::StatusWithMatchExpression;
+    using mongo::fromjson;
+    using mongo::unittest::Benchmark;
+    using mongo::unittest::doNotOptimizeAway;
+
+    const char* kDocument =
+        "{_id: 1, a: 5, b: 'some string', c: {d: 10, e: 'x'}, "
+        " tags: ['red', 'green', 'blue'], "
+        " items: [{sku: 'a', qty: 1}, {sku: 'b', qty: 5}, {sku: 'c', qty: 10}]}";
+
+    MatchExpression* parse(const BSONObj& query) {
+        StatusWithMatchExpression result = MatchExpressionParser::parse(query);
+        mongo::uassertStatusOK(result.getStatus());
+        return result.getValue();
+    }
+
+    /**
+     * Parses "queryJson" once and matches it against kDocument on every iteration.
+     */
+    class MatchFixture : public Benchmark {
+    protected:
+        void matchAll(const char* queryJson, bool expected) {
+            query = fromjson(queryJson);
+            doc = fromjson(kDocument);
+            scoped_ptr<MatchExpression> expr(parse(query));
+            invariant(expr->matchesBSON(doc) == expected);
+
+            resetTiming();
+            for (long long i = 0; i < iterations(); ++i) {
+                bool matched = expr->matchesBSON(doc);
+                doNotOptimizeAway(matched);
+            }
+        }
+
+        BSONObj query;
+        BSONObj doc;
+    };
+
+    BENCHMARK(MatchExpressionBench, ParseEquality) {
+        BSONObj query = fromjson("{a: 5}");
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            scoped_ptr<MatchExpression> expr(parse(query));
+            doNotOptimizeAway(expr.get());
+        }
+    }
+
+    BENCHMARK(MatchExpressionBench, ParseComplex) {
+        BSONObj query = fromjson(
+            "{a: {$gt: 1, $lt: 10}, b: {$in: ['x', 'y', 'some string']}, "
+            " $or: [{'c.d': 10}, {tags: 'red'}], items: {$elemMatch: {sku: 'b', qty: {$gt: 2}}}}");
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            scoped_ptr<MatchExpression> expr(parse(query));
+            doNotOptimizeAway(expr.get());
+        }
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchEquality) {
+        matchAll("{a: 5}", true);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchEqualityNoMatch) {
+        matchAll("{a: 6}", false);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchRange) {
+        matchAll("{a: {$gt: 1, $lt: 10}}", true);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchDotted) {
+        matchAll("{'c.d': 10}", true);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchAndOfThree) {
+        matchAll("{a: 5, b: 'some string', 'c.e': 'x'}", true);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchInOf20) {
+        matchAll("{a: {$in: [11, 12, 13, 14, 15, 16, 17, 18, 19, 20, "
+                 "           21, 22, 23, 24, 25, 26, 27, 28, 29, 5]}}", true);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchArrayElement) {
+        matchAll("{tags: 'blue'}", true);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchElemMatch) {
+        matchAll("{items: {$elemMatch: {sku: 'c', qty: {$gte: 10}}}}", true);
+    }
+
+    BENCHMARK_F(MatchFixture, MatchExpressionBench, MatchOr) {
+        matchAll("{$or: [{a: 1}, {a: 2}, {'c.d': 10}]}", true);
+    }
+
+} // namespace
@@ -42,6 +42,7 @@
 #include "mongo/db/ops/path_support.h"
 #include "mongo/util/embedded_builder.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/safe_num.h"
 
 namespace mongo {
 
@@ -141,9 +142,61 @@ namespace mongo {
         // replacement.
         _replacementMode = false;
 
+        compileSimplePlan(updateExpr);
+
         return Status::OK();
     }
 
+    void UpdateDriver::compileSimplePlan(const BSONObj& updateExpr) {
+        vector<SimpleMod> plan;
+
+        BSONObjIterator outerIter(updateExpr);
+        while (outerIter.more()) {
+            BSONElement outerModElem = outerIter.next();
+            const modifiertable::ModifierType modType =
+                modifiertable::getType(outerModElem.fieldName());
+            if (modType != modifiertable::MOD_SET &&
+                modType != modifiertable::MOD_INC &&
+                modType != modifiertable::MOD_UNSET) {
+                return;
+            }
+
+            BSONObjIterator innerIter(outerModElem.embeddedObject());
+            while (innerIter.more()) {
+                BSONElement innerModElem = innerIter.next();
+
+                // Dotted and positional paths, _id and values which need storage validation
+                // of their own are left to the mods.
+                StringData fieldName = innerModElem.fieldNameStringData();
+                if (fieldName.empty() ||
+                    fieldName[0] == '$' ||
+                    fieldName.find('.') != std::string::npos ||
+                    fieldName == "_id") {
+                    return;
+                }
+
+                if (modType == modifiertable::MOD_SET &&
+                    (innerModElem.type() == Object || innerModElem.type() == Array)) {
+                    return;
+                }
+
+                // Let the mods report conflicting updates of the same field.
+                for (vector<SimpleMod>::const_iterator it = plan.begin(); it != plan.end(); ++it) {
+                    if (it->elem.fieldNameStringData() == fieldName) {
+                        return;
+                    }
+                }
+
+                SimpleMod mod;
+                mod.type = modType;
+                mod.elem = innerModElem;
+                plan.push_back(mod);
+            }
+        }
+
+        _simplePlan.swap(plan);
+    }
+
     inline Status UpdateDriver::addAndParse(const modifiertable::ModifierType type,
                                             const BSONElement& elem) {
         if (elem.eoo()) {
@@ -326,6 +379,194 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool UpdateDriver::hasSimplePlan() const {
+        return !_simplePlan.empty();
+    }
+
+    bool UpdateDriver::updateSimple(const BSONObj& oldObj,
+                                    const vector<FieldRef*>* immutablePaths,
+                                    BSONObj* newObj,
+                                    BSONObj* logOpRec,
+                                    bool* docWasModified,
+                                    mutablebson::DamageVector* damages) {
+        dassert(hasSimplePlan());
+
+        if (damages)
+            damages->clear();
+
+        // The mods would have to move _id to the front.
+        if (!str::equals(oldObj.firstElementFieldName(), "_id"))
+            return false;
+
+        const size_t numMods = _simplePlan.size();
+        for (size_t i = 0; i < numMods; ++i) {
+            const StringData fieldName = _simplePlan[i].elem.fieldNameStringData();
+
+            if (_indexedFields && _indexedFields->mightBeIndexed(fieldName))
+                return false;
+
+            if (immutablePaths) {
+                for (vector<FieldRef*>::const_iterator it = immutablePaths->begin();
+                     it != immutablePaths->end();
+                     ++it) {
+                    if ((*it)->getPart(0) == fieldName)
+                        return false;
+                }
+            }
+        }
+
+        // Find the current value of each field, EOO if it is missing, in one pass over the
+        // document.
+        vector<BSONElement> current(numMods);
+        BSONObjIterator docIter(oldObj);
+        while (docIter.more()) {
+            BSONElement elem = docIter.next();
+            const StringData fieldName = elem.fieldNameStringData();
+            for (size_t i = 0; i < numMods; ++i) {
+                if (current[i].eoo() && _simplePlan[i].elem.fieldNameStringData() == fieldName) {
+                    current[i] = elem;
+                    break;
+                }
+            }
+        }
+
+        // Decide what each mod does, with the same no-op rules as the mods themselves.
+        enum Action { kNoOp, kReplace, kRemove };
+        vector<Action> actions(numMods, kNoOp);
+        vector<SafeNum> incResults(numMods);
+        bool anyChange = false;
+        for (size_t i = 0; i < numMods; ++i) {
+            const SimpleMod& mod = _simplePlan[i];
+            switch (mod.type) {
+            case modifiertable::MOD_SET:
+                if (current[i].eoo() || current[i].woCompare(mod.elem, false) != 0)
+                    actions[i] = kReplace;
+                break;
+            case modifiertable::MOD_INC:
+                incResults[i] = mod.elem;
+                if (!current[i].eoo()) {
+                    // Let the mod report type mismatches and overflows.
+                    if (!current[i].isNumber())
+                        return false;
+                    const SafeNum currentValue(current[i]);
+                    incResults[i] += currentValue;
+                    if (!incResults[i].isValid())
+                        return false;
+                    if (incResults[i].isIdentical(currentValue))
+                        break;
+                }
+                actions[i] = kReplace;
+                break;
+            case modifiertable::MOD_UNSET:
+                if (!current[i].eoo())
+                    actions[i] = kRemove;
+                break;
+            default:
+                invariant(false);
+            }
+            anyChange = anyChange || actions[i] != kNoOp;
+        }
+
+        _affectIndices = false;
+        *docWasModified = anyChange;
+        if (!anyChange)
+            return true;
+
+        // Copy the document, replacing or dropping the fields which change in place, then
+        // append the fields which are new, in the order of their mods.
+        BSONObjBuilder builder(oldObj.objsize() + 64);
+        mutablebson::DamageVector newDamages;
+        bool sameLayout = true;
+        docIter = BSONObjIterator(oldObj);
+        while (docIter.more()) {
+            BSONElement elem = docIter.next();
+            size_t i = 0;
+            while (i < numMods && current[i].rawdata() != elem.rawdata())
+                ++i;
+
+            if (i == numMods || actions[i] == kNoOp) {
+                builder.append(elem);
+                continue;
+            }
+
+            if (actions[i] == kRemove) {
+                sameLayout = false;
+                continue;
+            }
+
+            const int offset = builder.len();
+            if (_simplePlan[i].type == modifiertable::MOD_INC)
+                incResults[i].appendTo(elem.fieldNameStringData(), &builder);
+            else
+                builder.appendAs(_simplePlan[i].elem, elem.fieldNameStringData());
+
+            if (builder.len() - offset != elem.size()) {
+                sameLayout = false;
+            }
+            else if (sameLayout) {
+                mutablebson::DamageEvent damage;
+                damage.sourceOffset = offset;
+                damage.targetOffset = elem.rawdata() - oldObj.objdata();
+                damage.size = elem.size();
+                newDamages.push_back(damage);
+            }
+        }
+
+        for (size_t i = 0; i < numMods; ++i) {
+            if (!current[i].eoo() || actions[i] != kReplace)
+                continue;
+            sameLayout = false;
+            if (_simplePlan[i].type == modifiertable::MOD_INC)
+                incResults[i].appendTo(_simplePlan[i].elem.fieldNameStringData(), &builder);
+            else
+                builder.append(_simplePlan[i].elem);
+        }
+
+        *newObj = builder.obj();
+
+        if (damages && sameLayout)
+            damages->swap(newDamages);
+
+        // Build {$set: {...}, $unset: {...}}, with the sections in the order LogBuilder would
+        // create them.
+        if (_logOp && logOpRec) {
+            BSONObjBuilder setBuilder;
+            BSONObjBuilder unsetBuilder;
+            bool setFirst = true;
+            bool sawChange = false;
+            for (size_t i = 0; i < numMods; ++i) {
+                if (actions[i] == kNoOp)
+                    continue;
+
+                if (!sawChange) {
+                    setFirst = actions[i] == kReplace;
+                    sawChange = true;
+                }
+
+                const StringData fieldName = _simplePlan[i].elem.fieldNameStringData();
+                if (actions[i] == kRemove)
+                    unsetBuilder.append(fieldName, true);
+                else if (_simplePlan[i].type == modifiertable::MOD_INC)
+                    incResults[i].appendTo(fieldName, &setBuilder);
+                else
+                    setBuilder.append(_simplePlan[i].elem);
+            }
+
+            const BSONObj sets = setBuilder.obj();
+            const BSONObj unsets = unsetBuilder.obj();
+            BSONObjBuilder logBuilder;
+            if (setFirst && !sets.isEmpty())
+                logBuilder.append("$set", sets);
+            if (!unsets.isEmpty())
+                logBuilder.append("$unset", unsets);
+            if (!setFirst && !sets.isEmpty())
+                logBuilder.append("$set", sets);
+            *logOpRec = logBuilder.obj();
+        }
+
+        return true;
+    }
+
     size_t UpdateDriver::numMods() const {
         return _mods.size();
     }
@@ -390,6 +631,7 @@ namespace mongo {
             delete *it;
         }
         _mods.clear();
+        _simplePlan.clear();
         _indexedFields = NULL;
         _replacementMode = false;
         _positional = false;
@@ -101,6 +101,35 @@ namespace mongo {
                       FieldRefSet* updatedFields = NULL,
                       bool* docWasModified = NULL);
 
+        /**
+         * Returns true if the update is made only of $set, $inc and $unset over distinct
+         * top-level fields other than _id, with $set values that are neither objects nor
+         * arrays. Such an update may be tried with 'updateSimple' before 'update'.
+         */
+        bool hasSimplePlan() const;
+
+        /**
+         * Applies a simple update (see 'hasSimplePlan') by splicing the new values directly
+         * into a copy of 'oldObj', without building a mutable document.
+         *
+         * Returns false, having done nothing, if the update must go through 'update' instead:
+         * when one of the fields might be indexed or is a prefix of one of 'immutablePaths',
+         * when a $inc meets a non-numeric value or overflows, or when 'oldObj' doesn't start
+         * with its _id. Otherwise returns true and sets 'docWasModified'. If the document was
+         * modified, 'newObj' holds the new document and 'logOpRec' is filled in as 'update'
+         * would.
+         *
+         * If 'damages' is not NULL and no modified field changed size, it is filled in with
+         * the damage events that turn 'oldObj' into 'newObj', with 'newObj' as their source.
+         * Otherwise it is left empty.
+         */
+        bool updateSimple(const BSONObj& oldObj,
+                          const std::vector<FieldRef*>* immutablePaths,
+                          BSONObj* newObj,
+                          BSONObj* logOpRec,
+                          bool* docWasModified,
+                          mutablebson::DamageVector* damages);
+
         //
         // Accessors
         //
@@ -142,6 +171,15 @@ namespace mongo {
         inline Status addAndParse(const modifiertable::ModifierType type,
                                   const BSONElement& elem);
 
+        /** Fills in '_simplePlan' if the already parsed 'updateExpr' qualifies for it */
+        void compileSimplePlan(const BSONObj& updateExpr);
+
+        // A top-level $set, $inc or $unset, whose field name and operand are those of 'elem'.
+        struct SimpleMod {
+            modifiertable::ModifierType type;
+            BSONElement elem;
+        };
+
         //
         // immutable properties after parsing
         //
@@ -152,6 +190,10 @@ namespace mongo {
         // Collection of update mod instances. Owned here.
         std::vector<ModifierInterface*> _mods;
 
+        // The mods again, in the same order, if the update can be applied by 'updateSimple'.
+        // Empty otherwise. Like '_mods', refers to the parsed update expression.
+        std::vector<SimpleMod> _simplePlan;
+
         // What are the list of fields in the collection over which the update is going to be
         // applied that participate in indices?
         //
@@ -30,7 +30,9 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include <cstring>
 #include <map>
+#include <string>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/string_data.h"
@@ -47,9 +49,11 @@ namespace {
     using mongo::BSONElement;
     using mongo::BSONObjIterator;
     using mongo::FieldRef;
+    using mongo::ModifierInterface;
     using mongo::fromjson;
     using mongo::OwnedPointerVector;
     using mongo::UpdateIndexData;
+    using mongo::mutablebson::DamageVector;
     using mongo::mutablebson::Document;
     using mongo::StringData;
     using mongo::UpdateDriver;
@@ -126,6 +130,141 @@ namespace {
         ASSERT_FALSE(driver.isDocReplacement());
     }
 
+    //
+    // Tests of the simple plan for top-level $set, $inc and $unset
+    //
+
+    bool hasSimplePlan(const char* update) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson(update)));
+        return driver.hasSimplePlan();
+    }
+
+    TEST(SimplePlan, Eligibility) {
+        ASSERT_TRUE(hasSimplePlan("{$set:{a:1}}"));
+        ASSERT_TRUE(hasSimplePlan("{$inc:{a:1, b:2.5}, $unset:{c:1}}"));
+        ASSERT_TRUE(hasSimplePlan("{$set:{a:'x'}, $inc:{b:1}}"));
+        ASSERT_FALSE(hasSimplePlan("{$set:{'a.b':1}}"));
+        ASSERT_FALSE(hasSimplePlan("{$set:{a:{b:1}}}"));
+        ASSERT_FALSE(hasSimplePlan("{$set:{a:[1]}}"));
+        ASSERT_FALSE(hasSimplePlan("{$set:{_id:1}}"));
+        ASSERT_FALSE(hasSimplePlan("{$set:{a:1}, $inc:{a:1}}"));
+        ASSERT_FALSE(hasSimplePlan("{$set:{a:1}, $push:{b:1}}"));
+        ASSERT_FALSE(hasSimplePlan("{a:1}"));
+    }
+
+    /**
+     * Applies 'update' to 'doc' through both updateSimple and the mods, and checks that they
+     * produce the same document and oplog entry.
+     */
+    void assertSimpleMatchesMods(const char* update, const char* doc) {
+        const BSONObj updateObj = fromjson(update);
+        const BSONObj oldObj = fromjson(doc);
+
+        UpdateDriver::Options opts;
+        opts.logOp = true;
+        UpdateDriver driver(opts);
+        driver.setContext(ModifierInterface::ExecInfo::UPDATE_CONTEXT);
+        ASSERT_OK(driver.parse(updateObj));
+        ASSERT_TRUE(driver.hasSimplePlan());
+
+        BSONObj simpleObj;
+        BSONObj simpleLog;
+        bool simpleModified = false;
+        ASSERT_TRUE(driver.updateSimple(oldObj, NULL, &simpleObj, &simpleLog, &simpleModified,
+                                        NULL));
+
+        Document modsDoc(oldObj);
+        BSONObj modsLog;
+        bool modsModified = false;
+        ASSERT_OK(driver.update(StringData(), &modsDoc, &modsLog, NULL, &modsModified));
+
+        ASSERT_EQUALS(modsModified, simpleModified);
+        if (modsModified) {
+            ASSERT_TRUE(simpleObj.binaryEqual(modsDoc.getObject()));
+            ASSERT_TRUE(simpleLog.binaryEqual(modsLog));
+        }
+    }
+
+    TEST(SimplePlan, MatchesMods) {
+        assertSimpleMatchesMods("{$set:{a:2}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$set:{c:2}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$set:{a:'long string value'}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$inc:{a:1}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$inc:{a:1.5}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$inc:{c:1}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$inc:{a:1}}", "{_id:1, a:2147483647}");
+        assertSimpleMatchesMods("{$unset:{a:1}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$unset:{b:1}, $set:{c:1, a:3}}", "{_id:1, a:1, b:1}");
+        assertSimpleMatchesMods("{$set:{c:1, d:2}, $inc:{a:5}}", "{_id:1, a:1, b:1}");
+    }
+
+    TEST(SimplePlan, NoOps) {
+        assertSimpleMatchesMods("{$set:{a:1}}", "{_id:1, a:1}");
+        assertSimpleMatchesMods("{$set:{a:1.0}}", "{_id:1, a:1}");
+        assertSimpleMatchesMods("{$inc:{a:0}}", "{_id:1, a:1}");
+        assertSimpleMatchesMods("{$unset:{b:1}}", "{_id:1, a:1}");
+    }
+
+    TEST(SimplePlan, Damages) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        ASSERT_OK(driver.parse(fromjson("{$inc:{a:1}, $set:{c:'y'}}")));
+
+        const BSONObj oldObj = fromjson("{_id:1, a:1, b:'text', c:'x'}");
+        BSONObj newObj;
+        bool modified = false;
+        DamageVector damages;
+        ASSERT_TRUE(driver.updateSimple(oldObj, NULL, &newObj, NULL, &modified, &damages));
+        ASSERT_TRUE(modified);
+        ASSERT_EQUALS(2U, damages.size());
+
+        std::string patched(oldObj.objdata(), oldObj.objsize());
+        for (DamageVector::const_iterator it = damages.begin(); it != damages.end(); ++it) {
+            std::memcpy(&patched[it->targetOffset], newObj.objdata() + it->sourceOffset,
+                        it->size);
+        }
+        ASSERT_EQUALS(fromjson("{_id:1, a:2, b:'text', c:'y'}"), BSONObj(patched.data()));
+
+        // Growing a value changes the layout, so there are no damages.
+        ASSERT_OK(driver.parse(fromjson("{$set:{c:'longer'}}")));
+        ASSERT_TRUE(driver.updateSimple(oldObj, NULL, &newObj, NULL, &modified, &damages));
+        ASSERT_TRUE(modified);
+        ASSERT_TRUE(damages.empty());
+        ASSERT_EQUALS(fromjson("{_id:1, a:1, b:'text', c:'longer'}"), newObj);
+    }
+
+    TEST(SimplePlan, FallsBack) {
+        UpdateDriver::Options opts;
+        UpdateDriver driver(opts);
+        BSONObj newObj;
+        bool modified = false;
+
+        // Non-numeric $inc target, left to the mod to report.
+        ASSERT_OK(driver.parse(fromjson("{$inc:{a:1}}")));
+        ASSERT_FALSE(driver.updateSimple(fromjson("{_id:1, a:'x'}"), NULL, &newObj, NULL,
+                                         &modified, NULL));
+
+        // Document without a leading _id.
+        ASSERT_FALSE(driver.updateSimple(fromjson("{a:1, _id:1}"), NULL, &newObj, NULL,
+                                         &modified, NULL));
+
+        // Indexed field.
+        UpdateIndexData indexed;
+        indexed.addPath("a");
+        driver.refreshIndexKeys(&indexed);
+        ASSERT_FALSE(driver.updateSimple(fromjson("{_id:1, a:1}"), NULL, &newObj, NULL,
+                                         &modified, NULL));
+        driver.refreshIndexKeys(NULL);
+
+        // Field which is the prefix of an immutable path, like a shard key.
+        OwnedPointerVector<FieldRef> immutablePaths;
+        immutablePaths.push_back(new FieldRef("a.b"));
+        ASSERT_FALSE(driver.updateSimple(fromjson("{_id:1, a:1}"), &immutablePaths.vector(),
+                                         &newObj, NULL, &modified, NULL));
+    }
+
     //
     // Tests of creating a base for an upsert from a query document
     // $or, $and, $all get special handling, as does the _id field
@@ -276,6 +276,10 @@ namespace mongo {
         else if (STAGE_COUNT == stats.stageType) {
             CountStats* spec = static_cast<CountStats*>(stats.specific.get());
 
+            if (!spec->countMode.empty()) {
+                bob->append("countMode", spec->countMode);
+            }
+
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("nCounted", spec->nCounted);
                 bob->appendNumber("nSkipped", spec->nSkipped);
@@ -390,6 +394,7 @@ namespace mongo {
 
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("chunkSkips", spec->chunkSkips);
+                bob->appendBool("indexRangeOwned", spec->indexRangeOwned);
             }
         }
         else if (STAGE_SKIP == stats.stageType) {
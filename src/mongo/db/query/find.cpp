@@ -34,11 +34,13 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include "mongo/base/counter.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -48,7 +50,9 @@
 #include "mongo/db/query/find_constants.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_result_cache.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/server_parameters.h"
@@ -254,7 +258,8 @@ namespace mongo {
                               CurOp& curop,
                               int pass,
                               bool& exhaust,
-                              bool* isCursorAuthorized) {
+                              bool* isCursorAuthorized,
+                              int* bufferCapacity) {
 
         // For testing, we may want to fail if we receive a getmore.
         if (MONGO_FAIL_POINT(failReceivedGetmore)) {
@@ -517,11 +522,89 @@ namespace mongo {
         qr.setCursorId(cursorid);
         qr.setStartingFrom(startingResult);
         qr.setNReturned(numResults);
+        *bufferCapacity = bb.getSize();
         bb.decouple();
         LOG(5) << "getMore returned " << numResults << " results\n";
         return qr;
     }
 
+namespace {
+
+    Counter64 queryResultCacheHits;
+    Counter64 queryResultCacheMisses;
+
+    ServerStatusMetricField<Counter64> displayQueryResultCacheHits(
+        "queryExecutor.resultCache.hits", &queryResultCacheHits);
+    ServerStatusMetricField<Counter64> displayQueryResultCacheMisses(
+        "queryExecutor.resultCache.misses", &queryResultCacheMisses);
+
+    /**
+     * Returns the query result cache which may hold the reply to 'q', or NULL if 'q' must be run.
+     */
+    QueryResultCache* getQueryResultCache(OperationContext* txn,
+                                          Collection* collection,
+                                          const NamespaceString& nss,
+                                          const QueryMessage& q) {
+        if (!collection || !collection->infoCache()->getQueryResultCache()->isEnabled()) {
+            return NULL;
+        }
+
+        // These only make sense for queries which leave a cursor open, and cached replies never
+        // do.
+        if (q.queryOptions & (QueryOption_CursorTailable
+                              | QueryOption_OplogReplay
+                              | QueryOption_Exhaust)) {
+            return NULL;
+        }
+
+        // A direct client shares its caller's storage snapshot, which may predate the write
+        // epoch we would read.
+        if (txn->getClient()->isInDirectClient()) {
+            return NULL;
+        }
+
+        // Which documents a shard returns depends on the chunks it owns, which can change without
+        // the collection being written.
+        if (shardingState.needCollectionMetadata(nss.ns())) {
+            return NULL;
+        }
+
+        return collection->infoCache()->getQueryResultCache();
+    }
+
+    /**
+     * Returns the key under which the reply to 'q' is cached. It covers every part of the request
+     * that can affect the reply, byte for byte.
+     */
+    std::string getQueryResultCacheKey(const QueryMessage& q) {
+        BufBuilder bb;
+        bb.appendNum(q.ntoskip);
+        bb.appendNum(q.ntoreturn);
+        bb.appendNum(q.queryOptions);
+        bb.appendBuf(q.query.objdata(), q.query.objsize());
+        bb.appendBuf(q.fields.objdata(), q.fields.objsize());
+        return std::string(bb.buf(), bb.len());
+    }
+
+    /**
+     * Fills out the header of 'bb', an OP_REPLY holding 'numResults' documents, and hands it to
+     * 'result'.
+     */
+    void setQueryReply(BufBuilder& bb, long long cursorId, int numResults, Message& result) {
+        MsgData::View(bb.buf()).setLen(bb.len());
+        result.setPooledData(bb.buf(), bb.getSize());
+        bb.decouple();
+
+        QueryResult::View qr = result.header().view2ptr();
+        qr.setCursorId(cursorId);
+        qr.setResultFlagsToOk();
+        qr.msgdata().setOperation(opReply);
+        qr.setStartingFrom(0);
+        qr.setNReturned(numResults);
+    }
+
+} // namespace
+
     std::string runQuery(OperationContext* txn,
                          QueryMessage& q,
                          const NamespaceString& nss,
@@ -534,6 +617,48 @@ namespace mongo {
         // Set curop information.
         beginQueryOp(nss, q.query, q.ntoreturn, q.ntoskip, &curop);
 
+        AutoGetCollectionForRead ctx(txn, nss);
+        Collection* collection = ctx.getCollection();
+
+        const int dbProfilingLevel = ctx.getDb() ? ctx.getDb()->getProfilingLevel() :
+                                                   serverGlobalParams.defaultProfile;
+
+        // If the collection has a query result cache, try to answer the query from it before
+        // doing any parsing or planning.
+        QueryResultCache* resultCache = getQueryResultCache(txn, collection, nss, q);
+        std::string resultCacheKey;
+        QueryResultCache::Epoch resultCacheEpoch = 0;
+        if (resultCache) {
+            resultCacheKey = getQueryResultCacheKey(q);
+
+            // This must be read before the query takes its storage snapshot.
+            resultCacheEpoch = resultCache->getWriteEpoch();
+
+            std::shared_ptr<const QueryResultCache::CachedReply> cached =
+                resultCache->get(resultCacheKey);
+            if (cached) {
+                queryResultCacheHits.increment();
+
+                uassertStatusOK(repl::getGlobalReplicationCoordinator()->checkCanServeReadsFor(
+                        txn,
+                        nss,
+                        cached->slaveOk));
+
+                BufBuilder bb(sizeof(QueryResult::Value) + cached->docs.size());
+                bb.skip(sizeof(QueryResult::Value));
+                bb.appendBuf(cached->docs.data(), cached->docs.size());
+
+                curop.debug().planSummary = "QUERY_RESULT_CACHE";
+                curop.debug().nreturned = cached->nReturned;
+                curop.debug().cursorid = -1;
+                curop.debug().cursorExhausted = true;
+
+                setQueryReply(bb, 0, cached->nReturned, result);
+                return "";
+            }
+            queryResultCacheMisses.increment();
+        }
+
         // Parse the qm into a CanonicalQuery.
         std::auto_ptr<CanonicalQuery> cq;
         {
@@ -552,13 +677,6 @@ namespace mongo {
         LOG(5) << "Running query:\n" << cq->toString();
         LOG(2) << "Running query: " << cq->toStringShort();
 
-        // Parse, canonicalize, plan, transcribe, and get a plan executor.
-        AutoGetCollectionForRead ctx(txn, nss);
-        Collection* collection = ctx.getCollection();
-
-        const int dbProfilingLevel = ctx.getDb() ? ctx.getDb()->getProfilingLevel() :
-                                                   serverGlobalParams.defaultProfile;
-
         // We have a parsed query. Time to get the execution plan for it.
         std::unique_ptr<PlanExecutor> exec;
         {
@@ -749,19 +867,23 @@ namespace mongo {
         else {
             LOG(5) << "Not caching executor but returning " << numResults << " results.\n";
             endQueryOp(exec.get(), dbProfilingLevel, numResults, ccId, &curop);
+
+            // The reply holds every result, so it can be cached. $where is excluded because
+            // JavaScript need not be deterministic.
+            if (resultCache &&
+                !QueryPlannerCommon::hasNode(exec->getCanonicalQuery()->root(),
+                                             MatchExpression::WHERE)) {
+                resultCache->add(resultCacheKey,
+                                 resultCacheEpoch,
+                                 StringData(bb.buf() + sizeof(QueryResult::Value),
+                                            bb.len() - sizeof(QueryResult::Value)),
+                                 numResults,
+                                 slaveOK);
+            }
         }
 
         // Add the results from the query into the output buffer.
-        result.appendData(bb.buf(), bb.len());
-        bb.decouple();
-
-        // Fill out the output buffer's header.
-        QueryResult::View qr = result.header().view2ptr();
-        qr.setCursorId(ccId);
-        qr.setResultFlagsToOk();
-        qr.msgdata().setOperation(opReply);
-        qr.setStartingFrom(0);
-        qr.setNReturned(numResults);
+        setQueryReply(bb, ccId, numResults, result);
 
         // curop.debug().exhaust is set above.
         return curop.debug().exhaust ? nss.ns() : "";
@@ -148,6 +148,9 @@ namespace mongo {
 
     /**
      * Called from the getMore entry point in ops/query.cpp.
+     *
+     * Sets *bufferCapacity to the size of the buffer holding the returned reply, for
+     * Message::setPooledData().
      */
     QueryResult::View getMore(OperationContext* txn,
                               const char* ns,
@@ -156,7 +159,8 @@ namespace mongo {
                               CurOp& curop,
                               int pass,
                               bool& exhaust,
-                              bool* isCursorAuthorized);
+                              bool* isCursorAuthorized,
+                              int* bufferCapacity);
 
     /**
      * Run the query 'q' and place the result in 'result'.
@@ -113,8 +113,9 @@ namespace mongo {
     }
 
     namespace {
-        // The body is below in the "count hack" section but getExecutor calls it.
+        // The bodies are below in the "count hack" section but getExecutor calls them.
         bool turnIxscanIntoCount(QuerySolution* soln);
+        bool turnCollscanIntoCount(QuerySolution* soln);
 
         bool filteredIndexBad(const MatchExpression* filter, CanonicalQuery* query) {
             if (!filter)
@@ -402,6 +403,11 @@ namespace mongo {
             }
 
             if (1 == solutions.size()) {
+                // A count over a lone collection scan only needs to know which records match.
+                if (plannerParams.options & QueryPlannerParams::PRIVATE_IS_COUNT) {
+                    turnCollscanIntoCount(solutions[0]);
+                }
+
                 // Only one possible plan.  Run it.  Build the stages from the solution.
                 verify(StageBuilder::build(opCtx, collection, *solutions[0], ws, rootOut));
 
@@ -1049,21 +1055,20 @@ namespace {
         bool turnIxscanIntoCount(QuerySolution* soln) {
             QuerySolutionNode* root = soln->root.get();
 
-            // Root should be a fetch w/o any filters.
-            if (STAGE_FETCH != root->getType()) {
-                return false;
-            }
-
-            if (NULL != root->filter.get()) {
-                return false;
+            // Root should be an ixscan, or a fetch w/o any filters over an ixscan.
+            QuerySolutionNode* scan = root;
+            if (STAGE_FETCH == root->getType()) {
+                if (NULL != root->filter.get()) {
+                    return false;
+                }
+                scan = root->children[0];
             }
 
-            // Child should be an ixscan.
-            if (STAGE_IXSCAN != root->children[0]->getType()) {
+            if (STAGE_IXSCAN != scan->getType()) {
                 return false;
             }
 
-            IndexScanNode* isn = static_cast<IndexScanNode*>(root->children[0]);
+            IndexScanNode* isn = static_cast<IndexScanNode*>(scan);
 
             // No filters allowed and side-stepping isSimpleRange for now.  TODO: do we ever see
             // isSimpleRange here?  because we could well use it.  I just don't think we ever do see
@@ -1087,7 +1092,7 @@ namespace {
                 return false;
             }
 
-            // Make the count node that we replace the fetch + ixscan with.
+            // Make the count node that we replace the (fetch +) ixscan with.
             CountNode* cn = new CountNode();
             cn->indexKeyPattern = isn->indexKeyPattern;
             cn->startKey = startKey;
@@ -1099,6 +1104,22 @@ namespace {
             return true;
         }
 
+        /**
+         * If 'soln' is a bare collection scan, switches it to count-only mode so that the scan
+         * evaluates the filter on raw records and never materializes working set members.
+         * Only valid when the scan will be the direct child of a CountStage.
+         *
+         * Returns true if the solution was modified.
+         */
+        bool turnCollscanIntoCount(QuerySolution* soln) {
+            if (STAGE_COLLSCAN != soln->root->getType()) {
+                return false;
+            }
+
+            static_cast<CollectionScanNode*>(soln->root.get())->countOnly = true;
+            return true;
+        }
+
         /**
          * Returns true if indices contains an index that can be
          * used with DistinctNode. Sets indexOut to the array index
@@ -0,0 +1,218 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/hyperloglog.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/bits.h"
+#include "mongo/util/mongoutils/str.h"
+#include "third_party/murmurhash3/MurmurHash3.h"
+
+namespace mongo {
+
+namespace {
+
+    uint64_t hashBytes(const void* data, size_t len, uint32_t seed) {
+        uint64_t out[2];
+        MurmurHash3_x64_128(data, static_cast<int>(len), seed, out);
+        return out[0];
+    }
+
+    /**
+     * Numbers compare equal across types whenever they are numerically equal, so every number is
+     * hashed in a single representation: as a long long when it is integral and in range, and as
+     * a double otherwise. All NaNs compare equal, as do 0 and -0.
+     */
+    uint64_t hashNumber(const BSONElement& elt, uint32_t seed) {
+        if (NumberDouble != elt.type()) {
+            const long long value = elt.numberLong();
+            return hashBytes(&value, sizeof(value), seed);
+        }
+
+        double value = elt.numberDouble();
+        static const double kBoundOfLongRange = -static_cast<double>(LLONG_MIN);
+        if (value >= -kBoundOfLongRange && value < kBoundOfLongRange
+            && value == std::floor(value)) {
+            const long long integral = static_cast<long long>(value);
+            return hashBytes(&integral, sizeof(integral), seed);
+        }
+
+        if (std::isnan(value)) {
+            value = std::numeric_limits<double>::quiet_NaN();
+        }
+        // Distinguish from a long long with the same bit pattern.
+        return hashBytes(&value, sizeof(value), ~seed);
+    }
+
+}  // namespace
+
+    HyperLogLog::HyperLogLog(int precision)
+        : _precision(precision),
+          _registers(size_t(1) << precision, 0) {
+        invariant(precision >= kMinPrecision && precision <= kMaxPrecision);
+    }
+
+    void HyperLogLog::add(const BSONElement& elt) {
+        addHash(hashElement(elt));
+    }
+
+    void HyperLogLog::addHash(uint64_t hash) {
+        const size_t index = hash >> (64 - _precision);
+
+        // The rank is the position of the leftmost one bit among the remaining bits. Setting the
+        // lowest bit caps it for hashes whose remaining bits are all zero.
+        const uint64_t rest = (hash << _precision) | (uint64_t(1) << (_precision - 1));
+        const uint8_t rank = countLeadingZeros64(rest) + 1;
+
+        if (rank > _registers[index]) {
+            _registers[index] = rank;
+        }
+    }
+
+    Status HyperLogLog::merge(const HyperLogLog& other) {
+        if (other._precision != _precision) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "cannot merge a HyperLogLog of precision "
+                                        << other._precision << " into one of precision "
+                                        << _precision);
+        }
+
+        for (size_t i = 0; i < _registers.size(); ++i) {
+            _registers[i] = std::max(_registers[i], other._registers[i]);
+        }
+        return Status::OK();
+    }
+
+    double HyperLogLog::estimate() const {
+        const double m = _registers.size();
+
+        double alpha;
+        switch (_precision) {
+        case 4: alpha = 0.673; break;
+        case 5: alpha = 0.697; break;
+        case 6: alpha = 0.709; break;
+        default: alpha = 0.7213 / (1 + 1.079 / m); break;
+        }
+
+        double sum = 0;
+        size_t zeros = 0;
+        for (size_t i = 0; i < _registers.size(); ++i) {
+            sum += std::ldexp(1.0, -_registers[i]);
+            if (0 == _registers[i]) {
+                ++zeros;
+            }
+        }
+
+        const double raw = alpha * m * m / sum;
+
+        // Small cardinalities leave many registers empty, where linear counting is more accurate.
+        // With 64-bit hashes no correction is needed at the high end.
+        if (raw <= 2.5 * m && zeros > 0) {
+            return m * std::log(m / zeros);
+        }
+        return raw;
+    }
+
+    double HyperLogLog::standardError() const {
+        return 1.04 / std::sqrt(static_cast<double>(_registers.size()));
+    }
+
+    StringData HyperLogLog::getRegisters() const {
+        return StringData(reinterpret_cast<const char*>(&_registers[0]), _registers.size());
+    }
+
+    // static
+    Status HyperLogLog::fromRegisters(StringData registers, HyperLogLog* out) {
+        int precision = kMinPrecision;
+        while (precision <= kMaxPrecision && (size_t(1) << precision) != registers.size()) {
+            ++precision;
+        }
+        if (precision > kMaxPrecision) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "invalid HyperLogLog register count: "
+                                        << registers.size());
+        }
+
+        HyperLogLog sketch(precision);
+        for (size_t i = 0; i < registers.size(); ++i) {
+            const uint8_t rank = static_cast<uint8_t>(registers[i]);
+            if (rank > 64 - precision + 1) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << "invalid HyperLogLog register value: "
+                                            << static_cast<int>(rank));
+            }
+            sketch._registers[i] = rank;
+        }
+
+        *out = sketch;
+        return Status::OK();
+    }
+
+    // static
+    uint64_t HyperLogLog::hashElement(const BSONElement& elt) {
+        // Types which compare equal share a canonical type, so seeding with it keeps them together.
+        const uint32_t seed = elt.canonicalType();
+
+        switch (elt.type()) {
+        case NumberDouble:
+        case NumberInt:
+        case NumberLong:
+            return hashNumber(elt, seed);
+        case String:
+        case Symbol:
+            return hashBytes(elt.valuestr(), elt.valuestrsize() - 1, seed);
+        case Bool: {
+            const char value = elt.boolean();
+            return hashBytes(&value, sizeof(value), seed);
+        }
+        case Object:
+        case Array: {
+            // Embedded documents compare field by field, so hash them the same way.
+            std::string buf;
+            BSONObjIterator it(elt.embeddedObject());
+            while (it.more()) {
+                const BSONElement child = it.next();
+                const uint64_t childHash = hashElement(child);
+                buf.append(child.fieldName(), child.fieldNameSize());
+                buf.append(reinterpret_cast<const char*>(&childHash), sizeof(childHash));
+            }
+            return hashBytes(buf.data(), buf.size(), seed);
+        }
+        default:
+            return hashBytes(elt.value(), elt.valuesize(), seed);
+        }
+    }
+
+}  // namespace mongo
@@ -0,0 +1,109 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    class BSONElement;
+
+    /**
+     * A HyperLogLog sketch (Flajolet et al., with the small range correction of Heule et al.)
+     * estimating the number of distinct values added to it in a fixed amount of memory: 2^p
+     * one byte registers, with a relative standard error of about 1.04 / sqrt(2^p).
+     *
+     * Values that compare equal under BSONElement::woCompare() ignoring field names, such as the
+     * numbers 1, NumberLong(1) and 1.0, are counted once, matching the semantics of distinct.
+     *
+     * Sketches of the same precision can be merged, which yields the sketch of the union of the
+     * values added to each.
+     */
+    class HyperLogLog {
+    public:
+        static const int kMinPrecision = 4;
+        static const int kMaxPrecision = 16;
+
+        explicit HyperLogLog(int precision);
+
+        int getPrecision() const { return _precision; }
+
+        /**
+         * Adds the value of 'elt'. Its field name is ignored.
+         */
+        void add(const BSONElement& elt);
+
+        /**
+         * Adds a value by its 64-bit hash, which should be uniformly distributed.
+         */
+        void addHash(uint64_t hash);
+
+        /**
+         * Makes this the sketch of the union of the values added to this and to 'other'.
+         * Returns BadValue if the precisions differ.
+         */
+        Status merge(const HyperLogLog& other);
+
+        /**
+         * Returns the estimated number of distinct values added so far.
+         */
+        double estimate() const;
+
+        /**
+         * Returns the relative standard error of estimate().
+         */
+        double standardError() const;
+
+        /**
+         * The raw registers, which can be sent elsewhere and loaded with fromRegisters().
+         */
+        StringData getRegisters() const;
+
+        /**
+         * Rebuilds a sketch from the output of getRegisters(). Returns BadValue if the length of
+         * 'registers' is not a power of two within the allowed precisions.
+         */
+        static Status fromRegisters(StringData registers, HyperLogLog* out);
+
+        /**
+         * Hashes the value of 'elt' such that equal values hash alike. Exposed for testing.
+         */
+        static uint64_t hashElement(const BSONElement& elt);
+
+    private:
+        int _precision;
+        std::vector<uint8_t> _registers;
+    };
+
+}  // namespace mongo
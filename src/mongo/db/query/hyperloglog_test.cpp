@@ -0,0 +1,137 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/hyperloglog.h"
+
+#include <cmath>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    uint64_t hashOf(const BSONObj& obj) {
+        return HyperLogLog::hashElement(obj.firstElement());
+    }
+
+    void assertWithinError(const HyperLogLog& sketch, double expected) {
+        // Four standard errors makes a spurious failure vanishingly unlikely.
+        const double bound = 4 * sketch.standardError() * expected;
+        ASSERT_LESS_THAN_OR_EQUALS(std::fabs(sketch.estimate() - expected), bound);
+    }
+
+    TEST(HyperLogLogTest, EmptyEstimatesZero) {
+        HyperLogLog sketch(12);
+        ASSERT_EQUALS(sketch.estimate(), 0);
+    }
+
+    TEST(HyperLogLogTest, EqualValuesHashAlike) {
+        ASSERT_EQUALS(hashOf(BSON("" << 1)), hashOf(BSON("" << 1LL)));
+        ASSERT_EQUALS(hashOf(BSON("" << 1)), hashOf(BSON("" << 1.0)));
+        ASSERT_EQUALS(hashOf(BSON("" << 0.0)), hashOf(BSON("" << -0.0)));
+        ASSERT_EQUALS(hashOf(BSON("a" << "x")), hashOf(BSON("b" << "x")));
+        ASSERT_EQUALS(hashOf(BSON("" << BSON("a" << 1))), hashOf(BSON("" << BSON("a" << 1.0))));
+        ASSERT_EQUALS(hashOf(BSON("" << BSON_ARRAY(1 << 2))),
+                      hashOf(BSON("" << BSON_ARRAY(1.0 << 2LL))));
+    }
+
+    TEST(HyperLogLogTest, DifferentValuesHashApart) {
+        ASSERT_NOT_EQUALS(hashOf(BSON("" << 1)), hashOf(BSON("" << 1.5)));
+        ASSERT_NOT_EQUALS(hashOf(BSON("" << 1)), hashOf(BSON("" << "1")));
+        ASSERT_NOT_EQUALS(hashOf(BSON("" << 1)), hashOf(BSON("" << true)));
+        ASSERT_NOT_EQUALS(hashOf(BSON("" << BSON("a" << 1))), hashOf(BSON("" << BSON("b" << 1))));
+        ASSERT_NOT_EQUALS(hashOf(BSON("" << BSON("a" << 1))), hashOf(BSON("" << BSON_ARRAY(1))));
+        ASSERT_NOT_EQUALS(hashOf(BSON("" << 9007199254740993LL)),
+                          hashOf(BSON("" << 9007199254740992LL)));
+    }
+
+    TEST(HyperLogLogTest, DuplicatesCountOnce) {
+        HyperLogLog sketch(12);
+        for (int i = 0; i < 1000; ++i) {
+            sketch.add(BSON("" << (i % 10)).firstElement());
+        }
+        ASSERT_EQUALS(std::floor(sketch.estimate() + 0.5), 10);
+    }
+
+    TEST(HyperLogLogTest, SmallCardinality) {
+        HyperLogLog sketch(14);
+        for (int i = 0; i < 1000; ++i) {
+            sketch.add(BSON("" << i).firstElement());
+        }
+        assertWithinError(sketch, 1000);
+    }
+
+    TEST(HyperLogLogTest, LargeCardinality) {
+        HyperLogLog sketch(12);
+        for (int i = 0; i < 200000; ++i) {
+            sketch.add(BSON("" << i).firstElement());
+        }
+        assertWithinError(sketch, 200000);
+    }
+
+    TEST(HyperLogLogTest, MergeIsUnion) {
+        HyperLogLog left(12);
+        HyperLogLog right(12);
+        for (int i = 0; i < 20000; ++i) {
+            left.add(BSON("" << i).firstElement());
+            right.add(BSON("" << (i + 10000)).firstElement());
+        }
+        ASSERT_OK(left.merge(right));
+        assertWithinError(left, 30000);
+    }
+
+    TEST(HyperLogLogTest, MergeRequiresSamePrecision) {
+        HyperLogLog left(12);
+        HyperLogLog right(14);
+        ASSERT_NOT_OK(left.merge(right));
+    }
+
+    TEST(HyperLogLogTest, RegistersRoundTrip) {
+        HyperLogLog sketch(10);
+        for (int i = 0; i < 5000; ++i) {
+            sketch.add(BSON("" << i).firstElement());
+        }
+
+        HyperLogLog copy(4);
+        ASSERT_OK(HyperLogLog::fromRegisters(sketch.getRegisters(), &copy));
+        ASSERT_EQUALS(copy.getPrecision(), 10);
+        ASSERT_EQUALS(copy.estimate(), sketch.estimate());
+    }
+
+    TEST(HyperLogLogTest, FromRegistersRejectsBadInput) {
+        HyperLogLog sketch(4);
+        ASSERT_NOT_OK(HyperLogLog::fromRegisters(StringData("abc"), &sketch));
+        ASSERT_NOT_OK(HyperLogLog::fromRegisters(StringData(std::string(16, char(100))),
+                                                 &sketch));
+    }
+
+}  // namespace
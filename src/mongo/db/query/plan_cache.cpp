@@ -270,7 +270,9 @@ namespace {
     PlanCacheEntry::PlanCacheEntry(const std::vector<QuerySolution*>& solutions,
                                    PlanRankingDecision* why)
         : plannerData(solutions.size()),
-          decision(why) {
+          decision(why),
+          feedbackWorks(0),
+          feedbackAdvanced(0) {
         invariant(why);
 
         // The caller of this constructor is responsible for ensuring
@@ -314,6 +316,8 @@ namespace {
             fb->score = feedback[i]->score;
             entry->feedback.push_back(fb);
         }
+        entry->feedbackWorks = feedbackWorks;
+        entry->feedbackAdvanced = feedbackAdvanced;
         return entry;
     }
 
@@ -618,6 +622,11 @@ namespace {
         }
         invariant(entry);
 
+        if (autoFeedback->stats) {
+            entry->feedbackWorks += autoFeedback->stats->common.works;
+            entry->feedbackAdvanced += autoFeedback->stats->common.advanced;
+        }
+
         // We store up to a constant number of feedback entries.
         if (entry->feedback.size() < size_t(internalQueryCacheFeedbacksStored)) {
             entry->feedback.push_back(autoFeedback.release());
@@ -257,6 +257,13 @@ namespace mongo {
         // Annotations from cached runs.  The CachedPlanStage provides these stats about its
         // runs when they complete.
         std::vector<PlanCacheEntryFeedback*> feedback;
+
+        // Total works and advances of the winning plan over every cached run that provided
+        // feedback, including the runs beyond the first 'internalQueryCacheFeedbacksStored' whose
+        // stats are not kept above. Lets a replanned trial period start from what the cached
+        // runs observed.
+        size_t feedbackWorks;
+        size_t feedbackAdvanced;
     };
 
     /**
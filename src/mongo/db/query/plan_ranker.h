@@ -69,7 +69,7 @@ namespace mongo {
      */
     struct CandidatePlan {
         CandidatePlan(QuerySolution* s, PlanStage* r, WorkingSet* w)
-            : solution(s), root(r), ws(w), failed(false) { }
+            : solution(s), root(r), ws(w), failed(false), priorWorks(0), priorAdvanced(0) { }
 
         QuerySolution* solution;
         PlanStage* root;
@@ -79,6 +79,12 @@ namespace mongo {
         std::list<WorkingSetID> results;
 
         bool failed;
+
+        // How many times the plan was worked, and advanced, before this trial period: e.g. by
+        // the trial period that cached it and by later runs of the cached plan. Only used to
+        // decide whether the trial period can end early, never for ranking.
+        size_t priorWorks;
+        size_t priorAdvanced;
     };
 
     /**
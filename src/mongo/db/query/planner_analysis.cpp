@@ -725,6 +725,12 @@ namespace mongo {
             projNode->coveredKeyObj = coveredKeyObj;
             solnRoot = projNode;
         }
+        else if (STAGE_IXSCAN == solnRoot->getType()
+                 && (params.options & QueryPlannerParams::PRIVATE_IS_COUNT)) {
+            // A count only needs to know that a document matched. An unfetched index scan has
+            // already applied every predicate to the index keys, so leave out the FETCH and count
+            // straight from the index.
+        }
         else {
             // If there's no projection, we must fetch, as the user wants the entire doc.
             if (!solnRoot->fetched()) {
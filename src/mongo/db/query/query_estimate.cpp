@@ -0,0 +1,219 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_estimate.h"
+
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <cmath>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/count.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/hyperloglog.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_planner_common.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+
+    const long long kMaxEstimateSampleSize = 100 * 1000;
+
+namespace {
+
+    // 16KB of registers, for a relative standard error of about 0.8%.
+    const int kDistinctSketchPrecision = 14;
+
+    // How often to check for interruption while sampling.
+    const long long kInterruptCheckPeriod = 128;
+
+}  // namespace
+
+    Status parseEstimateBudget(const BSONObj& cmdObj,
+                               StringData fieldName,
+                               long long defaultValue,
+                               long long maxValue,
+                               long long* out) {
+        const BSONElement elt = cmdObj[fieldName];
+        if (elt.eoo()) {
+            *out = defaultValue;
+            return Status::OK();
+        }
+
+        if (!elt.isNumber()) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << fieldName << " must be a number");
+        }
+
+        const long long value = elt.numberLong();
+        if (value <= 0 || value > maxValue) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << fieldName << " must be between 1 and " << maxValue);
+        }
+
+        *out = value;
+        return Status::OK();
+    }
+
+    Status sampleCount(OperationContext* txn,
+                       Collection* collection,
+                       const CountRequest& request,
+                       long long sampleSize,
+                       bool* sampledOut,
+                       QueryEstimate* out) {
+        *sampledOut = false;
+
+        // An empty query is answered exactly from the collection's record count, and reading
+        // every record of a small collection is no dearer than sampling it.
+        if (!collection || request.query.isEmpty()) {
+            return Status::OK();
+        }
+
+        const long long numRecords = collection->numRecords(txn);
+        if (numRecords <= sampleSize) {
+            return Status::OK();
+        }
+
+        scoped_ptr<RecordIterator> iter(collection->getRecordStore()->getRandomIterator(txn));
+        if (!iter) {
+            return Status::OK();
+        }
+
+        StatusWithMatchExpression swme =
+            MatchExpressionParser::parse(request.query,
+                                         WhereCallbackReal(txn, collection->ns().db()));
+        if (!swme.isOK()) {
+            return swme.getStatus();
+        }
+        scoped_ptr<MatchExpression> filter(swme.getValue());
+
+        if (QueryPlannerCommon::hasNode(filter.get(), MatchExpression::GEO_NEAR)
+            || QueryPlannerCommon::hasNode(filter.get(), MatchExpression::TEXT)) {
+            return Status(ErrorCodes::BadValue,
+                          "estimated counts do not support $near or $text queries");
+        }
+
+        long long sampled = 0;
+        long long matched = 0;
+        while (sampled < sampleSize && !iter->isEOF()) {
+            if (0 == sampled % kInterruptCheckPeriod) {
+                txn->checkForInterrupt();
+            }
+
+            const RecordId loc = iter->curr();
+            const BSONObj obj = iter->dataFor(loc).releaseToBson();
+            iter->getNext();
+
+            ++sampled;
+            if (filter->matchesBSON(obj)) {
+                ++matched;
+            }
+        }
+
+        if (0 == sampled) {
+            // The collection was emptied out from under us.
+            return Status::OK();
+        }
+
+        const double fraction = static_cast<double>(matched) / sampled;
+        long long n = static_cast<long long>(std::floor(fraction * numRecords + 0.5));
+
+        // The normal approximation to the binomial breaks down when nothing or everything
+        // matched, so fall back on the "rule of three" for the 95% bound there.
+        double errorBound;
+        if (0 == matched || sampled == matched) {
+            errorBound = 3.0 * numRecords / sampled;
+        }
+        else {
+            errorBound = kEstimateConfidenceZ * numRecords
+                         * std::sqrt(fraction * (1 - fraction) / sampled);
+        }
+
+        // For counts, skip and limit are applied to the number of matching documents.
+        n = std::max(0LL, n - request.skip);
+        if (request.limit > 0) {
+            n = std::min(n, request.limit);
+        }
+
+        out->n = n;
+        out->errorBound = errorBound;
+        out->confidence = kEstimateConfidence;
+        out->method = "randomSample";
+        out->examined = sampled;
+        out->complete = true;
+        *sampledOut = true;
+        return Status::OK();
+    }
+
+    Status estimateDistinct(PlanExecutor* exec,
+                            const std::string& key,
+                            long long maxScan,
+                            bool includeSketch,
+                            QueryEstimate* out) {
+        HyperLogLog sketch(kDistinctSketchPrecision);
+        long long examined = 0;
+        bool complete = true;
+
+        BSONObj obj;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, NULL))) {
+            if (examined >= maxScan) {
+                complete = false;
+                break;
+            }
+            ++examined;
+
+            BSONElementSet elts;
+            obj.getFieldsDotted(key, elts);
+            for (BSONElementSet::const_iterator it = elts.begin(); it != elts.end(); ++it) {
+                sketch.add(*it);
+            }
+        }
+
+        if (PlanExecutor::DEAD == state || PlanExecutor::FAILURE == state) {
+            return Status(ErrorCodes::OperationFailed,
+                          str::stream() << "executor error during distinct estimate: "
+                                        << WorkingSetCommon::toStatusString(obj));
+        }
+
+        *out = QueryEstimate::fromSketch(sketch, examined, complete);
+        if (includeSketch) {
+            out->sketch = sketch.getRegisters().toString();
+        }
+        return Status::OK();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,91 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/query/query_estimate_common.h"
+
+namespace mongo {
+
+    class BSONObj;
+    class Collection;
+    class OperationContext;
+    class PlanExecutor;
+    struct CountRequest;
+
+    // The largest number of records an estimated count may sample.
+    extern const long long kMaxEstimateSampleSize;
+
+    /**
+     * Reads the positive number 'fieldName' from 'cmdObj' into 'out', or 'defaultValue' if the
+     * field is absent. Returns BadValue if the field is not a number in [1, maxValue].
+     */
+    Status parseEstimateBudget(const BSONObj& cmdObj,
+                               StringData fieldName,
+                               long long defaultValue,
+                               long long maxValue,
+                               long long* out);
+
+    /**
+     * Estimates the result of 'request' by evaluating its query against 'sampleSize' records of
+     * 'collection' chosen at random, and scaling the fraction that match by the number of
+     * records in the collection.
+     *
+     * Sets '*sampledOut' to false and leaves 'out' untouched if the count should be run exactly
+     * instead: the collection is missing, the query is empty, the collection holds no more than
+     * 'sampleSize' records, or its storage engine can't position on random records.
+     *
+     * Returns a failure status if the query is invalid or uses $near or $text, which need an
+     * index to be evaluated.
+     */
+    Status sampleCount(OperationContext* txn,
+                       Collection* collection,
+                       const CountRequest& request,
+                       long long sampleSize,
+                       bool* sampledOut,
+                       QueryEstimate* out);
+
+    /**
+     * Estimates the number of distinct values of 'key' among the results of 'exec' with a
+     * HyperLogLog sketch, so that memory use does not grow with the number of values. Arrays
+     * are expanded as by the distinct command. Stops after examining 'maxScan' results.
+     *
+     * If 'includeSketch' is true, also returns the sketch in 'out', so that it can be merged with
+     * the sketches of other shards.
+     */
+    Status estimateDistinct(PlanExecutor* exec,
+                            const std::string& key,
+                            long long maxScan,
+                            bool includeSketch,
+                            QueryEstimate* out);
+
+}  // namespace mongo
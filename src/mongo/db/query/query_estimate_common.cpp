@@ -0,0 +1,135 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_estimate_common.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/hyperloglog.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    const double kEstimateConfidence = 0.95;
+    const double kEstimateConfidenceZ = 1.96;
+
+    QueryEstimate::QueryEstimate()
+        : n(0),
+          errorBound(0),
+          confidence(1),
+          method("exact"),
+          examined(0),
+          complete(true) { }
+
+    // static
+    QueryEstimate QueryEstimate::exact(long long n) {
+        QueryEstimate estimate;
+        estimate.n = n;
+        return estimate;
+    }
+
+    // static
+    QueryEstimate QueryEstimate::fromSketch(const HyperLogLog& sketch,
+                                            long long examined,
+                                            bool complete) {
+        const double value = sketch.estimate();
+
+        QueryEstimate estimate;
+        estimate.n = static_cast<long long>(std::floor(value + 0.5));
+        estimate.errorBound = kEstimateConfidenceZ * sketch.standardError() * value;
+        estimate.confidence = kEstimateConfidence;
+        estimate.method = "hyperLogLog";
+        estimate.examined = examined;
+        estimate.complete = complete;
+        return estimate;
+    }
+
+    // static
+    Status QueryEstimate::parseFromResponse(const BSONObj& response, QueryEstimate* out) {
+        const BSONElement estimateElt = response["estimate"];
+        if (Object != estimateElt.type() || !response["n"].isNumber()) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << "response has no estimate: " << response);
+        }
+        const BSONObj estimateObj = estimateElt.Obj();
+
+        QueryEstimate estimate;
+        estimate.n = response["n"].numberLong();
+        estimate.errorBound = estimateObj["errorBound"].numberDouble();
+        estimate.confidence = estimateObj["confidence"].numberDouble();
+        estimate.method = estimateObj["method"].str();
+        estimate.examined = estimateObj["examined"].numberLong();
+        estimate.complete = estimateObj["complete"].trueValue();
+
+        const BSONElement sketchElt = estimateObj["sketch"];
+        if (BinData == sketchElt.type()) {
+            int len;
+            const char* data = sketchElt.binData(len);
+            estimate.sketch.assign(data, len);
+        }
+
+        *out = estimate;
+        return Status::OK();
+    }
+
+    void QueryEstimate::appendToBuilder(BSONObjBuilder* bob) const {
+        bob->appendNumber("n", n);
+
+        BSONObjBuilder estimateBob(bob->subobjStart("estimate"));
+        estimateBob.append("method", method);
+        estimateBob.append("errorBound", errorBound);
+        estimateBob.append("confidence", confidence);
+        if (method != "exact") {
+            estimateBob.appendNumber("examined", examined);
+        }
+        estimateBob.append("complete", complete);
+        if (!sketch.empty()) {
+            estimateBob.appendBinData("sketch", sketch.size(), BinDataGeneral, sketch.data());
+        }
+        estimateBob.doneFast();
+    }
+
+    void QueryEstimate::addCount(const QueryEstimate& other) {
+        n += other.n;
+
+        // The errors of independent estimates are approximately normal, so their variances add.
+        errorBound = std::sqrt(errorBound * errorBound + other.errorBound * other.errorBound);
+        confidence = std::min(confidence, other.confidence);
+
+        if ("exact" != other.method) {
+            method = other.method;
+        }
+        examined += other.examined;
+        complete = complete && other.complete;
+    }
+
+}  // namespace mongo
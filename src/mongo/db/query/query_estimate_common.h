@@ -0,0 +1,106 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/status.h"
+
+namespace mongo {
+
+    class BSONObj;
+    class BSONObjBuilder;
+    class HyperLogLog;
+
+    // Estimates are reported at two-sided 95% confidence.
+    extern const double kEstimateConfidence;
+    extern const double kEstimateConfidenceZ;
+
+    /**
+     * An approximate answer to a count or distinct, which lies within 'errorBound' of the true
+     * answer with probability 'confidence'.
+     *
+     * Used both by mongod, which computes estimates, and by mongos, which merges the estimates of
+     * its shards.
+     */
+    struct QueryEstimate {
+        QueryEstimate();
+
+        /**
+         * Returns an "estimate" which is known to be exactly 'n'.
+         */
+        static QueryEstimate exact(long long n);
+
+        /**
+         * Returns the estimate of a distinct count given by 'sketch', which was built from
+         * 'examined' values.
+         */
+        static QueryEstimate fromSketch(const HyperLogLog& sketch,
+                                        long long examined,
+                                        bool complete);
+
+        /**
+         * Reads back an estimate from a command response written by appendToBuilder().
+         */
+        static Status parseFromResponse(const BSONObj& response, QueryEstimate* out);
+
+        /**
+         * Appends "n" and an "estimate" subdocument describing how accurate it is.
+         */
+        void appendToBuilder(BSONObjBuilder* bob) const;
+
+        /**
+         * Makes this the estimated count of the union of the documents counted by this and by
+         * 'other', which must be disjoint and estimated independently.
+         */
+        void addCount(const QueryEstimate& other);
+
+        long long n;
+
+        double errorBound;
+
+        double confidence;
+
+        // How 'n' was obtained: "randomSample", "hyperLogLog" or "exact".
+        std::string method;
+
+        // The number of records sampled or values examined.
+        long long examined;
+
+        // False if the cost budget ran out before every value was examined, in which case 'n'
+        // only describes the values that were.
+        bool complete;
+
+        // The registers of the HyperLogLog sketch behind a "hyperLogLog" estimate, if the
+        // caller asked for them with "includeSketch". Lets mongos merge the sketches of its
+        // shards. Empty otherwise.
+        std::string sketch;
+    };
+
+}  // namespace mongo
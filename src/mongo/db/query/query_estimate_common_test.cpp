@@ -0,0 +1,121 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_estimate_common.h"
+
+#include <cmath>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/hyperloglog.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    QueryEstimate roundTrip(const QueryEstimate& estimate) {
+        BSONObjBuilder bob;
+        estimate.appendToBuilder(&bob);
+
+        QueryEstimate parsed;
+        ASSERT_OK(QueryEstimate::parseFromResponse(bob.obj(), &parsed));
+        return parsed;
+    }
+
+    TEST(QueryEstimateTest, ResponseRoundTrip) {
+        QueryEstimate estimate;
+        estimate.n = 1234;
+        estimate.errorBound = 56.5;
+        estimate.confidence = kEstimateConfidence;
+        estimate.method = "randomSample";
+        estimate.examined = 2000;
+        estimate.complete = false;
+
+        const QueryEstimate parsed = roundTrip(estimate);
+        ASSERT_EQUALS(parsed.n, 1234);
+        ASSERT_EQUALS(parsed.errorBound, 56.5);
+        ASSERT_EQUALS(parsed.confidence, kEstimateConfidence);
+        ASSERT_EQUALS(parsed.method, "randomSample");
+        ASSERT_EQUALS(parsed.examined, 2000);
+        ASSERT_FALSE(parsed.complete);
+        ASSERT(parsed.sketch.empty());
+    }
+
+    TEST(QueryEstimateTest, SketchRoundTrip) {
+        HyperLogLog sketch(10);
+        for (int i = 0; i < 5000; ++i) {
+            sketch.add(BSON("" << i).firstElement());
+        }
+
+        QueryEstimate estimate = QueryEstimate::fromSketch(sketch, 5000, true);
+        estimate.sketch = sketch.getRegisters().toString();
+
+        const QueryEstimate parsed = roundTrip(estimate);
+        ASSERT_EQUALS(parsed.method, "hyperLogLog");
+        ASSERT_EQUALS(parsed.n, estimate.n);
+
+        HyperLogLog copy(4);
+        ASSERT_OK(HyperLogLog::fromRegisters(parsed.sketch, &copy));
+        ASSERT_EQUALS(copy.estimate(), sketch.estimate());
+    }
+
+    TEST(QueryEstimateTest, ParseRejectsResponseWithoutEstimate) {
+        QueryEstimate parsed;
+        ASSERT_NOT_OK(QueryEstimate::parseFromResponse(BSON("n" << 3 << "ok" << 1), &parsed));
+    }
+
+    TEST(QueryEstimateTest, AddCountSumsCountsAndVariances) {
+        QueryEstimate total;
+
+        total.addCount(QueryEstimate::exact(10));
+        ASSERT_EQUALS(total.n, 10);
+        ASSERT_EQUALS(total.method, "exact");
+        ASSERT_EQUALS(total.confidence, 1);
+
+        QueryEstimate sampled;
+        sampled.n = 100;
+        sampled.errorBound = 3;
+        sampled.confidence = kEstimateConfidence;
+        sampled.method = "randomSample";
+        sampled.examined = 50;
+        total.addCount(sampled);
+
+        sampled.errorBound = 4;
+        total.addCount(sampled);
+
+        ASSERT_EQUALS(total.n, 210);
+        ASSERT_EQUALS(total.errorBound, 5);
+        ASSERT_EQUALS(total.confidence, kEstimateConfidence);
+        ASSERT_EQUALS(total.method, "randomSample");
+        ASSERT_EQUALS(total.examined, 100);
+        ASSERT_TRUE(total.complete);
+    }
+
+}  // namespace
@@ -45,6 +45,10 @@ namespace mongo {
     // Stop working plans once a plan returns this many results.
     extern int internalQueryPlanEvaluationMaxResults;
 
+    // Stop working plans early once one plan is more productive than all the others by a
+    // statistically significant margin?
+    extern bool internalQueryPlanEvaluationEarlyCutoff;
+
     // Do we give a big ranking bonus to intersection plans?
     extern bool internalQueryForceIntersectionPlans;
 
@@ -72,6 +76,16 @@ namespace mongo {
     // How many write ops should we allow in a collection before tossing all cache entries?
     extern int internalQueryCacheWriteOpsBetweenFlush;
 
+    //
+    // query result cache
+    //
+
+    // How many bytes of cached replies may a collection's query result cache hold?
+    extern int internalQueryResultCacheMaxBytes;
+
+    // How large may a single reply be and still be cached?
+    extern int internalQueryResultCacheMaxReplyBytes;
+
     //
     // Planning and enumeration.
     //
@@ -104,4 +118,15 @@ namespace mongo {
     // Yield if it's been at least this many milliseconds since we last yielded.
     extern int internalQueryExecYieldPeriodMS;
 
+    //
+    // Estimated count and distinct.
+    //
+
+    // How many random records does an estimated count sample by default?
+    extern int internalQueryEstimateSampleSize;
+
+    // How many values may an estimated distinct examine by default before giving up on
+    // examining the rest?
+    extern int internalQueryEstimateMaxScan;
+
 }  // namespace mongo
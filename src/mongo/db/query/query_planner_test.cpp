@@ -2895,6 +2895,26 @@ namespace {
                                 "{filter: null, pattern: {x: 1}}}}}");
     }
 
+    // A count whose predicates are all answered by the index doesn't fetch.
+    TEST_F(QueryPlannerTest, CountIndexOnlyNoFetch) {
+        params.options = QueryPlannerParams::PRIVATE_IS_COUNT;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{a: {$gt: 1}, b: {$in: [/foo/, /bar/]}}"));
+
+        ASSERT_EQUALS(getNumSolutions(), 1U);
+        assertSolutionExists("{ixscan: {pattern: {a: 1, b: 1}}}");
+    }
+
+    // A count with a predicate the index can't answer still needs the fetch.
+    TEST_F(QueryPlannerTest, CountUnindexedPredicateFetches) {
+        params.options = QueryPlannerParams::PRIVATE_IS_COUNT;
+        addIndex(BSON("a" << 1));
+        runQuery(fromjson("{a: {$gt: 1}, c: 2}"));
+
+        ASSERT_EQUALS(getNumSolutions(), 1U);
+        assertSolutionExists("{fetch: {filter: {c: 2}, node: {ixscan: {pattern: {a: 1}}}}}");
+    }
+
     // No keep with geoNear.
     TEST_F(QueryPlannerTest, NoKeepWithGeoNear) {
         params.options = QueryPlannerParams::KEEP_MUTATIONS;
@@ -0,0 +1,181 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_result_cache.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/recovery_unit.h"
+
+namespace mongo {
+
+namespace {
+
+    /**
+     * Bumps a write epoch when the write that registered it commits or rolls back. A reply
+     * computed while the write was in progress may or may not reflect it, so either way the
+     * reply must not be cached.
+     */
+    class BumpWriteEpochChange : public RecoveryUnit::Change {
+    public:
+        explicit BumpWriteEpochChange(std::shared_ptr<AtomicUInt64> writeEpoch)
+            : _writeEpoch(std::move(writeEpoch)) { }
+
+        virtual void commit() { _writeEpoch->fetchAndAdd(1); }
+        virtual void rollback() { _writeEpoch->fetchAndAdd(1); }
+
+    private:
+        const std::shared_ptr<AtomicUInt64> _writeEpoch;
+    };
+
+    size_t entrySize(const std::string& key, const QueryResultCache::CachedReply& reply) {
+        return key.size() + reply.docs.size();
+    }
+
+} // namespace
+
+    QueryResultCache::QueryResultCache()
+        : _enabled(false),
+          _writeEpoch(std::make_shared<AtomicUInt64>(0)),
+          _entriesEpoch(0),
+          _bytes(0),
+          _hits(0),
+          _misses(0),
+          _evictions(0) { }
+
+    void QueryResultCache::setEnabled(bool enabled) {
+        if (!enabled) {
+            clear();
+        }
+        _enabled = enabled;
+    }
+
+    QueryResultCache::Epoch QueryResultCache::getWriteEpoch() const {
+        return _writeEpoch->load();
+    }
+
+    void QueryResultCache::notifyOfWriteOp(OperationContext* txn) {
+        if (!_enabled) {
+            return;
+        }
+        _writeEpoch->fetchAndAdd(1);
+        txn->recoveryUnit()->registerChange(new BumpWriteEpochChange(_writeEpoch));
+    }
+
+    std::shared_ptr<const QueryResultCache::CachedReply> QueryResultCache::get(
+            const std::string& key) {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+
+        if (_writeEpoch->load() != _entriesEpoch) {
+            // Everything cached was computed before the latest write.
+            _clear_inlock();
+            _entriesEpoch = _writeEpoch->load();
+        }
+
+        unordered_map<std::string, EntryList::iterator>::const_iterator it = _index.find(key);
+        if (it == _index.end()) {
+            ++_misses;
+            return std::shared_ptr<const CachedReply>();
+        }
+
+        ++_hits;
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return it->second->second;
+    }
+
+    void QueryResultCache::add(const std::string& key,
+                               Epoch epoch,
+                               StringData docs,
+                               int nReturned,
+                               bool slaveOk) {
+        const size_t size = key.size() + docs.size();
+        if (size > static_cast<size_t>(internalQueryResultCacheMaxReplyBytes) ||
+                _writeEpoch->load() != epoch) {
+            return;
+        }
+
+        std::shared_ptr<const CachedReply> reply =
+            std::make_shared<CachedReply>(docs.toString(), nReturned, slaveOk);
+
+        boost::lock_guard<boost::mutex> lock(_mutex);
+
+        if (_writeEpoch->load() != epoch) {
+            return;
+        }
+        if (_entriesEpoch != epoch) {
+            _clear_inlock();
+            _entriesEpoch = epoch;
+        }
+
+        unordered_map<std::string, EntryList::iterator>::iterator it = _index.find(key);
+        if (it != _index.end()) {
+            // Another thread computed the same reply concurrently.
+            _bytes -= entrySize(key, *it->second->second);
+            _entries.erase(it->second);
+            _index.erase(it);
+        }
+
+        _entries.push_front(Entry(key, std::move(reply)));
+        _index[key] = _entries.begin();
+        _bytes += size;
+
+        const size_t maxBytes = static_cast<size_t>(internalQueryResultCacheMaxBytes);
+        while (_bytes > maxBytes && !_entries.empty()) {
+            const Entry& lru = _entries.back();
+            _bytes -= entrySize(lru.first, *lru.second);
+            _index.erase(lru.first);
+            _entries.pop_back();
+            ++_evictions;
+        }
+    }
+
+    void QueryResultCache::clear() {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _writeEpoch->fetchAndAdd(1);
+        _clear_inlock();
+    }
+
+    void QueryResultCache::_clear_inlock() {
+        _entries.clear();
+        _index.clear();
+        _bytes = 0;
+    }
+
+    void QueryResultCache::appendStats(BSONObjBuilder* builder) const {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        builder->appendNumber("entries", static_cast<long long>(_entries.size()));
+        builder->appendNumber("bytes", static_cast<long long>(_bytes));
+        builder->appendNumber("hits", _hits);
+        builder->appendNumber("misses", _misses);
+        builder->appendNumber("evictions", _evictions);
+    }
+
+}  // namespace mongo
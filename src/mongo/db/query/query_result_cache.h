@@ -0,0 +1,159 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/unordered_map.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class OperationContext;
+
+    /**
+     * A cache of complete query replies for a single collection, so that a query which is issued
+     * over and over again against data that rarely changes can be answered without being parsed,
+     * planned or executed.
+     *
+     * Every cached reply is tagged with the collection's write epoch as of just before the query
+     * that produced it started reading, and is only served while the epoch is unchanged. The epoch
+     * is bumped on every write to the collection, both when the write is made and when its unit
+     * of work commits or rolls back, so a reply is never served once the data it was computed
+     * from may have changed.
+     *
+     * The cache is disabled by default. Callers must hold the collection lock in exclusive mode to
+     * enable or disable it, and in at least intent shared mode for everything else.
+     */
+    class QueryResultCache {
+        MONGO_DISALLOW_COPYING(QueryResultCache);
+    public:
+        typedef unsigned long long Epoch;
+
+        /**
+         * The result documents of a query, concatenated in order as they appear in an OP_REPLY.
+         */
+        struct CachedReply {
+            CachedReply(std::string docs, int nReturned, bool slaveOk)
+                : docs(std::move(docs)), nReturned(nReturned), slaveOk(slaveOk) { }
+
+            const std::string docs;
+            const int nReturned;
+
+            // Whether the query that produced the reply may be served by a secondary.
+            const bool slaveOk;
+        };
+
+        QueryResultCache();
+
+        bool isEnabled() const { return _enabled; }
+
+        /**
+         * Enables or disables the cache. Disabling it drops all cached replies.
+         */
+        void setEnabled(bool enabled);
+
+        /**
+         * Returns the current write epoch. A query that wants to cache its reply must read this
+         * before it takes its storage snapshot, and pass it to add().
+         */
+        Epoch getWriteEpoch() const;
+
+        /**
+         * Must be called inside the WriteUnitOfWork of every write to the collection. Invalidates
+         * all cached replies, and arranges for any reply computed before the write commits or
+         * rolls back to be refused by add().
+         */
+        void notifyOfWriteOp(OperationContext* txn);
+
+        /**
+         * Returns the reply cached under 'key', or an empty pointer if there is none or it has
+         * been invalidated by a write.
+         */
+        std::shared_ptr<const CachedReply> get(const std::string& key);
+
+        /**
+         * Caches a reply of 'nReturned' documents, concatenated in 'docs', under 'key'. The reply
+         * must have been computed by a query that read the write epoch 'epoch' before it started.
+         *
+         * Does nothing if the collection has been written since, or if the reply is larger than
+         * internalQueryResultCacheMaxReplyBytes. Evicts the least recently used replies as needed
+         * to keep within internalQueryResultCacheMaxBytes.
+         */
+        void add(const std::string& key,
+                 Epoch epoch,
+                 StringData docs,
+                 int nReturned,
+                 bool slaveOk);
+
+        /**
+         * Drops all cached replies. Also refuses any reply still being computed.
+         */
+        void clear();
+
+        /**
+         * Appends the size of the cache and how often it has been hit to 'builder'.
+         */
+        void appendStats(BSONObjBuilder* builder) const;
+
+    private:
+        typedef std::pair<std::string, std::shared_ptr<const CachedReply>> Entry;
+        typedef std::list<Entry> EntryList;
+
+        void _clear_inlock();
+
+        // Protected by the collection lock.
+        bool _enabled;
+
+        // Shared with the RecoveryUnit::Changes which bump it, since those may outlive the cache.
+        const std::shared_ptr<AtomicUInt64> _writeEpoch;
+
+        // Protects everything below.
+        mutable boost::mutex _mutex;
+
+        // The write epoch at which every reply in '_entries' was computed.
+        Epoch _entriesEpoch;
+
+        // Most recently used first.
+        EntryList _entries;
+        unordered_map<std::string, EntryList::iterator> _index;
+        size_t _bytes;
+
+        long long _hits;
+        long long _misses;
+        long long _evictions;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,167 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_result_cache.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    typedef std::shared_ptr<const QueryResultCache::CachedReply> CachedReplyPtr;
+
+    void addReply(QueryResultCache* cache,
+                  const std::string& key,
+                  QueryResultCache::Epoch epoch,
+                  const std::string& docs) {
+        cache->add(key, epoch, docs, 1, false);
+    }
+
+    void assertCached(QueryResultCache* cache, const std::string& key, const std::string& docs) {
+        CachedReplyPtr reply = cache->get(key);
+        ASSERT(reply);
+        ASSERT_EQUALS(reply->docs, docs);
+        ASSERT_EQUALS(reply->nReturned, 1);
+    }
+
+    void assertNotCached(QueryResultCache* cache, const std::string& key) {
+        ASSERT(!cache->get(key));
+    }
+
+    TEST(QueryResultCacheTest, DisabledByDefault) {
+        QueryResultCache cache;
+        ASSERT_FALSE(cache.isEnabled());
+    }
+
+    TEST(QueryResultCacheTest, AddAndGet) {
+        QueryResultCache cache;
+        cache.setEnabled(true);
+
+        assertNotCached(&cache, "a");
+        addReply(&cache, "a", cache.getWriteEpoch(), "reply a");
+        addReply(&cache, "b", cache.getWriteEpoch(), "reply b");
+        assertCached(&cache, "a", "reply a");
+        assertCached(&cache, "b", "reply b");
+        assertNotCached(&cache, "c");
+
+        BSONObjBuilder bob;
+        cache.appendStats(&bob);
+        BSONObj stats = bob.obj();
+        ASSERT_EQUALS(stats["entries"].numberLong(), 2);
+        ASSERT_EQUALS(stats["hits"].numberLong(), 2);
+        ASSERT_EQUALS(stats["misses"].numberLong(), 2);
+    }
+
+    TEST(QueryResultCacheTest, WriteInvalidatesCachedReplies) {
+        OperationContextNoop txn;
+        QueryResultCache cache;
+        cache.setEnabled(true);
+
+        addReply(&cache, "a", cache.getWriteEpoch(), "reply a");
+        assertCached(&cache, "a", "reply a");
+
+        cache.notifyOfWriteOp(&txn);
+        assertNotCached(&cache, "a");
+    }
+
+    TEST(QueryResultCacheTest, RefusesReplyComputedBeforeWrite) {
+        OperationContextNoop txn;
+        QueryResultCache cache;
+        cache.setEnabled(true);
+
+        const QueryResultCache::Epoch epoch = cache.getWriteEpoch();
+        cache.notifyOfWriteOp(&txn);
+        addReply(&cache, "a", epoch, "reply a");
+        assertNotCached(&cache, "a");
+
+        addReply(&cache, "a", cache.getWriteEpoch(), "reply a");
+        assertCached(&cache, "a", "reply a");
+    }
+
+    TEST(QueryResultCacheTest, ClearDropsCachedReplies) {
+        QueryResultCache cache;
+        cache.setEnabled(true);
+
+        const QueryResultCache::Epoch epoch = cache.getWriteEpoch();
+        addReply(&cache, "a", epoch, "reply a");
+        cache.clear();
+        assertNotCached(&cache, "a");
+
+        // A reply being computed while the cache was cleared must be refused.
+        addReply(&cache, "b", epoch, "reply b");
+        assertNotCached(&cache, "b");
+    }
+
+    TEST(QueryResultCacheTest, DisablingDropsCachedReplies) {
+        QueryResultCache cache;
+        cache.setEnabled(true);
+
+        addReply(&cache, "a", cache.getWriteEpoch(), "reply a");
+        cache.setEnabled(false);
+        cache.setEnabled(true);
+        assertNotCached(&cache, "a");
+    }
+
+    TEST(QueryResultCacheTest, RefusesOversizedReply) {
+        QueryResultCache cache;
+        cache.setEnabled(true);
+
+        const std::string docs(internalQueryResultCacheMaxReplyBytes, 'x');
+        addReply(&cache, "a", cache.getWriteEpoch(), docs);
+        assertNotCached(&cache, "a");
+    }
+
+    TEST(QueryResultCacheTest, EvictsLeastRecentlyUsed) {
+        const int oldMaxBytes = internalQueryResultCacheMaxBytes;
+        internalQueryResultCacheMaxBytes = 3 * 10;
+
+        QueryResultCache cache;
+        cache.setEnabled(true);
+
+        // Each entry takes 10 bytes, key included.
+        addReply(&cache, "a", cache.getWriteEpoch(), "reply a  ");
+        addReply(&cache, "b", cache.getWriteEpoch(), "reply b  ");
+        addReply(&cache, "c", cache.getWriteEpoch(), "reply c  ");
+        assertCached(&cache, "a", "reply a  ");
+
+        addReply(&cache, "d", cache.getWriteEpoch(), "reply d  ");
+        assertCached(&cache, "a", "reply a  ");
+        assertNotCached(&cache, "b");
+        assertCached(&cache, "c", "reply c  ");
+        assertCached(&cache, "d", "reply d  ");
+
+        internalQueryResultCacheMaxBytes = oldMaxBytes;
+    }
+
+} // namespace
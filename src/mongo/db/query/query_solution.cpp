@@ -105,7 +105,10 @@ namespace mongo {
     // CollectionScanNode
     //
 
-    CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), maxScan(0) { }
+    CollectionScanNode::CollectionScanNode() : tailable(false),
+                                               direction(1),
+                                               maxScan(0),
+                                               countOnly(false) { }
 
     void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
         addIndent(ss, indent);
@@ -116,6 +119,10 @@ namespace mongo {
             addIndent(ss, indent + 1);
             *ss << "filter = " << filter->toString();
         }
+        if (countOnly) {
+            addIndent(ss, indent + 1);
+            *ss << "countOnly = true\n";
+        }
         addCommon(ss, indent);
     }
 
@@ -128,6 +135,7 @@ namespace mongo {
         copy->tailable = this->tailable;
         copy->direction = this->direction;
         copy->maxScan = this->maxScan;
+        copy->countOnly = this->countOnly;
 
         return copy;
     }
@@ -274,6 +274,9 @@ namespace mongo {
 
         // maxScan option to .find() limits how many docs we look at.
         int maxScan;
+
+        // Set when the scan feeds a count directly and its results need not be materialized.
+        bool countOnly;
     };
 
     struct AndHashNode : public QuerySolutionNode {
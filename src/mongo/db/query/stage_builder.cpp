@@ -70,6 +70,7 @@ namespace mongo {
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
+            params.countOnly = csn->countOnly;
             return new CollectionScan(txn, params, ws, csn->filter.get());
         }
         else if (STAGE_IXSCAN == root->getType()) {
@@ -279,8 +280,25 @@ namespace mongo {
             const ShardingFilterNode* fn = static_cast<const ShardingFilterNode*>(root);
             PlanStage* childStage = buildStages(txn, collection, qsol, fn->children[0], ws);
             if (NULL == childStage) { return NULL; }
-            return new ShardFilterStage(shardingState.getCollectionMetadata(collection->ns()),
-                                        ws, childStage);
+
+            CollectionMetadataPtr metadata = shardingState.getCollectionMetadata(collection->ns());
+
+            // If the documents come from a single index scan which stays inside a range owned by
+            // this shard, there is no need to filter them one by one.
+            const QuerySolutionNode* scanNode = fn->children[0];
+            if (STAGE_FETCH == scanNode->getType()) {
+                scanNode = scanNode->children[0];
+            }
+
+            bool childRangeOwned = false;
+            if (metadata && STAGE_IXSCAN == scanNode->getType()) {
+                const IndexScanNode* ixn = static_cast<const IndexScanNode*>(scanNode);
+                childRangeOwned = ShardFilterStage::indexBoundsOwned(metadata,
+                                                                     ixn->indexKeyPattern,
+                                                                     ixn->bounds);
+            }
+
+            return new ShardFilterStage(metadata, ws, childStage, childRangeOwned);
         }
         else if (STAGE_KEEP_MUTATIONS == root->getType()) {
             const KeepMutationsNode* km = static_cast<const KeepMutationsNode*>(root);
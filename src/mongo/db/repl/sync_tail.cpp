@@ -39,6 +39,7 @@
 #include "third_party/murmurhash3/MurmurHash3.h"
 
 #include "mongo/base/counter.h"
+#include "mongo/bson/bson_field_lookup.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
@@ -307,7 +308,9 @@ namespace {
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
-            const BSONElement e = it->getField("ns");
+            // Each op is probed for several fields, so avoid rescanning it for every one.
+            BSONFieldLookup opFields(*it);
+            const BSONElement e = opFields.getField("ns");
             //log() << "LX: fillWriterVectors: e.type: " << int(e.type());
             //log() << "LX: op size: " << (*it).objsize() << " op string: " << (*it).jsonString(Strict, 1);
             verify(e.type() == String);
@@ -316,18 +319,18 @@ namespace {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
-            const char* opType = it->getField( "op" ).valuestrsafe();
+            const char* opType = opFields.getField("op").valuestrsafe();
 
             if (getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking() &&
                 isCrudOpType(opType)) {
                 BSONElement id;
                 switch (opType[0]) {
                 case 'u':
-                    id = it->getField("o2").Obj()["_id"];
+                    id = opFields.getField("o2").Obj()["_id"];
                     break;
                 case 'd':
                 case 'i':
-                    id = it->getField("o").Obj()["_id"];
+                    id = opFields.getField("o").Obj()["_id"];
                     break;
                 }
 
@@ -0,0 +1,602 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/cpu_sampler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+
+#include "mongo/config.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+
+#if !defined(_WIN32) && defined(MONGO_CONFIG_HAVE___THREAD)
+#define MONGO_HAVE_CPU_SAMPLER
+#endif
+
+// Stacks are walked along the frame pointers, starting from the interrupted context
+#if defined(MONGO_HAVE_CPU_SAMPLER) && defined(__linux__) && defined(__x86_64__)
+#define MONGO_HAVE_CPU_SAMPLER_STACKS
+#endif
+
+#if defined(MONGO_HAVE_CPU_SAMPLER)
+#include <atomic>
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/time.h>
+#endif
+
+#if defined(MONGO_HAVE_CPU_SAMPLER_STACKS)
+#include <pthread.h>
+#include <ucontext.h>
+#endif
+
+namespace mongo {
+
+    using std::string;
+
+namespace {
+
+    // Samples per second of CPU time consumed by the process, zero turns sampling off
+    int cpuSamplingHz = 0;
+
+    const int kMaxCpuSamplingHz = 1000;
+
+    class ExportedCpuSamplingHzParameter : public ExportedServerParameter<int> {
+    public:
+        ExportedCpuSamplingHzParameter() :
+            ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                         "cpuSamplingHz",
+                                         &cpuSamplingHz,
+                                         true,
+                                         true) {}
+
+        virtual Status validate( const int& potentialNewValue ) {
+            if (potentialNewValue < 0 || potentialNewValue > kMaxCpuSamplingHz) {
+                return Status(ErrorCodes::BadValue,
+                              "cpuSamplingHz must be between 0 and 1000");
+            }
+            return Status::OK();
+        }
+
+    } exportedCpuSamplingHzParam;
+
+    const size_t kMaxNsLength = 127;
+
+    // Reported for samples taken while no operation was running on the thread
+    const char kNoOperation[] = "none";
+
+    std::string formatFrame(const void* address) {
+        std::ostringstream os;
+#if defined(MONGO_HAVE_CPU_SAMPLER)
+        Dl_info dlinfo;
+        if (dladdr(address, &dlinfo) && dlinfo.dli_fbase) {
+            if (dlinfo.dli_sname) {
+                const uintptr_t offset = uintptr_t(address) - uintptr_t(dlinfo.dli_saddr);
+                os << dlinfo.dli_sname << "+0x" << std::hex << offset;
+            }
+            else {
+                const char* slash = strrchr(dlinfo.dli_fname, '/');
+                const uintptr_t offset = uintptr_t(address) - uintptr_t(dlinfo.dli_fbase);
+                os << (slash ? slash + 1 : dlinfo.dli_fname) << "+0x" << std::hex << offset;
+            }
+            return os.str();
+        }
+#endif
+        os << address;
+        return os.str();
+    }
+
+    template <typename Entry>
+    bool hasMoreSamples(const Entry& a, const Entry& b) {
+        return a.second.samples > b.second.samples;
+    }
+
+    bool stackHasMoreSamples(const std::pair<std::vector<const void*>, long long>& a,
+                             const std::pair<std::vector<const void*>, long long>& b) {
+        return a.second > b.second;
+    }
+
+} // namespace
+
+    const int CpuSampleAggregator::kBucketSecs;
+    const int CpuSampleAggregator::kRetentionSecs;
+    const size_t CpuSampleAggregator::kMaxGroupsPerBucket;
+    const size_t CpuSampleAggregator::kMaxStacksPerBucket;
+    const size_t CpuSampleAggregator::kMaxOpIdsPerBucket;
+
+    void CpuSampleAggregator::record(long long when,
+                                     unsigned opId,
+                                     StringData operation,
+                                     StringData ns,
+                                     const void* const* frames,
+                                     int numFrames) {
+        const long long bucketStart = when - (when % kBucketSecs);
+
+        if (_buckets.empty() || _buckets.back().start < bucketStart) {
+            _buckets.push_back(Bucket(bucketStart));
+
+            while (_buckets.front().start + kRetentionSecs <= _buckets.back().start) {
+                _buckets.pop_front();
+            }
+        }
+
+        // Samples are collected in batches, so a few may arrive after their bucket was closed.
+        // These go to the newest bucket, which is not later than them.
+        std::deque<Bucket>::reverse_iterator bucket = _buckets.rbegin();
+        while (bucket->start > bucketStart && (bucket + 1) != _buckets.rend()) {
+            ++bucket;
+        }
+
+        const GroupKey key(operation.toString(), ns.toString());
+        std::map<GroupKey, Group>::iterator groupIt = bucket->groups.find(key);
+        if (groupIt == bucket->groups.end()) {
+            if (bucket->groups.size() >= kMaxGroupsPerBucket) {
+                bucket->samplesOverLimits++;
+                return;
+            }
+            groupIt = bucket->groups.insert(std::make_pair(key, Group())).first;
+        }
+
+        Group& group = groupIt->second;
+        group.samples++;
+
+        if (bucket->numOpIds < kMaxOpIdsPerBucket && group.opIds.insert(opId).second) {
+            bucket->numOpIds++;
+        }
+
+        const Stack stack(frames, frames + numFrames);
+        std::map<Stack, long long>::iterator stackIt = group.stacks.find(stack);
+        if (stackIt != group.stacks.end()) {
+            stackIt->second++;
+        }
+        else if (bucket->numStacks < kMaxStacksPerBucket) {
+            group.stacks.insert(std::make_pair(stack, 1LL));
+            bucket->numStacks++;
+        }
+        else {
+            bucket->samplesWithoutStack++;
+        }
+    }
+
+    void CpuSampleAggregator::append(long long now,
+                                     int windowSecs,
+                                     int maxGroups,
+                                     int maxStacks,
+                                     BSONObjBuilder* builder) const {
+        typedef std::map<GroupKey, Group> GroupMap;
+
+        GroupMap merged;
+        long long samples = 0;
+        long long samplesOverLimits = 0;
+        long long samplesWithoutStack = 0;
+        for (std::deque<Bucket>::const_iterator bucket = _buckets.begin();
+             bucket != _buckets.end();
+             ++bucket) {
+            if (bucket->start + kBucketSecs <= now - windowSecs) {
+                continue;
+            }
+
+            samplesOverLimits += bucket->samplesOverLimits;
+            samplesWithoutStack += bucket->samplesWithoutStack;
+
+            for (GroupMap::const_iterator it = bucket->groups.begin();
+                 it != bucket->groups.end();
+                 ++it) {
+                Group& group = merged[it->first];
+                group.samples += it->second.samples;
+                group.opIds.insert(it->second.opIds.begin(), it->second.opIds.end());
+                for (std::map<Stack, long long>::const_iterator stack = it->second.stacks.begin();
+                     stack != it->second.stacks.end();
+                     ++stack) {
+                    group.stacks[stack->first] += stack->second;
+                }
+                samples += it->second.samples;
+            }
+        }
+
+        std::vector<std::pair<GroupKey, Group> > groups(merged.begin(), merged.end());
+        std::sort(groups.begin(), groups.end(), hasMoreSamples<std::pair<GroupKey, Group> >);
+        if (groups.size() > static_cast<size_t>(maxGroups)) {
+            groups.resize(maxGroups);
+        }
+
+        builder->append("samples", samples);
+        builder->append("samplesOverLimits", samplesOverLimits);
+        builder->append("samplesWithoutStack", samplesWithoutStack);
+
+        BSONArrayBuilder groupsBuilder(builder->subarrayStart("groups"));
+        for (size_t i = 0; i < groups.size(); i++) {
+            const Group& group = groups[i].second;
+
+            BSONObjBuilder groupBuilder(groupsBuilder.subobjStart());
+            groupBuilder.append("op", groups[i].first.first);
+            groupBuilder.append("ns", groups[i].first.second);
+            groupBuilder.append("samples", group.samples);
+            groupBuilder.append("operations", static_cast<long long>(group.opIds.size()));
+
+            std::vector<std::pair<Stack, long long> > stacks(group.stacks.begin(),
+                                                             group.stacks.end());
+            std::sort(stacks.begin(), stacks.end(), stackHasMoreSamples);
+            if (stacks.size() > static_cast<size_t>(maxStacks)) {
+                stacks.resize(maxStacks);
+            }
+
+            BSONArrayBuilder stacksBuilder(groupBuilder.subarrayStart("stacks"));
+            for (size_t j = 0; j < stacks.size(); j++) {
+                BSONObjBuilder stackBuilder(stacksBuilder.subobjStart());
+                stackBuilder.append("samples", stacks[j].second);
+
+                BSONArrayBuilder framesBuilder(stackBuilder.subarrayStart("frames"));
+                for (size_t k = 0; k < stacks[j].first.size(); k++) {
+                    framesBuilder.append(formatFrame(stacks[j].first[k]));
+                }
+                framesBuilder.doneFast();
+                stackBuilder.doneFast();
+            }
+            stacksBuilder.doneFast();
+            groupBuilder.doneFast();
+        }
+        groupsBuilder.doneFast();
+    }
+
+    long long CpuSampleAggregator::numSamples() const {
+        long long samples = 0;
+        for (std::deque<Bucket>::const_iterator bucket = _buckets.begin();
+             bucket != _buckets.end();
+             ++bucket) {
+            for (std::map<GroupKey, Group>::const_iterator it = bucket->groups.begin();
+                 it != bucket->groups.end();
+                 ++it) {
+                samples += it->second.samples;
+            }
+        }
+        return samples;
+    }
+
+namespace {
+
+    SimpleMutex aggregatorMutex("CpuSampleAggregator");
+    CpuSampleAggregator aggregator;
+
+    // Sampling rate currently programmed into the profiling timer
+    AtomicInt32 activeHz;
+
+    AtomicInt64 collectedSamples;
+    AtomicInt64 droppedSamples;
+
+} // namespace
+
+#if defined(MONGO_HAVE_CPU_SAMPLER)
+
+namespace {
+
+    /**
+     * What the thread is working on. Only changed by the thread itself, so the signal handler,
+     * which interrupts that same thread, only needs to know whether an update is in progress.
+     */
+    struct ThreadSampleTag {
+        volatile sig_atomic_t updating;
+        unsigned opId;
+        const char* operation;
+        char ns[kMaxNsLength + 1];
+
+        // Top of the thread's stack, which bounds the frame pointer walk. Zero until the thread
+        // first sets an operation, or if it could not be found.
+        volatile uintptr_t stackTop;
+        bool stackTopChecked;
+    };
+
+    __thread ThreadSampleTag threadSampleTag;
+
+    class TagUpdate {
+    public:
+        TagUpdate() {
+            threadSampleTag.updating = 1;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        }
+
+        ~TagUpdate() {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            threadSampleTag.updating = 0;
+        }
+    };
+
+    const int kMaxFrames = 32;
+
+    /**
+     * A sample taken by the signal handler, waiting to be aggregated. The handler may only
+     * fill a free slot and the collector thread frees it after copying it out.
+     */
+    struct RawSample {
+        enum State {
+            kFree = 0,
+            kFilling,
+            kReady,
+        };
+
+        AtomicUInt32 state;
+        long long when;
+        unsigned opId;
+        const char* operation;
+        char ns[kMaxNsLength + 1];
+        int numFrames;
+        const void* frames[kMaxFrames];
+    };
+
+    // Enough for a second of samples at the highest rate, the collector drains it every second
+    const unsigned kNumRawSamples = 1024;
+
+    RawSample rawSamples[kNumRawSamples];
+    AtomicUInt32 nextRawSample;
+
+    /**
+     * Fills 'frames' with the interrupted instruction and the return addresses found by following
+     * the frame pointers from 'context', innermost first, and returns how many there are.
+     *
+     * Runs in the signal handler, so it may not call anything which isn't async-signal-safe.
+     * Every frame pointer is checked to lie between the interrupted stack pointer and the top of
+     * the thread's stack before it is read, so code built without frame pointers yields short or
+     * bogus stacks, but never faults.
+     */
+    int walkStack(void* context, uintptr_t stackTop, const void** frames, int maxFrames) {
+#if defined(MONGO_HAVE_CPU_SAMPLER_STACKS)
+        const mcontext_t& mcontext = static_cast<const ucontext_t*>(context)->uc_mcontext;
+        uintptr_t sp = mcontext.gregs[REG_RSP];
+        uintptr_t fp = mcontext.gregs[REG_RBP];
+
+        int numFrames = 0;
+        frames[numFrames++] = reinterpret_cast<const void*>(mcontext.gregs[REG_RIP]);
+
+        // A frame holds the caller's frame pointer followed by the return address
+        while (numFrames < maxFrames
+                && fp >= sp
+                && stackTop >= 2 * sizeof(uintptr_t)
+                && fp <= stackTop - 2 * sizeof(uintptr_t)
+                && fp % sizeof(uintptr_t) == 0) {
+            const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(fp);
+            const uintptr_t returnAddress = frame[1];
+            if (!returnAddress) {
+                break;
+            }
+            frames[numFrames++] = reinterpret_cast<const void*>(returnAddress);
+
+            // Stacks grow down, so callers' frames are always further up
+            sp = fp + 2 * sizeof(uintptr_t);
+            fp = frame[0];
+        }
+        return numFrames;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * Looks up the top of the calling thread's stack, once per thread, outside of the signal
+     * handler since pthread_getattr_np() is not async-signal-safe.
+     */
+    void checkThreadStackTop() {
+#if defined(MONGO_HAVE_CPU_SAMPLER_STACKS)
+        if (threadSampleTag.stackTopChecked) {
+            return;
+        }
+        threadSampleTag.stackTopChecked = true;
+
+        pthread_attr_t attr;
+        if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+            return;
+        }
+
+        void* stackAddr = NULL;
+        size_t stackSize = 0;
+        if (pthread_attr_getstack(&attr, &stackAddr, &stackSize) == 0) {
+            threadSampleTag.stackTop = reinterpret_cast<uintptr_t>(stackAddr) + stackSize;
+        }
+        pthread_attr_destroy(&attr);
+#endif
+    }
+
+    void cpuSampleHandler(int, siginfo_t*, void* context) {
+        const int savedErrno = errno;
+
+        RawSample& sample = rawSamples[nextRawSample.fetchAndAdd(1) % kNumRawSamples];
+        if (sample.state.compareAndSwap(RawSample::kFree, RawSample::kFilling) !=
+                RawSample::kFree) {
+            droppedSamples.fetchAndAdd(1);
+            errno = savedErrno;
+            return;
+        }
+
+        sample.when = time(NULL);
+
+        const ThreadSampleTag& tag = threadSampleTag;
+        if (tag.updating || !tag.operation) {
+            sample.opId = 0;
+            sample.operation = NULL;
+            sample.ns[0] = '\0';
+        }
+        else {
+            sample.opId = tag.opId;
+            sample.operation = tag.operation;
+            memcpy(sample.ns, tag.ns, sizeof(sample.ns));
+        }
+
+        sample.numFrames = walkStack(context, tag.stackTop, sample.frames, kMaxFrames);
+        sample.state.store(RawSample::kReady);
+
+        errno = savedErrno;
+    }
+
+    void setSamplingTimer(int hz) {
+        struct itimerval timer;
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = hz ? 1000 * 1000 / hz : 0;
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+            const int err = errno;
+            warning() << "failed to set the CPU sampling timer: " << errnoWithDescription(err);
+        }
+    }
+
+    void collectRawSamples() {
+        SimpleMutex::scoped_lock lk(aggregatorMutex);
+
+        for (unsigned i = 0; i < kNumRawSamples; i++) {
+            RawSample& sample = rawSamples[i];
+            if (sample.state.load() != RawSample::kReady) {
+                continue;
+            }
+
+            aggregator.record(sample.when,
+                              sample.opId,
+                              sample.operation ? sample.operation : kNoOperation,
+                              sample.ns,
+                              sample.frames,
+                              sample.numFrames);
+            collectedSamples.fetchAndAdd(1);
+
+            sample.state.store(RawSample::kFree);
+        }
+    }
+
+    class CpuSamplerJob : public BackgroundJob {
+    public:
+        CpuSamplerJob() : BackgroundJob(false /* selfDelete */) { }
+
+        virtual std::string name() const { return "CpuSampler"; }
+
+        virtual void run() {
+            struct sigaction action;
+            memset(&action, 0, sizeof(action));
+            action.sa_sigaction = cpuSampleHandler;
+            action.sa_flags = SA_RESTART | SA_SIGINFO;
+            sigemptyset(&action.sa_mask);
+            if (sigaction(SIGPROF, &action, NULL) != 0) {
+                const int err = errno;
+                warning() << "CPU sampling is not available, could not install the SIGPROF "
+                          << "handler: " << errnoWithDescription(err);
+                return;
+            }
+
+            while (!inShutdown()) {
+                const int hz = cpuSamplingHz;
+                if (hz != activeHz.load()) {
+                    if (hz) {
+                        log() << "CPU sampling at " << hz << " samples per CPU second";
+                    }
+                    else {
+                        log() << "CPU sampling turned off";
+                    }
+                    setSamplingTimer(hz);
+                    activeHz.store(hz);
+                }
+
+                collectRawSamples();
+                sleepsecs(1);
+            }
+
+            setSamplingTimer(0);
+            activeHz.store(0);
+        }
+    };
+
+    CpuSamplerJob cpuSamplerJob;
+
+} // namespace
+
+    void setCpuSampleOperation(unsigned opId, const char* operation) {
+        checkThreadStackTop();
+
+        TagUpdate update;
+        threadSampleTag.opId = opId;
+        threadSampleTag.operation = operation;
+        threadSampleTag.ns[0] = '\0';
+    }
+
+    void setCpuSampleNamespace(StringData ns) {
+        TagUpdate update;
+        const size_t length = std::min(ns.size(), kMaxNsLength);
+        memcpy(threadSampleTag.ns, ns.rawData(), length);
+        threadSampleTag.ns[length] = '\0';
+    }
+
+    void clearCpuSampleOperation() {
+        TagUpdate update;
+        threadSampleTag.opId = 0;
+        threadSampleTag.operation = NULL;
+        threadSampleTag.ns[0] = '\0';
+    }
+
+    void startCpuSampler() {
+        cpuSamplerJob.go();
+    }
+
+#else
+
+    void setCpuSampleOperation(unsigned opId, const char* operation) { }
+    void setCpuSampleNamespace(StringData ns) { }
+    void clearCpuSampleOperation() { }
+
+    void startCpuSampler() {
+        if (cpuSamplingHz) {
+            warning() << "CPU sampling is not supported on this platform";
+        }
+    }
+
+#endif
+
+    void appendCpuSamples(int windowSecs, int maxGroups, int maxStacks, BSONObjBuilder* builder) {
+#if defined(MONGO_HAVE_CPU_SAMPLER)
+        builder->append("supported", true);
+#else
+        builder->append("supported", false);
+#endif
+        builder->append("hz", activeHz.load());
+        builder->append("windowSecs", windowSecs);
+        builder->append("collected", collectedSamples.load());
+        builder->append("dropped", droppedSamples.load());
+
+        SimpleMutex::scoped_lock lk(aggregatorMutex);
+        aggregator.append(time(0), windowSecs, maxGroups, maxStacks, builder);
+    }
+
+} // namespace mongo
@@ -0,0 +1,161 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Aggregates CPU stack samples by the operation (command name or wire protocol operation)
+     * and namespace that was running on the sampled thread, in buckets of kBucketSecs seconds.
+     * Buckets older than kRetentionSecs are dropped as new samples come in.
+     *
+     * Each bucket holds at most kMaxGroupsPerBucket groups, kMaxStacksPerBucket distinct stacks
+     * and kMaxOpIdsPerBucket distinct operation ids, which bounds the memory used.  Samples for
+     * further groups are dropped, samples of further stacks are counted without their stack
+     * and further operations are not counted.  Both kinds of samples are reported.
+     *
+     * Not thread-safe.
+     */
+    class CpuSampleAggregator {
+        MONGO_DISALLOW_COPYING(CpuSampleAggregator);
+    public:
+        static const int kBucketSecs = 10;
+        static const int kRetentionSecs = 3600;
+
+        static const size_t kMaxGroupsPerBucket = 64;
+        static const size_t kMaxStacksPerBucket = 128;
+        static const size_t kMaxOpIdsPerBucket = 512;
+
+        CpuSampleAggregator() { }
+
+        /**
+         * Records one sample, taken at 'when' (seconds since the epoch) while operation 'opId'
+         * was running. 'frames' holds the sampled stack, innermost first.
+         */
+        void record(long long when,
+                    unsigned opId,
+                    StringData operation,
+                    StringData ns,
+                    const void* const* frames,
+                    int numFrames);
+
+        /**
+         * Appends the samples taken in the last 'windowSecs' seconds before 'now', grouped by
+         * operation and namespace, busiest group first, as
+         *
+         *     { samples: ..., samplesOverLimits: ..., samplesWithoutStack: ...,
+         *       groups: [ { op: ..., ns: ..., samples: ..., operations: ...,
+         *                   stacks: [ { samples: ..., frames: [ ... ] }, ... ] },
+         *                 ... ] }
+         *
+         * where 'operations' is the number of distinct operations sampled, and the samples over
+         * the bucket limits are counted separately. At most 'maxGroups' groups with at most
+         * 'maxStacks' stacks each are reported.
+         */
+        void append(long long now,
+                    int windowSecs,
+                    int maxGroups,
+                    int maxStacks,
+                    BSONObjBuilder* builder) const;
+
+        /**
+         * Number of samples currently held, across all buckets.
+         */
+        long long numSamples() const;
+
+    private:
+        typedef std::pair<std::string, std::string> GroupKey;
+        typedef std::vector<const void*> Stack;
+
+        struct Group {
+            Group() : samples(0) { }
+
+            long long samples;
+            std::set<unsigned> opIds;
+            std::map<Stack, long long> stacks;
+        };
+
+        struct Bucket {
+            explicit Bucket(long long start)
+                : start(start),
+                  numStacks(0),
+                  numOpIds(0),
+                  samplesOverLimits(0),
+                  samplesWithoutStack(0) { }
+
+            long long start;
+            std::map<GroupKey, Group> groups;
+
+            // Distinct stacks and operation ids across all groups
+            size_t numStacks;
+            size_t numOpIds;
+
+            long long samplesOverLimits;
+            long long samplesWithoutStack;
+        };
+
+        std::deque<Bucket> _buckets;
+    };
+
+    /**
+     * Records which operation and namespace the current thread is working on, for attributing
+     * CPU samples. Called by CurOp as operations start, learn their namespace or command, and
+     * finish. Cheap, since it only writes to thread local storage once the thread's stack was looked up
+     * by its first call.
+     */
+    void setCpuSampleOperation(unsigned opId, const char* operation);
+    void setCpuSampleNamespace(StringData ns);
+    void clearCpuSampleOperation();
+
+    /**
+     * Starts the thread, which collects the samples taken by the SIGPROF handler and turns the
+     * profiling timer on and off following the cpuSamplingHz server parameter. Sampling is only
+     * available on platforms with POSIX interval timers and thread local storage, and stacks are
+     * only collected on x86-64 Linux, by following frame pointers in the signal handler.
+     */
+    void startCpuSampler();
+
+    /**
+     * Appends the state of the sampler and the aggregated samples of the last 'windowSecs'
+     * seconds, for the cpuSamples command.
+     */
+    void appendCpuSamples(int windowSecs, int maxGroups, int maxStacks, BSONObjBuilder* builder);
+
+} // namespace mongo
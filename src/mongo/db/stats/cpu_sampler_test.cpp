@@ -0,0 +1,181 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/stats/cpu_sampler.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using namespace mongo;
+
+    const void* const stackA[] = { (const void*)0x10, (const void*)0x20 };
+    const void* const stackB[] = { (const void*)0x30 };
+
+    BSONObj getSamples(const CpuSampleAggregator& aggregator, long long now, int windowSecs) {
+        BSONObjBuilder b;
+        aggregator.append(now, windowSecs, 10, 10, &b);
+        return b.obj();
+    }
+
+    TEST(CpuSampleAggregatorTest, Empty) {
+        CpuSampleAggregator aggregator;
+        ASSERT_EQUALS(0, aggregator.numSamples());
+
+        BSONObj obj = getSamples(aggregator, 1000, 60);
+        ASSERT_EQUALS(0, obj["samples"].numberLong());
+        ASSERT_EQUALS(0, obj["groups"].Obj().nFields());
+    }
+
+    TEST(CpuSampleAggregatorTest, GroupsByOperationAndNamespace) {
+        CpuSampleAggregator aggregator;
+        aggregator.record(1000, 1, "find", "test.a", stackA, 2);
+        aggregator.record(1000, 1, "find", "test.a", stackA, 2);
+        aggregator.record(1001, 2, "find", "test.a", stackB, 1);
+        aggregator.record(1001, 3, "find", "test.b", stackA, 2);
+        aggregator.record(1002, 4, "insert", "test.a", stackB, 1);
+        ASSERT_EQUALS(5, aggregator.numSamples());
+
+        BSONObj obj = getSamples(aggregator, 1005, 60);
+        ASSERT_EQUALS(5, obj["samples"].numberLong());
+
+        std::vector<BSONElement> groups = obj["groups"].Array();
+        ASSERT_EQUALS(3U, groups.size());
+
+        // The busiest group comes first, with its most sampled stack first
+        BSONObj busiest = groups[0].Obj();
+        ASSERT_EQUALS("find", busiest["op"].String());
+        ASSERT_EQUALS("test.a", busiest["ns"].String());
+        ASSERT_EQUALS(3, busiest["samples"].numberLong());
+        ASSERT_EQUALS(2, busiest["operations"].numberLong());
+
+        std::vector<BSONElement> stacks = busiest["stacks"].Array();
+        ASSERT_EQUALS(2U, stacks.size());
+        ASSERT_EQUALS(2, stacks[0].Obj()["samples"].numberLong());
+        ASSERT_EQUALS(2U, stacks[0].Obj()["frames"].Array().size());
+        ASSERT_EQUALS(1, stacks[1].Obj()["samples"].numberLong());
+        ASSERT_EQUALS(1U, stacks[1].Obj()["frames"].Array().size());
+    }
+
+    TEST(CpuSampleAggregatorTest, Limits) {
+        CpuSampleAggregator aggregator;
+        aggregator.record(1000, 1, "find", "test.a", stackA, 2);
+        aggregator.record(1000, 1, "find", "test.a", stackA, 2);
+        aggregator.record(1000, 1, "find", "test.a", stackB, 1);
+        aggregator.record(1000, 2, "insert", "test.a", stackB, 1);
+
+        BSONObjBuilder b;
+        aggregator.append(1000, 60, 1, 1, &b);
+        BSONObj obj = b.obj();
+
+        std::vector<BSONElement> groups = obj["groups"].Array();
+        ASSERT_EQUALS(1U, groups.size());
+        ASSERT_EQUALS("find", groups[0].Obj()["op"].String());
+        ASSERT_EQUALS(1U, groups[0].Obj()["stacks"].Array().size());
+    }
+
+    TEST(CpuSampleAggregatorTest, BucketLimits) {
+        CpuSampleAggregator aggregator;
+
+        // One group per namespace, samples of the groups over the limit are dropped
+        for (size_t i = 0; i <= CpuSampleAggregator::kMaxGroupsPerBucket; i++) {
+            const std::string ns = str::stream() << "test.c" << i;
+            aggregator.record(1000, 1, "find", ns, stackA, 2);
+        }
+        ASSERT_EQUALS(static_cast<long long>(CpuSampleAggregator::kMaxGroupsPerBucket),
+                      aggregator.numSamples());
+
+        BSONObj obj = getSamples(aggregator, 1000, 60);
+        ASSERT_EQUALS(1, obj["samplesOverLimits"].numberLong());
+        ASSERT_EQUALS(0, obj["samplesWithoutStack"].numberLong());
+    }
+
+    TEST(CpuSampleAggregatorTest, StackAndOperationLimits) {
+        CpuSampleAggregator aggregator;
+
+        const size_t numSamples = std::max(CpuSampleAggregator::kMaxStacksPerBucket,
+                                           CpuSampleAggregator::kMaxOpIdsPerBucket) + 10;
+        for (size_t i = 0; i < numSamples; i++) {
+            const void* const frames[] = { (const void*)(0x1000 + i) };
+            aggregator.record(1000, i + 1, "find", "test.a", frames, 1);
+        }
+
+        // Known stacks are still counted once the limit is reached
+        const void* const firstFrames[] = { (const void*)0x1000 };
+        aggregator.record(1000, 1, "find", "test.a", firstFrames, 1);
+        ASSERT_EQUALS(static_cast<long long>(numSamples + 1), aggregator.numSamples());
+
+        BSONObjBuilder b;
+        aggregator.append(1000, 60, 10, 1000, &b);
+        BSONObj obj = b.obj();
+        ASSERT_EQUALS(0, obj["samplesOverLimits"].numberLong());
+        ASSERT_EQUALS(static_cast<long long>(numSamples - CpuSampleAggregator::kMaxStacksPerBucket),
+                      obj["samplesWithoutStack"].numberLong());
+
+        BSONObj group = obj["groups"].Array()[0].Obj();
+        ASSERT_EQUALS(static_cast<long long>(numSamples + 1), group["samples"].numberLong());
+        ASSERT_EQUALS(static_cast<long long>(CpuSampleAggregator::kMaxOpIdsPerBucket),
+                      group["operations"].numberLong());
+        std::vector<BSONElement> stacks = group["stacks"].Array();
+        ASSERT_EQUALS(CpuSampleAggregator::kMaxStacksPerBucket, stacks.size());
+        ASSERT_EQUALS(2, stacks[0].Obj()["samples"].numberLong());
+    }
+
+    TEST(CpuSampleAggregatorTest, Window) {
+        CpuSampleAggregator aggregator;
+        aggregator.record(1000, 1, "find", "test.a", stackA, 2);
+        aggregator.record(1100, 2, "find", "test.a", stackA, 2);
+
+        ASSERT_EQUALS(1, getSamples(aggregator, 1100, 30)["samples"].numberLong());
+        ASSERT_EQUALS(2, getSamples(aggregator, 1100, 200)["samples"].numberLong());
+    }
+
+    TEST(CpuSampleAggregatorTest, OldBucketsAreDropped) {
+        CpuSampleAggregator aggregator;
+        aggregator.record(1000, 1, "find", "test.a", stackA, 2);
+        aggregator.record(1000 + CpuSampleAggregator::kRetentionSecs, 2, "find", "test.a",
+                          stackA, 2);
+        ASSERT_EQUALS(1, aggregator.numSamples());
+    }
+
+    TEST(CpuSampleAggregatorTest, LateSamplesGoToAnEarlierBucket) {
+        CpuSampleAggregator aggregator;
+        aggregator.record(1000, 1, "find", "test.a", stackA, 2);
+        aggregator.record(1100, 2, "find", "test.a", stackA, 2);
+        aggregator.record(1050, 3, "find", "test.a", stackA, 2);
+        ASSERT_EQUALS(3, aggregator.numSamples());
+        ASSERT_EQUALS(1, getSamples(aggregator, 1100, 60)["samples"].numberLong());
+        ASSERT_EQUALS(3, getSamples(aggregator, 1100, 200)["samples"].numberLong());
+    }
+
+} // namespace
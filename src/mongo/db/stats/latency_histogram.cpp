@@ -0,0 +1,157 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/latency_histogram.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    void LatencyHistogram::record(long long micros) {
+        if (micros < 0) {
+            micros = 0;
+        }
+        _count.fetchAndAdd(1);
+        _totalMicros.fetchAndAdd(micros);
+        _buckets[_bucketFor(micros)].fetchAndAdd(1);
+    }
+
+    int LatencyHistogram::_bucketFor(long long micros) {
+        int bucket = 0;
+        while (micros > 0 && bucket < kNumBuckets - 1) {
+            micros >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    long long LatencyHistogram::getPercentileMicros(double percentile) const {
+        long long counts[kNumBuckets];
+        long long count = 0;
+        for (int i = 0; i < kNumBuckets; i++) {
+            counts[i] = _buckets[i].loadRelaxed();
+            count += counts[i];
+        }
+        if (count == 0) {
+            return 0;
+        }
+
+        // The rank, counting from one, of the latency we are after.
+        long long rank = static_cast<long long>(count * percentile / 100);
+        if (rank < 1) {
+            rank = 1;
+        }
+
+        long long seen = 0;
+        for (int i = 0; i < kNumBuckets; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return 1LL << i;
+            }
+        }
+        return 1LL << (kNumBuckets - 1);
+    }
+
+    void LatencyHistogram::append(BSONObjBuilder* builder) const {
+        builder->appendNumber("count", getCount());
+        builder->appendNumber("totalMicros", _totalMicros.loadRelaxed());
+        builder->appendNumber("p50Micros", getPercentileMicros(50));
+        builder->appendNumber("p95Micros", getPercentileMicros(95));
+        builder->appendNumber("p99Micros", getPercentileMicros(99));
+
+        BSONArrayBuilder buckets(builder->subarrayStart("buckets"));
+        for (int i = 0; i < kNumBuckets; i++) {
+            const long long count = _buckets[i].loadRelaxed();
+            if (count == 0) {
+                continue;
+            }
+            BSONObjBuilder bucket(buckets.subobjStart());
+            bucket.appendNumber("lessThanMicros", 1LL << i);
+            bucket.appendNumber("count", count);
+        }
+    }
+
+    void OpLatencyHistograms::record(int op, bool isCommand, long long micros) {
+        switch (op) {
+        case dbQuery:
+            if (isCommand)
+                _command.record(micros);
+            else
+                _query.record(micros);
+            break;
+        case dbCommand: _command.record(micros); break;
+        case dbGetMore: _getmore.record(micros); break;
+        case dbInsert: _insert.record(micros); break;
+        case dbUpdate: _update.record(micros); break;
+        case dbDelete: _remove.record(micros); break;
+        case dbKillCursors: _killcursors.record(micros); break;
+        default: break;
+        }
+    }
+
+    void OpLatencyHistograms::append(BSONObjBuilder* builder) const {
+        {
+            BSONObjBuilder b(builder->subobjStart("query"));
+            _query.append(&b);
+        }
+        {
+            BSONObjBuilder b(builder->subobjStart("getmore"));
+            _getmore.append(&b);
+        }
+        {
+            BSONObjBuilder b(builder->subobjStart("insert"));
+            _insert.append(&b);
+        }
+        {
+            BSONObjBuilder b(builder->subobjStart("update"));
+            _update.append(&b);
+        }
+        {
+            BSONObjBuilder b(builder->subobjStart("remove"));
+            _remove.append(&b);
+        }
+        {
+            BSONObjBuilder b(builder->subobjStart("command"));
+            _command.append(&b);
+        }
+        {
+            BSONObjBuilder b(builder->subobjStart("killcursors"));
+            _killcursors.append(&b);
+        }
+        {
+            BSONObjBuilder b(builder->subobjStart("replyWrite"));
+            _replyWrite.append(&b);
+        }
+    }
+
+    OpLatencyHistograms globalOpLatencies;
+
+} // namespace mongo
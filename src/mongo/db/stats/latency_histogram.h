@@ -0,0 +1,99 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Counts latencies in power of two buckets of microseconds.  Bucket 0 holds latencies under
+     * a microsecond and bucket i those in [2^(i-1), 2^i), with the last bucket open ended.
+     *
+     * Safe for concurrent use.  The counters are updated independently, so a reader racing with
+     * record() may see totals that are slightly ahead of the buckets.
+     */
+    class LatencyHistogram {
+    public:
+        static const int kNumBuckets = 32;
+
+        void record(long long micros);
+
+        long long getCount() const { return _count.loadRelaxed(); }
+
+        /**
+         * Estimates the latency below which "percentile" percent of the recorded latencies fall,
+         * as the upper bound of the bucket holding it.  Returns 0 if nothing was recorded.
+         */
+        long long getPercentileMicros(double percentile) const;
+
+        /**
+         * Appends the count, total time, estimated p50/p95/p99 and the non-empty buckets, as
+         *
+         *     { count: ..., totalMicros: ..., p50Micros: ..., p95Micros: ..., p99Micros: ...,
+         *       buckets: [ { lessThanMicros: <2^i>, count: ... }, ... ] }
+         */
+        void append(BSONObjBuilder* builder) const;
+
+    private:
+        static int _bucketFor(long long micros);
+
+        AtomicInt64 _count;
+        AtomicInt64 _totalMicros;
+        AtomicInt64 _buckets[kNumBuckets];
+    };
+
+    /**
+     * Latency histograms by wire protocol operation type, reported as serverStatus.opLatencies.
+     * Also holds the time mongod spends writing replies, which is not part of any operation.
+     */
+    class OpLatencyHistograms {
+    public:
+        void record(int op, bool isCommand, long long micros);
+
+        void recordReplyWrite(long long micros) { _replyWrite.record(micros); }
+
+        void append(BSONObjBuilder* builder) const;
+
+    private:
+        LatencyHistogram _query;
+        LatencyHistogram _getmore;
+        LatencyHistogram _insert;
+        LatencyHistogram _update;
+        LatencyHistogram _remove;
+        LatencyHistogram _command;
+        LatencyHistogram _killcursors;
+        LatencyHistogram _replyWrite;
+    };
+
+    extern OpLatencyHistograms globalOpLatencies;
+
+} // namespace mongo
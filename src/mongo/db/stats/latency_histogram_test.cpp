@@ -0,0 +1,92 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+
+    TEST(LatencyHistogramTest, Empty) {
+        LatencyHistogram histogram;
+        ASSERT_EQUALS(0, histogram.getCount());
+        ASSERT_EQUALS(0, histogram.getPercentileMicros(50));
+
+        BSONObjBuilder b;
+        histogram.append(&b);
+        BSONObj obj = b.obj();
+        ASSERT_EQUALS(0, obj["count"].numberLong());
+        ASSERT_EQUALS(0, obj["buckets"].Obj().nFields());
+    }
+
+    TEST(LatencyHistogramTest, PowerOfTwoBuckets) {
+        LatencyHistogram histogram;
+        histogram.record(0);
+        histogram.record(1);
+        histogram.record(3);
+        histogram.record(4);
+        histogram.record(7);
+
+        BSONObjBuilder b;
+        histogram.append(&b);
+        BSONObj obj = b.obj();
+        ASSERT_EQUALS(5, obj["count"].numberLong());
+        ASSERT_EQUALS(15, obj["totalMicros"].numberLong());
+
+        std::vector<BSONElement> buckets = obj["buckets"].Array();
+        ASSERT_EQUALS(4U, buckets.size());
+        ASSERT_EQUALS(BSON("lessThanMicros" << 1 << "count" << 1), buckets[0].Obj());
+        ASSERT_EQUALS(BSON("lessThanMicros" << 2 << "count" << 1), buckets[1].Obj());
+        ASSERT_EQUALS(BSON("lessThanMicros" << 4 << "count" << 1), buckets[2].Obj());
+        ASSERT_EQUALS(BSON("lessThanMicros" << 8 << "count" << 2), buckets[3].Obj());
+    }
+
+    TEST(LatencyHistogramTest, Percentiles) {
+        LatencyHistogram histogram;
+        for (int i = 0; i < 99; i++) {
+            histogram.record(100);
+        }
+        histogram.record(100000);
+
+        ASSERT_EQUALS(128, histogram.getPercentileMicros(50));
+        ASSERT_EQUALS(128, histogram.getPercentileMicros(99));
+        ASSERT_EQUALS(131072, histogram.getPercentileMicros(100));
+    }
+
+    TEST(LatencyHistogramTest, HugeLatenciesGoInTheLastBucket) {
+        LatencyHistogram histogram;
+        histogram.record(1LL << 50);
+        ASSERT_EQUALS(1LL << (LatencyHistogram::kNumBuckets - 1),
+                      histogram.getPercentileMicros(50));
+    }
+
+} // namespace
@@ -35,6 +35,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/service_context.h"
+#include "mongo/util/concurrency/sharded_counter.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/message.h"
 
@@ -70,6 +71,20 @@ namespace {
 
     }
 
+    void Top::CollectionData::add( const CollectionData& other ) {
+        total.add( other.total );
+        readLock.add( other.readLock );
+        writeLock.add( other.writeLock );
+        queries.add( other.queries );
+        getmore.add( other.getmore );
+        insert.add( other.insert );
+        update.add( other.update );
+        remove.add( other.remove );
+        commands.add( other.commands );
+    }
+
+    Top::Top() : _partitions( new Partition[kNumPartitions] ) { }
+
     // static
     Top& Top::get(ServiceContext* service) {
         return getTop(service);
@@ -80,17 +95,22 @@ namespace {
             return;
 
         //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
-        SimpleMutex::scoped_lock lk(_lock);
+        Partition& partition = _partitionForThread();
+        SimpleMutex::scoped_lock lk(partition.lock);
 
-        if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
-            _lastDropped = "";
+        if ( ( command || op == dbQuery ) && ns == partition.lastDropped ) {
+            partition.lastDropped = "";
             return;
         }
 
-        CollectionData& coll = _usage[ns];
+        CollectionData& coll = partition.usage[ns];
         _record( coll, op, lockType, micros, command );
     }
 
+    Top::Partition& Top::_partitionForThread() {
+        return _partitions[getCounterShardForThread() % kNumPartitions];
+    }
+
     void Top::_record( CollectionData& c, int op, int lockType, long long micros, bool command ) {
         c.total.inc( micros );
 
@@ -138,19 +158,33 @@ namespace {
     }
 
     void Top::collectionDropped( StringData ns ) {
-        SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
-        _lastDropped = ns.toString();
+        for ( size_t i = 0; i < kNumPartitions; i++ ) {
+            SimpleMutex::scoped_lock lk( _partitions[i].lock );
+            _partitions[i].usage.erase(ns);
+        }
+
+        // The command doing the drop is recorded afterwards by this same thread, so only its
+        // partition needs to know not to resurrect the collection's entry.
+        Partition& partition = _partitionForThread();
+        SimpleMutex::scoped_lock lk( partition.lock );
+        partition.lastDropped = ns.toString();
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
-        SimpleMutex::scoped_lock lk(_lock);
-        out = _usage;
+        out = UsageMap();
+        for ( size_t i = 0; i < kNumPartitions; i++ ) {
+            SimpleMutex::scoped_lock lk( _partitions[i].lock );
+            const UsageMap& usage = _partitions[i].usage;
+            for ( UsageMap::const_iterator it = usage.begin(); it != usage.end(); ++it ) {
+                out[it->first].add( it->second );
+            }
+        }
     }
 
     void Top::append( BSONObjBuilder& b ) {
-        SimpleMutex::scoped_lock lk( _lock );
-        _appendToUsageMap( b, _usage );
+        UsageMap merged;
+        cloneMap( merged );
+        _appendToUsageMap( b, merged );
     }
 
     void Top::_appendToUsageMap( BSONObjBuilder& b, const UsageMap& map ) const {
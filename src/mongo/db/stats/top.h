@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/scoped_array.hpp>
 
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/string_map.h"
@@ -40,13 +41,16 @@ namespace mongo {
 
     /**
      * tracks usage by collection
+     *
+     * Usage is kept in several partitions, each with its own lock, and a thread always records
+     * into the same partition.  Readers merge the partitions.
      */
     class Top {
 
     public:
         static Top& get(ServiceContext* service);
 
-        Top() : _lock("Top") { }
+        Top();
 
         struct UsageData {
             UsageData() : time(0), count(0) {}
@@ -58,6 +62,11 @@ namespace mongo {
                 count++;
                 time += micros;
             }
+
+            void add( const UsageData& other ) {
+                count += other.count;
+                time += other.time;
+            }
         };
 
         struct CollectionData {
@@ -67,6 +76,8 @@ namespace mongo {
             CollectionData() {}
             CollectionData( const CollectionData& older, const CollectionData& newer );
 
+            void add( const CollectionData& other );
+
             UsageData total;
 
             UsageData readLock;
@@ -89,13 +100,25 @@ namespace mongo {
         void collectionDropped( StringData ns );
 
     private:
+        static const size_t kNumPartitions = 16;
+
+        struct Partition {
+            Partition() : lock("Top") { }
+
+            mutable SimpleMutex lock;
+            UsageMap usage;
+
+            // Dropping threads skip recording their own drop command, see collectionDropped().
+            std::string lastDropped;
+        };
+
         void _appendToUsageMap( BSONObjBuilder& b, const UsageMap& map ) const;
         void _appendStatsEntry( BSONObjBuilder& b, const char * statsName, const UsageData& map ) const;
         void _record( CollectionData& c, int op, int lockType, long long micros, bool command );
 
-        mutable SimpleMutex _lock;
-        UsageMap _usage;
-        std::string _lastDropped;
+        Partition& _partitionForThread();
+
+        boost::scoped_array<Partition> _partitions;
     };
 
 } // namespace mongo
@@ -28,8 +28,12 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/db/stats/top.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
 
 namespace {
 
@@ -39,4 +43,48 @@ namespace {
         Top().collectionDropped("coll");
     }
 
+    void recordQueries(Top* top, int count) {
+        for (int i = 0; i < count; i++) {
+            top->record("test.coll", dbQuery, -1, 10, false);
+        }
+    }
+
+    TEST(TopTest, MergesUsageFromAllThreads) {
+        Top top;
+        const int threads = 32;
+        boost::thread* workers[threads];
+        for (int i = 0; i < threads; i++) {
+            workers[i] = new boost::thread(stdx::bind(&recordQueries, &top, 100));
+        }
+        for (int i = 0; i < threads; i++) {
+            workers[i]->join();
+            delete workers[i];
+        }
+
+        Top::UsageMap usage;
+        top.cloneMap(usage);
+        const Top::CollectionData& coll = usage["test.coll"];
+        ASSERT_EQUALS(threads * 100, coll.total.count);
+        ASSERT_EQUALS(threads * 100 * 10, coll.total.time);
+        ASSERT_EQUALS(threads * 100, coll.queries.count);
+        ASSERT_EQUALS(threads * 100, coll.readLock.count);
+        ASSERT_EQUALS(0, coll.writeLock.count);
+    }
+
+    TEST(TopTest, DroppedCollectionIsRemovedFromAllPartitions) {
+        Top top;
+        boost::thread other(stdx::bind(&recordQueries, &top, 5));
+        other.join();
+        recordQueries(&top, 5);
+
+        top.collectionDropped("test.coll");
+
+        // The drop command itself is not recorded against the dropped collection.
+        top.record("test.coll", dbQuery, 1, 10, true);
+
+        Top::UsageMap usage;
+        top.cloneMap(usage);
+        ASSERT(usage.find("test.coll") == usage.end());
+    }
+
 } // namespace
@@ -112,7 +112,8 @@ namespace mongo {
             return false;
         }
 
-        virtual Status updateWithDamages( OperationContext* txn,
+        virtual StatusWith<RecordData> updateWithDamages(
+                                          OperationContext* txn,
                                           const RecordId& loc,
                                           const RecordData& oldRec,
                                           const char* damageSource,
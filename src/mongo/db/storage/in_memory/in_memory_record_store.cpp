@@ -329,17 +329,11 @@ namespace mongo {
     }
 
     bool InMemoryRecordStore::updateWithDamagesSupported() const {
-        // TODO: Currently the UpdateStage assumes that updateWithDamages will apply the
-        // damages directly to the unowned BSONObj containing the record to be modified.
-        // The implementation of updateWithDamages() below copies the old record to a
-        // a new one and then applies the damages.
-        //
-        // We should be able to enable updateWithDamages() here once this assumption is
-        // relaxed.
-        return false;
+        return true;
     }
 
-    Status InMemoryRecordStore::updateWithDamages( OperationContext* txn,
+    StatusWith<RecordData> InMemoryRecordStore::updateWithDamages(
+                                                   OperationContext* txn,
                                                    const RecordId& loc,
                                                    const RecordData& oldRec,
                                                    const char* damageSource,
@@ -366,7 +360,7 @@ namespace mongo {
 
         *oldRecord = newRecord;
 
-        return Status::OK();
+        return StatusWith<RecordData>(newRecord.toRecordData());
     }
 
     RecordIterator* InMemoryRecordStore::getIterator(
@@ -81,11 +81,11 @@ namespace mongo {
 
         virtual bool updateWithDamagesSupported() const;
 
-        virtual Status updateWithDamages( OperationContext* txn,
-                                          const RecordId& loc,
-                                          const RecordData& oldRec,
-                                          const char* damageSource,
-                                          const mutablebson::DamageVector& damages );
+        virtual StatusWith<RecordData> updateWithDamages( OperationContext* txn,
+                                                      const RecordId& loc,
+                                                      const RecordData& oldRec,
+                                                      const char* damageSource,
+                                                      const mutablebson::DamageVector& damages );
 
         virtual RecordIterator* getIterator( OperationContext* txn,
                                              const RecordId& start,
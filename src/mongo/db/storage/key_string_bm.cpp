@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::KeyString;
+    using mongo::Ordering;
+    using mongo::RecordId;
+    using mongo::unittest::Benchmark;
+    using mongo::unittest::doNotOptimizeAway;
+
+    const Ordering kAscending = Ordering::make(BSONObj());
+
+    /**
+     * Encodes "key" on every iteration.
+     */
+    class EncodeFixture : public Benchmark {
+    protected:
+        void encodeAll() {
+            KeyString ks;
+            resetTiming();
+            for (long long i = 0; i < iterations(); ++i) {
+                ks.resetToKey(key, kAscending, RecordId(i));
+                doNotOptimizeAway(ks.getBuffer());
+            }
+        }
+
+        BSONObj key;
+    };
+
+    /**
+     * Decodes the encoding of "key" on every iteration.
+     */
+    class DecodeFixture : public Benchmark {
+    protected:
+        void decodeAll() {
+            KeyString ks(key, kAscending);
+            resetTiming();
+            for (long long i = 0; i < iterations(); ++i) {
+                BSONObj obj = KeyString::toBson(ks.getBuffer(), ks.getSize(), kAscending,
+                                                ks.getTypeBits());
+                doNotOptimizeAway(obj.objdata());
+            }
+        }
+
+        BSONObj key;
+    };
+
+    BENCHMARK_F(EncodeFixture, KeyStringBench, EncodeInt) {
+        key = BSON("" << 12345);
+        encodeAll();
+    }
+
+    BENCHMARK_F(EncodeFixture, KeyStringBench, EncodeDouble) {
+        key = BSON("" << 1234.5678);
+        encodeAll();
+    }
+
+    BENCHMARK_F(EncodeFixture, KeyStringBench, EncodeString) {
+        key = BSON("" << "a string of a typical length for an index key");
+        encodeAll();
+    }
+
+    BENCHMARK_F(EncodeFixture, KeyStringBench, EncodeCompound) {
+        key = BSON("" << 42 << "" << "name" << "" << mongo::OID::gen() << "" << true);
+        encodeAll();
+    }
+
+    BENCHMARK_F(DecodeFixture, KeyStringBench, DecodeInt) {
+        key = BSON("" << 12345);
+        decodeAll();
+    }
+
+    BENCHMARK_F(DecodeFixture, KeyStringBench, DecodeCompound) {
+        key = BSON("" << 42 << "" << "name" << "" << mongo::OID::gen() << "" << true);
+        decodeAll();
+    }
+
+    BENCHMARK(KeyStringBench, CompareEncoded) {
+        KeyString a(BSON("" << 42 << "" << "name a"), kAscending);
+        KeyString b(BSON("" << 42 << "" << "name b"), kAscending);
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            int cmp = a.compare(b);
+            doNotOptimizeAway(cmp);
+        }
+    }
+
+    BENCHMARK(KeyStringBench, CompareBSON) {
+        BSONObj a = BSON("" << 42 << "" << "name a");
+        BSONObj b = BSON("" << 42 << "" << "name b");
+        for (long long i = 0; i < iterations(); ++i) {
+            int cmp = a.woCompare(b, kAscending, false);
+            doNotOptimizeAway(cmp);
+        }
+    }
+
+} // namespace
@@ -85,7 +85,8 @@ namespace mongo {
             return true;
         }
 
-        virtual Status updateWithDamages(OperationContext* txn,
+        virtual StatusWith<RecordData> updateWithDamages(
+                                         OperationContext* txn,
                                          const RecordId& loc,
                                          const RecordData& oldRec,
                                          const char* damageSource,
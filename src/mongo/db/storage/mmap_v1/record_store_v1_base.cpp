@@ -418,7 +418,8 @@ namespace mongo {
         return true;
     }
 
-    Status RecordStoreV1Base::updateWithDamages( OperationContext* txn,
+    StatusWith<RecordData> RecordStoreV1Base::updateWithDamages(
+                                                 OperationContext* txn,
                                                  const RecordId& loc,
                                                  const RecordData& oldRec,
                                                  const char* damageSource,
@@ -435,7 +436,7 @@ namespace mongo {
             std::memcpy(targetPtr, sourcePtr, where->size);
         }
 
-        return Status::OK();
+        return StatusWith<RecordData>(RecordData(root, rec->netLength()));
     }
 
     void RecordStoreV1Base::deleteRecord( OperationContext* txn, const RecordId& rid ) {
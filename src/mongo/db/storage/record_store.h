@@ -213,7 +213,15 @@ namespace mongo {
          */
         virtual bool updateWithDamagesSupported() const = 0;
 
-        virtual Status updateWithDamages( OperationContext* txn,
+        /**
+         * Applies 'damages' to the record at 'loc', whose current contents are 'oldRec'.
+         *
+         * Implementations may apply the damages directly to the memory backing 'oldRec', or
+         * may write a modified copy of it. Either way, the returned RecordData holds the
+         * updated record and is what callers must use to observe the result.
+         */
+        virtual StatusWith<RecordData> updateWithDamages(
+                                          OperationContext* txn,
                                           const RecordId& loc,
                                           const RecordData& oldRec,
                                           const char* damageSource,
@@ -264,6 +272,15 @@ namespace mongo {
          */
         virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const = 0;
 
+        /**
+         * Constructs an iterator which is positioned on a randomly chosen record each time it is
+         * advanced, so records may repeat and the iterator only reaches EOF if the store is
+         * empty. Callers must bound how far they iterate. Returns NULL if not supported.
+         */
+        virtual RecordIterator* getRandomIterator( OperationContext* txn ) const {
+            return NULL;
+        }
+
         // higher level
 
 
@@ -0,0 +1,254 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/mutable/damage_vector.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/assert_util.h"
+
+/**
+ * Record store benchmarks, run against whichever engine provides newHarnessHelper().
+ */
+
+namespace {
+
+    using boost::scoped_ptr;
+    using mongo::HarnessHelper;
+    using mongo::OperationContext;
+    using mongo::RecordData;
+    using mongo::RecordId;
+    using mongo::RecordIterator;
+    using mongo::RecordStore;
+    using mongo::StatusWith;
+    using mongo::WriteUnitOfWork;
+    using mongo::unittest::Benchmark;
+    using mongo::unittest::doNotOptimizeAway;
+    namespace mutablebson = mongo::mutablebson;
+
+    const int kRecordSize = 100;
+    const int kPopulatedRecords = 10000;
+
+    // Stands in for a large document of which an update changes a single small field.
+    const int kLargeRecordSize = 64 * 1024;
+    const int kLargePopulatedRecords = 100;
+    const int kSmallFieldOffset = kLargeRecordSize / 2;
+
+    class RecordStoreFixture : public Benchmark {
+    protected:
+        RecordStoreFixture() : record(kRecordSize, 'x') {}
+
+        /**
+         * Inserts "count" records, committing in batches.
+         */
+        void populate(int count) {
+            scoped_ptr<OperationContext> txn(harness->newOperationContext());
+            for (int i = 0; i < count; i += 100) {
+                WriteUnitOfWork uow(txn.get());
+                for (int j = i; j < count && j < i + 100; ++j) {
+                    StatusWith<RecordId> res =
+                        rs->insertRecord(txn.get(), record.data(), record.size(), false);
+                    fassert(28807, res.getStatus());
+                    locs.push_back(res.getValue());
+                }
+                uow.commit();
+            }
+        }
+
+        scoped_ptr<HarnessHelper> harness;
+        scoped_ptr<RecordStore> rs;
+        std::string record;
+        std::vector<RecordId> locs;
+
+    private:
+        virtual void setUp() {
+            harness.reset(mongo::newHarnessHelper());
+            rs.reset(harness->newNonCappedRecordStore());
+            locs.clear();
+        }
+
+        virtual void tearDown() {
+            rs.reset();
+            harness.reset();
+        }
+    };
+
+    BENCHMARK_F(RecordStoreFixture, RecordStoreBench, InsertOnePerUnitOfWork) {
+        setBytesPerIteration(kRecordSize);
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            WriteUnitOfWork uow(txn.get());
+            StatusWith<RecordId> res =
+                rs->insertRecord(txn.get(), record.data(), record.size(), false);
+            doNotOptimizeAway(res.getStatus());
+            uow.commit();
+        }
+    }
+
+    BENCHMARK_F(RecordStoreFixture, RecordStoreBench, InsertBatched) {
+        setBytesPerIteration(kRecordSize);
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); i += 100) {
+            WriteUnitOfWork uow(txn.get());
+            for (long long j = i; j < iterations() && j < i + 100; ++j) {
+                StatusWith<RecordId> res =
+                    rs->insertRecord(txn.get(), record.data(), record.size(), false);
+                doNotOptimizeAway(res.getStatus());
+            }
+            uow.commit();
+        }
+    }
+
+    BENCHMARK_F(RecordStoreFixture, RecordStoreBench, DataFor) {
+        populate(kPopulatedRecords);
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            // Stride through the records so consecutive lookups don't share a page.
+            const RecordId& loc = locs[(i * 7919) % locs.size()];
+            RecordData data = rs->dataFor(txn.get(), loc);
+            doNotOptimizeAway(*data.data());
+        }
+    }
+
+    BENCHMARK_F(RecordStoreFixture, RecordStoreBench, UpdateSameSize) {
+        setBytesPerIteration(kRecordSize);
+        populate(kPopulatedRecords);
+        const std::string updated(kRecordSize, 'y');
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            WriteUnitOfWork uow(txn.get());
+            StatusWith<RecordId> res = rs->updateRecord(txn.get(),
+                                                        locs[i % locs.size()],
+                                                        updated.data(),
+                                                        updated.size(),
+                                                        false,
+                                                        NULL);
+            doNotOptimizeAway(res.getStatus());
+            uow.commit();
+        }
+    }
+
+    /**
+     * Changes 8 bytes in the middle of a large record by rewriting all of it, as an update
+     * does when the record store can't apply damages.
+     */
+    BENCHMARK_F(RecordStoreFixture, RecordStoreBench, UpdateSmallFieldOfLargeRecord) {
+        record.assign(kLargeRecordSize, 'x');
+        populate(kLargePopulatedRecords);
+        std::string updated(record);
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            const RecordId& loc = locs[i % locs.size()];
+            WriteUnitOfWork uow(txn.get());
+            RecordData oldRec = rs->dataFor(txn.get(), loc);
+            updated.assign(oldRec.data(), oldRec.size());
+            std::memcpy(&updated[kSmallFieldOffset], &i, sizeof(i));
+            StatusWith<RecordId> res = rs->updateRecord(txn.get(),
+                                                        loc,
+                                                        updated.data(),
+                                                        updated.size(),
+                                                        false,
+                                                        NULL);
+            doNotOptimizeAway(res.getStatus());
+            uow.commit();
+        }
+    }
+
+    /**
+     * The same change as UpdateSmallFieldOfLargeRecord, applied as a damage event. Engines
+     * without damage support fall back to rewriting the record.
+     */
+    BENCHMARK_F(RecordStoreFixture, RecordStoreBench, UpdateSmallFieldOfLargeRecordWithDamages) {
+        record.assign(kLargeRecordSize, 'x');
+        populate(kLargePopulatedRecords);
+        std::string updated(record);
+        mutablebson::DamageVector damages(1);
+        damages[0].sourceOffset = 0;
+        damages[0].targetOffset = kSmallFieldOffset;
+        damages[0].size = sizeof(long long);
+        const bool supported = rs->updateWithDamagesSupported();
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            const RecordId& loc = locs[i % locs.size()];
+            WriteUnitOfWork uow(txn.get());
+            RecordData oldRec = rs->dataFor(txn.get(), loc);
+            if (supported) {
+                StatusWith<RecordData> res = rs->updateWithDamages(txn.get(),
+                                                                   loc,
+                                                                   oldRec,
+                                                                   reinterpret_cast<char*>(&i),
+                                                                   damages);
+                doNotOptimizeAway(res.getStatus());
+            }
+            else {
+                updated.assign(oldRec.data(), oldRec.size());
+                std::memcpy(&updated[kSmallFieldOffset], &i, sizeof(i));
+                StatusWith<RecordId> res = rs->updateRecord(txn.get(),
+                                                            loc,
+                                                            updated.data(),
+                                                            updated.size(),
+                                                            false,
+                                                            NULL);
+                doNotOptimizeAway(res.getStatus());
+            }
+            uow.commit();
+        }
+    }
+
+    BENCHMARK_F(RecordStoreFixture, RecordStoreBench, ScanForward) {
+        setBytesPerIteration(kRecordSize);
+        populate(kPopulatedRecords);
+        scoped_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        long long done = 0;
+        while (done < iterations()) {
+            scoped_ptr<RecordIterator> it(rs->getIterator(txn.get()));
+            for (; done < iterations() && !it->isEOF(); ++done) {
+                RecordId loc = it->getNext();
+                RecordData data = it->dataFor(loc);
+                doNotOptimizeAway(*data.data());
+            }
+        }
+    }
+
+} // namespace
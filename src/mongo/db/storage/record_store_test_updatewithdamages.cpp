@@ -92,7 +92,8 @@ namespace mongo {
                 dv[2].size = 3;
 
                 WriteUnitOfWork uow( opCtx.get() );
-                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, data.c_str(), dv ) );
+                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, data.c_str(), dv )
+                           .getStatus() );
                 uow.commit();
             }
         }
@@ -155,7 +156,8 @@ namespace mongo {
                 dv[1].size = 5;
 
                 WriteUnitOfWork uow( opCtx.get() );
-                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, data.c_str(), dv ) );
+                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, data.c_str(), dv )
+                           .getStatus() );
                 uow.commit();
             }
         }
@@ -219,7 +221,8 @@ namespace mongo {
                 dv[1].size = 5;
 
                 WriteUnitOfWork uow( opCtx.get() );
-                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, data.c_str(), dv ) );
+                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, data.c_str(), dv )
+                           .getStatus() );
                 uow.commit();
             }
         }
@@ -275,7 +278,7 @@ namespace mongo {
                 mutablebson::DamageVector dv;
 
                 WriteUnitOfWork uow( opCtx.get() );
-                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, "", dv ) );
+                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, "", dv ).getStatus() );
                 uow.commit();
             }
         }
@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <memory>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/sorted_data_interface.h"
+#include "mongo/db/storage/sorted_data_interface_test_harness.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/assert_util.h"
+
+/**
+ * Index benchmarks, run against whichever engine provides newHarnessHelper().
+ */
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::HarnessHelper;
+    using mongo::OperationContext;
+    using mongo::RecordId;
+    using mongo::SortedDataInterface;
+    using mongo::WriteUnitOfWork;
+    using mongo::unittest::Benchmark;
+    using mongo::unittest::doNotOptimizeAway;
+
+    const int kPopulatedKeys = 10000;
+
+    BSONObj makeKey(long long i) {
+        return BSON("" << i);
+    }
+
+    RecordId makeLoc(long long i) {
+        return RecordId(1, 2 * i);
+    }
+
+    class SortedDataInterfaceFixture : public Benchmark {
+    protected:
+        /**
+         * Inserts keys 0 through count - 1, committing in batches.
+         */
+        void populate(int count) {
+            std::unique_ptr<OperationContext> txn(harness->newOperationContext());
+            for (int i = 0; i < count; i += 100) {
+                WriteUnitOfWork uow(txn.get());
+                for (int j = i; j < count && j < i + 100; ++j) {
+                    fassert(28808, sorted->insert(txn.get(), makeKey(j), makeLoc(j), true));
+                }
+                uow.commit();
+            }
+        }
+
+        std::unique_ptr<HarnessHelper> harness;
+        std::unique_ptr<SortedDataInterface> sorted;
+
+    private:
+        virtual void setUp() {
+            harness = mongo::newHarnessHelper();
+            sorted = harness->newSortedDataInterface(false);
+        }
+
+        virtual void tearDown() {
+            sorted.reset();
+            harness.reset();
+        }
+    };
+
+    BENCHMARK_F(SortedDataInterfaceFixture, SortedDataInterfaceBench, InsertAscending) {
+        std::unique_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            WriteUnitOfWork uow(txn.get());
+            doNotOptimizeAway(sorted->insert(txn.get(), makeKey(i), makeLoc(i), true));
+            uow.commit();
+        }
+    }
+
+    BENCHMARK_F(SortedDataInterfaceFixture, SortedDataInterfaceBench, InsertScattered) {
+        std::unique_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            // Multiplying by a large odd constant permutes the keys.
+            const long long k = (i * 2654435761LL) % (1LL << 32);
+            WriteUnitOfWork uow(txn.get());
+            doNotOptimizeAway(sorted->insert(txn.get(), makeKey(k), makeLoc(i), true));
+            uow.commit();
+        }
+    }
+
+    BENCHMARK_F(SortedDataInterfaceFixture, SortedDataInterfaceBench, SeekExact) {
+        populate(kPopulatedKeys);
+        std::unique_ptr<OperationContext> txn(harness->newOperationContext());
+        auto cursor = sorted->newCursor(txn.get());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            auto entry = cursor->seekExact(makeKey((i * 7919) % kPopulatedKeys));
+            doNotOptimizeAway(entry);
+        }
+    }
+
+    BENCHMARK_F(SortedDataInterfaceFixture, SortedDataInterfaceBench, ScanForward) {
+        populate(kPopulatedKeys);
+        std::unique_ptr<OperationContext> txn(harness->newOperationContext());
+        auto cursor = sorted->newCursor(txn.get());
+        const BSONObj start = makeKey(0);
+        resetTiming();
+        long long done = 0;
+        while (done < iterations()) {
+            for (auto entry = cursor->seek(start, true);
+                 entry && done < iterations();
+                 entry = cursor->next()) {
+                doNotOptimizeAway(entry->loc);
+                ++done;
+            }
+        }
+    }
+
+    BENCHMARK_F(SortedDataInterfaceFixture, SortedDataInterfaceBench, InsertAndUnindex) {
+        std::unique_ptr<OperationContext> txn(harness->newOperationContext());
+        resetTiming();
+        for (long long i = 0; i < iterations(); ++i) {
+            const BSONObj key = makeKey(i);
+            WriteUnitOfWork uow(txn.get());
+            sorted->insert(txn.get(), key, makeLoc(i), true);
+            sorted->unindex(txn.get(), key, makeLoc(i), true);
+            uow.commit();
+        }
+    }
+
+} // namespace
@@ -66,6 +66,7 @@ namespace mongo {
                                                                  params.repair );
                 kv->setRecordStoreExtraOptions( wiredTigerGlobalOptions.collectionConfig );
                 kv->setSortedDataInterfaceExtraOptions( wiredTigerGlobalOptions.indexConfig );
+                kv->startTicketController();
                 // Intentionally leaked.
                 new WiredTigerServerStatusSection(kv);
                 new WiredTigerEngineRuntimeConfigParameter(kv);
@@ -44,6 +44,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_controller.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
@@ -149,6 +150,10 @@ namespace mongo {
     void WiredTigerKVEngine::cleanShutdown() {
         log() << "WiredTigerKVEngine shutting down";
         syncSizeInfo(true);
+        if (_ticketController) {
+            _ticketController->shutdown();
+            _ticketController.reset();
+        }
         if (_conn) {
             // these must be the last things we do before _conn->close();
             _sizeStorer.reset( NULL );
@@ -164,6 +169,12 @@ namespace mongo {
         }
     }
 
+    void WiredTigerKVEngine::startTicketController() {
+        invariant(!_ticketController);
+        _ticketController.reset(new WiredTigerTicketController(_conn));
+        _ticketController->go();
+    }
+
     Status WiredTigerKVEngine::okToRename( OperationContext* opCtx,
                                            StringData fromNS,
                                            StringData toNS,
@@ -48,6 +48,7 @@ namespace mongo {
 
     class WiredTigerSessionCache;
     class WiredTigerSizeStorer;
+    class WiredTigerTicketController;
 
     class WiredTigerKVEngine : public KVEngine {
     public:
@@ -128,6 +129,12 @@ namespace mongo {
          */
         static bool initRsOplogBackgroundThread(StringData ns);
 
+        /**
+         * Starts the background job, which adjusts the number of concurrent read and write
+         * transactions to the observed load. It is stopped by cleanShutdown.
+         */
+        void startTicketController();
+
     private:
 
         Status _salvageIfNeeded(const char* uri);
@@ -153,6 +160,8 @@ namespace mongo {
         boost::scoped_ptr<WiredTigerSizeStorer> _sizeStorer;
         std::string _sizeStorerUri;
         mutable ElapsedTracker _sizeStorerSyncTracker;
+
+        boost::scoped_ptr<WiredTigerTicketController> _ticketController;
     };
 
 }
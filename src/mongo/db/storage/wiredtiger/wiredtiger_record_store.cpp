@@ -667,15 +667,48 @@ namespace {
     }
 
     bool WiredTigerRecordStore::updateWithDamagesSupported() const {
-        return false;
+        return true;
     }
 
-    Status WiredTigerRecordStore::updateWithDamages( OperationContext* txn,
+    StatusWith<RecordData> WiredTigerRecordStore::updateWithDamages(
+                                                     OperationContext* txn,
                                                      const RecordId& loc,
                                                      const RecordData& oldRec,
                                                      const char* damageSource,
                                                      const mutablebson::DamageVector& damages ) {
-        invariant(false);
+        // WiredTiger has no partial-value update, so the damages are patched into a copy of
+        // the current value, which is then written back in full. 'oldRec' was read in this
+        // snapshot, so there is no need to search for the record again, and the caller is
+        // spared from serializing the whole modified document. The record size is unchanged
+        // by damage events, so neither the data size nor capped collections need adjusting.
+        const int len = oldRec.size();
+
+        SharedBuffer data = SharedBuffer::allocate(len);
+        char* root = data.get();
+        memcpy(root, oldRec.data(), len);
+
+        mutablebson::DamageVector::const_iterator where = damages.begin();
+        const mutablebson::DamageVector::const_iterator end = damages.end();
+        for( ; where != end; ++where ) {
+            const char* sourcePtr = damageSource + where->sourceOffset;
+            char* targetPtr = root + where->targetOffset;
+            std::memcpy(targetPtr, sourcePtr, where->size);
+        }
+
+        WiredTigerCursor curwrap( _uri, _instanceId, true, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+        c->set_key(c, _makeKey(loc));
+        WiredTigerItem value(root, len);
+        c->set_value(c, value.Get());
+        int ret = WT_OP_CHECK(c->insert(c));
+        if (ret) {
+            return StatusWith<RecordData>(wtRCToStatus(ret,
+                                                       "WiredTigerRecordStore::updateWithDamages"));
+        }
+
+        return StatusWith<RecordData>(RecordData(std::move(data), len));
     }
 
     void WiredTigerRecordStore::_oplogSetStartHack( WiredTigerRecoveryUnit* wru ) const {
@@ -1260,6 +1293,103 @@ namespace {
         }
     }
 
+    // --------
+
+    /**
+     * Iterates using a cursor opened with "next_random", which WiredTiger positions on a random
+     * record on every call to next(). The cursor can't come from the session's cursor cache
+     * because of its configuration, so it is opened here and closed on saveState().
+     */
+    class WiredTigerRecordStore::RandomIterator : public RecordIterator {
+    public:
+        RandomIterator( const WiredTigerRecordStore& rs, OperationContext* txn )
+            : _rs( rs ),
+              _txn( NULL ),
+              _cursor( NULL ) {
+            invariant( restoreState( txn ) );
+        }
+
+        virtual ~RandomIterator() {
+            _closeCursor();
+        }
+
+        virtual bool isEOF() { return _loc.isNull(); }
+
+        virtual RecordId curr() { return _loc; }
+
+        virtual RecordId getNext() {
+            const RecordId toReturn = _loc;
+            _advance();
+            return toReturn;
+        }
+
+        virtual void invalidate( const RecordId& dl ) { }
+
+        virtual void saveState() {
+            _closeCursor();
+            _txn = NULL;
+        }
+
+        virtual bool restoreState( OperationContext* txn ) {
+            _txn = txn;
+            WT_SESSION* session = WiredTigerRecoveryUnit::get( txn )->getSession( txn )->getSession();
+            int ret = session->open_cursor( session, _rs.getURI().c_str(), NULL,
+                                            "next_random=true", &_cursor );
+            if ( ret == ENOENT ) {
+                _cursor = NULL;
+                _loc = RecordId();
+                return false;
+            }
+            invariantWTOK( ret );
+
+            // Whatever we were positioned on may be gone, so pick again.
+            _advance();
+            return true;
+        }
+
+        virtual RecordData dataFor( const RecordId& loc ) const {
+            if ( loc != _loc ) {
+                return _rs.dataFor( _txn, loc );
+            }
+
+            WT_ITEM value;
+            invariantWTOK( _cursor->get_value( _cursor, &value ) );
+            SharedBuffer data = SharedBuffer::allocate( value.size );
+            memcpy( data.get(), value.data, value.size );
+            return RecordData( data, value.size );
+        }
+
+    private:
+        void _advance() {
+            int ret = WT_OP_CHECK( _cursor->next( _cursor ) );
+            if ( ret == WT_NOTFOUND ) {
+                _loc = RecordId();
+                return;
+            }
+            invariantWTOK( ret );
+
+            int64_t key;
+            invariantWTOK( _cursor->get_key( _cursor, &key ) );
+            _loc = _fromKey( key );
+        }
+
+        void _closeCursor() {
+            if ( _cursor ) {
+                invariantWTOK( _cursor->close( _cursor ) );
+                _cursor = NULL;
+            }
+        }
+
+        const WiredTigerRecordStore& _rs;
+        OperationContext* _txn;
+        WT_CURSOR* _cursor;
+        RecordId _loc;
+    };
+
+    RecordIterator* WiredTigerRecordStore::getRandomIterator( OperationContext* txn ) const {
+        return new RandomIterator( *this, txn );
+    }
+
     void WiredTigerRecordStore::temp_cappedTruncateAfter( OperationContext* txn,
                                                           RecordId end,
                                                           bool inclusive ) {
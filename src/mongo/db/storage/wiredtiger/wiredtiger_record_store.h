@@ -140,11 +140,11 @@ namespace mongo {
 
         virtual bool updateWithDamagesSupported() const;
 
-        virtual Status updateWithDamages( OperationContext* txn,
-                                          const RecordId& loc,
-                                          const RecordData& oldRec,
-                                          const char* damageSource,
-                                          const mutablebson::DamageVector& damages );
+        virtual StatusWith<RecordData> updateWithDamages( OperationContext* txn,
+                                                      const RecordId& loc,
+                                                      const RecordData& oldRec,
+                                                      const char* damageSource,
+                                                      const mutablebson::DamageVector& damages );
 
         virtual RecordIterator* getIterator( OperationContext* txn,
                                              const RecordId& start = RecordId(),
@@ -153,6 +153,8 @@ namespace mongo {
 
         virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const;
 
+        virtual RecordIterator* getRandomIterator( OperationContext* txn ) const;
+
         virtual Status truncate( OperationContext* txn );
 
         virtual bool compactSupported() const { return true; }
@@ -251,6 +253,7 @@ namespace mongo {
             RecordId _lastLoc; // the last thing returned from getNext()
         };
 
+        class RandomIterator;
         class CappedInsertChange;
         class NumRecordsChange;
         class DataSizeChange;
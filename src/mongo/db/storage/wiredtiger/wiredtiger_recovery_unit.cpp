@@ -30,6 +30,7 @@
 
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
 
+#include <algorithm>
 #include <boost/thread/condition.hpp>
 #include <boost/thread/mutex.hpp>
 
@@ -40,6 +41,7 @@
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_controller.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/log.h"
@@ -279,6 +281,17 @@ namespace mongo {
         TicketServerParameter openReadTransactionParam(&openReadTransaction,
                                                        "wiredTigerConcurrentReadTransactions");
 
+        WiredTigerTicketStats openWriteTransactionStats;
+        WiredTigerTicketStats openReadTransactionStats;
+
+    }
+
+    TicketHolder* WiredTigerRecoveryUnit::getTransactionTicketHolder(bool forWrite) {
+        return forWrite ? &openWriteTransaction : &openReadTransaction;
+    }
+
+    const WiredTigerTicketStats& WiredTigerRecoveryUnit::getTransactionTicketStats(bool forWrite) {
+        return forWrite ? openWriteTransactionStats : openReadTransactionStats;
     }
 
     void WiredTigerRecoveryUnit::appendGlobalStats(BSONObjBuilder& b) {
@@ -288,6 +301,7 @@ namespace mongo {
             bbb.append("out", openWriteTransaction.used());
             bbb.append("available", openWriteTransaction.available());
             bbb.append("totalTickets", openWriteTransaction.outof());
+            openWriteTransactionStats.append(&bbb);
             bbb.done();
         }
         {
@@ -295,8 +309,10 @@ namespace mongo {
             bbb.append("out", openReadTransaction.used());
             bbb.append("available", openReadTransaction.available());
             bbb.append("totalTickets", openReadTransaction.outof());
+            openReadTransactionStats.append(&bbb);
             bbb.done();
         }
+        WiredTigerTicketController::appendStats(&bb);
         bb.done();
     }
 
@@ -350,8 +366,18 @@ namespace mongo {
         }
 
         TicketHolder* holder = writeLocked ? &openWriteTransaction : &openReadTransaction;
+        WiredTigerTicketStats* stats =
+            writeLocked ? &openWriteTransactionStats : &openReadTransactionStats;
+
+        // Only time the slow path, where the operation has to queue up for a ticket
+        long long waitMicros = 0;
+        if (!holder->tryAcquire()) {
+            Timer t;
+            holder->waitForTicket();
+            waitMicros = std::max(t.micros(), 1LL);
+        }
 
-        holder->waitForTicket();
+        stats->recordAcquisition(waitMicros);
         _ticket.reset(holder);
     }
 
@@ -48,6 +48,7 @@ namespace mongo {
     class BSONObjBuilder;
     class WiredTigerSession;
     class WiredTigerSessionCache;
+    class WiredTigerTicketStats;
 
     class WiredTigerRecoveryUnit : public RecoveryUnit {
     public:
@@ -95,6 +96,13 @@ namespace mongo {
         static WiredTigerRecoveryUnit* get(OperationContext *txn);
 
         static void appendGlobalStats(BSONObjBuilder& b);
+
+        /**
+         * The ticket pools, which limit the number of concurrently open write or read
+         * transactions, and the statistics of their use.
+         */
+        static TicketHolder* getTransactionTicketHolder(bool forWrite);
+        static const WiredTigerTicketStats& getTransactionTicketStats(bool forWrite);
     private:
 
         void _abort();
@@ -0,0 +1,333 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_controller.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Whether the controller may resize the transaction ticket pools. When it is off, the pools
+    // keep the sizes set through wiredTigerConcurrent{Read,Write}Transactions.
+    MONGO_EXPORT_SERVER_PARAMETER(wiredTigerAdaptiveConcurrentTransactions, bool, false);
+
+    // Bounds within which the controller keeps each of the ticket pools
+    MONGO_EXPORT_SERVER_PARAMETER(wiredTigerConcurrentTransactionsMin, int, 16);
+    MONGO_EXPORT_SERVER_PARAMETER(wiredTigerConcurrentTransactionsMax, int, 512);
+
+namespace {
+
+    // How often the controller samples the ticket pools
+    const unsigned kIntervalMillis = 1000;
+
+    // TicketHolder does not accept less than this many tickets
+    const int kMinPoolSize = 5;
+
+    // Application threads start evicting pages once the cache is this full
+    const double kEvictionTriggerRatio = 0.95;
+
+    struct PolicyStats {
+        AtomicInt64 increases;
+        AtomicInt64 decreases;
+        AtomicInt32 lastDecision;
+
+        void record(AdaptiveTicketPolicy::Decision decision) {
+            if (decision == AdaptiveTicketPolicy::kIncrease) {
+                increases.fetchAndAdd(1);
+            }
+            else if (decision == AdaptiveTicketPolicy::kDecrease) {
+                decreases.fetchAndAdd(1);
+            }
+
+            lastDecision.store(decision);
+        }
+
+        void append(BSONObjBuilder* builder) const {
+            builder->append("increases", increases.load());
+            builder->append("decreases", decreases.load());
+            builder->append("lastDecision",
+                            AdaptiveTicketPolicy::decisionName(
+                                static_cast<AdaptiveTicketPolicy::Decision>(lastDecision.load())));
+        }
+    };
+
+    AtomicInt32 controllerRunning;
+    AtomicInt64 controllerIntervals;
+    AtomicInt64 controllerCachePressureIntervals;
+    PolicyStats writePolicyStats;
+    PolicyStats readPolicyStats;
+
+} // namespace
+
+    void WiredTigerTicketStats::recordAcquisition(long long waitMicros) {
+        _acquisitions.increment();
+
+        if (waitMicros > 0) {
+            _waits.increment();
+            _waitMicros.increment(waitMicros);
+        }
+    }
+
+    WiredTigerTicketStats::Snapshot WiredTigerTicketStats::get() const {
+        Snapshot snapshot;
+        snapshot.acquisitions = _acquisitions.get();
+        snapshot.waits = _waits.get();
+        snapshot.waitMicros = _waitMicros.get();
+        return snapshot;
+    }
+
+    void WiredTigerTicketStats::append(BSONObjBuilder* builder) const {
+        const Snapshot snapshot = get();
+        builder->append("acquisitions", snapshot.acquisitions);
+        builder->append("waits", snapshot.waits);
+        builder->append("totalWaitMicros", snapshot.waitMicros);
+    }
+
+
+    const int AdaptiveTicketPolicy::kIncreaseStep = 8;
+    const double AdaptiveTicketPolicy::kThroughputDropRatio = 0.9;
+
+    AdaptiveTicketPolicy::AdaptiveTicketPolicy()
+        : _lastDecision(kHold),
+          _lastStep(0),
+          _lastAcquisitions(0) {
+
+    }
+
+    int AdaptiveTicketPolicy::nextTickets(const Interval& interval,
+                                          int minTickets,
+                                          int maxTickets) {
+        minTickets = std::max(minTickets, kMinPoolSize);
+        maxTickets = std::max(maxTickets, minTickets);
+
+        int target = interval.tickets;
+
+        if (interval.cachePressure) {
+            // More concurrent transactions only make eviction fall further behind
+            target = interval.tickets * 3 / 4;
+        }
+        else if (_lastDecision == kIncrease &&
+                 interval.acquisitions < _lastAcquisitions * kThroughputDropRatio) {
+            // The last increase made things worse, so go back to where we were
+            target = interval.tickets - _lastStep;
+        }
+        else if (interval.waits > 0) {
+            // Operations are queueing up for tickets
+            target = interval.tickets + kIncreaseStep;
+        }
+
+        target = std::min(std::max(target, minTickets), maxTickets);
+
+        if (target > interval.tickets) {
+            _lastDecision = kIncrease;
+        }
+        else if (target < interval.tickets) {
+            _lastDecision = kDecrease;
+        }
+        else {
+            _lastDecision = kHold;
+        }
+
+        _lastStep = target - interval.tickets;
+        _lastAcquisitions = interval.acquisitions;
+
+        return target;
+    }
+
+    const char* AdaptiveTicketPolicy::decisionName(Decision decision) {
+        switch (decision) {
+        case kHold: return "hold";
+        case kIncrease: return "increase";
+        case kDecrease: return "decrease";
+        }
+
+        return "unknown";
+    }
+
+
+    WiredTigerTicketController::WiredTigerTicketController(WT_CONNECTION* conn)
+        : _conn(conn),
+          _inShutdown(false) {
+
+    }
+
+    std::string WiredTigerTicketController::name() const {
+        return "WTTicketController";
+    }
+
+    void WiredTigerTicketController::run() {
+        controllerRunning.store(1);
+
+        WiredTigerTicketStats::Snapshot lastWrite =
+            WiredTigerRecoveryUnit::getTransactionTicketStats(true).get();
+        WiredTigerTicketStats::Snapshot lastRead =
+            WiredTigerRecoveryUnit::getTransactionTicketStats(false).get();
+
+        AdaptiveTicketPolicy writePolicy;
+        AdaptiveTicketPolicy readPolicy;
+
+        while (true) {
+            {
+                stdx::unique_lock<stdx::mutex> lk(_mutex);
+                const boost::xtime deadline = incxtimemillis(kIntervalMillis);
+                while (!_inShutdown && _shutdownCondition.timed_wait(lk, deadline)) {
+                }
+
+                if (_inShutdown) {
+                    break;
+                }
+            }
+
+            if (!wiredTigerAdaptiveConcurrentTransactions) {
+                // Start over with fresh samples once re-enabled
+                lastWrite = WiredTigerRecoveryUnit::getTransactionTicketStats(true).get();
+                lastRead = WiredTigerRecoveryUnit::getTransactionTicketStats(false).get();
+                continue;
+            }
+
+            const bool cachePressure = _isCacheUnderPressure();
+            controllerIntervals.fetchAndAdd(1);
+            if (cachePressure) {
+                controllerCachePressureIntervals.fetchAndAdd(1);
+            }
+
+            _adjust("write",
+                    WiredTigerRecoveryUnit::getTransactionTicketHolder(true),
+                    WiredTigerRecoveryUnit::getTransactionTicketStats(true),
+                    &lastWrite,
+                    &writePolicy,
+                    cachePressure);
+            writePolicyStats.record(writePolicy.lastDecision());
+
+            // Readers do not dirty the cache, so eviction pressure does not limit them
+            _adjust("read",
+                    WiredTigerRecoveryUnit::getTransactionTicketHolder(false),
+                    WiredTigerRecoveryUnit::getTransactionTicketStats(false),
+                    &lastRead,
+                    &readPolicy,
+                    false);
+            readPolicyStats.record(readPolicy.lastDecision());
+        }
+
+        controllerRunning.store(0);
+    }
+
+    void WiredTigerTicketController::shutdown() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _inShutdown = true;
+            _shutdownCondition.notify_one();
+        }
+
+        wait();
+    }
+
+    void WiredTigerTicketController::appendStats(BSONObjBuilder* builder) {
+        BSONObjBuilder adaptive(builder->subobjStart("adaptive"));
+        adaptive.appendBool("enabled", wiredTigerAdaptiveConcurrentTransactions &&
+                                       controllerRunning.load());
+        adaptive.append("minTickets", wiredTigerConcurrentTransactionsMin);
+        adaptive.append("maxTickets", wiredTigerConcurrentTransactionsMax);
+        adaptive.append("intervals", controllerIntervals.load());
+        adaptive.append("cachePressureIntervals", controllerCachePressureIntervals.load());
+        {
+            BSONObjBuilder write(adaptive.subobjStart("write"));
+            writePolicyStats.append(&write);
+        }
+        {
+            BSONObjBuilder read(adaptive.subobjStart("read"));
+            readPolicyStats.append(&read);
+        }
+    }
+
+    bool WiredTigerTicketController::_isCacheUnderPressure() {
+        WiredTigerSession session(_conn);
+        WT_SESSION* s = session.getSession();
+
+        StatusWith<int64_t> inUse = WiredTigerUtil::getStatisticsValueAs<int64_t>(
+            s, "statistics:", "statistics=(fast)", WT_STAT_CONN_CACHE_BYTES_INUSE);
+        StatusWith<int64_t> max = WiredTigerUtil::getStatisticsValueAs<int64_t>(
+            s, "statistics:", "statistics=(fast)", WT_STAT_CONN_CACHE_BYTES_MAX);
+
+        if (!inUse.isOK() || !max.isOK() || max.getValue() <= 0) {
+            return false;
+        }
+
+        return inUse.getValue() >= max.getValue() * kEvictionTriggerRatio;
+    }
+
+    void WiredTigerTicketController::_adjust(const char* kind,
+                                             TicketHolder* holder,
+                                             const WiredTigerTicketStats& stats,
+                                             WiredTigerTicketStats::Snapshot* last,
+                                             AdaptiveTicketPolicy* policy,
+                                             bool cachePressure) {
+        const WiredTigerTicketStats::Snapshot current = stats.get();
+
+        AdaptiveTicketPolicy::Interval interval;
+        interval.tickets = holder->outof();
+        interval.acquisitions = current.acquisitions - last->acquisitions;
+        interval.waits = current.waits - last->waits;
+        interval.waitMicros = current.waitMicros - last->waitMicros;
+        interval.cachePressure = cachePressure;
+
+        *last = current;
+
+        const int target = policy->nextTickets(interval,
+                                               wiredTigerConcurrentTransactionsMin,
+                                               wiredTigerConcurrentTransactionsMax);
+        if (target == interval.tickets) {
+            return;
+        }
+
+        LOG(1) << "Resizing " << kind << " transaction tickets from " << interval.tickets
+               << " to " << target << "; acquisitions: " << interval.acquisitions
+               << ", waits: " << interval.waits << ", waitMicros: " << interval.waitMicros
+               << ", cachePressure: " << cachePressure;
+
+        // Shrinking waits for tickets to be returned, which may take a while under load
+        Status status = holder->resize(target);
+        if (!status.isOK()) {
+            warning() << "Unable to resize " << kind << " transaction tickets: " << status;
+        }
+    }
+
+}  // namespace mongo
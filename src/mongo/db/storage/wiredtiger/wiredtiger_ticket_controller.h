@@ -0,0 +1,179 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <wiredtiger.h>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/sharded_counter.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class TicketHolder;
+
+    /**
+     * Counts how many tickets were handed out by a TicketHolder and how long the operations
+     * waited for them. Thread-safe.
+     */
+    class WiredTigerTicketStats {
+        MONGO_DISALLOW_COPYING(WiredTigerTicketStats);
+    public:
+        struct Snapshot {
+            Snapshot() : acquisitions(0), waits(0), waitMicros(0) { }
+
+            long long acquisitions;
+            long long waits;
+            long long waitMicros;
+        };
+
+        WiredTigerTicketStats() { }
+
+        /**
+         * Records a ticket acquisition. A 'waitMicros' of zero means the ticket was available
+         * right away.
+         */
+        void recordAcquisition(long long waitMicros);
+
+        Snapshot get() const;
+
+        void append(BSONObjBuilder* builder) const;
+
+    private:
+        // Bumped by every operation, so kept per thread to avoid contention
+        ShardedCounter64 _acquisitions;
+        ShardedCounter64 _waits;
+        ShardedCounter64 _waitMicros;
+    };
+
+    /**
+     * Decides how many tickets one kind of transaction (read or write) should get, based on
+     * what happened during the last sampling interval. Uses additive increase while operations
+     * are queueing for tickets and multiplicative decrease when the cache is under eviction
+     * pressure. An increase, which is followed by a drop in throughput, is undone.
+     *
+     * Not thread-safe.
+     */
+    class AdaptiveTicketPolicy {
+    public:
+        enum Decision {
+            kHold,
+            kIncrease,
+            kDecrease,
+        };
+
+        struct Interval {
+            Interval() : tickets(0), acquisitions(0), waits(0), waitMicros(0),
+                         cachePressure(false) { }
+
+            // Number of tickets during the interval
+            int tickets;
+
+            // Ticket activity during the interval
+            long long acquisitions;
+            long long waits;
+            long long waitMicros;
+
+            // Whether the cache needed application threads to help with eviction
+            bool cachePressure;
+        };
+
+        // Tickets added on each increase
+        static const int kIncreaseStep;
+
+        // Fraction of the throughput before an increase, below which the increase is undone
+        static const double kThroughputDropRatio;
+
+        AdaptiveTicketPolicy();
+
+        /**
+         * Returns the number of tickets to use for the next interval, which is always within
+         * [minTickets, maxTickets].
+         */
+        int nextTickets(const Interval& interval, int minTickets, int maxTickets);
+
+        Decision lastDecision() const { return _lastDecision; }
+
+        static const char* decisionName(Decision decision);
+
+    private:
+        Decision _lastDecision;
+        int _lastStep;
+        long long _lastAcquisitions;
+    };
+
+    /**
+     * Background thread, which periodically resizes the read and write transaction ticket pools
+     * of the WiredTiger storage engine using an AdaptiveTicketPolicy for each. Only changes the
+     * pools while the wiredTigerAdaptiveConcurrentTransactions server parameter is set.
+     */
+    class WiredTigerTicketController : public BackgroundJob {
+        MONGO_DISALLOW_COPYING(WiredTigerTicketController);
+    public:
+        explicit WiredTigerTicketController(WT_CONNECTION* conn);
+
+        virtual std::string name() const;
+
+        virtual void run();
+
+        /**
+         * Stops the thread and waits for it to exit. Must be called before the connection
+         * is closed.
+         */
+        void shutdown();
+
+        /**
+         * Appends the decisions of the controller, if there is one running, to 'builder'.
+         */
+        static void appendStats(BSONObjBuilder* builder);
+
+    private:
+        /**
+         * Whether the WiredTiger cache is full enough for application threads to do eviction.
+         */
+        bool _isCacheUnderPressure();
+
+        void _adjust(const char* kind,
+                     TicketHolder* holder,
+                     const WiredTigerTicketStats& stats,
+                     WiredTigerTicketStats::Snapshot* last,
+                     AdaptiveTicketPolicy* policy,
+                     bool cachePressure);
+
+        WT_CONNECTION* const _conn;
+
+        stdx::mutex _mutex;
+        stdx::condition_variable _shutdownCondition;
+        bool _inShutdown;
+    };
+
+}  // namespace mongo
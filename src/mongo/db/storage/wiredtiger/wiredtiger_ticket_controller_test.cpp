@@ -0,0 +1,104 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_controller.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    AdaptiveTicketPolicy::Interval makeInterval(int tickets,
+                                                long long acquisitions,
+                                                long long waits,
+                                                bool cachePressure = false) {
+        AdaptiveTicketPolicy::Interval interval;
+        interval.tickets = tickets;
+        interval.acquisitions = acquisitions;
+        interval.waits = waits;
+        interval.waitMicros = waits * 100;
+        interval.cachePressure = cachePressure;
+        return interval;
+    }
+
+    TEST(AdaptiveTicketPolicy, HoldsWithoutWaits) {
+        AdaptiveTicketPolicy policy;
+        ASSERT_EQUALS(128, policy.nextTickets(makeInterval(128, 1000, 0), 16, 512));
+        ASSERT_EQUALS(AdaptiveTicketPolicy::kHold, policy.lastDecision());
+    }
+
+    TEST(AdaptiveTicketPolicy, IncreasesWhileOperationsWait) {
+        AdaptiveTicketPolicy policy;
+        const int step = AdaptiveTicketPolicy::kIncreaseStep;
+
+        ASSERT_EQUALS(128 + step, policy.nextTickets(makeInterval(128, 1000, 10), 16, 512));
+        ASSERT_EQUALS(AdaptiveTicketPolicy::kIncrease, policy.lastDecision());
+
+        // Throughput holds up, so keep going
+        ASSERT_EQUALS(128 + 2 * step,
+                      policy.nextTickets(makeInterval(128 + step, 1000, 10), 16, 512));
+        ASSERT_EQUALS(AdaptiveTicketPolicy::kIncrease, policy.lastDecision());
+    }
+
+    TEST(AdaptiveTicketPolicy, UndoesIncreaseWhenThroughputDrops) {
+        AdaptiveTicketPolicy policy;
+        const int step = AdaptiveTicketPolicy::kIncreaseStep;
+
+        ASSERT_EQUALS(128 + step, policy.nextTickets(makeInterval(128, 1000, 10), 16, 512));
+
+        // Even though operations still wait, the extra tickets made things worse
+        ASSERT_EQUALS(128, policy.nextTickets(makeInterval(128 + step, 500, 10), 16, 512));
+        ASSERT_EQUALS(AdaptiveTicketPolicy::kDecrease, policy.lastDecision());
+    }
+
+    TEST(AdaptiveTicketPolicy, DecreasesUnderCachePressure) {
+        AdaptiveTicketPolicy policy;
+        ASSERT_EQUALS(96, policy.nextTickets(makeInterval(128, 1000, 10, true), 16, 512));
+        ASSERT_EQUALS(AdaptiveTicketPolicy::kDecrease, policy.lastDecision());
+
+        ASSERT_EQUALS(72, policy.nextTickets(makeInterval(96, 1000, 10, true), 16, 512));
+    }
+
+    TEST(AdaptiveTicketPolicy, StaysWithinBounds) {
+        AdaptiveTicketPolicy policy;
+        ASSERT_EQUALS(130, policy.nextTickets(makeInterval(128, 1000, 10), 16, 130));
+        ASSERT_EQUALS(130, policy.nextTickets(makeInterval(130, 1000, 10), 16, 130));
+        ASSERT_EQUALS(AdaptiveTicketPolicy::kHold, policy.lastDecision());
+
+        ASSERT_EQUALS(16, policy.nextTickets(makeInterval(20, 1000, 0, true), 16, 130));
+        ASSERT_EQUALS(16, policy.nextTickets(makeInterval(16, 1000, 0, true), 16, 130));
+
+        // Bounds outside of what the ticket holder supports are adjusted
+        ASSERT_EQUALS(5, policy.nextTickets(makeInterval(6, 1000, 0, true), 0, 0));
+        ASSERT_EQUALS(300, policy.nextTickets(makeInterval(128, 1000, 0), 300, 200));
+    }
+
+} // namespace
+} // namespace mongo
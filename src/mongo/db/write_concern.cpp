@@ -33,6 +33,7 @@
 #include "mongo/base/counter.h"
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/optime.h"
@@ -218,6 +219,8 @@ namespace mongo {
         // We assume all options have been validated earlier, if not, programming error
         dassert( validateWriteConcern( writeConcern ).isOK() );
 
+        ScopedWaitTimer waitTimer( &CurOp::get( txn )->debug().writeConcernWaitTicks );
+
         // Next handle blocking on disk
 
         Timer syncTimer;
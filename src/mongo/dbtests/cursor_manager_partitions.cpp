@@ -0,0 +1,295 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+/**
+ * This file tests that the operations of a CursorManager reach every one of its partitions.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <set>
+#include <vector>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/catalog/cursor_manager.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/service_context.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/stdx/thread.h"
+
+namespace CursorManagerPartitions {
+
+    using std::auto_ptr;
+    using std::set;
+    using std::vector;
+
+    static const char* const ns = "unittests.cursor_manager_partitions";
+
+    // Matches CursorManager::kNumPartitions. A cursor's partition is the low bits of its id.
+    static const unsigned kNumPartitions = 16;
+
+    // Each new thread takes the next counter shard, and so registers its cursors in the next
+    // partition. Twice as many threads as partitions reach every partition even if a few
+    // other threads start in the meantime.
+    static const size_t kNumThreads = 2 * kNumPartitions;
+
+    // Enough executors that their addresses spread over every partition.
+    static const size_t kNumExecutors = 8 * kNumPartitions;
+
+    class Base {
+    public:
+        Base() : _manager(ns) { }
+
+    protected:
+        /**
+         * Returns an executor over an empty QueuedDataStage and with no collection. The root
+         * stage is returned in 'rootOut' if it is not NULL.
+         */
+        PlanExecutor* makeExecutor(QueuedDataStage** rootOut = NULL) {
+            auto_ptr<WorkingSet> ws(new WorkingSet());
+            auto_ptr<QueuedDataStage> root(new QueuedDataStage(ws.get()));
+            if (rootOut) {
+                *rootOut = root.get();
+            }
+
+            PlanExecutor* exec;
+            ASSERT_OK(PlanExecutor::make(&_opCtx, ws.release(), root.release(), ns,
+                                         PlanExecutor::YIELD_MANUAL, &exec));
+            return exec;
+        }
+
+        /**
+         * Registers one cursor from each of kNumThreads new threads. The root stages of their
+         * executors are appended to 'roots' if it is not NULL.
+         */
+        vector<ClientCursor*> registerCursors(vector<QueuedDataStage*>* roots = NULL) {
+            vector<ClientCursor*> cursors(kNumThreads, NULL);
+            for (size_t i = 0; i < kNumThreads; ++i) {
+                QueuedDataStage* root;
+                PlanExecutor* exec = makeExecutor(&root);
+                if (roots) {
+                    roots->push_back(root);
+                }
+
+                stdx::thread t([this, &cursors, i, exec]() {
+                    cursors[i] = new ClientCursor(&_manager, exec, ns);
+                });
+                t.join();
+            }
+
+            ASSERT_EQUALS(kNumPartitions, partitionsOf(cursors).size());
+            return cursors;
+        }
+
+        static set<unsigned> partitionsOf(const vector<ClientCursor*>& cursors) {
+            set<unsigned> partitions;
+            for (size_t i = 0; i < cursors.size(); ++i) {
+                partitions.insert(static_cast<uint64_t>(cursors[i]->cursorid()) % kNumPartitions);
+            }
+            return partitions;
+        }
+
+        OperationContextImpl _opCtx;
+        CursorManager _manager;
+    };
+
+    /**
+     * Cursors in every partition can be found, pinned, unpinned and erased by id.
+     */
+    class FindPinAndErase : public Base {
+    public:
+        void run() {
+            vector<ClientCursor*> cursors = registerCursors();
+            ASSERT_EQUALS(kNumThreads, _manager.numCursors());
+
+            set<CursorId> ids;
+            _manager.getCursorIds(&ids);
+            ASSERT_EQUALS(kNumThreads, ids.size());
+
+            for (size_t i = 0; i < cursors.size(); ++i) {
+                const CursorId id = cursors[i]->cursorid();
+                ASSERT_EQUALS(1U, ids.count(id));
+                ASSERT_TRUE(_manager.ownsCursorId(id));
+
+                ASSERT_EQUALS(cursors[i], _manager.find(id, false));
+                ASSERT_FALSE(cursors[i]->isPinned());
+
+                ASSERT_EQUALS(cursors[i], _manager.find(id, true));
+                ASSERT_TRUE(cursors[i]->isPinned());
+                ASSERT_THROWS(_manager.find(id, true), UserException);
+                _manager.unpin(cursors[i]);
+                ASSERT_FALSE(cursors[i]->isPinned());
+            }
+
+            for (size_t i = 0; i < cursors.size(); ++i) {
+                const CursorId id = cursors[i]->cursorid();
+                ASSERT_TRUE(_manager.eraseCursor(&_opCtx, id, false));
+                ASSERT_TRUE(NULL == _manager.find(id, false));
+                ASSERT_FALSE(_manager.eraseCursor(&_opCtx, id, false));
+                ASSERT_EQUALS(kNumThreads - i - 1, _manager.numCursors());
+            }
+        }
+    };
+
+    /**
+     * numCursors() and getCursorIds() add up the cursors of every partition.
+     */
+    class NumCursorsSumsPartitions : public Base {
+    public:
+        void run() {
+            vector<ClientCursor*> cursors = registerCursors();
+
+            // Erase the cursors of every other partition.
+            vector<ClientCursor*> remaining;
+            for (size_t i = 0; i < cursors.size(); ++i) {
+                if (static_cast<uint64_t>(cursors[i]->cursorid()) % 2) {
+                    ASSERT_TRUE(_manager.eraseCursor(&_opCtx, cursors[i]->cursorid(), false));
+                }
+                else {
+                    remaining.push_back(cursors[i]);
+                }
+            }
+            ASSERT_EQUALS(kNumPartitions / 2, partitionsOf(remaining).size());
+            ASSERT_EQUALS(remaining.size(), _manager.numCursors());
+
+            set<CursorId> ids;
+            _manager.getCursorIds(&ids);
+            ASSERT_EQUALS(remaining.size(), ids.size());
+            for (size_t i = 0; i < remaining.size(); ++i) {
+                ASSERT_EQUALS(1U, ids.count(remaining[i]->cursorid()));
+            }
+        }
+    };
+
+    /**
+     * timeoutCursors() times out the idle cursors of every partition, but not pinned ones.
+     */
+    class TimeoutVisitsEveryPartition : public Base {
+    public:
+        void run() {
+            vector<ClientCursor*> cursors = registerCursors();
+            ClientCursor* pinned = _manager.find(cursors[0]->cursorid(), true);
+
+            // Not idle for long enough yet.
+            ASSERT_EQUALS(0U, _manager.timeoutCursors(1));
+            ASSERT_EQUALS(kNumThreads, _manager.numCursors());
+
+            // Past the default cursor timeout of 10 minutes.
+            ASSERT_EQUALS(kNumThreads - 1, _manager.timeoutCursors(600001));
+            ASSERT_EQUALS(1U, _manager.numCursors());
+            ASSERT_EQUALS(pinned, _manager.find(pinned->cursorid(), false));
+
+            _manager.unpin(pinned);
+        }
+    };
+
+    /**
+     * invalidateAll() kills the executors registered in every partition and deletes the
+     * cursors of every partition, except for pinned cursors, whose executors are killed.
+     */
+    class InvalidateAllReachesEveryPartition : public Base {
+    public:
+        void run() {
+            vector<ClientCursor*> cursors = registerCursors();
+            ClientCursor* pinned = _manager.find(cursors[0]->cursorid(), true);
+
+            OwnedPointerVector<PlanExecutor> execs;
+            for (size_t i = 0; i < kNumExecutors; ++i) {
+                execs.push_back(makeExecutor());
+                _manager.registerExecutor(execs.back());
+            }
+
+            _manager.invalidateAll(false, "test");
+
+            // A killed executor reports DEAD rather than EOF.
+            for (size_t i = 0; i < execs.size(); ++i) {
+                ASSERT_EQUALS(PlanExecutor::DEAD, execs[i]->getNext(NULL, NULL));
+            }
+            ASSERT_EQUALS(1U, _manager.numCursors());
+            ASSERT_EQUALS(pinned, _manager.find(pinned->cursorid(), false));
+            ASSERT_EQUALS(PlanExecutor::DEAD, pinned->getExecutor()->getNext(NULL, NULL));
+
+            _manager.unpin(pinned);
+        }
+    };
+
+    /**
+     * invalidateDocument() reaches the executors registered in every partition and those of the
+     * cursors in every partition.
+     */
+    class InvalidateDocumentReachesEveryPartition : public Base {
+    public:
+        void run() {
+            // The storage engine isolates such executors instead.
+            if (supportsDocLocking()) {
+                return;
+            }
+
+            vector<QueuedDataStage*> roots;
+            registerCursors(&roots);
+
+            OwnedPointerVector<PlanExecutor> execs;
+            for (size_t i = 0; i < kNumExecutors; ++i) {
+                QueuedDataStage* root;
+                execs.push_back(makeExecutor(&root));
+                roots.push_back(root);
+                _manager.registerExecutor(execs.back());
+            }
+
+            _manager.invalidateDocument(&_opCtx, RecordId(1, 1), INVALIDATION_DELETION);
+
+            for (size_t i = 0; i < roots.size(); ++i) {
+                ASSERT_EQUALS(1U, roots[i]->getCommonStats()->invalidates);
+            }
+
+            for (size_t i = 0; i < execs.size(); ++i) {
+                _manager.deregisterExecutor(execs[i]);
+            }
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite("cursor_manager_partitions") { }
+
+        void setupTests() {
+            add<FindPinAndErase>();
+            add<NumCursorsSumsPartitions>();
+            add<TimeoutVisitsEveryPartition>();
+            add<InvalidateAllReachesEveryPartition>();
+            add<InvalidateDocumentReachesEveryPartition>();
+        }
+    };
+
+    SuiteInstance<All> cursorManagerPartitionsAll;
+
+}  // namespace CursorManagerPartitions
@@ -37,6 +37,7 @@
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context_impl.h"
@@ -283,6 +284,121 @@ namespace QueryMultiPlanRunner {
         }
     };
 
+    /**
+     * Base class for tests of when the trial period ends early. The candidate plans are mock
+     * stages which advance at fixed rates.
+     */
+    class MPREarlyCutoffBase : public MultiPlanRunnerBase {
+    public:
+        MPREarlyCutoffBase() : _earlyCutoffOldValue(internalQueryPlanEvaluationEarlyCutoff) {
+            internalQueryPlanEvaluationEarlyCutoff = true;
+
+            // Make sure the collection exists.
+            insert(BSON("foo" << 7));
+        }
+
+        virtual ~MPREarlyCutoffBase() {
+            internalQueryPlanEvaluationEarlyCutoff = _earlyCutoffOldValue;
+        }
+
+        /**
+         * Returns a mock plan which advances on every 'advanceEvery'th work, or never if
+         * 'advanceEvery' is 0, and has enough to do to outlast any trial period.
+         */
+        QueuedDataStage* makeMockPlan(WorkingSet* ws, size_t advanceEvery) {
+            auto_ptr<QueuedDataStage> mockPlan(new QueuedDataStage(ws));
+            for (int i = 0; i < 4 * internalQueryPlanEvaluationMaxResults; ++i) {
+                if (advanceEvery && 0 == (i + 1) % advanceEvery) {
+                    WorkingSetMember member;
+                    member.state = WorkingSetMember::OWNED_OBJ;
+                    member.obj = Snapshotted<BSONObj>(SnapshotId(), BSON("foo" << 7));
+                    mockPlan->pushBack(member);
+                }
+                else {
+                    mockPlan->pushBack(PlanStage::NEED_TIME);
+                }
+            }
+            return mockPlan.release();
+        }
+
+        /**
+         * Runs a trial period between a plan advancing on every 'firstAdvanceEvery'th work and a
+         * plan advancing on every 'secondAdvanceEvery'th work, each of which has already advanced
+         * at that rate for 'priorWorks' works. Returns how many times each plan was worked.
+         */
+        size_t runTrial(size_t firstAdvanceEvery, size_t secondAdvanceEvery, size_t priorWorks) {
+            AutoGetCollectionForRead ctx(&_txn, ns());
+
+            CanonicalQuery* cq = NULL;
+            verify(CanonicalQuery::canonicalize(ns(), BSON("foo" << 7), &cq).isOK());
+            scoped_ptr<CanonicalQuery> killCq(cq);
+
+            WorkingSet ws;
+            const bool shouldCache = false;
+            MultiPlanStage mps(&_txn, ctx.getCollection(), cq, shouldCache);
+
+            QueuedDataStage* firstPlan = makeMockPlan(&ws, firstAdvanceEvery);
+            mps.addPlan(createQuerySolution(), firstPlan, &ws);
+            if (priorWorks) {
+                mps.setPriorForLastPlan(priorWorks,
+                                        firstAdvanceEvery ? priorWorks / firstAdvanceEvery : 0);
+            }
+
+            QueuedDataStage* secondPlan = makeMockPlan(&ws, secondAdvanceEvery);
+            mps.addPlan(createQuerySolution(), secondPlan, &ws);
+            if (priorWorks) {
+                mps.setPriorForLastPlan(priorWorks,
+                                        secondAdvanceEvery ? priorWorks / secondAdvanceEvery : 0);
+            }
+
+            PlanYieldPolicy yieldPolicy(NULL, PlanExecutor::YIELD_MANUAL);
+            ASSERT_OK(mps.pickBestPlan(&yieldPolicy));
+            ASSERT(mps.bestPlanChosen());
+            ASSERT_EQUALS(0, mps.bestPlanIdx());
+
+            const size_t numWorks = firstPlan->getCommonStats()->works;
+            ASSERT_EQUALS(numWorks, secondPlan->getCommonStats()->works);
+            return numWorks;
+        }
+
+    private:
+        const bool _earlyCutoffOldValue;
+    };
+
+    // A plan which advances on every work is clearly ahead of one which never advances, so the
+    // trial period ends long before either plan could return a full batch. With the cutoff
+    // disabled, it runs until the first plan returns a full batch.
+    class MPREarlyCutoffWhenWinnerIsAhead : public MPREarlyCutoffBase {
+    public:
+        void run() {
+            const size_t numResults = static_cast<size_t>(internalQueryPlanEvaluationMaxResults);
+            ASSERT_LESS_THAN(runTrial(1, 0, 0), numResults);
+
+            internalQueryPlanEvaluationEarlyCutoff = false;
+            ASSERT_EQUALS(runTrial(1, 0, 0), numResults);
+        }
+    };
+
+    // A plan which advances on every other work is ahead of one which advances on every third,
+    // but not by enough to tell apart before the first plan returns a full batch.
+    class MPRNoEarlyCutoffWhenPlansAreClose : public MPREarlyCutoffBase {
+    public:
+        void run() {
+            const size_t numResults = static_cast<size_t>(internalQueryPlanEvaluationMaxResults);
+            ASSERT_EQUALS(runTrial(2, 3, 0), 2 * numResults);
+        }
+    };
+
+    // History from before the trial period which agrees with the trial lets it end sooner.
+    class MPREarlyCutoffSoonerWithPriors : public MPREarlyCutoffBase {
+    public:
+        void run() {
+            const size_t worksWithoutPriors = runTrial(2, 4, 0);
+            const size_t worksWithPriors = runTrial(2, 4, 100);
+            ASSERT_LESS_THAN(worksWithPriors, worksWithoutPriors);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_multi_plan_runner" ) { }
@@ -290,6 +406,9 @@ namespace QueryMultiPlanRunner {
         void setupTests() {
             add<MPRCollectionScanVsHighlySelectiveIXScan>();
             add<MPRBackupPlan>();
+            add<MPREarlyCutoffWhenWinnerIsAhead>();
+            add<MPRNoEarlyCutoffWhenPlansAreClose>();
+            add<MPREarlyCutoffSoonerWithPriors>();
         }
     };
 
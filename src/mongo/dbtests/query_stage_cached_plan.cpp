@@ -237,6 +237,176 @@ namespace QueryStageCachedPlan {
         }
     };
 
+    /**
+     * Test that when the cached plan stage replans a query which already has a plan cache entry,
+     * the new trial period starts from the stats in that entry and so can end sooner than the
+     * trial period which created the entry.
+     */
+    class QueryStageCachedPlanReplanUsesPriors : public QueryStageCachedPlanBase {
+    public:
+        QueryStageCachedPlanReplanUsesPriors()
+            : _earlyCutoffOldValue(internalQueryPlanEvaluationEarlyCutoff),
+              _enableIxisectOldValue(internalQueryPlannerEnableIndexIntersection) {
+            // Index intersection plans have a blocking stage, which rules out ending early.
+            internalQueryPlanEvaluationEarlyCutoff = true;
+            internalQueryPlannerEnableIndexIntersection = false;
+
+            OldClientWriteContext ctx(&_txn, ns());
+            Collection* collection = ctx.getCollection();
+            ASSERT(collection);
+
+            // Half of the documents matching 'a' also match 'b', while three quarters of those
+            // matching 'b' also match 'a'. Neither plan hits EOF during the trial period.
+            for (int i = 10; i < 1010; i++) {
+                insertDocument(collection, BSON("_id" << i << "a" << i << "b" << (i % 2)));
+                if (0 == i % 6) {
+                    insertDocument(collection, BSON("_id" << -i << "a" << -1 << "b" << 0));
+                }
+            }
+        }
+
+        ~QueryStageCachedPlanReplanUsesPriors() {
+            internalQueryPlanEvaluationEarlyCutoff = _earlyCutoffOldValue;
+            internalQueryPlannerEnableIndexIntersection = _enableIxisectOldValue;
+        }
+
+        /**
+         * Runs the cached plan stage for 'cq' with a cached plan from 'mockChild', which must make
+         * it replan, and returns how many times the winning plan was worked during the trial period
+         * for the replanned query.
+         */
+        size_t replanTrialWorks(Collection* collection,
+                                CanonicalQuery* cq,
+                                size_t decisionWorks,
+                                QueuedDataStage* mockChild) {
+            QueryPlannerParams plannerParams;
+            fillOutPlannerParams(&_txn, collection, cq, &plannerParams);
+
+            CachedPlanStage cachedPlanStage(&_txn, collection, &_ws, cq, plannerParams,
+                                            decisionWorks, mockChild);
+
+            PlanYieldPolicy yieldPolicy(nullptr, PlanExecutor::YIELD_MANUAL);
+            ASSERT_OK(cachedPlanStage.pickBestPlan(&yieldPolicy));
+
+            const std::unique_ptr<PlanStageStats> stats(cachedPlanStage.getStats());
+            ASSERT_EQ(stats->children.size(), 1U);
+            return stats->children[0]->common.works;
+        }
+
+        void run() {
+            AutoGetCollectionForRead ctx(&_txn, ns());
+            Collection* collection = ctx.getCollection();
+            ASSERT(collection);
+
+            CanonicalQuery* rawCq;
+            ASSERT_OK(CanonicalQuery::canonicalize(ns(), fromjson("{a: {$gte: 10}, b: 0}"), &rawCq));
+            const std::unique_ptr<CanonicalQuery> cq(rawCq);
+
+            PlanCache* cache = collection->infoCache()->getPlanCache();
+            ASSERT(cache);
+            CachedSolution* rawCachedSolution;
+            ASSERT_NOT_OK(cache->get(*cq, &rawCachedSolution));
+
+            // The first replan has nothing to start from. Hitting the works threshold makes it
+            // cache its choice.
+            const size_t decisionWorks = 10;
+            const size_t mockWorks = 1U + static_cast<size_t>(internalQueryCacheEvictionRatio
+                                                              * decisionWorks);
+            std::unique_ptr<QueuedDataStage> slowChild = stdx::make_unique<QueuedDataStage>(&_ws);
+            for (size_t i = 0; i < mockWorks; i++) {
+                slowChild->pushBack(PlanStage::NEED_TIME);
+            }
+            const size_t firstTrialWorks = replanTrialWorks(collection, cq.get(), decisionWorks,
+                                                            slowChild.release());
+            ASSERT_OK(cache->get(*cq, &rawCachedSolution));
+            const std::unique_ptr<CachedSolution> cachedSolution(rawCachedSolution);
+
+            // The second replan starts from the stats in the cache entry, which agree with what
+            // its own trial period sees.
+            std::unique_ptr<QueuedDataStage> failingChild =
+                stdx::make_unique<QueuedDataStage>(&_ws);
+            failingChild->pushBack(PlanStage::FAILURE);
+            const size_t secondTrialWorks = replanTrialWorks(collection, cq.get(), decisionWorks,
+                                                             failingChild.release());
+
+            ASSERT_LESS_THAN(secondTrialWorks, firstTrialWorks);
+        }
+
+    private:
+        const bool _earlyCutoffOldValue;
+        const bool _enableIxisectOldValue;
+    };
+
+    /**
+     * Test that each run of a cached plan adds its works and advances to the cache entry, even
+     * once the entry holds as many individual feedback entries as it keeps.
+     */
+    class QueryStageCachedPlanRecordsFeedback : public QueryStageCachedPlanBase {
+    public:
+        void run() {
+            AutoGetCollectionForRead ctx(&_txn, ns());
+            Collection* collection = ctx.getCollection();
+            ASSERT(collection);
+
+            CanonicalQuery* rawCq;
+            ASSERT_OK(CanonicalQuery::canonicalize(ns(), fromjson("{a: {$gte: 8}, b: 1}"), &rawCq));
+            const std::unique_ptr<CanonicalQuery> cq(rawCq);
+
+            PlanCache* cache = collection->infoCache()->getPlanCache();
+            ASSERT(cache);
+
+            QueryPlannerParams plannerParams;
+            fillOutPlannerParams(&_txn, collection, cq.get(), &plannerParams);
+            PlanYieldPolicy yieldPolicy(nullptr, PlanExecutor::YIELD_MANUAL);
+
+            // Create a cache entry by making the cached plan stage replan.
+            const size_t decisionWorks = 10;
+            const size_t mockWorks = 1U + static_cast<size_t>(internalQueryCacheEvictionRatio
+                                                              * decisionWorks);
+            std::unique_ptr<QueuedDataStage> slowChild = stdx::make_unique<QueuedDataStage>(&_ws);
+            for (size_t i = 0; i < mockWorks; i++) {
+                slowChild->pushBack(PlanStage::NEED_TIME);
+            }
+            {
+                CachedPlanStage cachedPlanStage(&_txn, collection, &_ws, cq.get(), plannerParams,
+                                                decisionWorks, slowChild.release());
+                ASSERT_OK(cachedPlanStage.pickBestPlan(&yieldPolicy));
+            }
+
+            PlanCacheEntry* rawEntry;
+            ASSERT_OK(cache->getEntry(*cq, &rawEntry));
+            std::unique_ptr<PlanCacheEntry> entry(rawEntry);
+            ASSERT_EQ(entry->feedbackWorks, 0U);
+            ASSERT_EQ(entry->feedbackAdvanced, 0U);
+            ASSERT(entry->feedback.empty());
+
+            // Each cached run below is worked 3 times to advance twice and once more to hit EOF.
+            const size_t numRuns = static_cast<size_t>(internalQueryCacheFeedbacksStored) + 1;
+            for (size_t runIx = 0; runIx < numRuns; runIx++) {
+                std::unique_ptr<QueuedDataStage> mockChild =
+                    stdx::make_unique<QueuedDataStage>(&_ws);
+                mockChild->pushBack(PlanStage::NEED_TIME);
+                for (int i = 0; i < 2; i++) {
+                    WorkingSetMember member;
+                    member.state = WorkingSetMember::OWNED_OBJ;
+                    member.obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << 9 << "b" << 1));
+                    mockChild->pushBack(member);
+                }
+
+                CachedPlanStage cachedPlanStage(&_txn, collection, &_ws, cq.get(), plannerParams,
+                                                decisionWorks, mockChild.release());
+                ASSERT_OK(cachedPlanStage.pickBestPlan(&yieldPolicy));
+            }
+
+            ASSERT_OK(cache->getEntry(*cq, &rawEntry));
+            entry.reset(rawEntry);
+            ASSERT_EQ(entry->feedbackWorks, 4U * numRuns);
+            ASSERT_EQ(entry->feedbackAdvanced, 2U * numRuns);
+            ASSERT_EQ(entry->feedback.size(),
+                      static_cast<size_t>(internalQueryCacheFeedbacksStored));
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite("query_stage_cached_plan") {}
@@ -244,6 +414,8 @@ namespace QueryStageCachedPlan {
         void setupTests() {
             add<QueryStageCachedPlanFailure>();
             add<QueryStageCachedPlanHitMaxWorks>();
+            add<QueryStageCachedPlanReplanUsesPriors>();
+            add<QueryStageCachedPlanRecordsFeedback>();
         }
     };
 
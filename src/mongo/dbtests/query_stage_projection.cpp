@@ -0,0 +1,217 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+/**
+ * This file tests the COVERED_ONE_INDEX fast path of db/exec/projection.cpp.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <memory>
+
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace QueryStageProjection {
+
+    using std::auto_ptr;
+
+    /**
+     * Projects index keys through a COVERED_ONE_INDEX ProjectionStage and checks that each
+     * result is byte for byte what appending the included key elements to a BSONObjBuilder, in
+     * key order and under the key pattern's field names, produces.
+     */
+    class CoveredProjectionBase {
+    public:
+        virtual ~CoveredProjectionBase() { }
+
+        void run() {
+            const BSONObj keyPattern = fromjson(keyPatternJson());
+            const BSONObj projObj = fromjson(projectionJson());
+            const std::vector<BSONObj> keys = makeKeys();
+
+            WorkingSet ws;
+            auto_ptr<QueuedDataStage> queued(new QueuedDataStage(&ws));
+            for (size_t i = 0; i < keys.size(); ++i) {
+                WorkingSetMember member;
+                member.state = WorkingSetMember::LOC_AND_IDX;
+                member.keyData.push_back(IndexKeyDatum(keyPattern, keys[i], NULL));
+                queued->pushBack(member);
+            }
+
+            WhereCallbackNoop whereCallback;
+            ProjectionStageParams params(whereCallback);
+            params.projImpl = ProjectionStageParams::COVERED_ONE_INDEX;
+            params.projObj = projObj;
+            params.coveredKeyObj = keyPattern;
+            ProjectionStage projection(params, &ws, queued.release());
+
+            for (size_t i = 0; i < keys.size(); ++i) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = PlanStage::NEED_TIME;
+                while (PlanStage::NEED_TIME == state) {
+                    state = projection.work(&id);
+                }
+                ASSERT_EQUALS(PlanStage::ADVANCED, state);
+
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, member->state);
+                const BSONObj out = member->obj.value();
+                const BSONObj expected = buildWithBuilder(keyPattern, projObj, keys[i]);
+
+                ASSERT_EQUALS(expected, out);
+                ASSERT_EQUALS(expected.objsize(), out.objsize());
+                ASSERT(expected.binaryEqual(out));
+                ASSERT_EQUALS(expectedFieldNames(), fieldNames(out));
+            }
+        }
+
+    protected:
+        virtual const char* keyPatternJson() const = 0;
+        virtual const char* projectionJson() const = 0;
+
+        // The field names of every result, in order, separated by commas.
+        virtual std::string expectedFieldNames() const = 0;
+
+        /**
+         * Returns keys for a six field index, with values of differing types and sizes so that
+         * every element is copied with the right length.
+         */
+        virtual std::vector<BSONObj> makeKeys() const {
+            std::vector<BSONObj> keys;
+            keys.push_back(BSON("" << 1 << "" << "x" << "" << 2.5 << "" << BSON("y" << 3)
+                                << "" << true << "" << 4LL));
+            keys.push_back(BSON("" << "a much longer string value" << "" << BSONNULL
+                                << "" << OID::gen() << "" << MINKEY << "" << 7
+                                << "" << BSON_ARRAY(1 << 2)));
+            keys.push_back(BSON("" << MAXKEY << "" << BSONObj() << "" << ""
+                                << "" << Date_t::fromMillisSinceEpoch(1000) << "" << -1 << "" << "z"));
+            return keys;
+        }
+
+    private:
+        /**
+         * How the projection stage built covered results before it wrote them itself.
+         */
+        static BSONObj buildWithBuilder(const BSONObj& keyPattern,
+                                        const BSONObj& projObj,
+                                        const BSONObj& key) {
+            ProjectionStage::FieldSet includedFields;
+            ProjectionStage::getSimpleInclusionFields(projObj, &includedFields);
+
+            BSONObjBuilder bob;
+            BSONObjIterator patternIt(keyPattern);
+            BSONObjIterator keyIt(key);
+            while (keyIt.more()) {
+                const BSONElement patternElt = patternIt.next();
+                const BSONElement keyElt = keyIt.next();
+                if (includedFields.count(patternElt.fieldNameStringData())) {
+                    bob.appendAs(keyElt, patternElt.fieldNameStringData());
+                }
+            }
+            return bob.obj();
+        }
+
+        static std::string fieldNames(const BSONObj& obj) {
+            std::string names;
+            BSONObjIterator it(obj);
+            while (it.more()) {
+                if (!names.empty()) {
+                    names += ",";
+                }
+                names += it.next().fieldName();
+            }
+            return names;
+        }
+    };
+
+    /**
+     * The output follows the key order rather than the projection's.
+     */
+    class ProjectionOrderDiffersFromKeyOrder : public CoveredProjectionBase {
+    protected:
+        const char* keyPatternJson() const { return "{a: 1, b: 1, c: 1, d: 1, e: 1, f: 1}"; }
+        const char* projectionJson() const { return "{_id: 0, e: 1, c: 1, b: 1}"; }
+        std::string expectedFieldNames() const { return "b,c,e"; }
+    };
+
+    /**
+     * Key fields in between the included ones are skipped.
+     */
+    class NonContiguousSubset : public CoveredProjectionBase {
+    protected:
+        const char* keyPatternJson() const { return "{a: 1, b: -1, c: 1, d: 1, e: -1, f: 1}"; }
+        const char* projectionJson() const { return "{_id: 0, b: 1, d: 1, e: 1}"; }
+        std::string expectedFieldNames() const { return "b,d,e"; }
+    };
+
+    /**
+     * Included fields at the first and last key positions.
+     */
+    class FirstAndLastKeyFields : public CoveredProjectionBase {
+    protected:
+        const char* keyPatternJson() const { return "{a: 1, b: 1, c: 1, d: 1, e: 1, f: 1}"; }
+        const char* projectionJson() const { return "{_id: 0, f: 1, a: 1}"; }
+        std::string expectedFieldNames() const { return "a,f"; }
+    };
+
+    /**
+     * Every key field, with field names of differing lengths.
+     */
+    class AllKeyFields : public CoveredProjectionBase {
+    protected:
+        const char* keyPatternJson() const {
+            return "{a: 1, bb: 1, ccc: 1, dddd: 1, eeeeeeeeeeeeeeeeeeee: 1, f: 1}";
+        }
+        const char* projectionJson() const {
+            return "{_id: 0, a: 1, bb: 1, ccc: 1, dddd: 1, eeeeeeeeeeeeeeeeeeee: 1, f: 1}";
+        }
+        std::string expectedFieldNames() const {
+            return "a,bb,ccc,dddd,eeeeeeeeeeeeeeeeeeee,f";
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite("query_stage_projection") { }
+
+        void setupTests() {
+            add<ProjectionOrderDiffersFromKeyOrder>();
+            add<NonContiguousSubset>();
+            add<FirstAndLastKeyFields>();
+            add<AllKeyFields>();
+        }
+    };
+
+    SuiteInstance<All> queryStageProjectionAll;
+
+}  // namespace QueryStageProjection
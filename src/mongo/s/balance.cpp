@@ -34,6 +34,7 @@
 
 #include <algorithm>
 #include <boost/scoped_ptr.hpp>
+#include <list>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/client.h"
@@ -56,6 +57,10 @@
 #include "mongo/s/grid.h"
 #include "mongo/s/client/shard.h"
 #include "mongo/s/type_mongos.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -67,6 +72,7 @@ namespace mongo {
     using boost::scoped_ptr;
     using boost::shared_ptr;
     using std::auto_ptr;
+    using std::list;
     using std::map;
     using std::set;
     using std::string;
@@ -76,135 +82,343 @@ namespace mongo {
 
     Balancer balancer;
 
-    Balancer::Balancer()
-        : _balancedLastTime(0),
-          _policy(new BalancerPolicy()) {
+namespace {
+
+    // Used when the balancer settings don't specify _maxConcurrentMigrations
+    const int kDefaultMaxConcurrentMigrations = 1;
+
+    /**
+     * Returns false if balancing was disabled (or its state can't be determined) since the
+     * current round started.
+     */
+    bool balancingStillEnabled() {
+        const auto balSettingsResult =
+            grid.catalogManager()->getGlobalSettings(SettingsType::BalancerDocKey);
+
+        const bool isBalSettingsAbsent =
+            balSettingsResult.getStatus() == ErrorCodes::NoSuchKey;
+
+        if (!balSettingsResult.isOK() && !isBalSettingsAbsent) {
+            warning() << balSettingsResult.getStatus();
+            return false;
+        }
+
+        const SettingsType& balancerConfig = balSettingsResult.getValue();
+
+        if ((!isBalSettingsAbsent && !grid.shouldBalance(balancerConfig)) ||
+             MONGO_FAIL_POINT(skipBalanceRound)) {
+            LOG(1) << "Stopping balancing round early as balancing was disabled";
+            return false;
+        }
 
+        return true;
     }
 
-    Balancer::~Balancer() = default;
+    /**
+     * Records the outcome of a single migration, along with its throughput, in the actionlog.
+     * Formats for details are:
+     * Success: {
+     *           "ns" : , "from" : , "to" : , "min" : , "max" : ,
+     *           "executionTimeMillis" : ,
+     *           "errorOccured" : false,
+     *           "cloned" : ,
+     *           "clonedBytes" : ,
+     *           "clonedBytesPerSecond" :
+     *          }
+     * Failure: {
+     *           "ns" : , "from" : , "to" : , "min" : , "max" : ,
+     *           "executionTimeMillis" : ,
+     *           "errorOccured" : true,
+     *           "errmsg" :
+     *          }
+     * The clone counts are only present if the donor shard reports them.
+     */
+    void logMigration(const MigrateInfo& migrateInfo,
+                      bool moved,
+                      int executionTimeMillis,
+                      const BSONObj& res) {
+        BSONObjBuilder details;
+        details.append("ns", migrateInfo.ns);
+        details.append("from", migrateInfo.from);
+        details.append("to", migrateInfo.to);
+        details.append("min", migrateInfo.chunk.min);
+        details.append("max", migrateInfo.chunk.max);
+        details.append("executionTimeMillis", executionTimeMillis);
+        details.append("errorOccured", !moved);
+
+        if (!moved) {
+            details.append("errmsg", res["errmsg"].str());
+        }
+        else if (res["counts"].type() == Object) {
+            const BSONObj counts = res["counts"].Obj();
+            const long long clonedBytes = counts["clonedBytes"].safeNumberLong();
+
+            details.append("cloned", counts["cloned"].safeNumberLong());
+            details.append("clonedBytes", clonedBytes);
+            details.append("clonedBytesPerSecond",
+                           clonedBytes * 1000 / std::max(executionTimeMillis, 1));
+        }
 
-    int Balancer::_moveChunks(const vector<shared_ptr<MigrateInfo>>& candidateChunks,
-                              const WriteConcernOptions* writeConcern,
-                              bool waitForDelete)
-    {
-        int movedCount = 0;
+        ActionLogType actionLog;
+        actionLog.setServer(getHostNameCached());
+        actionLog.setWhat("balancer.move");
+        actionLog.setDetails(details.obj());
+        actionLog.setTime(jsTime());
 
-        for (const auto& migrateInfo : candidateChunks) {
-            // If the balancer was disabled since we started this round, don't start new chunks
-            // moves.
-            const auto balSettingsResult =
-                grid.catalogManager()->getGlobalSettings(SettingsType::BalancerDocKey);
+        grid.catalogManager()->logAction(actionLog);
+    }
 
-            const bool isBalSettingsAbsent =
-                balSettingsResult.getStatus() == ErrorCodes::NoSuchKey;
+    /**
+     * Runs a single migration chosen by the balancer policy.
+     *
+     * @return true if the chunk was moved, or marked as jumbo so the next round should start
+     *      right away
+     */
+    bool moveChunk(const MigrateInfo& migrateInfo,
+                   const WriteConcernOptions* writeConcern,
+                   bool waitForDelete) {
+        // Changes to metadata, borked metadata, and connectivity problems between shards
+        // should cause us to abort this chunk move, but shouldn't cause us to abort the entire
+        // round of chunks.
+        //
+        // TODO(spencer): We probably *should* abort the whole round on issues communicating
+        // with the config servers, but its impossible to distinguish those types of failures
+        // at the moment.
+        //
+        // TODO: Handle all these things more cleanly, since they're expected problems
 
-            if (!balSettingsResult.isOK() && !isBalSettingsAbsent) {
-                warning() << balSettingsResult.getStatus();
-                return movedCount;
-            }
+        const NamespaceString nss(migrateInfo.ns);
+
+        try {
+            auto status = grid.catalogCache()->getDatabase(nss.db().toString());
+            fassert(28628, status.getStatus());
 
-            const SettingsType& balancerConfig = balSettingsResult.getValue();
+            shared_ptr<DBConfig> cfg = status.getValue();
 
-            if ((!isBalSettingsAbsent && !grid.shouldBalance(balancerConfig)) ||
-                 MONGO_FAIL_POINT(skipBalanceRound)) {
-                LOG(1) << "Stopping balancing round early as balancing was disabled";
-                return movedCount;
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            shared_ptr<ChunkManager> cm = cfg->getChunkManager(migrateInfo.ns);
+            invariant(cm);
+
+            ChunkPtr c = cm->findIntersectingChunk(migrateInfo.chunk.min);
+
+            if (c->getMin().woCompare(migrateInfo.chunk.min) ||
+                    c->getMax().woCompare(migrateInfo.chunk.max)) {
+
+                // Likely a split happened somewhere, so force reload the chunk manager
+                cm = cfg->getChunkManager(migrateInfo.ns, true);
+                invariant(cm);
+
+                c = cm->findIntersectingChunk(migrateInfo.chunk.min);
+
+                if (c->getMin().woCompare(migrateInfo.chunk.min) ||
+                        c->getMax().woCompare(migrateInfo.chunk.max)) {
+
+                    log() << "chunk mismatch after reload, ignoring will retry issue "
+                          << migrateInfo.chunk.toString();
+
+                    return false;
+                }
             }
 
-            // Changes to metadata, borked metadata, and connectivity problems between shards
-            // should cause us to abort this chunk move, but shouldn't cause us to abort the entire
-            // round of chunks.
-            //
-            // TODO(spencer): We probably *should* abort the whole round on issues communicating
-            // with the config servers, but its impossible to distinguish those types of failures
-            // at the moment.
-            //
-            // TODO: Handle all these things more cleanly, since they're expected problems
+            Timer moveTimer;
+            BSONObj res;
+            const bool moved = c->moveAndCommit(Shard::make(migrateInfo.to),
+                                                Chunk::MaxChunkSize,
+                                                writeConcern,
+                                                waitForDelete,
+                                                0, /* maxTimeMS */
+                                                res);
 
-            const NamespaceString nss(migrateInfo->ns);
+            logMigration(migrateInfo, moved, moveTimer.millis(), res);
 
-            try {
-                auto status = grid.catalogCache()->getDatabase(nss.db().toString());
-                fassert(28628, status.getStatus());
+            if (moved) {
+                return true;
+            }
 
-                shared_ptr<DBConfig> cfg = status.getValue();
+            // The move requires acquiring the collection metadata's lock, which can fail.
+            log() << "balancer move failed: " << res
+                  << " from: " << migrateInfo.from
+                  << " to: " << migrateInfo.to
+                  << " chunk: " << migrateInfo.chunk;
 
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                shared_ptr<ChunkManager> cm = cfg->getChunkManager(migrateInfo->ns);
+            if (res["chunkTooBig"].trueValue()) {
+                // Reload just to be safe
+                cm = cfg->getChunkManager(migrateInfo.ns);
                 invariant(cm);
 
-                ChunkPtr c = cm->findIntersectingChunk(migrateInfo->chunk.min);
-
-                if (c->getMin().woCompare(migrateInfo->chunk.min) ||
-                        c->getMax().woCompare(migrateInfo->chunk.max)) {
+                c = cm->findIntersectingChunk(migrateInfo.chunk.min);
 
-                    // Likely a split happened somewhere, so force reload the chunk manager
-                    cm = cfg->getChunkManager(migrateInfo->ns, true);
-                    invariant(cm);
+                log() << "performing a split because migrate failed for size reasons";
 
-                    c = cm->findIntersectingChunk(migrateInfo->chunk.min);
+                Status status = c->split(Chunk::normal, NULL, NULL);
+                log() << "split results: " << status;
 
-                    if (c->getMin().woCompare(migrateInfo->chunk.min) ||
-                            c->getMax().woCompare(migrateInfo->chunk.max)) {
+                if (!status.isOK()) {
+                    log() << "marking chunk as jumbo: " << c->toString();
 
-                        log() << "chunk mismatch after reload, ignoring will retry issue "
-                              << migrateInfo->chunk.toString();
+                    c->markAsJumbo();
 
-                        continue;
-                    }
+                    // We count this as a move so we do another round right away
+                    return true;
                 }
+            }
+        }
+        catch (const DBException& ex) {
+            warning() << "could not move chunk " << migrateInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy(ex);
+        }
 
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(migrateInfo->to),
-                                     Chunk::MaxChunkSize,
-                                     writeConcern,
-                                     waitForDelete,
-                                     0, /* maxTimeMS */
-                                     res)) {
+        return false;
+    }
 
-                    movedCount++;
-                    continue;
-                }
+} // namespace
 
-                // The move requires acquiring the collection metadata's lock, which can fail.
-                log() << "balancer move failed: " << res
-                      << " from: " << migrateInfo->from
-                      << " to: " << migrateInfo->to
-                      << " chunk: " << migrateInfo->chunk;
+    int runMigrations(const vector<shared_ptr<MigrateInfo>>& candidateChunks,
+                      int maxConcurrentMigrations,
+                      const stdx::function<bool (const MigrateInfo&)>& moveChunk,
+                      const stdx::function<bool ()>& shouldContinue) {
+        invariant(maxConcurrentMigrations > 0);
 
-                if (res["chunkTooBig"].trueValue()) {
-                    // Reload just to be safe
-                    cm = cfg->getChunkManager(migrateInfo->ns);
-                    invariant(cm);
+        // Protects the state below, which is shared with the migration threads
+        stdx::mutex mutex;
+        stdx::condition_variable migrationDone;
+        set<string> busyShards;
+        set<string> busyNamespaces;
+        int inProgress = 0;
+        int movedCount = 0;
+
+        list<shared_ptr<MigrateInfo>> pending(candidateChunks.begin(), candidateChunks.end());
+        vector<shared_ptr<stdx::thread>> threads;
 
-                    c = cm->findIntersectingChunk(migrateInfo->chunk.min);
+        // Runs a single migration, counting it as not moved if it throws
+        auto tryMoveChunk = [&moveChunk](const MigrateInfo& migrateInfo) {
+            try {
+                return moveChunk(migrateInfo);
+            }
+            catch (const std::exception& ex) {
+                warning() << "could not move chunk " << migrateInfo.chunk.toString()
+                          << causedBy(ex);
+                return false;
+            }
+        };
+
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        while (!pending.empty()) {
+            // Candidates are started in the order the policy returned them, skipping over the
+            // ones which conflict with a migration in progress.
+            auto next = pending.end();
+            if (inProgress < maxConcurrentMigrations) {
+                next = std::find_if(pending.begin(),
+                                    pending.end(),
+                                    [&](const shared_ptr<MigrateInfo>& migrateInfo) {
+                    return !busyShards.count(migrateInfo->from) &&
+                           !busyShards.count(migrateInfo->to) &&
+                           !busyNamespaces.count(migrateInfo->ns);
+                });
+            }
 
-                    log() << "performing a split because migrate failed for size reasons";
+            if (next == pending.end()) {
+                // Nothing in conflict can be in progress if there is no migration running
+                invariant(inProgress > 0);
+                migrationDone.wait(lk);
+                continue;
+            }
 
-                    Status status = c->split(Chunk::normal, NULL, NULL);
-                    log() << "split results: " << status;
+            const shared_ptr<MigrateInfo> migrateInfo = *next;
+            pending.erase(next);
 
-                    if (!status.isOK()) {
-                        log() << "marking chunk as jumbo: " << c->toString();
+            lk.unlock();
+            const bool stillEnabled = shouldContinue();
+            lk.lock();
 
-                        c->markAsJumbo();
+            if (!stillEnabled) {
+                break;
+            }
 
-                        // We increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+            if (maxConcurrentMigrations == 1) {
+                // Nothing to overlap with, so don't bother with a thread
+                lk.unlock();
+                if (tryMoveChunk(*migrateInfo)) {
+                    movedCount++;
                 }
+                lk.lock();
+                continue;
             }
-            catch (const DBException& ex) {
-                warning() << "could not move chunk " << migrateInfo->chunk.toString()
-                          << ", continuing balancing round" << causedBy(ex);
+
+            busyShards.insert(migrateInfo->from);
+            busyShards.insert(migrateInfo->to);
+            busyNamespaces.insert(migrateInfo->ns);
+            inProgress++;
+
+            auto runMigration = [&, migrateInfo]() {
+                const bool moved = tryMoveChunk(*migrateInfo);
+
+                stdx::lock_guard<stdx::mutex> migrationLk(mutex);
+                busyShards.erase(migrateInfo->from);
+                busyShards.erase(migrateInfo->to);
+                busyNamespaces.erase(migrateInfo->ns);
+                inProgress--;
+                if (moved) {
+                    movedCount++;
+                }
+                migrationDone.notify_all();
+            };
+
+            try {
+                threads.push_back(shared_ptr<stdx::thread>(new stdx::thread(runMigration)));
+            }
+            catch (const std::exception& ex) {
+                warning() << "could not start migration thread" << causedBy(ex);
+
+                busyShards.erase(migrateInfo->from);
+                busyShards.erase(migrateInfo->to);
+                busyNamespaces.erase(migrateInfo->ns);
+                inProgress--;
+                break;
             }
         }
 
+        while (inProgress > 0) {
+            migrationDone.wait(lk);
+        }
+        lk.unlock();
+
+        for (const auto& thread : threads) {
+            thread->join();
+        }
+
         return movedCount;
     }
 
+    Balancer::Balancer()
+        : _balancedLastTime(0),
+          _policy(new BalancerPolicy()) {
+
+    }
+
+    Balancer::~Balancer() = default;
+
+    int Balancer::_moveChunks(const vector<shared_ptr<MigrateInfo>>& candidateChunks,
+                              const WriteConcernOptions* writeConcern,
+                              bool waitForDelete,
+                              int maxConcurrentMigrations)
+    {
+        return runMigrations(candidateChunks,
+                             maxConcurrentMigrations,
+                             [writeConcern, waitForDelete](const MigrateInfo& migrateInfo) {
+                                 // Migrations run on their own threads unless they run one at
+                                 // a time, in which case they run on the balancer's.
+                                 if (!haveClient()) {
+                                     Client::initThread("BalancerMigration");
+                                 }
+                                 return moveChunk(migrateInfo, writeConcern, waitForDelete);
+                             },
+                             // If the balancer was disabled since we started this round, don't
+                             // start new chunks moves.
+                             balancingStillEnabled);
+    }
+
     void Balancer::_ping(bool waiting) {
         grid.catalogManager()->update(
                         MongosType::ConfigNS,
@@ -568,6 +782,13 @@ namespace mongo {
                     const bool waitForDelete = (balancerConfig.isWaitForDeleteSet() ?
                             balancerConfig.getWaitForDelete() : false);
 
+                    const int maxConcurrentMigrations =
+                        (balancerConfig.isKeySet() &&
+                         balancerConfig.isMaxConcurrentMigrationsSet()) ?
+                            // validate() bounds the setting to the range of an int
+                            static_cast<int>(balancerConfig.getMaxConcurrentMigrations()) :
+                            kDefaultMaxConcurrentMigrations;
+
                     std::unique_ptr<WriteConcernOptions> writeConcern;
                     if (balancerConfig.isKeySet()) { // if balancer doc exists.
                         writeConcern = std::move(balancerConfig.getWriteConcern());
@@ -575,6 +796,7 @@ namespace mongo {
 
                     LOG(1) << "*** start balancing round. "
                            << "waitForDelete: " << waitForDelete
+                           << ", maxConcurrentMigrations: " << maxConcurrentMigrations
                            << ", secondaryThrottle: "
                            << (writeConcern.get() ? writeConcern->toBSON().toString() : "default")
                           ;
@@ -589,7 +811,8 @@ namespace mongo {
                     else {
                         _balancedLastTime = _moveChunks(candidateChunks,
                                                         writeConcern.get(),
-                                                        waitForDelete);
+                                                        waitForDelete,
+                                                        maxConcurrentMigrations);
                     }
 
                     actionLog.setDetails(
@@ -32,7 +32,9 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <vector>
 
+#include "mongo/stdx/functional.h"
 #include "mongo/util/background.h"
 
 namespace mongo {
@@ -41,6 +43,20 @@ namespace mongo {
     struct MigrateInfo;
     struct WriteConcernOptions;
 
+    /**
+     * Runs the candidate migrations through 'moveChunk', with at most 'maxConcurrentMigrations'
+     * in progress at once. Migrations which have a shard or a collection in common never overlap.
+     * 'shouldContinue' is checked before each migration is started and no new migrations are
+     * started once it returns false. A migration for which 'moveChunk' returns false or throws
+     * is not counted as moved.
+     *
+     * @return number of chunks effectively moved
+     */
+    int runMigrations(const std::vector<boost::shared_ptr<MigrateInfo>>& candidateChunks,
+                      int maxConcurrentMigrations,
+                      const stdx::function<bool (const MigrateInfo&)>& moveChunk,
+                      const stdx::function<bool ()>& shouldContinue);
+
     /**
      * The balancer is a background task that tries to keep the number of chunks across all
      * servers of the cluster even. Although every mongos will have one balancer running, only one
@@ -49,7 +65,8 @@ namespace mongo {
      *
      * The balancer does act continuously but in "rounds". At a given round, it would decide if
      * there is an imbalance by checking the difference in chunks between the most and least
-     * loaded shards. It would issue a request for a chunk migration per round, if it found so.
+     * loaded shards. It would issue a request for a chunk migration per collection, if it found
+     * so. Migrations which have no shard in common are run concurrently.
      */
     class Balancer : public BackgroundJob {
     public:
@@ -94,16 +111,20 @@ namespace mongo {
         void _doBalanceRound(std::vector<boost::shared_ptr<MigrateInfo>>* candidateChunks);
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Issues chunk migration requests. A shard can only donate or receive one chunk at a time
+         * and a collection only allows one migration at a time, so migrations run concurrently
+         * only if they have neither a shard nor a collection in common.
          *
          * @param candidateChunks possible chunks to move
          * @param writeConcern detailed write concern. NULL means the default write concern.
          * @param waitForDelete wait for deletes to complete after each chunk move
+         * @param maxConcurrentMigrations how many migrations may be in progress at once
          * @return number of chunks effectively moved
          */
         int _moveChunks(const std::vector<boost::shared_ptr<MigrateInfo>>& candidateChunks,
                         const WriteConcernOptions* writeConcern,
-                        bool waitForDelete);
+                        bool waitForDelete,
+                        int maxConcurrentMigrations);
 
         /**
          * Marks this balancer as being live on the config server(s).
@@ -0,0 +1,223 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/balance.h"
+
+#include <set>
+
+#include "mongo/s/balancer_policy.h"
+#include "mongo/s/catalog/type_chunk.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using namespace mongo;
+
+    using boost::shared_ptr;
+    using std::set;
+    using std::string;
+    using std::vector;
+
+    shared_ptr<MigrateInfo> makeMigration(const string& ns,
+                                          const string& from,
+                                          const string& to) {
+        return shared_ptr<MigrateInfo>(new MigrateInfo(ns,
+                                                       to,
+                                                       from,
+                                                       BSON(ChunkType::min(BSON("x" << 0)) <<
+                                                            ChunkType::max(BSON("x" << 10)))));
+    }
+
+    /**
+     * Stands in for the migration command. Each migration waits until 'width' of them are in
+     * progress (or half a second passes) so that the test sees as much overlap as the
+     * scheduler allows, and records the busiest moment and any shard used by two migrations at
+     * once.
+     */
+    class MigrationRecorder {
+    public:
+        explicit MigrationRecorder(int width) : _width(width) { }
+
+        bool moveChunk(const MigrateInfo& migrateInfo) {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+
+            if (_activeShards.count(migrateInfo.from) || _activeShards.count(migrateInfo.to)) {
+                _shardConflict = true;
+            }
+            _activeShards.insert(migrateInfo.from);
+            _activeShards.insert(migrateInfo.to);
+            _started.push_back(migrateInfo.ns);
+
+            _active++;
+            _maxActive = std::max(_maxActive, _active);
+            _changed.notify_all();
+
+            _changed.timed_wait(lk, boost::posix_time::milliseconds(500), [this]() {
+                return _active >= _width;
+            });
+
+            _active--;
+            _activeShards.erase(migrateInfo.from);
+            _activeShards.erase(migrateInfo.to);
+
+            if (migrateInfo.ns == "test.throws") {
+                uasserted(ErrorCodes::OperationFailed, "simulated migration failure");
+            }
+
+            return migrateInfo.ns != "test.fails";
+        }
+
+        stdx::function<bool (const MigrateInfo&)> asFunction() {
+            return [this](const MigrateInfo& migrateInfo) { return moveChunk(migrateInfo); };
+        }
+
+        int maxActive() const { return _maxActive; }
+        bool shardConflict() const { return _shardConflict; }
+        const vector<string>& started() const { return _started; }
+
+    private:
+        const int _width;
+
+        stdx::mutex _mutex;
+        stdx::condition_variable _changed;
+        set<string> _activeShards;
+        vector<string> _started;
+        int _active = 0;
+        int _maxActive = 0;
+        bool _shardConflict = false;
+    };
+
+    bool alwaysContinue() {
+        return true;
+    }
+
+    TEST(RunMigrations, SerialWhenLimitIsOne) {
+        vector<shared_ptr<MigrateInfo>> candidates;
+        candidates.push_back(makeMigration("test.a", "shard0", "shard1"));
+        candidates.push_back(makeMigration("test.b", "shard2", "shard3"));
+        candidates.push_back(makeMigration("test.c", "shard4", "shard5"));
+
+        MigrationRecorder recorder(2);
+        ASSERT_EQUALS(3, runMigrations(candidates, 1, recorder.asFunction(), alwaysContinue));
+        ASSERT_EQUALS(1, recorder.maxActive());
+
+        // Runs in the order the policy gave them
+        ASSERT_EQUALS(3U, recorder.started().size());
+        ASSERT_EQUALS("test.a", recorder.started()[0]);
+        ASSERT_EQUALS("test.b", recorder.started()[1]);
+        ASSERT_EQUALS("test.c", recorder.started()[2]);
+    }
+
+    TEST(RunMigrations, RespectsConcurrencyLimit) {
+        vector<shared_ptr<MigrateInfo>> candidates;
+        for (int i = 0; i < 6; i++) {
+            candidates.push_back(makeMigration(str::stream() << "test.coll" << i,
+                                               str::stream() << "from" << i,
+                                               str::stream() << "to" << i));
+        }
+
+        MigrationRecorder recorder(3);
+        ASSERT_EQUALS(6, runMigrations(candidates, 3, recorder.asFunction(), alwaysContinue));
+        ASSERT_EQUALS(3, recorder.maxActive());
+        ASSERT_FALSE(recorder.shardConflict());
+    }
+
+    TEST(RunMigrations, NeverSharesAShard) {
+        // Every migration touches shard0, either as the donor or as the recipient
+        vector<shared_ptr<MigrateInfo>> candidates;
+        candidates.push_back(makeMigration("test.a", "shard0", "shard1"));
+        candidates.push_back(makeMigration("test.b", "shard2", "shard0"));
+        candidates.push_back(makeMigration("test.c", "shard0", "shard3"));
+        candidates.push_back(makeMigration("test.d", "shard4", "shard0"));
+
+        MigrationRecorder recorder(4);
+        ASSERT_EQUALS(4, runMigrations(candidates, 4, recorder.asFunction(), alwaysContinue));
+        ASSERT_EQUALS(1, recorder.maxActive());
+        ASSERT_FALSE(recorder.shardConflict());
+    }
+
+    TEST(RunMigrations, SkipsConflictsAndOverlapsTheRest) {
+        // test.b conflicts with test.a on shard1, but test.c can run next to test.a
+        vector<shared_ptr<MigrateInfo>> candidates;
+        candidates.push_back(makeMigration("test.a", "shard0", "shard1"));
+        candidates.push_back(makeMigration("test.b", "shard1", "shard2"));
+        candidates.push_back(makeMigration("test.c", "shard3", "shard4"));
+
+        MigrationRecorder recorder(2);
+        ASSERT_EQUALS(3, runMigrations(candidates, 4, recorder.asFunction(), alwaysContinue));
+        ASSERT_EQUALS(2, recorder.maxActive());
+        ASSERT_FALSE(recorder.shardConflict());
+        ASSERT_EQUALS("test.c", recorder.started()[1]);
+    }
+
+    TEST(RunMigrations, FailedMigrationsAreNotCounted) {
+        for (int limit = 1; limit <= 4; limit *= 4) {
+            vector<shared_ptr<MigrateInfo>> candidates;
+            candidates.push_back(makeMigration("test.fails", "shard0", "shard1"));
+            candidates.push_back(makeMigration("test.throws", "shard2", "shard3"));
+            candidates.push_back(makeMigration("test.a", "shard4", "shard5"));
+            candidates.push_back(makeMigration("test.b", "shard0", "shard2"));
+
+            MigrationRecorder recorder(limit);
+
+            // The failures don't stop the remaining migrations and don't leave their shards busy
+            ASSERT_EQUALS(2, runMigrations(candidates,
+                                           limit,
+                                           recorder.asFunction(),
+                                           alwaysContinue));
+            ASSERT_EQUALS(4U, recorder.started().size());
+            ASSERT_FALSE(recorder.shardConflict());
+        }
+    }
+
+    TEST(RunMigrations, StopsStartingWhenDisabled) {
+        for (int limit = 1; limit <= 4; limit *= 4) {
+            vector<shared_ptr<MigrateInfo>> candidates;
+            candidates.push_back(makeMigration("test.a", "shard0", "shard1"));
+            candidates.push_back(makeMigration("test.b", "shard2", "shard3"));
+            candidates.push_back(makeMigration("test.c", "shard4", "shard5"));
+
+            int checks = 0;
+            auto enabledTwice = [&checks]() { return ++checks <= 2; };
+
+            MigrationRecorder recorder(1);
+            ASSERT_EQUALS(2, runMigrations(candidates,
+                                           limit,
+                                           recorder.asFunction(),
+                                           enabledTwice));
+            ASSERT_EQUALS(2U, recorder.started().size());
+        }
+    }
+
+} // namespace
@@ -32,6 +32,7 @@
 
 #include "mongo/s/catalog/type_settings.h"
 
+#include <limits>
 #include <memory>
 
 #include "mongo/base/status_with.h"
@@ -57,6 +58,7 @@ namespace mongo {
     const BSONField<bool> SettingsType::deprecated_secondaryThrottle("_secondaryThrottle");
     const BSONField<BSONObj> SettingsType::migrationWriteConcern("_secondaryThrottle");
     const BSONField<bool> SettingsType::waitForDelete("_waitForDelete");
+    const BSONField<long long> SettingsType::maxConcurrentMigrations("_maxConcurrentMigrations");
 
     StatusWith<SettingsType> SettingsType::fromBSON(const BSONObj& source) {
         SettingsType settings;
@@ -138,6 +140,17 @@ namespace mongo {
                     settings._waitForDelete = settingsWaitForDelete;
                 }
             }
+
+            {
+                long long settingsMaxConcurrentMigrations;
+                Status status = bsonExtractIntegerField(source,
+                                                        maxConcurrentMigrations.name(),
+                                                        &settingsMaxConcurrentMigrations);
+                if (status != ErrorCodes::NoSuchKey) {
+                    if (!status.isOK()) return status;
+                    settings._maxConcurrentMigrations = settingsMaxConcurrentMigrations;
+                }
+            }
         }
 
         return settings;
@@ -163,6 +176,20 @@ namespace mongo {
                               str::stream() << "cannot have both secondary throttle and "
                                             << "migration write concern set at the same time");
             }
+
+            if (_maxConcurrentMigrations.is_initialized() && !(getMaxConcurrentMigrations() > 0)) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << maxConcurrentMigrations.name()
+                                            << " must be greater than zero");
+            }
+
+            if (_maxConcurrentMigrations.is_initialized() &&
+                getMaxConcurrentMigrations() > std::numeric_limits<int>::max()) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << maxConcurrentMigrations.name()
+                                            << " must be at most "
+                                            << std::numeric_limits<int>::max());
+            }
         }
         else {
             return Status(ErrorCodes::UnsupportedFormat,
@@ -185,6 +212,9 @@ namespace mongo {
             builder.append(migrationWriteConcern(), getMigrationWriteConcern().toBSON());
         }
         if (_waitForDelete) builder.append(waitForDelete(), getWaitForDelete());
+        if (_maxConcurrentMigrations) {
+            builder.append(maxConcurrentMigrations(), getMaxConcurrentMigrations());
+        }
 
         return builder.obj();
     }
@@ -303,4 +333,11 @@ namespace mongo {
         _waitForDelete = waitForDelete;
     }
 
+    void SettingsType::setMaxConcurrentMigrations(const long long maxConcurrentMigrations) {
+        invariant(_key == BalancerDocKey);
+        invariant(maxConcurrentMigrations > 0);
+        invariant(maxConcurrentMigrations <= std::numeric_limits<int>::max());
+        _maxConcurrentMigrations = maxConcurrentMigrations;
+    }
+
 } // namespace mongo
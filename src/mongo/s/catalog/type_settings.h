@@ -83,6 +83,7 @@ namespace mongo {
         static const BSONField<bool> deprecated_secondaryThrottle;
         static const BSONField<BSONObj> migrationWriteConcern;
         static const BSONField<bool> waitForDelete;
+        static const BSONField<long long> maxConcurrentMigrations;
 
         /**
          * Returns OK if all mandatory fields have been set and their corresponding
@@ -148,6 +149,12 @@ namespace mongo {
         bool getWaitForDelete() const { return _waitForDelete.get(); }
         void setWaitForDelete(const bool waitForDelete);
 
+        bool isMaxConcurrentMigrationsSet() const {
+            return _maxConcurrentMigrations.is_initialized();
+        }
+        long long getMaxConcurrentMigrations() const { return _maxConcurrentMigrations.get(); }
+        void setMaxConcurrentMigrations(const long long maxConcurrentMigrations);
+
     private:
 
         /**
@@ -185,6 +192,10 @@ namespace mongo {
 
         // (O)  synchronous migration cleanup.
         boost::optional<bool> _waitForDelete;
+
+        // (O)  how many migrations between disjoint pairs of shards the balancer may run at the
+        //      same time. Must be positive.
+        boost::optional<long long> _maxConcurrentMigrations;
     };
 
 } // namespace mongo
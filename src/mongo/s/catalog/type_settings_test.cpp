@@ -132,6 +132,36 @@ namespace {
         ASSERT(settings.getSecondaryThrottle());
     }
 
+    TEST(SettingsType, MaxConcurrentMigrations) {
+        BSONObj objBalancer = BSON(SettingsType::key(SettingsType::BalancerDocKey) <<
+                                   SettingsType::maxConcurrentMigrations(4));
+        StatusWith<SettingsType> result = SettingsType::fromBSON(objBalancer);
+        ASSERT_OK(result.getStatus());
+        SettingsType settings = result.getValue();
+        ASSERT_OK(settings.validate());
+        ASSERT(settings.isMaxConcurrentMigrationsSet());
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 4);
+        ASSERT_EQUALS(settings.toBSON(), objBalancer);
+
+        BSONObj objBalancerZero = BSON(SettingsType::key(SettingsType::BalancerDocKey) <<
+                                       SettingsType::maxConcurrentMigrations(0));
+        result = SettingsType::fromBSON(objBalancerZero);
+        ASSERT_OK(result.getStatus());
+        ASSERT_EQUALS(result.getValue().validate(), ErrorCodes::BadValue);
+
+        // Would become 0 if it were truncated to an int
+        BSONObj objBalancerTooLarge = BSON(SettingsType::key(SettingsType::BalancerDocKey) <<
+                                           SettingsType::maxConcurrentMigrations(4294967296LL));
+        result = SettingsType::fromBSON(objBalancerTooLarge);
+        ASSERT_OK(result.getStatus());
+        ASSERT_EQUALS(result.getValue().validate(), ErrorCodes::BadValue);
+
+        BSONObj objBalancerBadType = BSON(SettingsType::key(SettingsType::BalancerDocKey) <<
+                                          SettingsType::maxConcurrentMigrations.name() << "4");
+        result = SettingsType::fromBSON(objBalancerBadType);
+        ASSERT_FALSE(result.isOK());
+    }
+
     TEST(SettingsType, BadType) {
         BSONObj badTypeObj = BSON(SettingsType::key() << 0);
         StatusWith<SettingsType> result = SettingsType::fromBSON(badTypeObj);
@@ -290,7 +290,8 @@ namespace {
     void Chunk::pickSplitVector(vector<BSONObj>& splitPoints,
                                 long long chunkSize /* bytes */,
                                 int maxPoints,
-                                int maxObjs) const {
+                                int maxObjs,
+                                bool estimate) const {
         // Ask the mongod holding this chunk to figure out the split points.
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
@@ -302,6 +303,9 @@ namespace {
         cmd.append( "maxChunkSizeBytes" , chunkSize );
         cmd.append( "maxSplitPoints" , maxPoints );
         cmd.append( "maxChunkObjects" , maxObjs );
+        if ( estimate ) {
+            cmd.appendBool( "estimate" , true );
+        }
         BSONObj cmdObj = cmd.obj();
 
         if ( ! conn->runCommand( "admin" , cmdObj , result )) {
@@ -318,7 +322,100 @@ namespace {
         conn.done();
     }
 
-    void Chunk::determineSplitPoints(bool atMedian, vector<BSONObj>* splitPoints) const {
+    bool Chunk::pickSplitVectors(const vector<ChunkPtr>& chunks,
+                                 vector<vector<BSONObj> >* splitPoints,
+                                 vector<Status>* errors) {
+        invariant( !chunks.empty() );
+        const ChunkPtr& first = chunks.front();
+        const ChunkManager* manager = first->getManager();
+
+        BSONObjBuilder cmd;
+        cmd.append( "splitVector" , manager->getns() );
+        cmd.append( "keyPattern" , manager->getShardKeyPattern().toBSON() );
+        // Shards which don't know about 'ranges' only look at the first chunk
+        cmd.append( "min" , first->getMin() );
+        cmd.append( "max" , first->getMax() );
+        cmd.append( "maxSplitPoints" , 0 );
+        cmd.append( "maxChunkObjects" , MaxObjectPerChunk );
+        cmd.appendBool( "estimate" , true );
+
+        BSONArrayBuilder ranges( cmd.subarrayStart( "ranges" ) );
+        for ( vector<ChunkPtr>::const_iterator it = chunks.begin(); it != chunks.end(); ++it ) {
+            const ChunkPtr& chunk = *it;
+            dassert( chunk->getShard() == first->getShard() );
+            ranges.append( BSON( "min" << chunk->getMin()
+                              << "max" << chunk->getMax()
+                              << "maxChunkSizeBytes" << chunk->getAutoSplitChunkSize() ) );
+        }
+        ranges.done();
+        BSONObj cmdObj = cmd.obj();
+
+        ScopedDbConnection conn(first->getShard().getConnString());
+        BSONObj result;
+        if ( ! conn->runCommand( "admin" , cmdObj , result )) {
+            conn.done();
+            ostringstream os;
+            os << "splitVector command failed: " << result;
+            uassert( 13345 , os.str() , 0 );
+        }
+        conn.done();
+
+        BSONElement rangeSplitKeys = result["rangeSplitKeys"];
+        if ( rangeSplitKeys.type() != Array ) {
+            return false;
+        }
+
+        splitPoints->clear();
+        BSONObjIterator rangesIt( rangeSplitKeys.Obj() );
+        while ( rangesIt.more() ) {
+            splitPoints->push_back( vector<BSONObj>() );
+            BSONObjIterator keysIt( rangesIt.next().Obj() );
+            while ( keysIt.more() ) {
+                splitPoints->back().push_back( keysIt.next().Obj().getOwned() );
+            }
+        }
+
+        uassert( 28803,
+                 str::stream() << "splitVector returned split points for " << splitPoints->size()
+                               << " chunks instead of " << chunks.size(),
+                 splitPoints->size() == chunks.size() );
+
+        errors->assign( chunks.size(), Status::OK() );
+        BSONObjIterator errorsIt( result.getObjectField( "rangeErrors" ) );
+        while ( errorsIt.more() ) {
+            const BSONObj error = errorsIt.next().Obj();
+            const int index = error["index"].numberInt();
+            uassert( 28810,
+                     str::stream() << "splitVector returned an error for chunk " << index
+                                   << " of " << chunks.size(),
+                     index >= 0 && static_cast<size_t>( index ) < chunks.size() );
+
+            (*errors)[index] = Status( ErrorCodes::fromInt( error["code"].numberInt() ),
+                                       error["errmsg"].str() );
+        }
+
+        return true;
+    }
+
+    long long Chunk::getAutoSplitChunkSize() const {
+        long long chunkSize = _manager->getCurrentDesiredChunkSize();
+
+        // Note: One split point for every 1/2 chunk size.
+        const int estNumSplitPoints = _dataWritten / chunkSize * 2;
+        if (estNumSplitPoints >= kTooManySplitPoints) {
+            // The current desired chunk size will split the chunk into lots of small chunks
+            // (At the worst case, this can result into thousands of chunks); so check and
+            // see if a bigger value can be used.
+
+            chunkSize = std::min(_dataWritten, Chunk::MaxChunkSize);
+        }
+
+        return chunkSize;
+    }
+
+    void Chunk::determineSplitPoints(bool atMedian,
+                                     bool estimate,
+                                     vector<BSONObj>* splitPoints) const {
         // if splitting is not obligatory we may return early if there are not enough data
         // we cap the number of objects that would fall in the first half (before the split point)
         // the rationale is we'll find a split point without traversing all the data
@@ -329,19 +426,11 @@ namespace {
                 splitPoints->push_back( medianKey );
         }
         else {
-            long long chunkSize = _manager->getCurrentDesiredChunkSize();
-
-            // Note: One split point for every 1/2 chunk size.
-            const int estNumSplitPoints = _dataWritten / chunkSize * 2;
-            if (estNumSplitPoints >= kTooManySplitPoints) {
-                // The current desired chunk size will split the chunk into lots of small chunks
-                // (At the worst case, this can result into thousands of chunks); so check and
-                // see if a bigger value can be used.
-
-                chunkSize = std::min(_dataWritten, Chunk::MaxChunkSize);
-            }
-
-            pickSplitVector(*splitPoints, chunkSize, 0, MaxObjectPerChunk);
+            pickSplitVector(*splitPoints,
+                            getAutoSplitChunkSize(),
+                            0,
+                            MaxObjectPerChunk,
+                            estimate);
 
             if ( splitPoints->size() <= 1 ) {
                 // no split points means there isn't enough data to split on
@@ -358,10 +447,24 @@ namespace {
             resultingSplits = &dummy;
         }
 
-        bool atMedian = mode == Chunk::atMedian;
         vector<BSONObj> splitPoints;
+        determineSplitPoints( mode == Chunk::atMedian,
+                              mode == Chunk::autoSplitInternal,
+                              &splitPoints );
 
-        determineSplitPoints( atMedian, &splitPoints );
+        return splitAt(mode, splitPoints, resultingSplits, res);
+    }
+
+    Status Chunk::splitAt(SplitPointMode mode,
+                          vector<BSONObj> splitPoints,
+                          size_t* resultingSplits,
+                          BSONObj* res) const {
+        size_t dummy;
+        if (resultingSplits == NULL) {
+            resultingSplits = &dummy;
+        }
+
+        bool atMedian = mode == Chunk::atMedian;
         if (splitPoints.empty()) {
             string msg;
             if (atMedian) {
@@ -522,18 +625,22 @@ namespace {
         return worked;
     }
 
+    bool Chunk::shouldCheckSplit( long dataWritten ) const {
+        _dataWritten += dataWritten;
+        int splitThreshold = getManager()->getCurrentDesiredChunkSize();
+        if (_minIsInf() || _maxIsInf()) {
+            splitThreshold = (int)((double)splitThreshold * .9);
+        }
+
+        return _dataWritten >= splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor;
+    }
+
     bool Chunk::splitIfShould( long dataWritten ) const {
         dassert( ShouldAutoSplit );
         LastError::Disabled d(&LastError::get(cc()));
 
         try {
-            _dataWritten += dataWritten;
-            int splitThreshold = getManager()->getCurrentDesiredChunkSize();
-            if (_minIsInf() || _maxIsInf()) {
-                splitThreshold = (int)((double)splitThreshold * .9);
-            }
-
-            if ( _dataWritten < splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor )
+            if ( !shouldCheckSplit( dataWritten ) )
                 return false;
             
             if ( ! getManager()->_splitHeuristics._splitTickets.tryAcquire() ) {
@@ -549,78 +656,182 @@ namespace {
             // this was implicit before since we did a splitVector on the same socket
             ShardConnection::sync();
 
-            LOG(1) << "about to initiate autosplit: " << *this << " dataWritten: " << _dataWritten << " splitThreshold: " << splitThreshold;
+            return autoSplit(NULL);
+        }
+        catch ( DBException& e ) {
 
-            BSONObj res;
-            size_t splitCount = 0;
-            Status status = split(Chunk::autoSplitInternal,
-                                  &splitCount,
-                                  &res);
-            if (!status.isOK()) {
-                // Split would have issued a message if we got here. This means there wasn't enough
-                // data to split, so don't want to try again until considerable more data
-                _dataWritten = 0;
-                return false;
-            }
-            
-            if (_maxIsInf() || _minIsInf()) {
-                // we don't want to reset _dataWritten since we kind of want to check the other side right away
+            // TODO: Make this better - there are lots of reasons a split could fail
+            // Random so that we don't sync up with other failed splits
+            _dataWritten = mkDataWritten();
+
+            // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
+            warning() << "could not autosplit collection " << _manager->getns() << causedBy( e );
+            return false;
+        }
+    }
+
+    void Chunk::splitIfShould( const vector<std::pair<ChunkPtr, long> >& chunksWritten ) {
+        dassert( ShouldAutoSplit );
+        if ( chunksWritten.empty() )
+            return;
+
+        LastError::Disabled d(&LastError::get(cc()));
+        const ChunkManager* manager = chunksWritten.front().first->getManager();
+
+        // Only the chunks whose write estimate is high enough are worth a look, grouped by the
+        // shard which owns them.
+        map<string, vector<ChunkPtr> > chunksByShard;
+        for ( vector<std::pair<ChunkPtr, long> >::const_iterator it = chunksWritten.begin();
+              it != chunksWritten.end();
+              ++it ) {
+            const ChunkPtr& chunk = it->first;
+            dassert( chunk->getManager() == manager );
+            if ( chunk->shouldCheckSplit( it->second ) ) {
+                chunksByShard[chunk->getShard().getName()].push_back( chunk );
             }
-            else {
-                // we're splitting, so should wait a bit
-                _dataWritten = 0;
+        }
+
+        if ( chunksByShard.empty() )
+            return;
+
+        if ( ! manager->_splitHeuristics._splitTickets.tryAcquire() ) {
+            LOG(1) << "won't auto split because not enough tickets: " << manager->getns();
+            return;
+        }
+        TicketHolderReleaser releaser( &(manager->_splitHeuristics._splitTickets) );
+
+        // See splitIfShould above
+        try {
+            ShardConnection::sync();
+        }
+        catch ( DBException& e ) {
+            warning() << "could not autosplit collection " << manager->getns() << causedBy( e );
+            return;
+        }
+
+        for ( map<string, vector<ChunkPtr> >::const_iterator shardIt = chunksByShard.begin();
+              shardIt != chunksByShard.end();
+              ++shardIt ) {
+            const vector<ChunkPtr>& chunks = shardIt->second;
+
+            vector<vector<BSONObj> > splitPoints;
+            vector<Status> splitPointErrors;
+            bool batched = false;
+            if ( chunks.size() > 1 ) {
+                try {
+                    batched = pickSplitVectors( chunks, &splitPoints, &splitPointErrors );
+                }
+                catch ( DBException& e ) {
+                    warning() << "could not look up split points of " << chunks.size()
+                              << " chunks of collection " << manager->getns()
+                              << " on shard " << shardIt->first << causedBy( e );
+
+                    // Random so that we don't sync up with other failed splits, and so that the
+                    // shard isn't asked again on every write until more data has been written.
+                    for ( size_t i = 0; i < chunks.size(); i++ ) {
+                        chunks[i]->_dataWritten = mkDataWritten();
+                    }
+                    continue;
+                }
             }
 
-            bool shouldBalance = grid.getConfigShouldBalance();
-            if (shouldBalance) {
-                auto status = grid.catalogManager()->getCollection(_manager->getns());
-                if (!status.isOK()) {
-                    log() << "Auto-split for " << _manager->getns()
-                          << " failed to load collection metadata due to " << status.getStatus();
-                    return false;
+            for ( size_t i = 0; i < chunks.size(); i++ ) {
+                const ChunkPtr& chunk = chunks[i];
+                try {
+                    if ( batched && !splitPointErrors[i].isOK() ) {
+                        // Same as when the lookup of all the chunks fails
+                        chunk->_dataWritten = mkDataWritten();
+                        warning() << "could not look up split points of chunk " << *chunk
+                                  << " of collection " << manager->getns()
+                                  << causedBy( splitPointErrors[i] );
+                    }
+                    else if ( batched ) {
+                        // Same rule as in determineSplitPoints
+                        if ( splitPoints[i].size() <= 1 ) {
+                            splitPoints[i].clear();
+                        }
+                        chunk->autoSplit( &splitPoints[i] );
+                    }
+                    else {
+                        chunk->autoSplit( NULL );
+                    }
+                }
+                catch ( DBException& e ) {
+                    // Random so that we don't sync up with other failed splits
+                    chunk->_dataWritten = mkDataWritten();
+                    warning() << "could not autosplit collection " << manager->getns()
+                              << causedBy( e );
                 }
+            }
+        }
+    }
+
+    bool Chunk::autoSplit( const vector<BSONObj>* presetSplitPoints ) const {
+        int splitThreshold = getManager()->getCurrentDesiredChunkSize();
+        if (_minIsInf() || _maxIsInf()) {
+            splitThreshold = (int)((double)splitThreshold * .9);
+        }
+
+        LOG(1) << "about to initiate autosplit: " << *this << " dataWritten: " << _dataWritten << " splitThreshold: " << splitThreshold;
 
-                shouldBalance = status.getValue().getAllowBalance();
+        BSONObj res;
+        size_t splitCount = 0;
+        Status status = presetSplitPoints ?
+            splitAt(Chunk::autoSplitInternal, *presetSplitPoints, &splitCount, &res) :
+            split(Chunk::autoSplitInternal, &splitCount, &res);
+        if (!status.isOK()) {
+            // Split would have issued a message if we got here. This means there wasn't enough
+            // data to split, so don't want to try again until considerable more data
+            _dataWritten = 0;
+            return false;
+        }
+        
+        if (_maxIsInf() || _minIsInf()) {
+            // we don't want to reset _dataWritten since we kind of want to check the other side right away
+        }
+        else {
+            // we're splitting, so should wait a bit
+            _dataWritten = 0;
+        }
+
+        bool shouldBalance = grid.getConfigShouldBalance();
+        if (shouldBalance) {
+            auto status = grid.catalogManager()->getCollection(_manager->getns());
+            if (!status.isOK()) {
+                log() << "Auto-split for " << _manager->getns()
+                      << " failed to load collection metadata due to " << status.getStatus();
+                return false;
             }
 
-            log() << "autosplitted " << _manager->getns()
-                  << " shard: " << toString()
-                  << " into " << (splitCount + 1)
-                  << " (splitThreshold " << splitThreshold << ")"
+            shouldBalance = status.getValue().getAllowBalance();
+        }
+
+        log() << "autosplitted " << _manager->getns()
+              << " shard: " << toString()
+              << " into " << (splitCount + 1)
+              << " (splitThreshold " << splitThreshold << ")"
 #ifdef MONGO_CONFIG_DEBUG_BUILD
-                  << " size: " << getPhysicalSize() // slow - but can be useful when debugging
+              << " size: " << getPhysicalSize() // slow - but can be useful when debugging
 #endif
-                  << ( res["shouldMigrate"].eoo() ? "" : (string)" (migrate suggested" +
-                     ( shouldBalance ? ")" : ", but no migrations allowed)" ) );
-
-            // Top chunk optimization - try to move the top chunk out of this shard
-            // to prevent the hot spot from staying on a single shard. This is based on
-            // the assumption that succeeding inserts will fall on the top chunk.
-            BSONElement shouldMigrate = res["shouldMigrate"]; // not in mongod < 1.9.1 but that is ok
-            if ( ! shouldMigrate.eoo() && shouldBalance ){
-                BSONObj range = shouldMigrate.embeddedObject();
-
-                ChunkType chunkToMove;
-                chunkToMove.setShard(getShard().toString());
-                chunkToMove.setMin(range["min"].embeddedObject());
-                chunkToMove.setMax(range["max"].embeddedObject());
-
-                tryMoveToOtherShard(*_manager, chunkToMove);
-            }
+              << ( res["shouldMigrate"].eoo() ? "" : (string)" (migrate suggested" +
+                 ( shouldBalance ? ")" : ", but no migrations allowed)" ) );
 
-            return true;
+        // Top chunk optimization - try to move the top chunk out of this shard
+        // to prevent the hot spot from staying on a single shard. This is based on
+        // the assumption that succeeding inserts will fall on the top chunk.
+        BSONElement shouldMigrate = res["shouldMigrate"]; // not in mongod < 1.9.1 but that is ok
+        if ( ! shouldMigrate.eoo() && shouldBalance ){
+            BSONObj range = shouldMigrate.embeddedObject();
 
-        }
-        catch ( DBException& e ) {
+            ChunkType chunkToMove;
+            chunkToMove.setShard(getShard().toString());
+            chunkToMove.setMin(range["min"].embeddedObject());
+            chunkToMove.setMax(range["max"].embeddedObject());
 
-            // TODO: Make this better - there are lots of reasons a split could fail
-            // Random so that we don't sync up with other failed splits
-            _dataWritten = mkDataWritten();
-
-            // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
-            warning() << "could not autosplit collection " << _manager->getns() << causedBy( e );
-            return false;
+            tryMoveToOtherShard(*_manager, chunkToMove);
         }
+
+        return true;
     }
 
     long Chunk::getPhysicalSize() const {
@@ -42,9 +42,12 @@
 
 namespace mongo {
 
+    class Chunk;
     class ChunkManager;
     struct WriteConcernOptions;
 
+    typedef boost::shared_ptr<const Chunk> ChunkPtr;
+
     /**
        config.chunks
        { ns : "alleyinsider.fs.chunks" , min : {} , max : {} , server : "localhost:30001" }
@@ -124,6 +127,14 @@ namespace mongo {
          */
         bool splitIfShould( long dataWritten ) const;
 
+        /**
+         * Batched version of splitIfShould for several chunks of the same collection, each with
+         * the amount of data just written to it. The split points of all the chunks which are due
+         * for a size check are looked up with a single splitVector request per shard, after which
+         * the chunks big enough to be split are split one by one.
+         */
+        static void splitIfShould( const std::vector<std::pair<ChunkPtr, long> >& chunksWritten );
+
         /**
          * Splits this chunk at a non-specificed split key to be chosen by the mongod holding this chunk.
          *
@@ -163,7 +174,24 @@ namespace mongo {
         void pickSplitVector(std::vector<BSONObj>& splitPoints,
                              long long chunkSize,
                              int maxPoints = 0,
-                             int maxObjs = 0) const;
+                             int maxObjs = 0,
+                             bool estimate = false) const;
+
+        /**
+         * Asks the shard holding all of 'chunks' for the auto-split points of each of them with a
+         * single splitVector request, using the shard's cheaper estimated index walk.
+         *
+         * @param splitPoints filled in with one vector of split points per chunk, in order
+         * @param errors filled in with one status per chunk, in order. A chunk whose split points
+         *        could not be found has no split points and a failed status.
+         * @return false if the shard can't answer batched requests, in which case the split points
+         *         have to be picked chunk by chunk
+         *
+         * @throws UserException
+         */
+        static bool pickSplitVectors(const std::vector<ChunkPtr>& chunks,
+                                     std::vector<std::vector<BSONObj> >* splitPoints,
+                                     std::vector<Status>* errors);
 
         //
         // migration support
@@ -277,12 +305,42 @@ namespace mongo {
          * @param atMedian perform a single split at the middle of this chunk.
          * @param splitPoints out parameter containing the chosen split points. Can be empty.
          */
-        void determineSplitPoints(bool atMedian, std::vector<BSONObj>* splitPoints) const;
+        void determineSplitPoints(bool atMedian,
+                                  bool estimate,
+                                  std::vector<BSONObj>* splitPoints) const;
+
+        /**
+         * Returns the chunk size to ask the shard to split this chunk at when auto-splitting.
+         */
+        long long getAutoSplitChunkSize() const;
+
+        /**
+         * Adds 'dataWritten' to the write estimate of this chunk and returns true if the estimate
+         * is now high enough that the actual size of the chunk should be checked.
+         */
+        bool shouldCheckSplit(long dataWritten) const;
+
+        /**
+         * Splits this chunk at 'splitPoints', after applying the heuristics for top chunks and
+         * checking the points don't fall on the chunk bounds.
+         */
+        Status splitAt(SplitPointMode mode,
+                       std::vector<BSONObj> splitPoints,
+                       size_t* resultingSplits,
+                       BSONObj* res) const;
+
+        /**
+         * Does the work of an auto-split once the split ticket has been acquired: splits this
+         * chunk, either at 'splitPoints' if they were already looked up or at the points the shard
+         * picks if it is NULL, and then tries to move the top chunk away if the shard suggests so.
+         *
+         * @return if something was split
+         * @throws DBException
+         */
+        bool autoSplit(const std::vector<BSONObj>* splitPoints) const;
 
         /** initializes _dataWritten with a random value so that a mongos restart wouldn't cause delay in splitting */
         static int mkDataWritten();
     };
 
-    typedef boost::shared_ptr<const Chunk> ChunkPtr;
-
 } // namespace mongo
@@ -32,6 +32,8 @@
 
 #include "mongo/s/chunk_manager_targeter.h"
 
+#include <algorithm>
+
 #include "mongo/s/chunk_manager.h"
 #include "mongo/s/config.h"
 #include "mongo/s/grid.h"
@@ -59,6 +61,9 @@ namespace {
 
     const ShardKeyPattern virtualIdShardKey(BSON("_id" << 1));
 
+    // How many chunks bulk targeting steps over before doing a lookup in the chunk map instead
+    const int kMaxChunkMergeSteps = 8;
+
     // To match legacy reload behavior, we have to backoff on config reload per-thread
     // TODO: Centralize this behavior better by refactoring config reload in mongos
     boost::thread_specific_ptr<Backoff> perThreadBackoff;
@@ -339,6 +344,122 @@ namespace {
         }
     }
 
+    void ChunkManagerTargeter::targetInserts( const vector<BSONObj>& docs,
+                                              TargetedInserts* targeted ) const {
+
+        if ( !_manager ) {
+            // Everything goes to the primary, nothing to share
+            NSTargeter::targetInserts( docs, targeted );
+            return;
+        }
+
+        const ShardKeyPattern& shardKeyPattern = _manager->getShardKeyPattern();
+        const size_t firstPos = targeted->endpoints.size();
+
+        targeted->endpoints.mutableVector().resize( firstPos + docs.size(), NULL );
+        targeted->statuses.resize( firstPos + docs.size(), Status::OK() );
+        targeted->chunkMins.resize( firstPos + docs.size() );
+
+        vector<BSONObj> shardKeys;
+        shardKeyPattern.extractShardKeysFromDocs( docs, &shardKeys );
+
+        // Same requirements as targetInsert, inserts must contain the exact shard key
+        vector<size_t> keyOrder;
+        keyOrder.reserve( docs.size() );
+        for ( size_t i = 0; i < docs.size(); ++i ) {
+
+            if ( shardKeys[i].isEmpty() ) {
+                targeted->statuses[firstPos + i] =
+                    Status( ErrorCodes::ShardKeyNotFound,
+                            stream() << "document " << docs[i]
+                                     << " does not contain shard key for pattern "
+                                     << shardKeyPattern.toString() );
+                continue;
+            }
+
+            Status status = ShardKeyPattern::checkShardKeySize( shardKeys[i] );
+            if ( !status.isOK() ) {
+                targeted->statuses[firstPos + i] = status;
+                continue;
+            }
+
+            keyOrder.push_back( i );
+        }
+
+        const ChunkMap& chunkMap = _manager->getChunkMap();
+        const BSONObjCmp keyLess;
+
+        std::sort( keyOrder.begin(),
+                   keyOrder.end(),
+                   [&]( size_t a, size_t b ) { return keyLess( shardKeys[a], shardKeys[b] ); } );
+
+        //
+        // The chunk map is ordered by chunk max, so walking the sorted shard keys alongside it
+        // finds each chunk without a lookup.  Runs of keys in the same chunk are common, but the
+        // keys may also be sparse over a large chunk map - after a few steps we seek instead.
+        //
+
+        ChunkMap::const_iterator chunkIt = chunkMap.end();
+        ChunkPtr chunk;
+        string shardName;
+        ChunkVersion shardVersion;
+
+        for ( vector<size_t>::const_iterator it = keyOrder.begin(); it != keyOrder.end(); ++it ) {
+
+            const BSONObj& shardKey = shardKeys[*it];
+
+            if ( !chunk || !chunk->containsKey( shardKey ) ) {
+
+                int steps = 0;
+                while ( chunkIt != chunkMap.end() && steps < kMaxChunkMergeSteps
+                        && !keyLess( shardKey, chunkIt->first ) ) {
+                    ++chunkIt;
+                    ++steps;
+                }
+
+                if ( chunkIt == chunkMap.end() || !keyLess( shardKey, chunkIt->first ) ) {
+                    chunkIt = chunkMap.upper_bound( shardKey );
+                }
+
+                if ( chunkIt != chunkMap.end() && chunkIt->second->containsKey( shardKey ) ) {
+                    chunk = chunkIt->second;
+                }
+                else {
+                    // Let the chunk manager report a broken chunk map
+                    chunk = _manager->findIntersectingChunk( shardKey );
+                }
+
+                if ( chunk->getShard().getName() != shardName ) {
+                    shardName = chunk->getShard().getName();
+                    shardVersion = _manager->getVersion( shardName );
+                }
+            }
+
+            targeted->endpoints.mutableVector()[firstPos + *it] =
+                new ShardEndpoint( shardName, shardVersion );
+            targeted->chunkMins[firstPos + *it] = chunk->getMin();
+        }
+
+        // Group in document order
+        for ( size_t i = 0; i < docs.size(); ++i ) {
+            const ShardEndpoint* endpoint = targeted->endpoints[firstPos + i];
+            if ( endpoint ) {
+                targeted->byShard[endpoint->shardName].push_back( firstPos + i );
+            }
+        }
+    }
+
+    void ChunkManagerTargeter::noteInsertSent( const TargetedInserts& targeted,
+                                               size_t pos,
+                                               int docSize ) const {
+
+        // Track autosplit stats for sharded collections
+        // Note: this is only best effort accounting and is not accurate.
+        if ( pos < targeted.chunkMins.size() && !targeted.chunkMins[pos].isEmpty() ) {
+            _stats.chunkSizeDelta[targeted.chunkMins[pos]] += docSize;
+        }
+    }
+
     Status ChunkManagerTargeter::targetUpdate( const BatchedUpdateDocument& updateDoc,
                                                vector<ShardEndpoint*>* endpoints ) const {
 
@@ -70,6 +70,13 @@ namespace mongo {
         // Returns ShardKeyNotFound if document does not have a full shard key.
         Status targetInsert( const BSONObj& doc, ShardEndpoint** endpoint ) const;
 
+        // Extracts all the shard keys up front and resolves their chunks in shard key order, so
+        // documents falling in the same chunk share a single chunk lookup.
+        void targetInserts( const std::vector<BSONObj>& docs, TargetedInserts* targeted ) const;
+
+        // Tracks autosplit stats for the chunk of the sent document.
+        void noteInsertSent( const TargetedInserts& targeted, size_t pos, int docSize ) const;
+
         // Returns ShardKeyNotFound if the update can't be targeted without a shard key.
         Status targetUpdate( const BatchedUpdateDocument& updateDoc,
                              std::vector<ShardEndpoint*>* endpoints ) const;
@@ -161,6 +168,8 @@ namespace mongo {
 
         // Map of shard->remote shard version reported from stale errors
         ShardVersionMap _remoteShardVersions;
+
+        friend class TestableChunkManagerTargeter;
     };
 
 } // namespace mongo
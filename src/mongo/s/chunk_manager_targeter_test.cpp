@@ -33,11 +33,64 @@
 #include "mongo/db/json.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/s/chunk.h"
 #include "mongo/s/chunk_manager.h"
+#include "mongo/s/chunk_manager_targeter.h"
 #include "mongo/s/shard_key_pattern.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
 
+namespace mongo {
+
+    /**
+     * Chunk manager with one chunk per shard, split at the given split points.
+     */
+    class TestableChunkManager : public ChunkManager {
+    public:
+
+        TestableChunkManager(const std::string& ns, const ShardKeyPattern& keyPattern)
+            : ChunkManager(ns, keyPattern, false) {
+        }
+
+        void setSingleChunkForShards(const std::vector<BSONObj>& splitPoints) {
+            ChunkMap& chunkMap = const_cast<ChunkMap&>(_chunkMap);
+            ChunkRangeManager& chunkRanges = const_cast<ChunkRangeManager&>(_chunkRanges);
+            std::set<Shard>& shards = const_cast<std::set<Shard>&>(_shards);
+
+            std::vector<BSONObj> mySplitPoints(splitPoints);
+            mySplitPoints.insert(mySplitPoints.begin(), _keyPattern.getKeyPattern().globalMin());
+            mySplitPoints.push_back(_keyPattern.getKeyPattern().globalMax());
+
+            for (size_t i = 1; i < mySplitPoints.size(); ++i) {
+                std::string name = str::stream() << (i - 1);
+                Shard shard(name,
+                            ConnectionString(HostAndPort(name)),
+                            0 /* maxSize */,
+                            false /* draining */);
+                shards.insert(shard);
+
+                ChunkPtr chunk(new Chunk(this, mySplitPoints[i - 1], mySplitPoints[i], shard));
+                chunkMap[mySplitPoints[i]] = chunk;
+            }
+
+            chunkRanges.reloadAll(chunkMap);
+        }
+    };
+
+    /**
+     * Chunk manager targeter over a given chunk manager, without loading any metadata.
+     */
+    class TestableChunkManagerTargeter : public ChunkManagerTargeter {
+    public:
+
+        TestableChunkManagerTargeter(const boost::shared_ptr<ChunkManager>& manager)
+            : ChunkManagerTargeter(NamespaceString(manager->getns())) {
+            _manager = manager;
+        }
+    };
+
+} // namespace mongo
+
 namespace {
 
     using namespace mongo;
@@ -532,4 +585,128 @@ namespace {
         CheckBoundList(list, expectedList);
     }
 
+    //
+    // Bulk insert targeting
+    //
+
+    // Shards "0", "1" and "2" own { a: [MinKey, 10) }, { a: [10, 20) } and { a: [20, MaxKey) }
+    boost::shared_ptr<ChunkManager> threeChunkManager() {
+        ShardKeyPattern shardKeyPattern(BSON("a" << 1));
+        boost::shared_ptr<TestableChunkManager> manager(
+            new TestableChunkManager("test.foo", shardKeyPattern));
+
+        std::vector<BSONObj> splitPoints;
+        splitPoints.push_back(BSON("a" << 10));
+        splitPoints.push_back(BSON("a" << 20));
+        manager->setSingleChunkForShards(splitPoints);
+        return manager;
+    }
+
+    std::vector<BSONObj> insertDocs() {
+        std::vector<BSONObj> docs;
+        docs.push_back(BSON("a" << 25));
+        docs.push_back(BSON("a" << 5));
+        docs.push_back(BSON("b" << 1));
+        docs.push_back(BSON("a" << 15));
+        docs.push_back(BSON("a" << 6));
+        return docs;
+    }
+
+    TEST(CMTargetInsertsTest, TargetsEachDocument) {
+        TestableChunkManagerTargeter targeter(threeChunkManager());
+        std::vector<BSONObj> docs = insertDocs();
+
+        TargetedInserts targeted;
+        targeter.targetInserts(docs, &targeted);
+
+        ASSERT_EQUALS(targeted.endpoints.size(), docs.size());
+        ASSERT_EQUALS(targeted.statuses.size(), docs.size());
+
+        // Same results as targeting the documents one by one
+        for (size_t i = 0; i < docs.size(); ++i) {
+            ShardEndpoint* endpointRaw = NULL;
+            Status status = targeter.targetInsert(docs[i], &endpointRaw);
+            auto_ptr<ShardEndpoint> endpoint(endpointRaw);
+
+            ASSERT_EQUALS(targeted.statuses[i].code(), status.code());
+            if (!status.isOK()) {
+                ASSERT(NULL == targeted.endpoints[i]);
+                continue;
+            }
+
+            ASSERT(NULL != targeted.endpoints[i]);
+            ASSERT_EQUALS(targeted.endpoints[i]->shardName, endpoint->shardName);
+        }
+
+        ASSERT_EQUALS(targeted.statuses[2].code(), ErrorCodes::ShardKeyNotFound);
+        ASSERT_EQUALS(targeted.endpoints[0]->shardName, "2");
+        ASSERT_EQUALS(targeted.endpoints[1]->shardName, "0");
+        ASSERT_EQUALS(targeted.endpoints[3]->shardName, "1");
+        ASSERT_EQUALS(targeted.endpoints[4]->shardName, "0");
+
+        // Grouped by shard in document order
+        ASSERT_EQUALS(targeted.byShard.size(), 3U);
+        ASSERT_EQUALS(targeted.byShard["0"].size(), 2U);
+        ASSERT_EQUALS(targeted.byShard["0"][0], 1U);
+        ASSERT_EQUALS(targeted.byShard["0"][1], 4U);
+        ASSERT_EQUALS(targeted.byShard["1"].size(), 1U);
+        ASSERT_EQUALS(targeted.byShard["1"][0], 3U);
+        ASSERT_EQUALS(targeted.byShard["2"].size(), 1U);
+        ASSERT_EQUALS(targeted.byShard["2"][0], 0U);
+    }
+
+    TEST(CMTargetInsertsTest, AppendsToPreviousResults) {
+        TestableChunkManagerTargeter targeter(threeChunkManager());
+        std::vector<BSONObj> docs = insertDocs();
+
+        TargetedInserts targeted;
+        targeter.targetInserts(docs, &targeted);
+        targeter.targetInserts(docs, &targeted);
+
+        ASSERT_EQUALS(targeted.endpoints.size(), 2 * docs.size());
+        ASSERT_EQUALS(targeted.statuses.size(), 2 * docs.size());
+
+        for (size_t i = 0; i < docs.size(); ++i) {
+            const size_t j = docs.size() + i;
+            ASSERT_EQUALS(targeted.statuses[i].code(), targeted.statuses[j].code());
+            if (targeted.endpoints[i]) {
+                ASSERT_EQUALS(targeted.endpoints[i]->shardName,
+                              targeted.endpoints[j]->shardName);
+            }
+            else {
+                ASSERT(NULL == targeted.endpoints[j]);
+            }
+        }
+
+        ASSERT_EQUALS(targeted.byShard["0"].size(), 4U);
+        ASSERT_EQUALS(targeted.byShard["0"][2], docs.size() + 1);
+        ASSERT_EQUALS(targeted.byShard["0"][3], docs.size() + 4);
+    }
+
+    TEST(CMTargetInsertsTest, ChunkSizeDeltaOnlyForSentInserts) {
+        TestableChunkManagerTargeter targeter(threeChunkManager());
+        std::vector<BSONObj> docs = insertDocs();
+
+        TargetedInserts targeted;
+        targeter.targetInserts(docs, &targeted);
+
+        // Targeting alone writes nothing
+        ASSERT(targeter.getStats()->chunkSizeDelta.empty());
+
+        targeter.noteInsertSent(targeted, 1, docs[1].objsize());
+        targeter.noteInsertSent(targeted, 4, docs[4].objsize());
+        targeter.noteInsertSent(targeted, 3, docs[3].objsize());
+
+        const std::map<BSONObj, int>& chunkSizeDelta = targeter.getStats()->chunkSizeDelta;
+        ASSERT_EQUALS(chunkSizeDelta.size(), 2U);
+
+        std::map<BSONObj, int>::const_iterator it = chunkSizeDelta.find(BSON("a" << MINKEY));
+        ASSERT(it != chunkSizeDelta.end());
+        ASSERT_EQUALS(it->second, docs[1].objsize() + docs[4].objsize());
+
+        it = chunkSizeDelta.find(BSON("a" << 10));
+        ASSERT(it != chunkSizeDelta.end());
+        ASSERT_EQUALS(it->second, docs[3].objsize());
+    }
+
 } // namespace
@@ -135,6 +135,10 @@ namespace mongo {
                 return;
             }
 
+            // Check all the chunks written by this batch together, so that the split points of
+            // the chunks living on the same shard are looked up with a single round trip.
+            vector<std::pair<ChunkPtr, long> > chunksWritten;
+            chunksWritten.reserve(stats.chunkSizeDelta.size());
             for (map<BSONObj, int>::const_iterator it = stats.chunkSizeDelta.begin();
                  it != stats.chunkSizeDelta.end();
                  ++it) {
@@ -149,8 +153,10 @@ namespace mongo {
                     return;
                 }
 
-                chunk->splitIfShould(it->second);
+                chunksWritten.push_back(std::make_pair(chunk, static_cast<long>(it->second)));
             }
+
+            Chunk::splitIfShould(chunksWritten);
         }
 
     } // namespace
@@ -33,6 +33,7 @@
 #include "mongo/s/collection_metadata.h"
 
 #include "mongo/bson/util/builder.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -46,6 +47,23 @@ namespace mongo {
 
     using mongoutils::str::stream;
 
+    namespace {
+
+        // Shard key ranges are ordered by plain BSONObj comparison, so the flat range index
+        // encodes every key as if all its fields were ascending.
+        const Ordering kAllAscending = Ordering::make(BSONObj());
+
+        int compareKeyStrings( const char* lhs, size_t lhsSize, const char* rhs, size_t rhsSize ) {
+            int cmp = memcmp( lhs, rhs, std::min( lhsSize, rhsSize ) );
+            if ( cmp )
+                return cmp;
+            if ( lhsSize == rhsSize )
+                return 0;
+            return lhsSize < rhsSize ? -1 : 1;
+        }
+
+    } // namespace
+
     CollectionMetadata::CollectionMetadata() { }
 
     CollectionMetadata::~CollectionMetadata() { }
@@ -209,6 +227,8 @@ namespace mongo {
         metadata->_pendingMap.erase( pending.getMin() );
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_flatRanges = this->_flatRanges;
+        metadata->_flatRangeKeys = this->_flatRangeKeys;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -244,6 +264,8 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_flatRanges = this->_flatRanges;
+        metadata->_flatRangeKeys = this->_flatRangeKeys;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -434,6 +456,8 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_flatRanges = this->_flatRanges;
+        metadata->_flatRangeKeys = this->_flatRangeKeys;
         metadata->_shardVersion = newShardVersion;
         metadata->_collVersion =
                 newShardVersion > _collVersion ? newShardVersion : this->_collVersion;
@@ -455,29 +479,73 @@ namespace mongo {
             return true;
         }
 
-        if ( _rangesMap.size() <= 0 ) {
+        if ( _flatRanges.empty() ) {
             return false;
         }
 
-        RangeMap::const_iterator it = _rangesMap.upper_bound( key );
-        if ( it != _rangesMap.begin() ) it--;
+        dassert( _flatRanges.size() == _rangesMap.size() );
 
-        bool good = rangeContains( it->first, it->second, key );
+        const KeyString encodedKey( key, kAllAscending );
+        const int rangeIndex = findFlatRange( encodedKey.getBuffer(), encodedKey.getSize() );
+        if ( rangeIndex < 0 ) {
+            return false;
+        }
 
-#if 0
-        // DISABLED because of SERVER-11175 - huge amount of logging
-        // Logs if the point doesn't belong here.
-        if ( !good ) {
-            log() << "bad: " << key << " " << it->first << " " << key.woCompare( it->first ) << " "
-                  << key.woCompare( it->second ) << endl;
+        const FlatRange& range = _flatRanges[rangeIndex];
+        return compareKeyStrings( encodedKey.getBuffer(),
+                                  encodedKey.getSize(),
+                                  _flatRangeKeys.data() + range.maxOffset,
+                                  range.maxSize ) < 0;
+    }
+
+    bool CollectionMetadata::rangeBelongsToMe( const BSONObj& minKey,
+                                               const BSONObj& maxKey,
+                                               bool maxKeyInclusive ) const {
+        if ( _keyPattern.isEmpty() ) {
+            return true;
+        }
+
+        if ( _flatRanges.empty() ) {
+            return false;
+        }
 
-            for ( RangeMap::const_iterator i = _rangesMap.begin(); i != _rangesMap.end(); ++i ) {
-                log() << "\t" << i->first << "\t" << i->second << "\t" << endl;
+        const KeyString encodedMin( minKey, kAllAscending );
+        const int rangeIndex = findFlatRange( encodedMin.getBuffer(), encodedMin.getSize() );
+        if ( rangeIndex < 0 ) {
+            return false;
+        }
+
+        // The ranges are coalesced, so if the max key is also before the end of the range which
+        // contains the min key, there can be no hole in between.
+        const FlatRange& range = _flatRanges[rangeIndex];
+        const KeyString encodedMax( maxKey, kAllAscending );
+        const int cmp = compareKeyStrings( encodedMax.getBuffer(),
+                                           encodedMax.getSize(),
+                                           _flatRangeKeys.data() + range.maxOffset,
+                                           range.maxSize );
+        return cmp < 0 || ( cmp == 0 && !maxKeyInclusive );
+    }
+
+    int CollectionMetadata::findFlatRange( const char* key, size_t keySize ) const {
+        // Binary search for the first range whose min key is greater than 'key'; the range
+        // before it is the only one which could contain 'key'.
+        size_t low = 0;
+        size_t high = _flatRanges.size();
+        while ( low < high ) {
+            const size_t mid = low + ( high - low ) / 2;
+            const FlatRange& range = _flatRanges[mid];
+            if ( compareKeyStrings( _flatRangeKeys.data() + range.minOffset,
+                                    range.minSize,
+                                    key,
+                                    keySize ) <= 0 ) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
             }
         }
-#endif
 
-        return good;
+        return static_cast<int>( low ) - 1;
     }
 
     bool CollectionMetadata::keyIsPending( const BSONObj& key ) const {
@@ -741,6 +809,31 @@ namespace mongo {
         dassert(!min.isEmpty());
 
         _rangesMap.insert(make_pair(min, max));
+
+        fillFlatRanges();
+    }
+
+    void CollectionMetadata::fillFlatRanges() {
+        _flatRanges.clear();
+        _flatRangeKeys.clear();
+        _flatRanges.reserve(_rangesMap.size());
+
+        KeyString encoded;
+        for (RangeMap::const_iterator it = _rangesMap.begin(); it != _rangesMap.end(); ++it) {
+            FlatRange range;
+
+            encoded.resetToKey(it->first, kAllAscending);
+            range.minOffset = _flatRangeKeys.size();
+            range.minSize = encoded.getSize();
+            _flatRangeKeys.append(encoded.getBuffer(), encoded.getSize());
+
+            encoded.resetToKey(it->second, kAllAscending);
+            range.maxOffset = _flatRangeKeys.size();
+            range.maxSize = encoded.getSize();
+            _flatRangeKeys.append(encoded.getBuffer(), encoded.getSize());
+
+            _flatRanges.push_back(range);
+        }
     }
 
     void CollectionMetadata::fillKeyPatternFields() {
@@ -147,6 +147,18 @@ namespace mongo {
          */
         bool keyBelongsToMe( const BSONObj& key ) const;
 
+        /**
+         * Returns true if every shard key between 'minKey' and 'maxKey' belongs to this chunkset,
+         * i.e. the whole range falls inside a single contiguous run of chunks owned by this
+         * shard. 'maxKey' is included in the range iff 'maxKeyInclusive' is true. Both bounds
+         * must be full shard keys.
+         *
+         * Used by the query path to skip per-document ownership checks.
+         */
+        bool rangeBelongsToMe( const BSONObj& minKey,
+                               const BSONObj& maxKey,
+                               bool maxKeyInclusive ) const;
+
         /**
          * Returns true if the document key 'key' is or has been migrated to this shard, and may
          * belong to us after a subsequent config reload.  Key must be the full shard key.
@@ -300,6 +312,25 @@ namespace mongo {
         // installations.
         RangeMap _rangesMap;
 
+        //
+        // Flat copy of _rangesMap used by the ownership checks on the query path. The bounds
+        // of each range are stored as KeyStrings encoded with an all-ascending ordering and
+        // concatenated in _flatRangeKeys, so a lookup is a binary search over memcmp()
+        // comparisons rather than over BSONObj::woCompare.
+        //
+
+        struct FlatRange {
+            uint32_t minOffset;
+            uint32_t minSize;
+            uint32_t maxOffset;
+            uint32_t maxSize;
+        };
+
+        // Sorted by min key, and non-overlapping since _rangesMap is.
+        std::vector<FlatRange> _flatRanges;
+
+        std::string _flatRangeKeys;
+
         /**
          * Returns true if this metadata was loaded with all necessary information.
          */
@@ -310,6 +341,17 @@ namespace mongo {
          */
         void fillRanges();
 
+        /**
+         * Rebuilds _flatRanges and _flatRangeKeys from the current contents of _rangesMap
+         */
+        void fillFlatRanges();
+
+        /**
+         * Returns the index in _flatRanges of the last range whose min key is less than or
+         * equal to 'key', or -1 if 'key' sorts before all the ranges.
+         */
+        int findFlatRange( const char* key, size_t keySize ) const;
+
         /**
          * Creates the _keyField* local data
          */
@@ -533,6 +533,34 @@ namespace {
         ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << MAXKEY)) );
     }
 
+    TEST_F(SingleChunkFixture, BelongsToMeAfterSplit) {
+        ChunkType chunk;
+        chunk.setMin( BSON("a" << 10) );
+        chunk.setMax( BSON("a" << 20) );
+
+        vector<BSONObj> splitPoints;
+        splitPoints.push_back( BSON("a" << 14) );
+
+        ChunkVersion version;
+        getCollMetadata().getCollVersion().cloneTo( &version );
+        version.incMinor();
+
+        string errMsg;
+        scoped_ptr<CollectionMetadata> cloned( getCollMetadata().cloneSplit( chunk,
+                                                                             splitPoints,
+                                                                             version,
+                                                                             &errMsg ) );
+        ASSERT_EQUALS( errMsg, "" );
+        ASSERT( cloned != NULL );
+
+        // The split chunks are still one contiguous owned range
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 10)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 14)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 19)) );
+        ASSERT_FALSE( cloned->keyBelongsToMe(BSON("a" << 20)) );
+        ASSERT( cloned->rangeBelongsToMe(BSON("a" << 12), BSON("a" << 16), true) );
+    }
+
     TEST_F(SingleChunkFixture, CompoudKeyBelongsToMe) {
         ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 15 << "a" << 14)) );
     }
@@ -1253,6 +1281,29 @@ namespace {
         ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << MAXKEY)) );
     }
 
+    TEST_F(ThreeChunkWithRangeGapFixture, ShardOwnsRange) {
+        // [MinKey, 10) and [10, 20) coalesce into one owned range
+        ASSERT( getCollMetadata().rangeBelongsToMe(BSON("a" << MINKEY), BSON("a" << 5), true) );
+        ASSERT( getCollMetadata().rangeBelongsToMe(BSON("a" << 5), BSON("a" << 15), true) );
+        ASSERT( getCollMetadata().rangeBelongsToMe(BSON("a" << 10), BSON("a" << 20), false) );
+        ASSERT( getCollMetadata().rangeBelongsToMe(BSON("a" << 30), BSON("a" << 1000), true) );
+    }
+
+    TEST_F(ThreeChunkWithRangeGapFixture, ShardDoesntOwnRange) {
+        ASSERT_FALSE( getCollMetadata().rangeBelongsToMe(BSON("a" << 10),
+                                                         BSON("a" << 20),
+                                                         true) );
+        ASSERT_FALSE( getCollMetadata().rangeBelongsToMe(BSON("a" << 15),
+                                                         BSON("a" << 35),
+                                                         true) );
+        ASSERT_FALSE( getCollMetadata().rangeBelongsToMe(BSON("a" << 20),
+                                                         BSON("a" << 25),
+                                                         true) );
+        ASSERT_FALSE( getCollMetadata().rangeBelongsToMe(BSON("a" << 30),
+                                                         BSON("a" << MAXKEY),
+                                                         true) );
+    }
+
     TEST_F(ThreeChunkWithRangeGapFixture, GetNextFromEmpty) {
         ChunkType nextChunk;
         ASSERT( getCollMetadata().getNextChunk( getCollMetadata().getMinKey(), &nextChunk ) );
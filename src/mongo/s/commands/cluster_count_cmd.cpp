@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "mongo/db/commands.h"
+#include "mongo/db/query/query_estimate_common.h"
 #include "mongo/s/cluster_explain.h"
 #include "mongo/s/commands/cluster_commands_common.h"
 #include "mongo/s/strategy.h"
@@ -148,6 +149,15 @@ namespace {
                 countCmdBuilder.append(cmdObj["hint"]);
             }
 
+            // Each shard estimates its own count, and the estimates are summed below.
+            const bool estimate = cmdObj["estimate"].trueValue();
+            if (estimate) {
+                countCmdBuilder.append("estimate", true);
+                if (cmdObj.hasField("sampleSize")) {
+                    countCmdBuilder.append(cmdObj["sampleSize"]);
+                }
+            }
+
             if (cmdObj.hasField("$queryOptions")) {
                 countCmdBuilder.append(cmdObj["$queryOptions"]);
             }
@@ -165,6 +175,7 @@ namespace {
                                 &countResult);
 
             long long total = 0;
+            QueryEstimate totalEstimate;
             BSONObjBuilder shardSubTotal(result.subobjStart("shards"));
 
             for (vector<Strategy::CommandResult>::const_iterator iter = countResult.begin();
@@ -176,6 +187,17 @@ namespace {
                 if (iter->result["ok"].trueValue()) {
                     long long shardCount = iter->result["n"].numberLong();
 
+                    if (estimate) {
+                        QueryEstimate shardEstimate;
+                        Status status = QueryEstimate::parseFromResponse(iter->result,
+                                                                         &shardEstimate);
+                        if (!status.isOK()) {
+                            shardSubTotal.doneFast();
+                            return appendCommandStatus(result, status);
+                        }
+                        totalEstimate.addCount(shardEstimate);
+                    }
+
                     shardSubTotal.appendNumber(shardName, shardCount);
                     total += shardCount;
                 }
@@ -197,6 +219,13 @@ namespace {
 
             shardSubTotal.doneFast();
             total = applySkipLimit(total, cmdObj);
+
+            if (estimate) {
+                totalEstimate.n = total;
+                totalEstimate.appendToBuilder(&result);
+                return true;
+            }
+
             result.appendNumber("n", total);
 
             return true;
@@ -48,7 +48,9 @@
 #include "mongo/db/commands/find_and_modify.h"
 #include "mongo/db/commands/rename_collection.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/query/hyperloglog.h"
 #include "mongo/db/query/lite_parsed_query.h"
+#include "mongo/db/query/query_estimate_common.h"
 #include "mongo/s/catalog/catalog_cache.h"
 #include "mongo/s/catalog/catalog_manager.h"
 #include "mongo/s/chunk_manager.h"
@@ -1155,7 +1157,9 @@ namespace mongo {
         public:
             DistinctCmd() : PublicGridCommand("distinct") {}
             virtual void help( stringstream &help ) const {
-                help << "{ distinct : 'collection name' , key : 'a.b' , query : {} }";
+                help << "{ distinct : 'collection name' , key : 'a.b' , query : {} }\n"
+                     << "with estimate : true, returns the approximate number of distinct values "
+                     << "instead of the values, examining at most maxScan results per shard";
             }
             virtual bool passOptions() const { return true; }
             virtual void addRequiredPrivileges(const std::string& dbname,
@@ -1191,6 +1195,10 @@ namespace mongo {
                 set<Shard> shards;
                 cm->getShardsForQuery(shards, query);
 
+                if (cmdObj["estimate"].trueValue()) {
+                    return runEstimate(conf, fullns, cmdObj, options, shards, errmsg, result);
+                }
+
                 set<BSONObj,BSONObjCmp> all;
                 int size = 32;
 
@@ -1224,6 +1232,84 @@ namespace mongo {
                 result.appendArray( "values" , b.obj() );
                 return true;
             }
+
+        private:
+            /**
+             * Estimates the number of distinct values across 'shards' by merging the HyperLogLog
+             * sketches that each shard builds over its own documents. Unlike a sum of the
+             * shards' estimates, this counts a value held by several shards once.
+             */
+            bool runEstimate(const shared_ptr<DBConfig>& conf,
+                             const string& fullns,
+                             const BSONObj& cmdObj,
+                             int options,
+                             const set<Shard>& shards,
+                             string& errmsg,
+                             BSONObjBuilder& result) {
+                BSONObjBuilder shardCmdBob;
+                shardCmdBob.appendElements(cmdObj);
+                shardCmdBob.append("includeSketch", true);
+                const BSONObj shardCmd = shardCmdBob.obj();
+
+                scoped_ptr<HyperLogLog> merged;
+                long long examined = 0;
+                bool complete = true;
+
+                for (set<Shard>::const_iterator i = shards.begin(); i != shards.end(); ++i) {
+                    ShardConnection conn(i->getConnString(), fullns);
+                    BSONObj res;
+                    bool ok = conn->runCommand(conf->name(), shardCmd, res, options);
+                    conn.done();
+
+                    if (!ok) {
+                        result.appendElements(res);
+                        return false;
+                    }
+
+                    QueryEstimate shardEstimate;
+                    Status status = QueryEstimate::parseFromResponse(res, &shardEstimate);
+                    if (!status.isOK()) {
+                        return appendCommandStatus(result, status);
+                    }
+
+                    examined += shardEstimate.examined;
+                    complete = complete && shardEstimate.complete;
+
+                    // A shard without the collection answers an exact 0, with no sketch.
+                    if (shardEstimate.sketch.empty()) {
+                        if (0 != shardEstimate.n) {
+                            errmsg = str::stream() << "shard " << i->getName()
+                                                   << " did not return a distinct estimate sketch";
+                            return false;
+                        }
+                        continue;
+                    }
+
+                    HyperLogLog shardSketch(HyperLogLog::kMinPrecision);
+                    status = HyperLogLog::fromRegisters(shardEstimate.sketch, &shardSketch);
+                    if (!status.isOK()) {
+                        return appendCommandStatus(result, status);
+                    }
+
+                    if (!merged) {
+                        merged.reset(new HyperLogLog(shardSketch));
+                    }
+                    else {
+                        status = merged->merge(shardSketch);
+                        if (!status.isOK()) {
+                            return appendCommandStatus(result, status);
+                        }
+                    }
+                }
+
+                if (!merged) {
+                    QueryEstimate::exact(0).appendToBuilder(&result);
+                    return true;
+                }
+
+                QueryEstimate::fromSketch(*merged, examined, complete).appendToBuilder(&result);
+                return true;
+            }
         } disinctCmd;
 
         class FileMD5Cmd : public PublicGridCommand {
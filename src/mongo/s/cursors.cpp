@@ -231,30 +231,42 @@ namespace mongo {
         return sr->nextInt64();
     }
 
-    CursorCache::CursorCache()
-        : _random( getCCRandomSeed() ),
-          _shardedTotal(0) {
+    CursorCache::Partition::Partition()
+        : random( getCCRandomSeed() ),
+          shardedTotal(0) {
+    }
+
+    CursorCache::CursorCache() {
     }
 
     CursorCache::~CursorCache() {
         // TODO: delete old cursors?
+        size_t numSharded = 0;
+        size_t numRefs = 0;
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            const Partition& partition = _partitions[p];
+            verify(partition.refs.size() == partition.refsNS.size());
+            numSharded += partition.cursors.size();
+            numRefs += partition.refs.size();
+        }
+
         bool print = shouldLog(logger::LogSeverity::Debug(1));
-        if ( _cursors.size() || _refs.size() )
+        if ( numSharded || numRefs )
             print = true;
-        verify(_refs.size() == _refsNS.size());
         
         if ( print ) 
             log() << " CursorCache at shutdown - "
-                  << " sharded: " << _cursors.size()
-                  << " passthrough: " << _refs.size()
+                  << " sharded: " << numSharded
+                  << " passthrough: " << numRefs
                   << endl;
     }
 
     ShardedClientCursorPtr CursorCache::get( long long id ) const {
         LOG(_myLogLevel) << "CursorCache::get id: " << id << endl;
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        MapSharded::const_iterator i = _cursors.find( id );
-        if ( i == _cursors.end() ) {
+        const Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+        MapSharded::const_iterator i = partition.cursors.find( id );
+        if ( i == partition.cursors.end() ) {
             return ShardedClientCursorPtr();
         }
         i->second->accessed();
@@ -263,9 +275,47 @@ namespace mongo {
 
     int CursorCache::getMaxTimeMS( long long id ) const {
         verify( id );
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        MapShardedInt::const_iterator i = _cursorsMaxTimeMS.find( id );
-        return ( i != _cursorsMaxTimeMS.end() ) ? i->second : 0;
+        const Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+        MapShardedInt::const_iterator i = partition.cursorsMaxTimeMS.find( id );
+        return ( i != partition.cursorsMaxTimeMS.end() ) ? i->second : 0;
+    }
+
+    void CursorCache::lookup( long long id,
+                              ShardedClientCursorPtr* cursor,
+                              int* maxTimeMS,
+                              std::string* ref ) const {
+        verify( id );
+        LOG(_myLogLevel) << "CursorCache::lookup id: " << id << endl;
+
+        const Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+
+        if ( cursor ) {
+            MapSharded::const_iterator i = partition.cursors.find( id );
+            if ( i == partition.cursors.end() ) {
+                cursor->reset();
+            }
+            else {
+                i->second->accessed();
+                *cursor = i->second;
+            }
+        }
+
+        if ( maxTimeMS ) {
+            MapShardedInt::const_iterator i = partition.cursorsMaxTimeMS.find( id );
+            *maxTimeMS = ( i != partition.cursorsMaxTimeMS.end() ) ? i->second : 0;
+        }
+
+        if ( ref ) {
+            MapNormal::const_iterator i = partition.refs.find( id );
+            if ( i == partition.refs.end() ) {
+                ref->clear();
+            }
+            else {
+                *ref = i->second;
+            }
+        }
     }
 
     void CursorCache::store( ShardedClientCursorPtr cursor, int maxTimeMS ) {
@@ -277,10 +327,11 @@ namespace mongo {
         verify( maxTimeMS == kMaxTimeCursorTimeLimitExpired
                 || maxTimeMS == kMaxTimeCursorNoTimeLimit
                 || maxTimeMS > 0 );
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        _cursorsMaxTimeMS[cursor->getId()] = maxTimeMS;
-        _cursors[cursor->getId()] = cursor;
-        _shardedTotal++;
+        Partition& partition = _getPartition( cursor->getId() );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+        partition.cursorsMaxTimeMS[cursor->getId()] = maxTimeMS;
+        partition.cursors[cursor->getId()] = cursor;
+        partition.shardedTotal++;
     }
 
     void CursorCache::updateMaxTimeMS( long long id, int maxTimeMS ) {
@@ -288,79 +339,105 @@ namespace mongo {
         verify( maxTimeMS == kMaxTimeCursorTimeLimitExpired
                 || maxTimeMS == kMaxTimeCursorNoTimeLimit
                 || maxTimeMS > 0 );
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        _cursorsMaxTimeMS[id] = maxTimeMS;
+        Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+        partition.cursorsMaxTimeMS[id] = maxTimeMS;
     }
 
     void CursorCache::remove( long long id ) {
         verify( id );
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        _cursorsMaxTimeMS.erase( id );
-        _cursors.erase( id );
+        Partition& partition = _getPartition( id );
+
+        // Destroying the cursor may talk to the shards, so only release our reference to it
+        // after the partition lock has been dropped.
+        ShardedClientCursorPtr removed;
+        {
+            boost::lock_guard<boost::mutex> lk( partition.mutex );
+            partition.cursorsMaxTimeMS.erase( id );
+            MapSharded::iterator i = partition.cursors.find( id );
+            if ( i == partition.cursors.end() ) {
+                return;
+            }
+            removed.swap( i->second );
+            partition.cursors.erase( i );
+        }
     }
     
     void CursorCache::removeRef( long long id ) {
         verify( id );
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        _refs.erase( id );
-        _refsNS.erase( id );
+        Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+        partition.refs.erase( id );
+        partition.refsNS.erase( id );
         cursorStatsSingleTarget.decrement();
     }
 
     void CursorCache::storeRef(const std::string& server, long long id, const std::string& ns) {
         LOG(_myLogLevel) << "CursorCache::storeRef server: " << server << " id: " << id << endl;
         verify( id );
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        _refs[id] = server;
-        _refsNS[id] = ns;
+        Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+        partition.refs[id] = server;
+        partition.refsNS[id] = ns;
         cursorStatsSingleTarget.increment();
     }
 
     string CursorCache::getRef( long long id ) const {
         verify( id );
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        MapNormal::const_iterator i = _refs.find( id );
+        const Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk( partition.mutex );
+        MapNormal::const_iterator i = partition.refs.find( id );
 
-        LOG(_myLogLevel) << "CursorCache::getRef id: " << id << " out: " << ( i == _refs.end() ? " NONE " : i->second ) << endl;
+        LOG(_myLogLevel) << "CursorCache::getRef id: " << id << " out: " << ( i == partition.refs.end() ? " NONE " : i->second ) << endl;
 
-        if ( i == _refs.end() )
+        if ( i == partition.refs.end() )
             return "";
         return i->second;
     }
 
     std::string CursorCache::getRefNS(long long id) const {
         verify(id);
-        boost::lock_guard<boost::mutex> lk(_mutex);
-        MapNormal::const_iterator i = _refsNS.find(id);
+        const Partition& partition = _getPartition( id );
+        boost::lock_guard<boost::mutex> lk(partition.mutex);
+        MapNormal::const_iterator i = partition.refsNS.find(id);
 
         LOG(_myLogLevel) << "CursorCache::getRefNs id: " << id
-                << " out: " << ( i == _refsNS.end() ? " NONE " : i->second ) << std::endl;
+                << " out: " << ( i == partition.refsNS.end() ? " NONE " : i->second ) << std::endl;
 
-        if ( i == _refsNS.end() )
+        if ( i == partition.refsNS.end() )
             return "";
         return i->second;
     }
 
 
     long long CursorCache::genId() {
+        // Pick the partition first and generate an id which maps onto it, so that the uniqueness
+        // check below only needs that partition's lock.
+        const size_t partitionIndex = _nextPartition.fetchAndAdd(1) & ( kNumPartitions - 1 );
+        Partition& partition = _partitions[partitionIndex];
+
         while ( true ) {
-            boost::lock_guard<boost::mutex> lk( _mutex );
+            boost::lock_guard<boost::mutex> lk( partition.mutex );
 
             long long x = Listener::getElapsedTimeMillis() << 32;
-            x |= _random.nextInt32();
+            x |= partition.random.nextInt32();
+
+            if ( x < 0 )
+                x *= -1;
+
+            x = ( x & ~static_cast<long long>( kNumPartitions - 1 ) ) | partitionIndex;
 
             if ( x == 0 )
                 continue;
 
-            if ( x < 0 )
-                x *= -1;
+            dassert( _partitionIndex( x ) == partitionIndex );
 
-            MapSharded::iterator i = _cursors.find( x );
-            if ( i != _cursors.end() )
+            MapSharded::iterator i = partition.cursors.find( x );
+            if ( i != partition.cursors.end() )
                 continue;
 
-            MapNormal::iterator j = _refs.find( x );
-            if ( j != _refs.end() )
+            MapNormal::iterator j = partition.refs.find( x );
+            if ( j != partition.refs.end() )
                 continue;
 
             return x;
@@ -395,12 +472,14 @@ namespace mongo {
                 continue;
             }
 
+            Partition& partition = _getPartition( id );
+            ShardedClientCursorPtr killed;
             string server;
             {
-                boost::lock_guard<boost::mutex> lk( _mutex );
+                boost::lock_guard<boost::mutex> lk( partition.mutex );
 
-                MapSharded::iterator i = _cursors.find( id );
-                if ( i != _cursors.end() ) {
+                MapSharded::iterator i = partition.cursors.find( id );
+                if ( i != partition.cursors.end() ) {
                     Status authorizationStatus = authSession->checkAuthForKillCursors(
                             NamespaceString(i->second->getNS()), id);
                     audit::logKillCursorsAuthzCheck(
@@ -409,19 +488,20 @@ namespace mongo {
                             id,
                             authorizationStatus.isOK() ? ErrorCodes::OK : ErrorCodes::Unauthorized);
                     if (authorizationStatus.isOK()) {
-                        _cursorsMaxTimeMS.erase( i->second->getId() );
-                        _cursors.erase( i );
+                        partition.cursorsMaxTimeMS.erase( i->second->getId() );
+                        killed.swap( i->second );
+                        partition.cursors.erase( i );
                     }
                     continue;
                 }
 
-                MapNormal::iterator refsIt = _refs.find(id);
-                MapNormal::iterator refsNSIt = _refsNS.find(id);
-                if (refsIt == _refs.end()) {
+                MapNormal::iterator refsIt = partition.refs.find(id);
+                MapNormal::iterator refsNSIt = partition.refsNS.find(id);
+                if (refsIt == partition.refs.end()) {
                     warning() << "can't find cursor: " << id << endl;
                     continue;
                 }
-                verify(refsNSIt != _refsNS.end());
+                verify(refsNSIt != partition.refsNS.end());
                 Status authorizationStatus = authSession->checkAuthForKillCursors(
                         NamespaceString(refsNSIt->second), id);
                 audit::logKillCursorsAuthzCheck(
@@ -433,8 +513,8 @@ namespace mongo {
                     continue;
                 }
                 server = refsIt->second;
-                _refs.erase(refsIt);
-                _refsNS.erase(refsNSIt);
+                partition.refs.erase(refsIt);
+                partition.refsNS.erase(refsNSIt);
                 cursorStatsSingleTarget.decrement();
             }
 
@@ -448,28 +528,44 @@ namespace mongo {
     }
 
     void CursorCache::appendInfo( BSONObjBuilder& result ) const {
-        boost::lock_guard<boost::mutex> lk( _mutex );
+        long long shardedTotal = 0;
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            const Partition& partition = _partitions[p];
+            boost::lock_guard<boost::mutex> lk( partition.mutex );
+            shardedTotal += partition.shardedTotal;
+        }
+
         result.append( "sharded", static_cast<int>(cursorStatsMultiTarget.get()));
-        result.appendNumber( "shardedEver" , _shardedTotal );
+        result.appendNumber( "shardedEver" , shardedTotal );
         result.append( "refs", static_cast<int>(cursorStatsSingleTarget.get()));
         result.append( "totalOpen", static_cast<int>(cursorStatsTotalOpen.get()));
     }
 
     void CursorCache::doTimeouts() {
-        long long now = Listener::getElapsedTimeMillis();
-        boost::lock_guard<boost::mutex> lk( _mutex );
-        for ( MapSharded::iterator i=_cursors.begin(); i!=_cursors.end(); ++i ) {
-            // Note: cursors with no timeout will always have an idleTime of 0
-            long long idleFor = i->second->idleTime( now );
-            if ( idleFor < TIMEOUT ) {
-                continue;
+        for ( size_t p = 0; p < kNumPartitions; p++ ) {
+            Partition& partition = _partitions[p];
+            std::vector<ShardedClientCursorPtr> expired;
+
+            {
+                long long now = Listener::getElapsedTimeMillis();
+                boost::lock_guard<boost::mutex> lk( partition.mutex );
+                MapSharded::iterator i = partition.cursors.begin();
+                while ( i != partition.cursors.end() ) {
+                    // Note: cursors with no timeout will always have an idleTime of 0
+                    long long idleFor = i->second->idleTime( now );
+                    if ( idleFor < TIMEOUT ) {
+                        ++i;
+                        continue;
+                    }
+                    log() << "killing old cursor " << i->second->getId() << " idle for: " << idleFor << "ms" << endl; // TODO: make LOG(1)
+                    partition.cursorsMaxTimeMS.erase( i->first );
+                    expired.push_back( i->second );
+                    partition.cursors.erase( i++ );
+                }
             }
-            log() << "killing old cursor " << i->second->getId() << " idle for: " << idleFor << "ms" << endl; // TODO: make LOG(1)
-            _cursorsMaxTimeMS.erase( i->second->getId() );
-            _cursors.erase( i );
-            i = _cursors.begin(); // possible 2nd entry will get skipped, will get on next pass
-            if ( i == _cursors.end() )
-                break;
+
+            // 'expired' holds the last references to the timed out cursors, which are destroyed
+            // here without holding the partition lock.
         }
     }
 
@@ -35,6 +35,7 @@
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/client/parallel.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/random.h"
 
 namespace mongo {
@@ -94,6 +95,15 @@ namespace mongo {
 
     typedef boost::shared_ptr<ShardedClientCursor> ShardedClientCursorPtr;
 
+    /**
+     * Registry of the cursors mongos hands out to clients.
+     *
+     * The registry is split into a fixed number of partitions, each with its own mutex and maps.
+     * A cursor id is owned by exactly one partition (chosen from the low-order bits of the id),
+     * so getMore, store, remove and killCursors only ever lock the partition owning the id they
+     * operate on. Only whole-registry operations (appendInfo, doTimeouts) visit every partition,
+     * and they lock the partitions one at a time.
+     */
     class CursorCache {
     public:
 
@@ -112,6 +122,19 @@ namespace mongo {
         void updateMaxTimeMS( long long id, int maxTimeMS );
         void remove( long long id );
 
+        /**
+         * Looks up everything getMore needs to know about 'id' with a single acquisition of the
+         * owning partition's lock. Any of the out parameters may be NULL.
+         *
+         * @param cursor set to the sharded cursor for 'id', or to an empty pointer
+         * @param maxTimeMS set to the remaining max time of the sharded cursor, or 0
+         * @param ref set to the server owning the passthrough cursor 'id', or ""
+         */
+        void lookup( long long id,
+                     ShardedClientCursorPtr* cursor,
+                     int* maxTimeMS,
+                     std::string* ref ) const;
+
         void storeRef(const std::string& server, long long id, const std::string& ns);
         void removeRef( long long id );
 
@@ -126,29 +149,60 @@ namespace mongo {
 
         long long genId();
 
+        /**
+         * Kills sharded cursors which have been idle for longer than TIMEOUT. Partitions are
+         * swept one at a time, and the expired cursors are destroyed after the partition lock
+         * has been released.
+         */
         void doTimeouts();
         void startTimeoutThread();
     private:
-        mutable mongo::mutex _mutex;
 
-        PseudoRandom _random;
+        // Must be a power of two, cursor ids are mapped to partitions by masking.
+        static const size_t kNumPartitions = 16;
 
-        // Maps sharded cursor ID to ShardedClientCursorPtr.
-        MapSharded _cursors;
+        struct Partition {
+            Partition();
 
-        // Maps sharded cursor ID to remaining max time.  Value can be any of:
-        // - the constant "kMaxTimeCursorNoTimeLimit", or
-        // - the constant "kMaxTimeCursorTimeLimitExpired", or
-        // - a positive integer representing milliseconds of remaining time
-        MapShardedInt _cursorsMaxTimeMS;
+            mutable mongo::mutex mutex;
 
-        // Maps passthrough cursor ID to shard name.
-        MapNormal _refs;
+            // Used to generate the cursor ids owned by this partition
+            PseudoRandom random;
 
-        // Maps passthrough cursor ID to namespace.
-        MapNormal _refsNS;
-        
-        long long _shardedTotal;
+            // Maps sharded cursor ID to ShardedClientCursorPtr.
+            MapSharded cursors;
+
+            // Maps sharded cursor ID to remaining max time.  Value can be any of:
+            // - the constant "kMaxTimeCursorNoTimeLimit", or
+            // - the constant "kMaxTimeCursorTimeLimitExpired", or
+            // - a positive integer representing milliseconds of remaining time
+            MapShardedInt cursorsMaxTimeMS;
+
+            // Maps passthrough cursor ID to shard name.
+            MapNormal refs;
+
+            // Maps passthrough cursor ID to namespace.
+            MapNormal refsNS;
+
+            long long shardedTotal;
+        };
+
+        static size_t _partitionIndex( long long id ) {
+            return static_cast<size_t>( id ) & ( kNumPartitions - 1 );
+        }
+
+        Partition& _getPartition( long long id ) {
+            return _partitions[_partitionIndex( id )];
+        }
+
+        const Partition& _getPartition( long long id ) const {
+            return _partitions[_partitionIndex( id )];
+        }
+
+        Partition _partitions[kNumPartitions];
+
+        // Spreads newly generated cursor ids across the partitions
+        AtomicUInt32 _nextPartition;
 
         static const int _myLogLevel;
     };
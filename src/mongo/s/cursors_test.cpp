@@ -0,0 +1,245 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/cursors.h"
+
+#include <limits>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/client/parallel.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/max_time.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+    // Defined in dbclient.cpp
+    void assembleRequest(const std::string& ns, BSONObj query, int nToReturn, int nToSkip,
+                         const BSONObj* fieldsToReturn, int queryOptions, Message& toSend);
+}
+
+namespace {
+
+    using namespace mongo;
+
+    using std::set;
+    using std::string;
+    using std::vector;
+
+    const char* const ns = "test.cursors";
+
+    // Matches CursorCache::kNumPartitions. A cursor id's partition is its low-order bits.
+    const size_t kNumPartitions = 16;
+
+    size_t partitionOf(long long id) {
+        return static_cast<size_t>(id) & (kNumPartitions - 1);
+    }
+
+    /**
+     * Makes a sharded cursor which has no shards to talk to, so it can be destroyed anywhere.
+     */
+    ShardedClientCursorPtr makeCursor() {
+        Message toSend;
+        assembleRequest(ns, BSONObj(), 0, 0, NULL, 0, toSend);
+        DbMessage dbMessage(toSend);
+        QueryMessage q(dbMessage);
+
+        return ShardedClientCursorPtr(
+            new ShardedClientCursor(q,
+                                    new ParallelSortClusteredCursor(set<string>(),
+                                                                    ns,
+                                                                    Query(),
+                                                                    0,
+                                                                    BSONObj())));
+    }
+
+    /**
+     * Stores one sharded cursor in each partition of 'cache'. Consecutive ids are generated in
+     * consecutive partitions.
+     */
+    vector<ShardedClientCursorPtr> storeCursors(CursorCache* cache) {
+        vector<ShardedClientCursorPtr> cursors;
+        set<size_t> partitions;
+        for (size_t i = 0; i < kNumPartitions; i++) {
+            ShardedClientCursorPtr cursor = makeCursor();
+            cache->store(cursor, static_cast<int>(i) + 1);
+            cursors.push_back(cursor);
+            partitions.insert(partitionOf(cursor->getId()));
+        }
+        ASSERT_EQUALS(kNumPartitions, partitions.size());
+        return cursors;
+    }
+
+    /**
+     * Sets CursorCache::TIMEOUT for the duration of a test.
+     */
+    class TimeoutSetting {
+    public:
+        explicit TimeoutSetting(long long timeout) : _saved(CursorCache::TIMEOUT) {
+            CursorCache::TIMEOUT = timeout;
+        }
+
+        ~TimeoutSetting() {
+            CursorCache::TIMEOUT = _saved;
+        }
+
+    private:
+        const long long _saved;
+    };
+
+    TEST(CursorCacheTest, StoreFindAndRemoveInEveryPartition) {
+        CursorCache cache;
+        vector<ShardedClientCursorPtr> cursors = storeCursors(&cache);
+
+        for (size_t i = 0; i < cursors.size(); i++) {
+            const long long id = cursors[i]->getId();
+            ASSERT(cache.get(id) == cursors[i]);
+            ASSERT_EQUALS(static_cast<int>(i) + 1, cache.getMaxTimeMS(id));
+
+            ShardedClientCursorPtr found;
+            int maxTimeMS = 0;
+            string ref = "unset";
+            cache.lookup(id, &found, &maxTimeMS, &ref);
+            ASSERT(found == cursors[i]);
+            ASSERT_EQUALS(static_cast<int>(i) + 1, maxTimeMS);
+            ASSERT_EQUALS("", ref);
+
+            cache.updateMaxTimeMS(id, kMaxTimeCursorNoTimeLimit);
+            ASSERT_EQUALS(kMaxTimeCursorNoTimeLimit, cache.getMaxTimeMS(id));
+        }
+
+        // Removing a cursor leaves the cursors of the other partitions alone.
+        for (size_t i = 0; i < cursors.size(); i++) {
+            const long long id = cursors[i]->getId();
+            cache.remove(id);
+            ASSERT(!cache.get(id));
+            for (size_t j = i + 1; j < cursors.size(); j++) {
+                ASSERT(cache.get(cursors[j]->getId()) == cursors[j]);
+            }
+        }
+    }
+
+    TEST(CursorCacheTest, RefsInEveryPartition) {
+        CursorCache cache;
+
+        vector<long long> ids;
+        set<size_t> partitions;
+        for (size_t i = 0; i < kNumPartitions; i++) {
+            const long long id = cache.genId();
+            ASSERT_NOT_EQUALS(0, id);
+            ids.push_back(id);
+            partitions.insert(partitionOf(id));
+            cache.storeRef(str::stream() << "shard" << i, id, ns);
+        }
+        ASSERT_EQUALS(kNumPartitions, partitions.size());
+
+        for (size_t i = 0; i < ids.size(); i++) {
+            ASSERT_EQUALS(string(str::stream() << "shard" << i), cache.getRef(ids[i]));
+            ASSERT_EQUALS(ns, cache.getRefNS(ids[i]));
+
+            ShardedClientCursorPtr found;
+            string ref;
+            cache.lookup(ids[i], &found, NULL, &ref);
+            ASSERT(!found);
+            ASSERT_EQUALS(string(str::stream() << "shard" << i), ref);
+        }
+
+        for (size_t i = 0; i < ids.size(); i++) {
+            cache.removeRef(ids[i]);
+            ASSERT_EQUALS("", cache.getRef(ids[i]));
+            ASSERT_EQUALS("", cache.getRefNS(ids[i]));
+        }
+    }
+
+    TEST(CursorCacheTest, TimeoutsCoverEveryPartition) {
+        CursorCache cache;
+        vector<ShardedClientCursorPtr> cursors = storeCursors(&cache);
+
+        {
+            TimeoutSetting neverIdleLongEnough(std::numeric_limits<long long>::max());
+            cache.doTimeouts();
+        }
+        for (size_t i = 0; i < cursors.size(); i++) {
+            ASSERT(cache.get(cursors[i]->getId()) == cursors[i]);
+        }
+
+        {
+            // Every cursor has been idle for at least no time at all.
+            TimeoutSetting alwaysIdleLongEnough(0);
+            cache.doTimeouts();
+        }
+        for (size_t i = 0; i < cursors.size(); i++) {
+            const long long id = cursors[i]->getId();
+            ASSERT(!cache.get(id));
+            ASSERT_EQUALS(0, cache.getMaxTimeMS(id));
+        }
+    }
+
+    TEST(CursorCacheTest, StatsCoverEveryPartition) {
+        CursorCache cache;
+
+        BSONObjBuilder before;
+        cache.appendInfo(before);
+        const BSONObj beforeInfo = before.obj();
+        ASSERT_EQUALS(0, beforeInfo["shardedEver"].numberLong());
+
+        vector<ShardedClientCursorPtr> cursors = storeCursors(&cache);
+        vector<long long> refIds;
+        for (size_t i = 0; i < kNumPartitions; i++) {
+            refIds.push_back(cache.genId());
+            cache.storeRef("shard0", refIds.back(), ns);
+        }
+
+        BSONObjBuilder after;
+        cache.appendInfo(after);
+        const BSONObj afterInfo = after.obj();
+        ASSERT_EQUALS(static_cast<long long>(kNumPartitions),
+                      afterInfo["shardedEver"].numberLong());
+        ASSERT_EQUALS(beforeInfo["sharded"].numberInt() + static_cast<int>(kNumPartitions),
+                      afterInfo["sharded"].numberInt());
+        ASSERT_EQUALS(beforeInfo["refs"].numberInt() + static_cast<int>(kNumPartitions),
+                      afterInfo["refs"].numberInt());
+
+        // Removing cursors doesn't change how many were ever opened.
+        for (size_t i = 0; i < cursors.size(); i++) {
+            cache.remove(cursors[i]->getId());
+            cache.removeRef(refIds[i]);
+        }
+        BSONObjBuilder removed;
+        cache.appendInfo(removed);
+        ASSERT_EQUALS(static_cast<long long>(kNumPartitions),
+                      removed.obj()["shardedEver"].numberLong());
+    }
+
+}  // namespace
@@ -1731,6 +1731,9 @@ namespace mongo {
                 commitInfo.appendElements( chunkInfo );
                 if (res["counts"].type() == Object) {
                     commitInfo.appendElements(res["counts"].Obj());
+
+                    // Lets the balancer keep track of migration throughput
+                    result.append("counts", res["counts"].Obj());
                 }
 
                 grid.catalogManager()->logChange(txn, "moveChunk.commit", ns, commitInfo.obj());
@@ -32,6 +32,8 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
 #include <map>
 #include <string>
 #include <vector>
@@ -53,6 +55,7 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/storage/record_store.h"
 #include "mongo/s/catalog/catalog_manager.h"
 #include "mongo/s/catalog/type_chunk.h"
 #include "mongo/s/chunk.h"
@@ -236,85 +239,222 @@ namespace mongo {
         return key.replaceFieldNames(keyPattern).clientReadable();
     }
 
-    class SplitVector : public Command {
-    public:
-        SplitVector() : Command( "splitVector" , false ) {}
-        virtual bool slaveOk() const { return false; }
-        virtual bool isWriteCommandForConfigServer() const { return false; }
-        virtual void help( stringstream &help ) const {
-            help <<
-                 "Internal command.\n"
-                 "examples:\n"
-                 "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, maxChunkSize:200 }\n"
-                 "  maxChunkSize unit in MBs\n"
-                 "  May optionally specify 'maxSplitPoints' and 'maxChunkObjects' to avoid traversing the whole chunk\n"
-                 "  \n"
-                 "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, force: true }\n"
-                 "  'force' will produce one split point even if data is small; defaults to false\n"
-                 "NOTE: This command may take a while to run";
-        }
-        virtual Status checkAuthForCommand(ClientBasic* client,
-                                           const std::string& dbname,
-                                           const BSONObj& cmdObj) {
-            if (!AuthorizationSession::get(client)->isAuthorizedForActionsOnResource(
-                    ResourcePattern::forExactNamespace(NamespaceString(parseNs(dbname, cmdObj))),
-                    ActionType::splitVector)) {
-                return Status(ErrorCodes::Unauthorized, "Unauthorized");
+    namespace {
+
+        // Fewest and most random records looked at to estimate the split points of a chunk.
+        const long long kMinSplitSampleSize = 1000;
+        const long long kMaxSplitSampleSize = 10000;
+
+        // How many of the sampled records have to fall in each resulting chunk for the sample to
+        // be trusted with picking the split points.
+        const long long kSampledRecordsPerSplit = 10;
+
+        /**
+         * Parameters of a split points lookup which apply to every range of a splitVector request.
+         */
+        struct SplitVectorParams {
+            SplitVectorParams()
+                : maxSplitPoints(0),
+                  maxChunkObjects(Chunk::MaxObjectPerChunk),
+                  maxChunkSize(0),
+                  force(false),
+                  estimate(false) {
+            }
+
+            long long maxSplitPoints;
+            long long maxChunkObjects;
+            long long maxChunkSize;
+            bool force;
+            bool estimate;
+        };
+
+        /**
+         * One entry of the 'ranges' array of a splitVector request.
+         */
+        struct SplitVectorRange {
+            BSONObj min;
+            BSONObj max;
+            SplitVectorParams params;
+        };
+
+        /**
+         * Reads the chunk size options of a splitVector request, or of one entry of its 'ranges'
+         * array, into 'maxChunkSize'. Leaves it untouched if neither option is present.
+         */
+        void parseMaxChunkSize(const BSONObj& obj, long long* maxChunkSize) {
+            BSONElement maxSizeElem = obj["maxChunkSize"];
+            if (maxSizeElem.isNumber()) {
+                *maxChunkSize = maxSizeElem.numberLong() * 1<<20;
+                return;
+            }
+
+            maxSizeElem = obj["maxChunkSizeBytes"];
+            if (maxSizeElem.isNumber()) {
+                *maxChunkSize = maxSizeElem.numberLong();
             }
-            return Status::OK();
-        }
-        virtual std::string parseNs(const string& dbname, const BSONObj& cmdObj) const {
-            return parseNsFullyQualified(dbname, cmdObj);
         }
-        bool run(OperationContext* txn,
-                 const string& dbname,
-                 BSONObj& jsobj,
-                 int,
-                 string& errmsg,
-                 BSONObjBuilder& result) {
 
-            //
-            // 1.a We'll parse the parameters in two steps. First, make sure the we can use the split index to get
-            //     a good approximation of the size of the chunk -- without needing to access the actual data.
-            //
+        /**
+         * Estimates the split points of the [min, max) chunk of 'collection' from a random sample
+         * of its records, rather than by reading every key of the chunk. 'min' and 'max' are shard
+         * keys and may both be empty to mean the whole key space.
+         *
+         * The sample is sized from the collection's record count so that about
+         * kSampledRecordsPerSplit sampled records fall between two consecutive split points. The
+         * sampled records of the chunk are sorted by shard key and every one which stands for more
+         * than 'keyCount' records of the collection becomes a split point, like every
+         * 'keyCount'-th key does in the exact scan.
+         *
+         * Sets '*sampledOut' to false and leaves 'splitKeys' untouched if the split points have to
+         * be found with the exact scan instead: the collection is too small for sampling to be
+         * cheaper, it is so large compared to 'keyCount' that the sample would have to be bigger
+         * than kMaxSplitSampleSize, or its storage engine can't position on random records.
+         *
+         * Must be called with the collection locked.
+         */
+        Status findSplitKeysFromSample(OperationContext* txn,
+                                       Collection* collection,
+                                       const ShardKeyPattern& shardKeyPattern,
+                                       const BSONObj& min,
+                                       const BSONObj& max,
+                                       long long keyCount,
+                                       long long maxSplitPoints,
+                                       vector<BSONObj>* splitKeys,
+                                       set<BSONObj>* tooFrequentKeys,
+                                       long long* recordsLookedAt,
+                                       bool* sampledOut) {
+            *sampledOut = false;
+            if (keyCount <= 0) {
+                return Status::OK();
+            }
 
-            const std::string ns = parseNs(dbname, jsobj);
-            BSONObj keyPattern = jsobj.getObjectField( "keyPattern" );
+            const long long numRecords = collection->numRecords(txn);
+            const long long sampleSize =
+                std::max(kMinSplitSampleSize,
+                         (kSampledRecordsPerSplit * numRecords + keyCount - 1) / keyCount);
+            if (numRecords <= sampleSize || sampleSize > kMaxSplitSampleSize) {
+                return Status::OK();
+            }
 
-            if ( keyPattern.isEmpty() ) {
-                errmsg = "no key pattern found in splitVector";
-                return false;
+            boost::scoped_ptr<RecordIterator> iter(
+                collection->getRecordStore()->getRandomIterator(txn));
+            if (!iter) {
+                return Status::OK();
             }
 
-            // If min and max are not provided use the "minKey" and "maxKey" for the sharding key pattern.
-            BSONObj min = jsobj.getObjectField( "min" );
-            BSONObj max = jsobj.getObjectField( "max" );
-            if ( min.isEmpty() != max.isEmpty() ){
-                errmsg = "either provide both min and max or leave both empty";
-                return false;
+            vector<BSONObj> sampleKeys;
+            long long sampled = 0;
+            while (sampled < sampleSize && !iter->isEOF()) {
+                if (0 == sampled % 128) {
+                    txn->checkForInterrupt();
+                }
+
+                const RecordId loc = iter->curr();
+                const BSONObj key =
+                    shardKeyPattern.extractShardKeyFromDoc(iter->dataFor(loc).releaseToBson());
+                iter->getNext();
+                ++sampled;
+
+                // Documents without a valid shard key don't belong to any chunk.
+                if (key.isEmpty()) {
+                    continue;
+                }
+
+                if (!min.isEmpty() && (key.woCompare(min) < 0 || key.woCompare(max) >= 0)) {
+                    continue;
+                }
+
+                sampleKeys.push_back(key.getOwned());
             }
 
-            long long maxSplitPoints = 0;
-            BSONElement maxSplitPointsElem = jsobj[ "maxSplitPoints" ];
-            if ( maxSplitPointsElem.isNumber() ) {
-                maxSplitPoints = maxSplitPointsElem.numberLong();
+            if (0 == sampled) {
+                // The collection was emptied out from under us.
+                return Status::OK();
             }
 
-            long long maxChunkObjects = Chunk::MaxObjectPerChunk;
-            BSONElement MaxChunkObjectsElem = jsobj[ "maxChunkObjects" ];
-            if ( MaxChunkObjectsElem.isNumber() ) {
-                maxChunkObjects = MaxChunkObjectsElem.numberLong();
+            *recordsLookedAt = sampled;
+            *sampledOut = true;
+
+            std::sort(sampleKeys.begin(),
+                      sampleKeys.end(),
+                      [](const BSONObj& a, const BSONObj& b) { return a.woCompare(b) < 0; });
+
+            // Each sampled record stands for this many records of the collection.
+            const double recordsPerSample = static_cast<double>(numRecords) / sampled;
+
+            long long numChunks = 0;
+            double currCount = 0;
+            for (vector<BSONObj>::const_iterator it = sampleKeys.begin();
+                 it != sampleKeys.end();
+                 ++it) {
+                if (splitKeys->empty()) {
+                    // Like the exact scan, the first key of the chunk is a sentinel which is
+                    // never used as a split point.
+                    splitKeys->push_back(*it);
+                }
+
+                currCount += recordsPerSample;
+                if (currCount <= keyCount) {
+                    continue;
+                }
+
+                // Do not use this split key if it is the same used in the previous split point.
+                if (it->woCompare(splitKeys->back()) == 0) {
+                    tooFrequentKeys->insert(*it);
+                    continue;
+                }
+
+                splitKeys->push_back(*it);
+                currCount = 0;
+                numChunks++;
+                LOG(4) << "picked a sampled split key: " << *it;
+
+                if (maxSplitPoints && (numChunks >= maxSplitPoints)) {
+                    break;
+                }
             }
 
-            vector<BSONObj> splitKeys;
+            return Status::OK();
+        }
+
+        /**
+         * Finds the keys which split the [min, max) range of the collection 'ns' into chunks of
+         * about half of the size limits in 'params'. 'min' and 'max' are shard keys and may both
+         * be empty to mean the whole key space.
+         *
+         * On success 'splitKeys' is filled in, possibly with no keys if the range doesn't hold
+         * enough data to be split.
+         */
+        Status findSplitKeys(OperationContext* txn,
+                             const std::string& ns,
+                             const BSONObj& keyPattern,
+                             BSONObj min,
+                             BSONObj max,
+                             const SplitVectorParams& params,
+                             vector<BSONObj>* splitKeys,
+                             long long* timeMillis) {
+
+            Timer timer;
+            long long keyCount = 0;
+            long long currCount = 0;
+            long long maxChunkSize = params.maxChunkSize;
+            BSONObj idxKeyPattern;
+
+            // The bounds of the chunk as shard keys, before they are turned into index bounds
+            const BSONObj chunkMin = min;
+            const BSONObj chunkMax = max;
+
+            // Use every 'keyCount'-th key as a split point. We add the initial key as a sentinel, to be removed
+            // at the end. If a key appears more times than entries allowed on a chunk, we issue a warning and
+            // split on the following key.
+            set<BSONObj> tooFrequentKeys;
 
             {
                 // Get the size estimate for this namespace
                 AutoGetCollectionForRead ctx(txn, ns);
                 Collection* collection = ctx.getCollection();
                 if ( !collection ) {
-                    errmsg = "ns not found";
-                    return false;
+                    return Status(ErrorCodes::NamespaceNotFound, "ns not found");
                 }
 
                 // Allow multiKey based on the invariant that shard keys must be single-valued.
@@ -325,10 +465,12 @@ namespace mongo {
                                                                               keyPattern,
                                                                               false );
                 if ( idx == NULL ) {
-                    errmsg = (string)"couldn't find index over splitting key " +
-                             keyPattern.clientReadable().toString();
-                    return false;
+                    return Status(ErrorCodes::IndexNotFound,
+                                  (string)"couldn't find index over splitting key " +
+                                  keyPattern.clientReadable().toString());
                 }
+                idxKeyPattern = idx->keyPattern().getOwned();
+
                 // extend min to get (min, MinKey, MinKey, ....)
                 KeyPattern kp( idx->keyPattern() );
                 min = Helpers::toKeyFormat( kp.extendRangeBound ( min, false ) );
@@ -347,162 +489,326 @@ namespace mongo {
                 // 1.b Now that we have the size estimate, go over the remaining parameters and apply any maximum size
                 //     restrictions specified there.
                 //
-                
+
                 // 'force'-ing a split is equivalent to having maxChunkSize be the size of the current chunk, i.e., the
                 // logic below will split that chunk in half
-                long long maxChunkSize = 0;
-                bool forceMedianSplit = false;
-                {
-                    BSONElement maxSizeElem = jsobj[ "maxChunkSize" ];
-                    BSONElement forceElem = jsobj[ "force" ];
-                    
-                    if ( forceElem.trueValue() ) {
-                        forceMedianSplit = true;
-                        // This chunk size is effectively ignored if force is true
-                        maxChunkSize = dataSize;
-                        
-                    }
-                    else if ( maxSizeElem.isNumber() ) {
-                        maxChunkSize = maxSizeElem.numberLong() * 1<<20;
-                        
-                    }
-                    else {
-                        maxSizeElem = jsobj["maxChunkSizeBytes"];
-                        if ( maxSizeElem.isNumber() ) {
-                            maxChunkSize = maxSizeElem.numberLong();
-                        }
-                    }
+                bool forceMedianSplit = params.force;
+                if ( forceMedianSplit ) {
+                    // This chunk size is effectively ignored if force is true
+                    maxChunkSize = dataSize;
+                }
 
-                    // We need a maximum size for the chunk, unless we're not actually capable of finding any
-                    // split points.
-                    if ( maxChunkSize <= 0 && recCount != 0 ) {
-                        errmsg = "need to specify the desired max chunk size (maxChunkSize or maxChunkSizeBytes)";
-                        return false;
-                    }
+                // We need a maximum size for the chunk, unless we're not actually capable of finding any
+                // split points.
+                if ( maxChunkSize <= 0 && recCount != 0 ) {
+                    return Status(ErrorCodes::BadValue,
+                                  "need to specify the desired max chunk size "
+                                  "(maxChunkSize or maxChunkSizeBytes)");
                 }
-                
-                
+
                 // If there's not enough data for more than one chunk, no point continuing.
                 if ( dataSize < maxChunkSize || recCount == 0 ) {
-                    vector<BSONObj> emptyVector;
-                    result.append( "splitKeys" , emptyVector );
-                    return true;
+                    return Status::OK();
                 }
-                
+
                 log() << "request split points lookup for chunk " << ns << " " << min << " -->> " << max << endl;
-                
+
                 // We'll use the average object size and number of object to find approximately how many keys
                 // each chunk should have. We'll split at half the maxChunkSize or maxChunkObjects, if
                 // provided.
                 const long long avgRecSize = dataSize / recCount;
-                long long keyCount = maxChunkSize / (2 * avgRecSize);
-                if ( maxChunkObjects && ( maxChunkObjects < keyCount ) ) {
-                    log() << "limiting split vector to " << maxChunkObjects << " (from " << keyCount << ") objects " << endl;
-                    keyCount = maxChunkObjects;
+                keyCount = maxChunkSize / (2 * avgRecSize);
+                if ( params.maxChunkObjects && ( params.maxChunkObjects < keyCount ) ) {
+                    log() << "limiting split vector to " << params.maxChunkObjects << " (from " << keyCount << ") objects " << endl;
+                    keyCount = params.maxChunkObjects;
                 }
-                
+
                 //
                 // 2. Traverse the index and add the keyCount-th key to the result vector. If that key
                 //    appeared in the vector before, we omit it. The invariant here is that all the
                 //    instances of a given key value live in the same chunk.
                 //
-                
-                Timer timer;
-                long long currCount = 0;
-                long long numChunks = 0;
-                
-                auto_ptr<PlanExecutor> exec(
-                    InternalPlanner::indexScan(txn, collection, idx, min, max,
-                    false, InternalPlanner::FORWARD));
-
-                BSONObj currKey;
-                PlanExecutor::ExecState state = exec->getNext(&currKey, NULL);
-                if (PlanExecutor::ADVANCED != state) {
-                    errmsg = "can't open a cursor for splitting (desired range is possibly empty)";
-                    return false;
+
+                bool sampled = false;
+                if ( params.estimate && !forceMedianSplit ) {
+                    Status status = findSplitKeysFromSample(txn,
+                                                            collection,
+                                                            ShardKeyPattern(keyPattern),
+                                                            chunkMin,
+                                                            chunkMax,
+                                                            keyCount,
+                                                            params.maxSplitPoints,
+                                                            splitKeys,
+                                                            &tooFrequentKeys,
+                                                            &currCount,
+                                                            &sampled);
+                    if (!status.isOK()) {
+                        return status;
+                    }
                 }
-                
-                // Use every 'keyCount'-th key as a split point. We add the initial key as a sentinel, to be removed
-                // at the end. If a key appears more times than entries allowed on a chunk, we issue a warning and
-                // split on the following key.
-                set<BSONObj> tooFrequentKeys;
-                splitKeys.push_back(prettyKey(idx->keyPattern(), currKey.getOwned()).extractFields( keyPattern ) );
-
-                exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
-                while ( 1 ) {
-                    while (PlanExecutor::ADVANCED == state) {
-                        currCount++;
-                        
-                        if ( currCount > keyCount && !forceMedianSplit ) {
-                            currKey = prettyKey(idx->keyPattern(), currKey.getOwned()).extractFields(keyPattern);
-                            // Do not use this split key if it is the same used in the previous split point.
-                            if ( currKey.woCompare( splitKeys.back() ) == 0 ) {
-                                tooFrequentKeys.insert( currKey.getOwned() );
+
+                if ( !sampled ) {
+                    long long numChunks = 0;
+
+                    auto_ptr<PlanExecutor> exec(
+                        InternalPlanner::indexScan(txn, collection, idx, min, max,
+                        false, InternalPlanner::FORWARD));
+
+                    BSONObj currKey;
+                    PlanExecutor::ExecState state = exec->getNext(&currKey, NULL);
+                    if (PlanExecutor::ADVANCED != state) {
+                        return Status(ErrorCodes::OperationFailed,
+                                      "can't open a cursor for splitting "
+                                      "(desired range is possibly empty)");
+                    }
+
+                    splitKeys->push_back(prettyKey(idx->keyPattern(), currKey.getOwned()).extractFields( keyPattern ) );
+
+                    exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
+                    while ( 1 ) {
+                        while (PlanExecutor::ADVANCED == state) {
+                            currCount++;
+
+                            if ( currCount > keyCount && !forceMedianSplit ) {
+                                currKey = prettyKey(idx->keyPattern(), currKey.getOwned()).extractFields(keyPattern);
+                                // Do not use this split key if it is the same used in the previous split point.
+                                if ( currKey.woCompare( splitKeys->back() ) == 0 ) {
+                                    tooFrequentKeys.insert( currKey.getOwned() );
+                                }
+                                else {
+                                    splitKeys->push_back( currKey.getOwned() );
+                                    currCount = 0;
+                                    numChunks++;
+                                    LOG(4) << "picked a split key: " << currKey << endl;
+                                }
                             }
-                            else {
-                                splitKeys.push_back( currKey.getOwned() );
-                                currCount = 0;
-                                numChunks++;
-                                LOG(4) << "picked a split key: " << currKey << endl;
+
+                            // Stop if we have enough split points.
+                            if ( params.maxSplitPoints && ( numChunks >= params.maxSplitPoints ) ) {
+                                log() << "max number of requested split points reached (" << numChunks
+                                      << ") before the end of chunk " << ns << " " << min << " -->> " << max
+                                      << endl;
+                                break;
                             }
+
+                            state = exec->getNext(&currKey, NULL);
                         }
 
-                        // Stop if we have enough split points.
-                        if ( maxSplitPoints && ( numChunks >= maxSplitPoints ) ) {
-                            log() << "max number of requested split points reached (" << numChunks
-                                  << ") before the end of chunk " << ns << " " << min << " -->> " << max
-                                  << endl;
+                        if ( ! forceMedianSplit )
                             break;
-                        }
 
+                        //
+                        // If we're forcing a split at the halfway point, then the first pass was just
+                        // to count the keys, and we still need a second pass.
+                        //
+
+                        forceMedianSplit = false;
+                        keyCount = currCount / 2;
+                        currCount = 0;
+                        log() << "splitVector doing another cycle because of force, keyCount now: " << keyCount << endl;
+
+                        exec.reset(InternalPlanner::indexScan(txn, collection, idx, min, max,
+                                                                false, InternalPlanner::FORWARD));
+
+                        exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
                         state = exec->getNext(&currKey, NULL);
                     }
-                    
-                    if ( ! forceMedianSplit )
-                        break;
-                    
-                    //
-                    // If we're forcing a split at the halfway point, then the first pass was just
-                    // to count the keys, and we still need a second pass.
-                    //
+                }
+            }
+
+            //
+            // 3. Format the result and issue any warnings about the data we gathered while traversing the
+            //    index
+            //
 
-                    forceMedianSplit = false;
-                    keyCount = currCount / 2;
-                    currCount = 0;
-                    log() << "splitVector doing another cycle because of force, keyCount now: " << keyCount << endl;
+            // Warn for keys that are more numerous than maxChunkSize allows.
+            for ( set<BSONObj>::const_iterator it = tooFrequentKeys.begin(); it != tooFrequentKeys.end(); ++it ) {
+                warning() << "chunk is larger than " << maxChunkSize
+                          << " bytes because of key " << prettyKey(idxKeyPattern, *it ) << endl;
+            }
 
-                    exec.reset(InternalPlanner::indexScan(txn, collection, idx, min, max,
-                                                            false, InternalPlanner::FORWARD));
+            // Remove the sentinel at the beginning before returning. A sample may have missed the
+            // chunk altogether, in which case there is none.
+            if ( !splitKeys->empty() ) {
+                splitKeys->erase( splitKeys->begin() );
+            }
 
-                    exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
-                    state = exec->getNext(&currKey, NULL);
+            if (timer.millis() > serverGlobalParams.slowMS) {
+                warning() << "Finding the split vector for " <<  ns << " over "<< keyPattern
+                          << " keyCount: " << keyCount << " numSplits: " << splitKeys->size()
+                          << " lookedAt: " << currCount << " took " << timer.millis() << "ms"
+                          << endl;
+            }
+
+            *timeMillis = timer.millis();
+            return Status::OK();
+        }
+
+    } // namespace
+
+    class SplitVector : public Command {
+    public:
+        SplitVector() : Command( "splitVector" , false ) {}
+        virtual bool slaveOk() const { return false; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual void help( stringstream &help ) const {
+            help <<
+                 "Internal command.\n"
+                 "examples:\n"
+                 "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, maxChunkSize:200 }\n"
+                 "  maxChunkSize unit in MBs\n"
+                 "  May optionally specify 'maxSplitPoints' and 'maxChunkObjects' to avoid traversing the whole chunk\n"
+                 "  \n"
+                 "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, force: true }\n"
+                 "  'force' will produce one split point even if data is small; defaults to false\n"
+                 "  \n"
+                 "  { splitVector : \"blog.post\" , keyPattern:{x:1} , maxChunkSize:200,\n"
+                 "    ranges: [ { min:{x:10} , max:{x:20} }, { min:{x:20} , max:{x:30}, maxChunkSizeBytes:1024 } ] }\n"
+                 "  looks up the split points of several chunks at once, returned in 'rangeSplitKeys';\n"
+                 "  the ranges which failed are listed in 'rangeErrors' and given no split points\n"
+                 "  \n"
+                 "  'estimate: true' picks approximate split points from a random sample of the\n"
+                 "  collection instead of reading every key of the chunk, where the storage engine\n"
+                 "  supports it\n"
+                 "NOTE: This command may take a while to run";
+        }
+        virtual Status checkAuthForCommand(ClientBasic* client,
+                                           const std::string& dbname,
+                                           const BSONObj& cmdObj) {
+            if (!AuthorizationSession::get(client)->isAuthorizedForActionsOnResource(
+                    ResourcePattern::forExactNamespace(NamespaceString(parseNs(dbname, cmdObj))),
+                    ActionType::splitVector)) {
+                return Status(ErrorCodes::Unauthorized, "Unauthorized");
+            }
+            return Status::OK();
+        }
+        virtual std::string parseNs(const string& dbname, const BSONObj& cmdObj) const {
+            return parseNsFullyQualified(dbname, cmdObj);
+        }
+        bool run(OperationContext* txn,
+                 const string& dbname,
+                 BSONObj& jsobj,
+                 int,
+                 string& errmsg,
+                 BSONObjBuilder& result) {
+
+            //
+            // 1.a We'll parse the parameters in two steps. First, make sure the we can use the split index to get
+            //     a good approximation of the size of the chunk -- without needing to access the actual data.
+            //
+
+            const std::string ns = parseNs(dbname, jsobj);
+            BSONObj keyPattern = jsobj.getObjectField( "keyPattern" );
+
+            if ( keyPattern.isEmpty() ) {
+                errmsg = "no key pattern found in splitVector";
+                return false;
+            }
+
+            SplitVectorParams params;
+
+            BSONElement maxSplitPointsElem = jsobj[ "maxSplitPoints" ];
+            if ( maxSplitPointsElem.isNumber() ) {
+                params.maxSplitPoints = maxSplitPointsElem.numberLong();
+            }
+
+            BSONElement MaxChunkObjectsElem = jsobj[ "maxChunkObjects" ];
+            if ( MaxChunkObjectsElem.isNumber() ) {
+                params.maxChunkObjects = MaxChunkObjectsElem.numberLong();
+            }
+
+            params.force = jsobj[ "force" ].trueValue();
+            params.estimate = jsobj[ "estimate" ].trueValue();
+            parseMaxChunkSize( jsobj, &params.maxChunkSize );
+
+            BSONElement rangesElem = jsobj[ "ranges" ];
+            if ( !rangesElem.eoo() ) {
+                if ( rangesElem.type() != Array ) {
+                    errmsg = "'ranges' must be an array";
+                    return false;
                 }
 
-                //
-                // 3. Format the result and issue any warnings about the data we gathered while traversing the
-                //    index
-                //
-                
-                // Warn for keys that are more numerous than maxChunkSize allows.
-                for ( set<BSONObj>::const_iterator it = tooFrequentKeys.begin(); it != tooFrequentKeys.end(); ++it ) {
-                    warning() << "chunk is larger than " << maxChunkSize
-                              << " bytes because of key " << prettyKey(idx->keyPattern(), *it ) << endl;
-                }
-                
-                // Remove the sentinel at the beginning before returning
-                splitKeys.erase( splitKeys.begin() );
-                
-                if (timer.millis() > serverGlobalParams.slowMS) {
-                    warning() << "Finding the split vector for " <<  ns << " over "<< keyPattern
-                              << " keyCount: " << keyCount << " numSplits: " << splitKeys.size() 
-                              << " lookedAt: " << currCount << " took " << timer.millis() << "ms"
-                              << endl;
-                }
-                
-                // Warning: we are sending back an array of keys but are currently limited to
-                // 4MB work of 'result' size. This should be okay for now.
-
-                result.append( "timeMillis", timer.millis() );
+                // Check every range before any of the reply is built, so that a malformed request
+                // is failed as a whole.
+                vector<SplitVectorRange> ranges;
+                BSONObjIterator rangesIt( rangesElem.Obj() );
+                while ( rangesIt.more() ) {
+                    BSONElement rangeElem = rangesIt.next();
+                    if ( rangeElem.type() != Object ) {
+                        errmsg = "each entry of 'ranges' must be an object";
+                        return false;
+                    }
+
+                    const BSONObj range = rangeElem.Obj();
+                    SplitVectorRange parsed;
+                    parsed.min = range.getObjectField( "min" );
+                    parsed.max = range.getObjectField( "max" );
+                    if ( parsed.min.isEmpty() != parsed.max.isEmpty() ) {
+                        errmsg = "either provide both min and max or leave both empty";
+                        return false;
+                    }
+
+                    parsed.params = params;
+                    parseMaxChunkSize( range, &parsed.params.maxChunkSize );
+                    ranges.push_back( parsed );
+                }
+
+                // Each range is looked up on its own, so a failure on one of them (e.g. because it
+                // is empty) doesn't fail the others. The range is given no split keys and its
+                // error is reported in 'rangeErrors'.
+                BSONArrayBuilder rangeErrors;
+                BSONArrayBuilder rangeSplitKeys( result.subarrayStart( "rangeSplitKeys" ) );
+                long long totalTimeMillis = 0;
+
+                for ( size_t i = 0; i < ranges.size(); i++ ) {
+                    const SplitVectorRange& range = ranges[i];
+
+                    vector<BSONObj> splitKeys;
+                    long long timeMillis = 0;
+                    Status status = findSplitKeys( txn, ns, keyPattern, range.min, range.max,
+                                                   range.params, &splitKeys, &timeMillis );
+                    if ( !status.isOK() ) {
+                        warning() << "could not find split points for chunk " << ns << " "
+                                  << range.min << " -->> " << range.max << causedBy( status );
+                        splitKeys.clear();
+                        rangeErrors.append( BSON( "index" << static_cast<int>( i )
+                                               << "code" << status.code()
+                                               << "errmsg" << status.reason() ) );
+                    }
+
+                    rangeSplitKeys.append( splitKeys );
+                    totalTimeMillis += timeMillis;
+                }
+
+                rangeSplitKeys.done();
+                if ( rangeErrors.arrSize() > 0 ) {
+                    result.append( "rangeErrors", rangeErrors.arr() );
+                }
+                result.append( "timeMillis", totalTimeMillis );
+                return true;
+            }
+
+            // If min and max are not provided use the "minKey" and "maxKey" for the sharding key pattern.
+            BSONObj min = jsobj.getObjectField( "min" );
+            BSONObj max = jsobj.getObjectField( "max" );
+            if ( min.isEmpty() != max.isEmpty() ){
+                errmsg = "either provide both min and max or leave both empty";
+                return false;
+            }
+
+            vector<BSONObj> splitKeys;
+            long long timeMillis = -1;
+            Status status = findSplitKeys( txn, ns, keyPattern, min, max, params,
+                                           &splitKeys, &timeMillis );
+            if ( !status.isOK() ) {
+                errmsg = status.reason();
+                return false;
+            }
+
+            // Warning: we are sending back an array of keys but are currently limited to
+            // 4MB work of 'result' size. This should be okay for now.
+            if ( timeMillis >= 0 ) {
+                result.append( "timeMillis", timeMillis );
             }
 
             result.append( "splitKeys" , splitKeys );
@@ -28,9 +28,12 @@
 
 #pragma once
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "mongo/bson/bsonobj.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/namespace_string.h"
@@ -41,6 +44,7 @@
 namespace mongo {
 
     struct ShardEndpoint;
+    struct TargetedInserts;
 
     /**
      * The NSTargeter interface is used by a WriteOp to generate and target child write operations
@@ -85,6 +89,28 @@ namespace mongo {
          */
         virtual Status targetInsert( const BSONObj& doc, ShardEndpoint** endpoint ) const = 0;
 
+        /**
+         * Targets many single document writes at once, with the same results as calling
+         * targetInsert for each document.  The results are appended to 'targeted', see
+         * TargetedInserts below.
+         *
+         * Implementations may share the targeting work across the documents, the default just
+         * targets them one by one.
+         */
+        virtual void targetInserts( const std::vector<BSONObj>& docs,
+                                    TargetedInserts* targeted ) const;
+
+        /**
+         * Informs the targeter that the document at position 'pos' of a targetInserts result,
+         * of 'docSize' bytes, is about to be sent to its endpoint.  Documents may be targeted
+         * in bulk well ahead of being sent, so this is where targeters should account for the
+         * data written.  The default does nothing.
+         */
+        virtual void noteInsertSent( const TargetedInserts& targeted,
+                                     size_t pos,
+                                     int docSize ) const {
+        }
+
         /**
          * Returns a vector of ShardEndpoints for a potentially multi-shard update.
          *
@@ -185,4 +211,39 @@ namespace mongo {
         }
     };
 
+    /**
+     * The results of NSTargeter::targetInserts, in the order of the targeted documents.
+     */
+    struct TargetedInserts {
+
+        // The endpoint of each document, or NULL if it could not be targeted
+        OwnedPointerVector<ShardEndpoint> endpoints;
+
+        // Why each document could or could not be targeted
+        std::vector<Status> statuses;
+
+        // Positions of the targeted documents in 'endpoints', grouped by shard name and in
+        // ascending order
+        std::map<std::string, std::vector<size_t> > byShard;
+
+        // The min key of the chunk each document falls in, only filled in by targeters which
+        // track chunks
+        std::vector<BSONObj> chunkMins;
+    };
+
+    inline void NSTargeter::targetInserts( const std::vector<BSONObj>& docs,
+                                           TargetedInserts* targeted ) const {
+
+        for ( std::vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it ) {
+
+            ShardEndpoint* endpoint = NULL;
+            targeted->statuses.push_back( targetInsert( *it, &endpoint ) );
+            targeted->endpoints.push_back( endpoint );
+
+            if ( endpoint ) {
+                targeted->byShard[endpoint->shardName].push_back( targeted->endpoints.size() - 1 );
+            }
+        }
+    }
+
 } // namespace mongo
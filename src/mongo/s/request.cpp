@@ -39,6 +39,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/s/cluster_last_error_info.h"
 #include "mongo/s/cursors.h"
 #include "mongo/s/grid.h"
@@ -135,6 +136,8 @@ namespace mongo {
             // globalOpCounters are handled by write commands.
         }
 
+        globalOpLatencies.record( op, iscmd, t.micros() );
+
         LOG(3) << "Request::process end ns: " << getns()
                << " msg id: " << msgId
                << " op: " << op
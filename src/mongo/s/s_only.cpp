@@ -45,6 +45,7 @@
 #include "mongo/s/cluster_last_error_info.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/cycle_clock.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -123,6 +124,7 @@ namespace mongo {
 
         c->_commandsExecuted.increment();
 
+        const int64_t startTicks = CycleClock::now();
         std::string errmsg;
         bool ok;
         try {
@@ -142,6 +144,7 @@ namespace mongo {
         if ( !ok ) {
             c->_commandsFailed.increment();
         }
+        c->_latency.record(CycleClock::toMicros(CycleClock::now() - startTicks));
 
         appendCommandStatus(result, ok, errmsg);
     }
@@ -259,6 +259,99 @@ namespace mongo {
         return extractShardKeyFromMatchable(matchable);
     }
 
+    /**
+     * Looks up 'path' in 'doc' by field name at every level.  Returns false if the path goes
+     * through an array, which only generic path matching knows how to handle.
+     */
+    static bool findPathElementNoArrays(const BSONObj& doc,
+                                        const FieldRef& path,
+                                        BSONElement* pathEl) {
+        BSONObj current = doc;
+        for (size_t i = 0; i < path.numParts(); ++i) {
+            BSONElement el = current.getField(path.getPart(i));
+            if (el.eoo() || i + 1 == path.numParts()) {
+                *pathEl = el;
+                return true;
+            }
+
+            if (el.type() == Array)
+                return false;
+
+            if (el.type() != Object) {
+                // Can't descend into a scalar, so there is no value at this path
+                *pathEl = BSONElement();
+                return true;
+            }
+
+            current = el.Obj();
+        }
+
+        *pathEl = BSONElement();
+        return true;
+    }
+
+    void ShardKeyPattern::extractShardKeysFromDocs(const vector<BSONObj>& docs,
+                                                   vector<BSONObj>* shardKeys) const {
+        shardKeys->clear();
+        shardKeys->reserve(docs.size());
+
+        if (!isValid()) {
+            shardKeys->resize(docs.size());
+            return;
+        }
+
+        // The pattern elements parallel the parsed paths
+        vector<BSONElement> patternEls;
+        vector<bool> hashedEls;
+        BSONObjIterator patternIt(_keyPattern.toBSON());
+        while (patternIt.more()) {
+            patternEls.push_back(patternIt.next());
+            hashedEls.push_back(isHashedPatternEl(patternEls.back()));
+        }
+        dassert(patternEls.size() == _keyPatternPaths.size());
+
+        for (vector<BSONObj>::const_iterator docIt = docs.begin(); docIt != docs.end(); ++docIt) {
+
+            BSONObjBuilder keyBuilder;
+            bool usedFallback = false;
+            bool isValidKey = true;
+
+            for (size_t i = 0; i < patternEls.size(); ++i) {
+
+                BSONElement matchEl;
+                if (!findPathElementNoArrays(*docIt, *_keyPatternPaths[i], &matchEl)) {
+                    usedFallback = true;
+                    break;
+                }
+
+                if (!isShardKeyElement(matchEl, true)) {
+                    isValidKey = false;
+                    break;
+                }
+
+                if (hashedEls[i]) {
+                    keyBuilder.append(patternEls[i].fieldName(),
+                                      BSONElementHasher::hash64(
+                                          matchEl, BSONElementHasher::DEFAULT_HASH_SEED));
+                }
+                else {
+                    keyBuilder.appendAs(matchEl, patternEls[i].fieldName());
+                }
+            }
+
+            if (usedFallback) {
+                shardKeys->push_back(extractShardKeyFromDoc(*docIt));
+            }
+            else if (!isValidKey) {
+                shardKeys->push_back(BSONObj());
+            }
+            else {
+                dassert(isShardKey(keyBuilder.asTempObj()));
+                shardKeys->push_back(keyBuilder.obj());
+            }
+        }
+    }
+
     static BSONElement findEqualityElement(const EqualityMatches& equalities,
                                            const FieldRef& path) {
 
@@ -138,6 +138,17 @@ namespace mongo {
          */
         BSONObj extractShardKeyFromDoc(const BSONObj& doc) const;
 
+        /**
+         * Extracts the shard keys of many documents at once, with the same results as calling
+         * extractShardKeyFromDoc on each of them.  On return, (*shardKeys)[i] is the shard key of
+         * docs[i], or an empty BSONObj() if it has none.
+         *
+         * The parsed key pattern paths are looked up directly in each document, only falling
+         * back to generic path matching for documents with arrays along a path.
+         */
+        void extractShardKeysFromDocs(const std::vector<BSONObj>& docs,
+                                      std::vector<BSONObj>* shardKeys) const;
+
         /**
          * Given a simple BSON query, extracts the shard key corresponding to the key pattern
          * from equality matches in the query.  The query expression *must not* be a complex query
@@ -134,7 +134,15 @@ namespace {
     }
 
     static BSONObj docKey(const ShardKeyPattern& pattern, const BSONObj& doc) {
-        return pattern.extractShardKeyFromDoc(doc);
+        BSONObj shardKey = pattern.extractShardKeyFromDoc(doc);
+
+        // Bulk extraction must agree with single document extraction
+        std::vector<BSONObj> shardKeys;
+        pattern.extractShardKeysFromDocs(std::vector<BSONObj>(1, doc), &shardKeys);
+        ASSERT_EQUALS(shardKeys.size(), 1U);
+        ASSERT_EQUALS(shardKeys.front(), shardKey);
+
+        return shardKey;
     }
 
     TEST(ShardKeyPattern, ExtractDocShardKeySingle) {
@@ -246,6 +254,36 @@ namespace {
         ASSERT_EQUALS(docKey(pattern, BSON("a" << BSON_ARRAY(BSON("b" << value)))), BSONObj());
     }
 
+    TEST(ShardKeyPattern, ExtractDocShardKeysBulk) {
+
+        //
+        // Extracting many shard keys at once
+        //
+
+        ShardKeyPattern pattern(BSON("a.b" << 1 << "c" << 1));
+
+        std::vector<BSONObj> docs;
+        docs.push_back(fromjson("{a:{b:10}, c:30}"));
+        docs.push_back(fromjson("{a:[{b:10}], c:30}"));
+        docs.push_back(fromjson("{c:30, a:{d:1, b:'x'}}"));
+        docs.push_back(fromjson("{a:5, c:30}"));
+        docs.push_back(fromjson("{a:{b:10}}"));
+
+        std::vector<BSONObj> shardKeys;
+        pattern.extractShardKeysFromDocs(docs, &shardKeys);
+        ASSERT_EQUALS(shardKeys.size(), docs.size());
+        ASSERT_EQUALS(shardKeys[0], fromjson("{'a.b':10, c:30}"));
+        ASSERT_EQUALS(shardKeys[1], BSONObj());
+        ASSERT_EQUALS(shardKeys[2], fromjson("{'a.b':'x', c:30}"));
+        ASSERT_EQUALS(shardKeys[3], BSONObj());
+        ASSERT_EQUALS(shardKeys[4], BSONObj());
+
+        // Previous contents are replaced
+        pattern.extractShardKeysFromDocs(std::vector<BSONObj>(1, docs[0]), &shardKeys);
+        ASSERT_EQUALS(shardKeys.size(), 1U);
+        ASSERT_EQUALS(shardKeys[0], fromjson("{'a.b':10, c:30}"));
+    }
+
     static BSONObj queryKey(const ShardKeyPattern& pattern, const BSONObj& query) {
         StatusWith<BSONObj> status = pattern.extractShardKeyFromQuery(query);
         if (!status.isOK())
@@ -567,15 +567,16 @@ namespace mongo {
         //
         // TODO: Cleanup cursor cache, consolidate into single codepath
         //
-        const string host = cursorCache.getRef(id);
-        ShardedClientCursorPtr cursor = cursorCache.get( id );
-        int cursorMaxTimeMS = cursorCache.getMaxTimeMS( id );
+        string host;
+        ShardedClientCursorPtr cursor;
+        int cursorMaxTimeMS = 0;
+        cursorCache.lookup( id, &cursor, &cursorMaxTimeMS, &host );
 
         // Cursor ids should not overlap between sharded and unsharded cursors
         massert( 17012, str::stream() << "duplicate sharded and unsharded cursor id "
                                       << id << " detected for " << ns
                                       << ", duplicated on host " << host,
-                 NULL == cursorCache.get( id ).get() || host.empty() );
+                 NULL == cursor.get() || host.empty() );
 
         ClientBasic* client = ClientBasic::getCurrent();
         NamespaceString nsString(ns);
@@ -28,6 +28,8 @@
 
 #include "mongo/s/write_ops/batch_write_op.h"
 
+#include <algorithm>
+
 #include "mongo/base/error_codes.h"
 
 namespace mongo {
@@ -65,8 +67,14 @@ namespace mongo {
         numInserted( 0 ), numUpserted( 0 ), numMatched( 0 ), numModified( 0 ), numDeleted( 0 ) {
     }
 
+    // Fewest single document inserts of an ordered batch which are targeted in bulk at once
+    static const size_t kMinBulkTargetedInserts = 64;
+
     BatchWriteOp::BatchWriteOp() :
-        _clientRequest( NULL ), _writeOps( NULL ), _stats( new BatchWriteStats ) {
+        _clientRequest( NULL ),
+        _writeOps( NULL ),
+        _bulkTargetWindow( 0 ),
+        _stats( new BatchWriteStats ) {
     }
 
     void BatchWriteOp::initClientRequest( const BatchedCommandRequest* clientRequest ) {
@@ -81,6 +89,7 @@ namespace mongo {
         }
 
         _clientRequest = clientRequest;
+        _bulkTargetWindow = clientRequest->getOrdered() ? kMinBulkTargetedInserts : numWriteOps;
     }
 
     // Arbitrary endpoint ordering, needed for grouping by endpoint
@@ -244,6 +253,35 @@ namespace mongo {
         batchMap->clear();
     }
 
+    /**
+     * Targets up to 'maxDocs' of the _Ready inserts from 'startOp' onwards in bulk, appending
+     * the results to 'targeted' and noting the position of each op's result in 'positions'.
+     *
+     * Returns the index of the first op which wasn't considered.
+     */
+    static size_t bulkTargetInserts( const NSTargeter& targeter,
+                                     WriteOp* writeOps,
+                                     size_t numWriteOps,
+                                     size_t startOp,
+                                     size_t maxDocs,
+                                     TargetedInserts* targeted,
+                                     vector<int>* positions ) {
+
+        vector<BSONObj> docs;
+        size_t opIndex = startOp;
+        for ( ; opIndex < numWriteOps && docs.size() < maxDocs; ++opIndex ) {
+
+            WriteOp& writeOp = writeOps[opIndex];
+            if ( writeOp.getWriteState() != WriteOpState_Ready ) continue;
+
+            (*positions)[opIndex] = targeted->endpoints.size() + docs.size();
+            docs.push_back( writeOp.getWriteItem().getDocument() );
+        }
+
+        targeter.targetInserts( docs, targeted );
+        return opIndex;
+    }
+
     Status BatchWriteOp::targetBatch( const NSTargeter& targeter,
                                       bool recordTargetErrors,
                                       vector<TargetedWriteBatch*>* targetedBatches ) {
@@ -289,6 +327,27 @@ namespace mongo {
         int numTargetErrors = 0;
 
         size_t numWriteOps = _clientRequest->sizeWriteOps();
+
+        //
+        // Single document inserts are targeted in bulk.  Ordered batches stop at the first write
+        // for another endpoint, so they are targeted in growing windows - most of the time the
+        // writes are sent out before a window runs out, without targeting the rest of the batch.
+        // The window is kept across rounds, so batches which keep outgrowing it only start out
+        // small once.
+        //
+
+        const bool bulkTargeting =
+            _clientRequest->getBatchType() == BatchedCommandRequest::BatchType_Insert
+            && !_clientRequest->isInsertIndexRequest();
+
+        TargetedInserts bulkTargeted;
+        vector<int> bulkPositions;
+        size_t bulkTargetedEnd = 0;
+
+        if ( bulkTargeting ) {
+            bulkPositions.resize( numWriteOps, -1 );
+        }
+
         for ( size_t i = 0; i < numWriteOps; ++i ) {
 
             WriteOp& writeOp = _writeOps[i];
@@ -304,7 +363,42 @@ namespace mongo {
             OwnedPointerVector<TargetedWrite> writesOwned;
             vector<TargetedWrite*>& writes = writesOwned.mutableVector();
 
-            Status targetStatus = writeOp.targetWrites( targeter, &writes );
+            Status targetStatus = Status::OK();
+
+            // Position of the write in 'bulkTargeted' if it was targeted there
+            int bulkPos = -1;
+
+            if ( bulkTargeting ) {
+
+                if ( i >= bulkTargetedEnd ) {
+                    bulkTargetedEnd = bulkTargetInserts( targeter,
+                                                         _writeOps,
+                                                         numWriteOps,
+                                                         i,
+                                                         _bulkTargetWindow,
+                                                         &bulkTargeted,
+                                                         &bulkPositions );
+                    _bulkTargetWindow = std::min( _bulkTargetWindow * 2, numWriteOps );
+                }
+
+                dassert( bulkPositions[i] >= 0 );
+                const ShardEndpoint* endpoint = bulkTargeted.endpoints[bulkPositions[i]];
+                targetStatus = bulkTargeted.statuses[bulkPositions[i]];
+
+                if ( targetStatus.isOK() ) {
+                    if ( endpoint ) {
+                        writeOp.targetWrites( *endpoint, &writes );
+                        bulkPos = bulkPositions[i];
+                    }
+                    else {
+                        // Nothing to go on, let the op decide
+                        targetStatus = writeOp.targetWrites( targeter, &writes );
+                    }
+                }
+            }
+            else {
+                targetStatus = writeOp.targetWrites( targeter, &writes );
+            }
 
             if ( !targetStatus.isOK() ) {
 
@@ -372,6 +466,12 @@ namespace mongo {
             // Targeting went ok, add to appropriate TargetedBatch
             //
 
+            if ( bulkPos >= 0 ) {
+                targeter.noteInsertSent( bulkTargeted,
+                                         bulkPos,
+                                         writeOp.getWriteItem().getDocument().objsize() );
+            }
+
             for ( vector<TargetedWrite*>::iterator it = writes.begin(); it != writes.end(); ++it ) {
 
                 TargetedWrite* write = *it;
@@ -169,6 +169,9 @@ namespace mongo {
         // Array of ops being processed from the client request
         WriteOp* _writeOps;
 
+        // How many single document inserts to target in bulk at once, grows as batches outgrow it
+        size_t _bulkTargetWindow;
+
         // Current outstanding batch op write requests
         // Not owned here but tracked for reporting
         std::set<const TargetedWriteBatch*> _targeted;
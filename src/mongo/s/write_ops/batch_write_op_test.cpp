@@ -724,6 +724,65 @@ namespace {
         ASSERT_EQUALS( clientResponse.getN(), 4 );
     }
 
+    TEST(WriteOpTests, MultiOpManyTwoShardsOrdered) {
+
+        //
+        // Multi-op targeting test (ordered) with more inserts to the first shard than are
+        // targeted in bulk at once
+        // There should be one batch to each shard, one-by-one
+        //
+
+        NamespaceString nss( "foo.bar" );
+        ShardEndpoint endpointA( "shardA", ChunkVersion::IGNORED() );
+        ShardEndpoint endpointB( "shardB", ChunkVersion::IGNORED() );
+        MockNSTargeter targeter;
+        initTargeterSplitRange( nss, endpointA, endpointB, &targeter );
+
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+        request.setNS( nss.ns() );
+        request.setOrdered( true );
+        for ( int i = 0; i < 150; ++i ) {
+            request.getInsertRequest()->addToDocuments( BSON( "x" << -1 - i ) );
+        }
+        for ( int i = 0; i < 10; ++i ) {
+            request.getInsertRequest()->addToDocuments( BSON( "x" << 1 + i ) );
+        }
+
+        BatchWriteOp batchOp;
+        batchOp.initClientRequest( &request );
+        ASSERT( !batchOp.isFinished() );
+
+        OwnedPointerVector<TargetedWriteBatch> targetedOwned;
+        vector<TargetedWriteBatch*>& targeted = targetedOwned.mutableVector();
+        Status status = batchOp.targetBatch( targeter, false, &targeted );
+
+        ASSERT( status.isOK() );
+        ASSERT_EQUALS( targeted.size(), 1u );
+        ASSERT_EQUALS( targeted.front()->getWrites().size(), 150u );
+        assertEndpointsEqual( targeted.front()->getEndpoint(), endpointA );
+
+        BatchedCommandResponse response;
+        buildResponse( 150, &response );
+        batchOp.noteBatchResponse( *targeted.front(), response, NULL );
+        ASSERT( !batchOp.isFinished() );
+
+        targetedOwned.clear();
+        status = batchOp.targetBatch( targeter, false, &targeted );
+        ASSERT( status.isOK() );
+        ASSERT_EQUALS( targeted.size(), 1u );
+        ASSERT_EQUALS( targeted.front()->getWrites().size(), 10u );
+        assertEndpointsEqual( targeted.front()->getEndpoint(), endpointB );
+
+        buildResponse( 10, &response );
+        batchOp.noteBatchResponse( *targeted.front(), response, NULL );
+        ASSERT( batchOp.isFinished() );
+
+        BatchedCommandResponse clientResponse;
+        batchOp.buildClientResponse( &clientResponse );
+        ASSERT( clientResponse.getOk() );
+        ASSERT_EQUALS( clientResponse.getN(), 160 );
+    }
+
     TEST(WriteOpTests, MultiOpOneOrTwoShardsOrdered) {
 
         //
@@ -120,28 +120,43 @@ namespace mongo {
 
             ShardEndpoint* endpoint = *it;
 
-            _childOps.push_back( new ChildWriteOp( this ) );
-
-            WriteOpRef ref( _itemRef.getItemIndex(), _childOps.size() - 1 );
-
             // For now, multiple endpoints imply no versioning - we can't retry half a multi-write
             if ( endpoints.size() == 1u ) {
-                targetedWrites->push_back( new TargetedWrite( *endpoint, ref ) );
+                addChildWrite( *endpoint, targetedWrites );
             }
             else {
                 ShardEndpoint broadcastEndpoint( endpoint->shardName,
                                                  ChunkVersion::IGNORED() );
-                targetedWrites->push_back( new TargetedWrite( broadcastEndpoint, ref ) );
+                addChildWrite( broadcastEndpoint, targetedWrites );
             }
-
-            _childOps.back()->pendingWrite = targetedWrites->back();
-            _childOps.back()->state = WriteOpState_Pending;
         }
 
         _state = WriteOpState_Pending;
         return Status::OK();
     }
 
+    void WriteOp::targetWrites( const ShardEndpoint& endpoint,
+                                std::vector<TargetedWrite*>* targetedWrites ) {
+
+        dassert( _itemRef.getOpType() == BatchedCommandRequest::BatchType_Insert );
+        dassert( !_itemRef.getRequest()->isInsertIndexRequest() );
+
+        addChildWrite( endpoint, targetedWrites );
+        _state = WriteOpState_Pending;
+    }
+
+    void WriteOp::addChildWrite( const ShardEndpoint& endpoint,
+                                 std::vector<TargetedWrite*>* targetedWrites ) {
+
+        _childOps.push_back( new ChildWriteOp( this ) );
+
+        WriteOpRef ref( _itemRef.getItemIndex(), _childOps.size() - 1 );
+        targetedWrites->push_back( new TargetedWrite( endpoint, ref ) );
+
+        _childOps.back()->pendingWrite = targetedWrites->back();
+        _childOps.back()->state = WriteOpState_Pending;
+    }
+
     size_t WriteOp::getNumTargeted() {
         return _childOps.size();
     }
@@ -129,6 +129,13 @@ namespace mongo {
         Status targetWrites( const NSTargeter& targeter,
                              std::vector<TargetedWrite*>* targetedWrites );
 
+        /**
+         * Creates the TargetedWrite for a single document insert which was already targeted at
+         * 'endpoint', for example by NSTargeter::targetInserts.
+         */
+        void targetWrites( const ShardEndpoint& endpoint,
+                           std::vector<TargetedWrite*>* targetedWrites );
+
         /**
          * Returns the number of child writes that were last targeted.
          */
@@ -168,6 +175,12 @@ namespace mongo {
 
     private:
 
+        /**
+         * Creates a pending child write and its TargetedWrite for the endpoint.
+         */
+        void addChildWrite( const ShardEndpoint& endpoint,
+                            std::vector<TargetedWrite*>* targetedWrites );
+
         /**
          * Updates the op state after new information is received.
          */
@@ -36,13 +36,16 @@
 
 #include <pcrecpp.h>
 
+#include <algorithm>
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
+#include <cmath>
 #include <iostream>
 
 #include "mongo/db/namespace_string.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/platform/bits.h"
 #include "mongo/scripting/bson_template_evaluator.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/log.h"
@@ -80,6 +83,67 @@ namespace mongo {
     using std::endl;
     using std::map;
 
+    BenchRunLatencyHistogram::BenchRunLatencyHistogram()
+        : _buckets(bucketIndex(kMaxMicros) + 1) {
+        reset();
+    }
+
+    void BenchRunLatencyHistogram::reset() {
+        std::fill(_buckets.begin(), _buckets.end(), 0);
+        _count = 0;
+        _maxMicros = 0;
+    }
+
+    void BenchRunLatencyHistogram::updateFrom(const BenchRunLatencyHistogram &other) {
+        for (size_t i = 0; i < _buckets.size(); ++i)
+            _buckets[i] += other._buckets[i];
+        _count += other._count;
+        if (other._maxMicros > _maxMicros)
+            _maxMicros = other._maxMicros;
+    }
+
+    size_t BenchRunLatencyHistogram::bucketIndex(long long timeMicros) {
+        if (timeMicros < 2 * kSubBucketCount)
+            return timeMicros < 0 ? 0 : static_cast<size_t>(timeMicros);
+        if (timeMicros > kMaxMicros)
+            timeMicros = kMaxMicros;
+
+        // Keep the kSubBucketBits + 1 most significant bits of the value.  The leading one
+        // picks the power of two range, the kSubBucketBits below it the bucket within it.
+        const int highBit = 63 - countLeadingZeros64(timeMicros);
+        const int shift = highBit - kSubBucketBits;
+        const long long subBucket = (timeMicros >> shift) - kSubBucketCount;
+        return static_cast<size_t>(2 * kSubBucketCount + (shift - 1) * kSubBucketCount + subBucket);
+    }
+
+    long long BenchRunLatencyHistogram::bucketHighestMicros(size_t index) {
+        if (index < 2 * kSubBucketCount)
+            return static_cast<long long>(index);
+
+        const long long offset = static_cast<long long>(index) - 2 * kSubBucketCount;
+        const int shift = static_cast<int>(offset / kSubBucketCount) + 1;
+        const long long subBucket = offset % kSubBucketCount + kSubBucketCount;
+        return ((subBucket + 1) << shift) - 1;
+    }
+
+    long long BenchRunLatencyHistogram::getPercentileMicros(double percentile) const {
+        if (_count == 0)
+            return 0;
+
+        unsigned long long target =
+            static_cast<unsigned long long>(std::ceil(percentile / 100.0 * _count));
+        if (target < 1)
+            target = 1;
+
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < _buckets.size(); ++i) {
+            seen += _buckets[i];
+            if (seen >= target)
+                return std::min(bucketHighestMicros(i), _maxMicros);
+        }
+        return _maxMicros;
+    }
+
     BenchRunEventCounter::BenchRunEventCounter() {
         reset();
     }
@@ -89,11 +153,13 @@ namespace mongo {
     void BenchRunEventCounter::reset() {
         _numEvents = 0;
         _totalTimeMicros = 0;
+        _latencies.reset();
     }
 
     void BenchRunEventCounter::updateFrom(const BenchRunEventCounter &other) {
         _numEvents += other._numEvents;
         _totalTimeMicros += other._totalTimeMicros;
+        _latencies.updateFrom(other._latencies);
     }
 
     BenchRunStats::BenchRunStats() {
@@ -156,6 +222,7 @@ namespace mongo {
         throwGLE = false;
         breakOnTrap = true;
         randomSeed = 1314159265358979323;
+        opsPerSecondPerThread = 0;
     }
 
     BenchRunConfig *BenchRunConfig::createFromBson( const BSONObj &args ) {
@@ -192,6 +259,11 @@ namespace mongo {
             this->throwGLE = args["throwGLE"].trueValue();
         if ( ! args["breakOnTrap"].eoo() )
             this->breakOnTrap = args["breakOnTrap"].trueValue();
+        if ( args["opsPerSecondPerThread"].isNumber() ) {
+            this->opsPerSecondPerThread = args["opsPerSecondPerThread"].number();
+            uassert(28804, "opsPerSecondPerThread must not be negative",
+                    this->opsPerSecondPerThread >= 0);
+        }
 
         uassert(16164, "loopCommands config not supported", args["loopCommands"].eoo());
 
@@ -338,11 +410,28 @@ namespace mongo {
         return _brState->shouldWorkerFinish();
     }
 
+    long long BenchRunWorker::waitForNextOp(const Timer &loadTimer, long long opNumber) {
+        if (_config->opsPerSecondPerThread <= 0)
+            return -1;
+
+        const long long opStartMicros =
+            static_cast<long long>(opNumber * 1000000.0 / _config->opsPerSecondPerThread);
+
+        // Sleep in bounded steps so a low rate does not keep the worker from noticing the end of
+        // the run.
+        for (long long now = loadTimer.micros(); now < opStartMicros && !shouldStop();
+             now = loadTimer.micros()) {
+            sleepmicros(std::min(opStartMicros - now, 100 * 1000LL));
+        }
+        return opStartMicros;
+    }
+
     void doNothing(const BSONObj&) { }
 
     void BenchRunWorker::generateLoadOnConnection( DBClientBase* conn ) {
         verify( conn );
         long long count = 0;
+        long long opNumber = 0;
         mongo::Timer timer;
 
         BsonTemplateEvaluator bsonTemplateEvaluator(_randomSeed);
@@ -361,6 +450,11 @@ namespace mongo {
 
                 if ( shouldStop() ) break;
 
+                // In open loop mode every op has a slot in the schedule.  An op which starts late
+                // because earlier ones ran long is charged for the time it spent waiting.
+                const long long opStartMicros = waitForNextOp(timer, opNumber++);
+                if ( shouldStop() ) break;
+
                 BSONElement e = i.next();
 
                 string ns = e["ns"].String();
@@ -409,7 +503,8 @@ namespace mongo {
 
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.findOneCounter);
+                            BenchRunEventTrace _bret(&_stats.findOneCounter,
+                                                     lateMicros(timer, opStartMicros));
                             result = conn->findOne( ns , fixQuery( e["query"].Obj(),
                                                                    bsonTemplateEvaluator ) );
                         }
@@ -464,12 +559,14 @@ namespace mongo {
 
                         // use special query function for exhaust query option
                         if (options & QueryOption_Exhaust) {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter,
+                                                     lateMicros(timer, opStartMicros));
                             stdx::function<void (const BSONObj&)> castedDoNothing(doNothing);
                             count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
                         }
                         else {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter,
+                                                     lateMicros(timer, opStartMicros));
                             cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
                                                  batchSize);
                             count = cursor->itcount();
@@ -505,7 +602,8 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
 
                         {
-                            BenchRunEventTrace _bret(&_stats.updateCounter);
+                            BenchRunEventTrace _bret(&_stats.updateCounter,
+                                                     lateMicros(timer, opStartMicros));
                             BSONObj query = fixQuery(queryOrginal, bsonTemplateEvaluator);
                             BSONObj update = fixQuery(updateOriginal, bsonTemplateEvaluator);
 
@@ -557,7 +655,8 @@ namespace mongo {
                         BSONObj result;
 
                         {
-                            BenchRunEventTrace _bret(&_stats.insertCounter);
+                            BenchRunEventTrace _bret(&_stats.insertCounter,
+                                                     lateMicros(timer, opStartMicros));
 
                             BSONObj insertDoc = fixQuery(e["doc"].Obj(), bsonTemplateEvaluator);
 
@@ -606,7 +705,8 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.deleteCounter);
+                            BenchRunEventTrace _bret(&_stats.deleteCounter,
+                                                     lateMicros(timer, opStartMicros));
                             BSONObj predicate = fixQuery(query, bsonTemplateEvaluator);
                             if (useWriteCmd) {
 
@@ -872,6 +972,22 @@ namespace mongo {
                         static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
      }
 
+     static void appendPercentilesMicrosIfAvailable(
+             BSONObjBuilder &buf, const std::string &name, const BenchRunEventCounter &counter) {
+
+         const BenchRunLatencyHistogram &latencies = counter.getLatencies();
+         if (latencies.getCount() == 0)
+             return;
+
+         BSONObjBuilder percentiles(buf.subobjStart(name));
+         percentiles.appendNumber("p50", latencies.getPercentileMicros(50));
+         percentiles.appendNumber("p95", latencies.getPercentileMicros(95));
+         percentiles.appendNumber("p99", latencies.getPercentileMicros(99));
+         percentiles.appendNumber("p99_9", latencies.getPercentileMicros(99.9));
+         percentiles.appendNumber("max", latencies.getMaxMicros());
+         percentiles.done();
+     }
+
      BSONObj BenchRunner::finish( BenchRunner* runner ) {
 
          runner->stop();
@@ -899,6 +1015,17 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
 
+         appendPercentilesMicrosIfAvailable(
+                 buf, "findOneLatencyPercentilesMicros", stats.findOneCounter);
+         appendPercentilesMicrosIfAvailable(
+                 buf, "insertLatencyPercentilesMicros", stats.insertCounter);
+         appendPercentilesMicrosIfAvailable(
+                 buf, "deleteLatencyPercentilesMicros", stats.deleteCounter);
+         appendPercentilesMicrosIfAvailable(
+                 buf, "updateLatencyPercentilesMicros", stats.updateCounter);
+         appendPercentilesMicrosIfAvailable(
+                 buf, "queryLatencyPercentilesMicros", stats.queryCounter);
+
          {
              BSONObjIterator i( after );
              while ( i.more() ) {
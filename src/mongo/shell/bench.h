@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
@@ -130,11 +131,90 @@ namespace mongo {
         bool throwGLE;
         bool breakOnTrap;
 
+        /**
+         * If positive, each thread schedules its n-th operation from "ops" to start
+         * n/opsPerSecondPerThread seconds into the run, and op latencies are measured from that
+         * intended start time rather than from when the op was actually sent.  Each thread still
+         * runs its ops one at a time: it waits for the intended start time when it is ahead, and
+         * starts the next op right away when it is behind, so the time an op spends waiting
+         * behind slow ones shows up in its latency.
+         *
+         * If zero, each thread starts the next op as soon as the previous one is done, and
+         * latencies are measured from when each op is sent.
+         */
+        double opsPerSecondPerThread;
+
     private:
         /// Initialize a config object to its default values.
         void initializeToDefaults();
     };
 
+    /**
+     * Histogram of event durations in microseconds, in the style of HdrHistogram.
+     *
+     * Durations under 128 microseconds each have their own bucket.  Every larger power of two
+     * range is split into 64 buckets, so values are tracked with a relative error below 1/64.
+     * Durations of kMaxMicros or more all land in the last bucket.
+     *
+     * Not thread safe.  Expected use is one instance per thread during parallel execution.
+     */
+    class BenchRunLatencyHistogram : private boost::noncopyable {
+    public:
+        static const long long kMaxMicros = 1LL << 40;
+
+        /// Constructs an empty histogram.
+        BenchRunLatencyHistogram();
+
+        /**
+         * Forget all recorded values.
+         */
+        void reset();
+
+        /**
+         * Adds the values recorded in "other" to this.
+         */
+        void updateFrom(const BenchRunLatencyHistogram &other);
+
+        /**
+         * Record one event which took "timeMicros" microseconds.
+         */
+        void record(long long timeMicros) {
+            ++_buckets[bucketIndex(timeMicros)];
+            ++_count;
+            if (timeMicros > _maxMicros)
+                _maxMicros = timeMicros;
+        }
+
+        /**
+         * Get the number of microseconds which "percentile" percent of the recorded events took
+         * at most, within the precision of the histogram.  Returns 0 if nothing was recorded.
+         */
+        long long getPercentileMicros(double percentile) const;
+
+        /**
+         * Get the longest recorded duration, exactly.
+         */
+        long long getMaxMicros() const { return _maxMicros; }
+
+        /**
+         * Get the number of recorded events.
+         */
+        unsigned long long getCount() const { return _count; }
+
+    private:
+        static const int kSubBucketBits = 6;
+        static const long long kSubBucketCount = 1LL << kSubBucketBits;
+
+        static size_t bucketIndex(long long timeMicros);
+
+        /// The largest duration which is counted in bucket "index".
+        static long long bucketHighestMicros(size_t index);
+
+        std::vector<unsigned long long> _buckets;
+        unsigned long long _count;
+        long long _maxMicros;
+    };
+
     /**
      * An event counter for events that have an associated duration.
      *
@@ -162,6 +242,7 @@ namespace mongo {
         void countOne(long long timeMicros) {
             ++_numEvents;
             _totalTimeMicros += timeMicros;
+            _latencies.record(timeMicros);
         }
 
         /**
@@ -174,9 +255,15 @@ namespace mongo {
          */
         unsigned long long getNumEvents() const { return _numEvents; }
 
+        /**
+         * Get the distribution of the durations of all observed events.
+         */
+        const BenchRunLatencyHistogram &getLatencies() const { return _latencies; }
+
     private:
         unsigned long long _numEvents;
         long long _totalTimeMicros;
+        BenchRunLatencyHistogram _latencies;
     };
 
     /**
@@ -191,21 +278,27 @@ namespace mongo {
      * event, and otherwise, the succes counter will.
      *
      * In all cases, the counter objects must outlive the trace object.
+     *
+     * If the event should have started earlier than the trace object was constructed, as with
+     * operations which are late in the open loop mode, "lateMicros" is counted in its duration.
      */
     class BenchRunEventTrace : private boost::noncopyable {
     public:
-        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter) {
+        explicit BenchRunEventTrace(BenchRunEventCounter *eventCounter, long long lateMicros = 0)
+            : _lateMicros(lateMicros) {
             initialize(eventCounter, eventCounter, false);
         }
 
         BenchRunEventTrace(BenchRunEventCounter *successCounter,
                            BenchRunEventCounter *failCounter,
-                           bool defaultToFailure=true) {
+                           bool defaultToFailure=true)
+            : _lateMicros(0) {
             initialize(successCounter, failCounter, defaultToFailure);
         }
 
         ~BenchRunEventTrace() {
-            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros());
+            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros() +
+                                                                    _lateMicros);
         }
 
         void succeed() { _succeeded = true; }
@@ -221,6 +314,7 @@ namespace mongo {
         }
 
         Timer _timer;
+        long long _lateMicros;
         BenchRunEventCounter *_successCounter;
         BenchRunEventCounter *_failCounter;
         bool _succeeded;
@@ -355,6 +449,19 @@ namespace mongo {
         /// Predicate, used to decide whether or not it's time to terminate the worker.
         bool shouldStop() const;
 
+        /**
+         * In open loop mode, waits until the next op is due and returns the time at which it was
+         * due, in microseconds since "loadTimer" started.  Returns -1 otherwise.
+         */
+        long long waitForNextOp(const Timer &loadTimer, long long opNumber);
+
+        /**
+         * How late the op due at "opStartMicros" (as returned by waitForNextOp) is running.
+         */
+        static long long lateMicros(const Timer &loadTimer, long long opStartMicros) {
+            return opStartMicros < 0 ? 0 : loadTimer.micros() - opStartMicros;
+        }
+
         size_t _id;
         const BenchRunConfig *_config;
         BenchRunState *_brState;
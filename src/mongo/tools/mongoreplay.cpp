@@ -0,0 +1,491 @@
+/*
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/base/data_view.h"
+#include "mongo/base/initializer.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/tools/mongoreplay_options.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_trace.h"
+#include "mongo/util/quick_exit.h"
+#include "mongo/util/text.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+using namespace mongo;
+using namespace std;
+
+namespace mongo {
+bool inShutdown() { return false; }
+}  // namespace mongo
+
+namespace {
+
+    /**
+     * Latencies of the replayed requests of one kind, in microseconds.
+     */
+    struct LatencyStats {
+        LatencyStats() : errors(0) {}
+
+        void updateFrom(const LatencyStats& other) {
+            latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+            errors += other.errors;
+        }
+
+        vector<long long> latencies;
+        long long errors;
+    };
+
+    typedef map<string, LatencyStats> StatsMap;
+
+    // Most records read ahead for a connection which haven't been replayed yet
+    const size_t kMaxQueuedRecords = 1000;
+
+    stdx::mutex statsMutex;
+    StatsMap totalStats;
+    long long totalMessages = 0;
+    long long totalSkipped = 0;
+    long long maxLagMicros = 0;
+
+    /**
+     * Plays back the messages of one recorded connection over a connection of its own.
+     *
+     * Cursor ids differ between the recording and the replay.  Since traces only hold requests,
+     * a getMore for a cursor id we have not seen before is assumed to continue the oldest cursor
+     * opened by this connection's replayed queries which no getMore has been matched to yet.
+     *
+     * Records are handed over by the thread reading the trace as it goes, and only a few are
+     * queued ahead at a time, so the trace is never held in memory as a whole.
+     */
+    class ConnectionReplayer {
+    public:
+        ConnectionReplayer(unsigned long long traceStartMicros,
+                           unsigned long long replayStartMicros)
+            : _traceStartMicros(traceStartMicros),
+              _replayStartMicros(replayStartMicros),
+              _finished(false),
+              _lastGetMoreCursor(0),
+              _messages(0),
+              _skipped(0),
+              _maxLagMicros(0) {
+        }
+
+        /**
+         * Queues "record" to be replayed, taking over its contents.  Waits while the queue is
+         * full.
+         */
+        void push(MessageTraceRecord* record) {
+            stdx::unique_lock<stdx::mutex> lk(_queueMutex);
+            while (_queue.size() >= kMaxQueuedRecords) {
+                _queueChanged.wait(lk);
+            }
+            _queue.push_back(MessageTraceRecord());
+            std::swap(_queue.back(), *record);
+            _queueChanged.notify_all();
+        }
+
+        /**
+         * Notes that no more records will be pushed.
+         */
+        void finish() {
+            stdx::lock_guard<stdx::mutex> lk(_queueMutex);
+            _finished = true;
+            _queueChanged.notify_all();
+        }
+
+        void run() {
+            string errmsg;
+            const bool connected =
+                _conn.connect(HostAndPort(mongoReplayGlobalParams.host), errmsg);
+            if (!connected) {
+                error() << "couldn't connect to " << mongoReplayGlobalParams.host << ": "
+                        << errmsg;
+            }
+
+            MessageTraceRecord record;
+            while (pop(&record)) {
+                if (!connected) {
+                    // Keep taking records so the reader doesn't wait on us
+                    ++_skipped;
+                    continue;
+                }
+
+                waitUntilDue(record);
+                try {
+                    replay(record);
+                }
+                catch (const DBException& e) {
+                    warning() << "replaying message failed: " << e.what();
+                    ++_skipped;
+                }
+            }
+
+            report();
+        }
+
+    private:
+        /**
+         * Takes the next queued record, waiting for one if needed.  Returns false once all
+         * records were taken.
+         */
+        bool pop(MessageTraceRecord* record) {
+            stdx::unique_lock<stdx::mutex> lk(_queueMutex);
+            while (_queue.empty() && !_finished) {
+                _queueChanged.wait(lk);
+            }
+            if (_queue.empty())
+                return false;
+
+            std::swap(*record, _queue.front());
+            _queue.pop_front();
+            _queueChanged.notify_all();
+            return true;
+        }
+
+        void waitUntilDue(const MessageTraceRecord& record) {
+            if (mongoReplayGlobalParams.speed <= 0)
+                return;
+
+            // Records are replayed in trace order, a few may be stamped before the first one
+            const unsigned long long sinceStartMicros =
+                record.timestampMicros > _traceStartMicros
+                    ? record.timestampMicros - _traceStartMicros : 0;
+            const long long dueMicros = _replayStartMicros + static_cast<long long>(
+                sinceStartMicros / mongoReplayGlobalParams.speed);
+            const long long nowMicros = curTimeMicros64();
+            if (nowMicros < dueMicros) {
+                sleepmicros(dueMicros - nowMicros);
+            }
+            else {
+                _maxLagMicros = std::max(_maxLagMicros, nowMicros - dueMicros);
+            }
+        }
+
+        void replay(const MessageTraceRecord& record) {
+            Message m;
+            record.toMessage(&m);
+
+            const int op = m.operation();
+            string kind;
+            if (op == dbQuery) {
+                DbMessage d(m);
+                kind = NamespaceString(d.getns()).isCommand() ? "command" : "query";
+
+                // Replies to exhaust queries are streamed without further requests, which
+                // would break the one reply per request pattern replay relies on.
+                DataView flags(m.singleData().data());
+                flags.write(LittleEndian<int>(
+                    flags.read<LittleEndian<int>>() & ~QueryOption_Exhaust));
+            }
+            else if (op == dbGetMore) {
+                kind = "getMore";
+                if (!remapGetMore(&m)) {
+                    ++_skipped;
+                    return;
+                }
+            }
+            else if (op == dbKillCursors) {
+                Message remapped;
+                if (!remapKillCursors(m, &remapped)) {
+                    ++_skipped;
+                    return;
+                }
+                _conn.port().say(remapped);
+                ++_messages;
+                return;
+            }
+            else if (op == dbInsert) {
+                kind = "insert";
+            }
+            else if (op == dbUpdate) {
+                kind = "update";
+            }
+            else if (op == dbDelete) {
+                kind = "delete";
+            }
+            else {
+                ++_skipped;
+                return;
+            }
+
+            ++_messages;
+            LatencyStats& stats = _stats[kind];
+
+            if (op != dbQuery && op != dbGetMore) {
+                // Legacy writes have no reply; their latency shows in the getLastError which
+                // usually follows them.
+                _conn.port().say(m);
+                return;
+            }
+
+            Message response;
+            Timer timer;
+            if (!_conn.port().call(m, response)) {
+                ++stats.errors;
+                return;
+            }
+            stats.latencies.push_back(timer.micros());
+
+            QueryResult::View reply = response.singleData().view2ptr();
+            if (reply.getResultFlags() & (ResultFlag_CursorNotFound | ResultFlag_ErrSet)) {
+                ++stats.errors;
+            }
+
+            const long long cursorId = reply.getCursorId();
+            if (op == dbQuery) {
+                if (cursorId != 0)
+                    _unmatchedCursors.push_back(cursorId);
+            }
+            else if (cursorId == 0) {
+                // The cursor is exhausted, further getMores for it can only fail.
+                _cursors.erase(_lastGetMoreCursor);
+            }
+        }
+
+        /**
+         * Returns the replayed cursor id for "recordedId", or 0 if there is none.
+         */
+        long long remapCursor(long long recordedId, bool allowNew) {
+            map<long long, long long>::const_iterator it = _cursors.find(recordedId);
+            if (it != _cursors.end())
+                return it->second;
+            if (!allowNew || _unmatchedCursors.empty())
+                return 0;
+
+            const long long replayedId = _unmatchedCursors.front();
+            _unmatchedCursors.pop_front();
+            _cursors[recordedId] = replayedId;
+            return replayedId;
+        }
+
+        bool remapGetMore(Message* m) {
+            // Layout: int reserved, ns, int nToReturn, long long cursorId.
+            DbMessage d(*m);
+            const size_t cursorOffset = sizeof(int) + strlen(d.getns()) + 1 + sizeof(int);
+            DataView cursor(m->singleData().data() + cursorOffset);
+
+            const long long recordedId = cursor.read<LittleEndian<long long>>();
+            const long long replayedId = remapCursor(recordedId, true);
+            if (replayedId == 0)
+                return false;
+
+            cursor.write(LittleEndian<long long>(replayedId));
+            _lastGetMoreCursor = recordedId;
+            return true;
+        }
+
+        bool remapKillCursors(Message& m, Message* remapped) {
+            DbMessage d(m);
+            const int n = d.pullInt();
+            if (n <= 0)
+                return false;
+            ConstDataView recordedIds(d.getArray(n));
+
+            vector<long long> ids;
+            for (int i = 0; i < n; ++i) {
+                const long long recordedId =
+                    recordedIds.read<LittleEndian<long long>>(i * sizeof(long long));
+                const long long replayedId = remapCursor(recordedId, false);
+                if (replayedId != 0) {
+                    ids.push_back(replayedId);
+                    _cursors.erase(recordedId);
+                }
+            }
+            if (ids.empty())
+                return false;
+
+            BufBuilder b;
+            b.appendNum(0);
+            b.appendNum(static_cast<int>(ids.size()));
+            for (size_t i = 0; i < ids.size(); ++i)
+                b.appendNum(ids[i]);
+            remapped->setData(dbKillCursors, b.buf(), b.len());
+            return true;
+        }
+
+        void report() {
+            stdx::lock_guard<stdx::mutex> lk(statsMutex);
+            for (StatsMap::const_iterator it = _stats.begin(); it != _stats.end(); ++it) {
+                totalStats[it->first].updateFrom(it->second);
+            }
+            totalMessages += _messages;
+            totalSkipped += _skipped;
+            maxLagMicros = std::max(maxLagMicros, _maxLagMicros);
+        }
+
+        const unsigned long long _traceStartMicros;
+        const unsigned long long _replayStartMicros;
+
+        // Records read from the trace which haven't been replayed yet
+        stdx::mutex _queueMutex;
+        stdx::condition_variable _queueChanged;
+        deque<MessageTraceRecord> _queue;
+        bool _finished;
+
+        DBClientConnection _conn;
+        map<long long, long long> _cursors;
+        deque<long long> _unmatchedCursors;
+        long long _lastGetMoreCursor;
+
+        StatsMap _stats;
+        long long _messages;
+        long long _skipped;
+        long long _maxLagMicros;
+    };
+
+    long long percentile(const vector<long long>& sorted, double pct) {
+        size_t rank = static_cast<size_t>(pct / 100 * sorted.size() + 0.5);
+        if (rank > 0)
+            --rank;
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    void printStats() {
+        cout << "replayed " << totalMessages << " messages, skipped " << totalSkipped
+             << ", fell behind schedule by up to " << maxLagMicros / 1000 << "ms" << endl;
+        cout << "latency in microseconds:" << endl;
+        for (StatsMap::iterator it = totalStats.begin(); it != totalStats.end(); ++it) {
+            vector<long long>& latencies = it->second.latencies;
+            cout << "  " << it->first << ": count " << latencies.size()
+                 << " errors " << it->second.errors;
+            if (!latencies.empty()) {
+                std::sort(latencies.begin(), latencies.end());
+                long long total = 0;
+                for (size_t i = 0; i < latencies.size(); ++i)
+                    total += latencies[i];
+                cout << " avg " << total / static_cast<long long>(latencies.size())
+                     << " p50 " << percentile(latencies, 50)
+                     << " p95 " << percentile(latencies, 95)
+                     << " p99 " << percentile(latencies, 99)
+                     << " p99.9 " << percentile(latencies, 99.9)
+                     << " max " << latencies.back();
+            }
+            cout << endl;
+        }
+    }
+
+} // namespace
+
+int toolMain(int argc, char** argv, char** envp) {
+    mongo::runGlobalInitializersOrDie(argc, argv, envp);
+
+    static StaticObserver staticObserver;
+
+    // Connections are replayed by threads of their own, which the trace is handed out to as
+    // it is read.
+    MessageTraceReader reader;
+    Status status = reader.open(mongoReplayGlobalParams.traceFile);
+    if (!status.isOK()) {
+        cerr << status.toString() << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "replaying " << mongoReplayGlobalParams.traceFile << " against "
+         << mongoReplayGlobalParams.host << endl;
+
+    typedef map<long long, boost::shared_ptr<ConnectionReplayer> > ReplayerMap;
+    ReplayerMap replayers;
+    vector<boost::shared_ptr<stdx::thread> > threads;
+
+    unsigned long long traceStartMicros = 0;
+    unsigned long long replayStartMicros = curTimeMicros64();
+    long long records = 0;
+    while (reader.more()) {
+        MessageTraceRecord record;
+        status = reader.next(&record);
+        if (!status.isOK()) {
+            warning() << "stopped reading " << mongoReplayGlobalParams.traceFile << " after "
+                      << records << " messages: " << status.reason();
+            break;
+        }
+
+        // The schedule starts with the first record
+        if (records++ == 0) {
+            traceStartMicros = record.timestampMicros;
+            replayStartMicros = curTimeMicros64();
+        }
+
+        boost::shared_ptr<ConnectionReplayer>& replayer = replayers[record.connectionId];
+        if (!replayer) {
+            replayer.reset(new ConnectionReplayer(traceStartMicros, replayStartMicros));
+            threads.push_back(boost::shared_ptr<stdx::thread>(
+                new stdx::thread(stdx::bind(&ConnectionReplayer::run, replayer.get()))));
+        }
+        replayer->push(&record);
+    }
+
+    for (ReplayerMap::const_iterator it = replayers.begin(); it != replayers.end(); ++it) {
+        it->second->finish();
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->join();
+    }
+
+    cout << "read " << records << " messages over " << replayers.size() << " connections"
+         << endl;
+    cout << "replay took " << (curTimeMicros64() - replayStartMicros) / 1000 << "ms" << endl;
+    printStats();
+    return 0;
+}
+
+#if defined(_WIN32)
+// In Windows, wmain() is an alternate entry point for main(), and receives the same parameters
+// as main() but encoded in Windows Unicode (UTF-16); "wide" 16-bit wchar_t characters.  The
+// WindowsCommandLine object converts these wide character strings to a UTF-8 coded equivalent
+// and makes them available through the argv() and envp() members.  This enables toolMain()
+// to process UTF-8 encoded arguments and environment variables without regard to platform.
+int wmain(int argc, wchar_t* argvW[], wchar_t* envpW[]) {
+    WindowsCommandLine wcl(argc, argvW, envpW);
+    int exitCode = toolMain(argc, wcl.argv(), wcl.envp());
+    quickExit(exitCode);
+}
+#else
+int main(int argc, char* argv[], char** envp) {
+    int exitCode = toolMain(argc, argv, envp);
+    quickExit(exitCode);
+}
+#endif
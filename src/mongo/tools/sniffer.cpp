@@ -67,6 +67,7 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_trace.h"
 #include "mongo/db/storage/mmap_v1/mmap.h"
 #include "mongo/util/quick_exit.h"
 #include "mongo/util/text.h"
@@ -79,6 +80,7 @@ using mongo::BSONObj;
 using mongo::BufBuilder;
 using mongo::DBClientConnection;
 using mongo::MemoryMappedFile;
+using mongo::MessageTraceWriter;
 using std::string;
 
 #define SNAP_LEN 65535
@@ -87,6 +89,7 @@ int captureHeaderSize;
 set<int> serverPorts;
 string forwardAddress;
 bool objcheck = false;
+MessageTraceWriter recorder;
 
 ostream *outPtr = &cout;
 ostream &out() { return *outPtr; }
@@ -169,6 +172,7 @@ map< Connection, unsigned > expectedSeq;
 map< Connection, boost::shared_ptr<DBClientConnection> > forwarder;
 map< Connection, long long > lastCursor;
 map< Connection, map< long long, long long > > mapCursor;
+map< Connection, long long > recordedConnectionId;
 
 void processMessage( Connection& c , Message& d );
 
@@ -256,6 +260,15 @@ void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *pa
         messageBuilder[ c ].reset();
     }
 
+    if ( recorder.isOpen() && serverPorts.count( ntohs( tcp->th_dport ) ) ) {
+        long long &connectionId = recordedConnectionId[ c ];
+        if ( connectionId == 0 )
+            connectionId = recordedConnectionId.size();
+        unsigned long long timestampMicros =
+            header->ts.tv_sec * 1000000ULL + header->ts.tv_usec;
+        recorder.append( connectionId, timestampMicros, m );
+    }
+
     DbMessage d( m );
 
     // inet_ntoa uses statically allocated buffer.
@@ -442,10 +455,12 @@ void processDiagLog( const char * file ) {
 
 void usage() {
     cout <<
-         "Usage: mongosniff [--help] [--forward host:port] [--objcheck] [--source (NET <interface> | (FILE | DIAGLOG) <filename>)] [<port0> <port1> ... ]\n"
+         "Usage: mongosniff [--help] [--forward host:port] [--record <filename>] [--objcheck] [--source (NET <interface> | (FILE | DIAGLOG) <filename>)] [<port0> <port1> ... ]\n"
          "--help          Print this help message.\n"
          "--forward       Forward all parsed request messages to mongod instance at \n"
          "                specified host:port\n"
+         "--record        Write all request messages to a trace file, which can be\n"
+         "                played back with mongoreplay.\n"
          "--source        Source of traffic to sniff, either a network interface or a\n"
          "                file containing previously captured packets in pcap format,\n"
          "                or a file containing output from mongod's --diaglog option.\n"
@@ -498,6 +513,10 @@ int toolMain(int argc, char **argv, char** envp) {
             else if ( arg == string( "--forward" ) ) {
                 forwardAddress = args[ ++i ];
             }
+            else if ( arg == string( "--record" ) ) {
+                uassert( 28805 , "--record needs a file name" , args.size() > i + 1 );
+                mongo::uassertStatusOK( recorder.open( args[ ++i ] ) );
+            }
             else if ( arg == string( "--source" ) ) {
                 uassert( 10266 ,  "can't use --source twice" , source == false );
                 uassert( 10267 ,  "source needs more args" , args.size() > i + 2);
@@ -581,6 +600,10 @@ int toolMain(int argc, char **argv, char** envp) {
 
     pcap_freecode(&fp);
     pcap_close(handle);
+    recorder.close();
+    if ( recorder.getDroppedCount() > 0 ) {
+        cout << "dropped " << recorder.getDroppedCount() << " messages from the trace" << endl;
+    }
 
     return 0;
 }
@@ -0,0 +1,355 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/benchmark.h"
+
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "mongo/bson/json.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace unittest {
+
+    namespace benchmark_detail {
+        void useCharPointer(char const volatile* p) {}
+    } // namespace benchmark_detail
+
+namespace {
+
+    // Never run a benchmark body with more iterations than this.
+    const long long kMaxIterations = 1000LL * 1000 * 1000;
+
+    std::vector<Benchmark::Registration>& registrations() {
+        static std::vector<Benchmark::Registration>* r = new std::vector<Benchmark::Registration>();
+        return *r;
+    }
+
+    struct BenchmarkResult {
+        BenchmarkResult() : iterations(0), bytesPerIteration(0), failed(false) {}
+
+        BSONObj toBSON() const;
+
+        std::string name;
+        long long iterations;
+        long long bytesPerIteration;
+        bool failed;
+        std::string error;
+
+        // Nanoseconds per iteration of each repetition, sorted.
+        std::vector<double> nanos;
+        double mean;
+        double median;
+        double stddev;
+    };
+
+    BSONObj BenchmarkResult::toBSON() const {
+        BSONObjBuilder b;
+        b.append("name", name);
+        if (failed) {
+            b.append("error", error);
+            return b.obj();
+        }
+
+        b.append("iterations", iterations);
+        b.append("repetitions", static_cast<int>(nanos.size()));
+        BSONObjBuilder stats(b.subobjStart("nsPerIteration"));
+        stats.append("mean", mean);
+        stats.append("median", median);
+        stats.append("stddev", stddev);
+        stats.append("min", nanos.front());
+        stats.append("max", nanos.back());
+        stats.done();
+        if (bytesPerIteration > 0) {
+            b.append("mbPerSecond", bytesPerIteration * 1000.0 / median);
+        }
+        return b.obj();
+    }
+
+    /**
+     * Runs a fresh instance of the benchmark for "iterations" iterations.
+     */
+    long long runOnce(const Benchmark::Registration& registration,
+                      long long iterations,
+                      long long* bytesPerIteration) {
+        boost::scoped_ptr<Benchmark> benchmark(registration.make());
+        const long long micros = benchmark->run(iterations);
+        *bytesPerIteration = benchmark->getBytesPerIteration();
+        return micros;
+    }
+
+    /**
+     * Finds an iteration count for which a run takes at least "minMicros", and keeps running
+     * until "warmupMicros" have passed.
+     */
+    long long calibrate(const Benchmark::Registration& registration,
+                        long long minMicros,
+                        long long warmupMicros) {
+        long long bytesPerIteration;
+        long long iterations = 1;
+        long long spentMicros = 0;
+        for (;;) {
+            const long long micros = runOnce(registration, iterations, &bytesPerIteration);
+            spentMicros += micros;
+            if (micros >= minMicros || iterations >= kMaxIterations)
+                break;
+
+            // Aim a bit past the target, but don't grow by more than 10x at once, since the
+            // first runs are the least representative.
+            double factor = micros > 0 ? 1.4 * minMicros / micros : 10;
+            factor = std::max(2.0, std::min(10.0, factor));
+            iterations = std::min(kMaxIterations, static_cast<long long>(iterations * factor));
+        }
+
+        while (spentMicros < warmupMicros) {
+            spentMicros += runOnce(registration, iterations, &bytesPerIteration);
+        }
+        return iterations;
+    }
+
+    BenchmarkResult measure(const Benchmark::Registration& registration,
+                            const BenchmarkOptions& options) {
+        BenchmarkResult result;
+        result.name = registration.fullName();
+        try {
+            result.iterations = calibrate(registration,
+                                          options.minTimeMillis * 1000LL,
+                                          options.warmupMillis * 1000LL);
+
+            for (int i = 0; i < std::max(1, options.repetitions); ++i) {
+                const long long micros =
+                    runOnce(registration, result.iterations, &result.bytesPerIteration);
+                result.nanos.push_back(micros * 1000.0 / result.iterations);
+            }
+        }
+        catch (const std::exception& e) {
+            result.failed = true;
+            result.error = e.what();
+            return result;
+        }
+
+        std::vector<double>& nanos = result.nanos;
+        std::sort(nanos.begin(), nanos.end());
+
+        const size_t n = nanos.size();
+        result.median = n % 2 ? nanos[n / 2] : (nanos[n / 2 - 1] + nanos[n / 2]) / 2;
+
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i)
+            sum += nanos[i];
+        result.mean = sum / n;
+
+        double squares = 0;
+        for (size_t i = 0; i < n; ++i)
+            squares += (nanos[i] - result.mean) * (nanos[i] - result.mean);
+        result.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+
+        return result;
+    }
+
+    /**
+     * Reads the median nanoseconds per iteration of each benchmark from JSON written with
+     * --json.
+     */
+    std::map<std::string, double> readBaseline(const std::string& path) {
+        std::ifstream in(path.c_str());
+        uassert(28806, str::stream() << "couldn't open benchmark baseline " << path, in.good());
+        std::stringstream contents;
+        contents << in.rdbuf();
+
+        std::map<std::string, double> baseline;
+        BSONObj obj = fromjson(contents.str());
+        BSONForEach(e, obj["benchmarks"].Obj()) {
+            BSONObj benchmark = e.Obj();
+            if (benchmark["nsPerIteration"].isABSONObj()) {
+                baseline[benchmark["name"].String()] =
+                    benchmark["nsPerIteration"]["median"].numberDouble();
+            }
+        }
+        return baseline;
+    }
+
+    void printTextHeader() {
+        std::cout << std::left << std::setw(48) << "benchmark" << std::right
+                  << std::setw(12) << "iterations"
+                  << std::setw(14) << "median ns"
+                  << std::setw(14) << "mean ns"
+                  << std::setw(10) << "stddev%"
+                  << std::setw(12) << "MB/s"
+                  << "  vs baseline" << std::endl;
+    }
+
+    void printText(const BenchmarkResult& result, const std::string& comparison) {
+        std::cout << std::left << std::setw(48) << result.name << std::right;
+        if (result.failed) {
+            std::cout << "  FAILED: " << result.error << std::endl;
+            return;
+        }
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::setw(12) << result.iterations
+                  << std::setw(14) << result.median
+                  << std::setw(14) << result.mean
+                  << std::setw(10) << (result.mean > 0 ? 100 * result.stddev / result.mean : 0)
+                  << std::setw(12);
+        if (result.bytesPerIteration > 0)
+            std::cout << result.bytesPerIteration * 1000.0 / result.median;
+        else
+            std::cout << "-";
+        std::cout << "  " << comparison << std::endl;
+    }
+
+}  // namespace
+
+    Benchmark::Benchmark()
+        : _iterations(0),
+          _bytesPerIteration(0),
+          _elapsedMicros(0),
+          _paused(false) {
+    }
+
+    Benchmark::~Benchmark() {}
+
+    void Benchmark::setUp() {}
+
+    void Benchmark::tearDown() {}
+
+    long long Benchmark::run(long long iterations) {
+        _iterations = iterations;
+        setUp();
+        resetTiming();
+        _run();
+        pauseTiming();
+        tearDown();
+        return _elapsedMicros;
+    }
+
+    void Benchmark::resetTiming() {
+        _elapsedMicros = 0;
+        _paused = false;
+        _timer.reset();
+    }
+
+    void Benchmark::pauseTiming() {
+        if (_paused)
+            return;
+        _elapsedMicros += _timer.micros();
+        _paused = true;
+    }
+
+    void Benchmark::resumeTiming() {
+        if (!_paused)
+            return;
+        _paused = false;
+        _timer.reset();
+    }
+
+    void Benchmark::registerBenchmark(const std::string& suiteName,
+                                      const std::string& benchmarkName,
+                                      const Factory& make) {
+        registrations().push_back(Registration(suiteName, benchmarkName, make));
+    }
+
+    const std::vector<Benchmark::Registration>& Benchmark::getRegistrations() {
+        return registrations();
+    }
+
+    int runBenchmarks(const BenchmarkOptions& options) {
+        std::map<std::string, double> baseline;
+        if (!options.baselineFile.empty()) {
+            baseline = readBaseline(options.baselineFile);
+        }
+
+        if (!options.json) {
+            printTextHeader();
+        }
+
+        int failures = 0;
+        int regressions = 0;
+        BSONArrayBuilder results;
+        const std::vector<Benchmark::Registration>& all = Benchmark::getRegistrations();
+        for (size_t i = 0; i < all.size(); ++i) {
+            if (all[i].fullName().find(options.filter) == std::string::npos)
+                continue;
+
+            BenchmarkResult result = measure(all[i], options);
+            if (result.failed)
+                ++failures;
+
+            BSONObjBuilder resultBuilder;
+            resultBuilder.appendElements(result.toBSON());
+
+            std::string comparison;
+            std::map<std::string, double>::const_iterator base = baseline.find(result.name);
+            if (!result.failed && base != baseline.end() && base->second > 0) {
+                const double changePercent = 100 * (result.median - base->second) / base->second;
+                const bool regressed = changePercent > options.regressionPercent;
+                if (regressed)
+                    ++regressions;
+
+                std::stringstream ss;
+                ss << std::showpos << std::fixed << std::setprecision(1) << changePercent << "%"
+                   << (regressed ? " REGRESSION" : "");
+                comparison = ss.str();
+
+                resultBuilder.append("baselineMedian", base->second);
+                resultBuilder.append("changePercent", changePercent);
+                resultBuilder.append("regressed", regressed);
+            }
+
+            if (options.json)
+                results.append(resultBuilder.obj());
+            else
+                printText(result, comparison);
+        }
+
+        if (options.json) {
+            BSONObjBuilder doc;
+            doc.append("benchmarks", results.arr());
+            std::cout << doc.obj().jsonString(Strict, 1) << std::endl;
+        }
+        else if (failures || regressions) {
+            std::cout << failures << " failed, " << regressions << " regressed" << std::endl;
+        }
+
+        return (failures || regressions) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+} // namespace unittest
+} // namespace mongo
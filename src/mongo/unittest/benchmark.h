@@ -0,0 +1,242 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/*
+ * A micro-benchmark framework.
+ *
+ * Benchmarks are declared much like unit tests, and are collected into CppBenchmark build
+ * targets, which run every registered benchmark, or the ones selected with --filter.
+ *
+ * BENCHMARK(BSONBench, IterateFields) {
+ *     BSONObj obj = makeObject();
+ *     resetTiming();
+ *     for (long long i = 0; i < iterations(); ++i) {
+ *         for (BSONObjIterator it(obj); it.more();)
+ *             doNotOptimizeAway(it.next());
+ *     }
+ * }
+ *
+ * The runner picks the iteration count so each run takes at least --minTimeMillis, warms up,
+ * and then reports statistics over several repetitions.  See benchmark_main.cpp for the options.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/util/timer.h"
+
+/**
+ * Declares a benchmark named "BENCHMARK_NAME" within "SUITE_NAME".  The body runs the code under
+ * measurement iterations() times.
+ */
+#define BENCHMARK(SUITE_NAME, BENCHMARK_NAME) \
+    BENCHMARK_F(::mongo::unittest::Benchmark, SUITE_NAME, BENCHMARK_NAME)
+
+/**
+ * Declares a benchmark which uses the fixture class "FIXTURE_NAME", derived from
+ * mongo::unittest::Benchmark.  The fixture's setUp() and tearDown() run outside of the timed
+ * region.
+ */
+#define BENCHMARK_F(FIXTURE_NAME, SUITE_NAME, BENCHMARK_NAME) \
+    class _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) : public FIXTURE_NAME { \
+    private:                                                            \
+        virtual void _run();                                            \
+                                                                        \
+        static const RegistrationAgent<_BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) > \
+            _agent;                                                     \
+    };                                                                  \
+    const ::mongo::unittest::Benchmark::RegistrationAgent<              \
+            _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) >          \
+        _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME)::_agent(#SUITE_NAME, #BENCHMARK_NAME); \
+    void _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME)::_run()
+
+/**
+ * Macro to construct a type name for a benchmark.  Do not use directly.
+ */
+#define _BENCHMARK_TYPE_NAME(SUITE_NAME, BENCHMARK_NAME) \
+    Benchmark__##SUITE_NAME##__##BENCHMARK_NAME
+
+namespace mongo {
+namespace unittest {
+
+    namespace benchmark_detail {
+        void useCharPointer(char const volatile* p);
+    } // namespace benchmark_detail
+
+    /**
+     * Keeps the compiler from optimizing away the computation of "value".
+     */
+    template <typename T>
+    inline void doNotOptimizeAway(const T& value) {
+        benchmark_detail::useCharPointer(&reinterpret_cast<char const volatile&>(value));
+    }
+
+    /**
+     * Base type for benchmarks and their fixtures.
+     */
+    class Benchmark : private boost::noncopyable {
+    public:
+        typedef stdx::function<Benchmark* ()> Factory;
+
+        struct Registration {
+            Registration(const std::string& suite, const std::string& name, const Factory& make)
+                : suite(suite), name(name), make(make) {}
+
+            std::string fullName() const { return suite + "." + name; }
+
+            std::string suite;
+            std::string name;
+            Factory make;
+        };
+
+        Benchmark();
+        virtual ~Benchmark();
+
+        /**
+         * Runs the benchmark body for "iterations" iterations between setUp() and tearDown(),
+         * and returns the timed microseconds.
+         */
+        long long run(long long iterations);
+
+        /**
+         * Bytes processed by one iteration, as set by the benchmark, or 0.
+         */
+        long long getBytesPerIteration() const { return _bytesPerIteration; }
+
+        /**
+         * All the benchmarks linked into this program, in registration order.
+         */
+        static const std::vector<Registration>& getRegistrations();
+
+    protected:
+        /**
+         * Registration agent for adding benchmarks, used by the BENCHMARK macros.
+         */
+        template <typename T>
+        class RegistrationAgent : private boost::noncopyable {
+        public:
+            RegistrationAgent(const std::string& suiteName, const std::string& benchmarkName) {
+                Benchmark::registerBenchmark(suiteName, benchmarkName, &RegistrationAgent::make);
+            }
+
+        private:
+            static Benchmark* make() { return new T(); }
+        };
+
+        /**
+         * Number of times the body should run the code under measurement.
+         */
+        long long iterations() const { return _iterations; }
+
+        /**
+         * Restarts timing, discarding the time spent so far.  For setup inside the body.
+         */
+        void resetTiming();
+
+        /**
+         * Excludes the code between pauseTiming() and resumeTiming() from the measurement.
+         * These are not free, so avoid calling them on every iteration of short loops.
+         */
+        void pauseTiming();
+        void resumeTiming();
+
+        /**
+         * Report throughput as well, given the bytes each iteration processes.
+         */
+        void setBytesPerIteration(long long bytes) { _bytesPerIteration = bytes; }
+
+    private:
+        static void registerBenchmark(const std::string& suiteName,
+                                      const std::string& benchmarkName,
+                                      const Factory& make);
+
+        /**
+         * Called on the benchmark object before each run, not timed.
+         */
+        virtual void setUp();
+
+        /**
+         * Called on the benchmark object after each run, not timed.
+         */
+        virtual void tearDown();
+
+        /**
+         * The benchmark body.
+         */
+        virtual void _run() = 0;
+
+        long long _iterations;
+        long long _bytesPerIteration;
+        Timer _timer;
+        long long _elapsedMicros;
+        bool _paused;
+    };
+
+    struct BenchmarkOptions {
+        BenchmarkOptions()
+            : minTimeMillis(200),
+              warmupMillis(100),
+              repetitions(5),
+              json(false),
+              regressionPercent(10) {
+        }
+
+        // Only run benchmarks whose "Suite.Name" contains this.
+        std::string filter;
+
+        // Each measured run takes at least this long; the iteration count is scaled to match.
+        int minTimeMillis;
+
+        // Run for at least this long before measuring.
+        int warmupMillis;
+
+        // Number of measured runs, the statistics are over these.
+        int repetitions;
+
+        // Print the results as JSON, which can also serve as a baseline for later runs.
+        bool json;
+
+        // JSON results of an earlier run to compare against.
+        std::string baselineFile;
+
+        // A median this much slower than the baseline counts as a regression.
+        double regressionPercent;
+    };
+
+    /**
+     * Runs the registered benchmarks and prints the results to stdout.  Returns the process exit
+     * code, which is non-zero if a benchmark failed or regressed against the baseline.
+     */
+    int runBenchmarks(const BenchmarkOptions& options);
+
+} // namespace unittest
+} // namespace mongo
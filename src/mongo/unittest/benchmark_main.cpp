@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mongo/base/initializer.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/signal_handlers_synchronous.h"
+
+namespace {
+
+    void usage(const char* program) {
+        std::cout <<
+            "Usage: " << program << " [options]\n"
+            "--filter <text>            Only run benchmarks whose Suite.Name contains <text>.\n"
+            "--minTimeMillis <ms>       Minimum duration of each measured run (default 200).\n"
+            "--warmupMillis <ms>        Run for this long before measuring (default 100).\n"
+            "--repetitions <n>          Number of measured runs (default 5).\n"
+            "--json                     Print results as JSON, usable as a baseline.\n"
+            "--baseline <file>          Compare medians with the JSON results in <file>.\n"
+            "--regressionPercent <p>    Slowdown against the baseline which fails the run\n"
+            "                           (default 10).\n"
+            "--list                     List the benchmarks and exit.\n"
+            << std::endl;
+    }
+
+}  // namespace
+
+int main(int argc, char** argv, char** envp) {
+    ::mongo::setupSynchronousSignalHandlers();
+    ::mongo::runGlobalInitializersOrDie(1, argv, envp);
+
+    ::mongo::unittest::BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--help") {
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--list") {
+            const std::vector< ::mongo::unittest::Benchmark::Registration>& all =
+                ::mongo::unittest::Benchmark::getRegistrations();
+            for (size_t j = 0; j < all.size(); ++j)
+                std::cout << all[j].fullName() << std::endl;
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--json") {
+            options.json = true;
+        }
+        else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--minTimeMillis" && hasValue) {
+            options.minTimeMillis = atoi(argv[++i]);
+        }
+        else if (arg == "--warmupMillis" && hasValue) {
+            options.warmupMillis = atoi(argv[++i]);
+        }
+        else if (arg == "--repetitions" && hasValue) {
+            options.repetitions = atoi(argv[++i]);
+        }
+        else if (arg == "--baseline" && hasValue) {
+            options.baselineFile = argv[++i];
+        }
+        else if (arg == "--regressionPercent" && hasValue) {
+            options.regressionPercent = atof(argv[++i]);
+        }
+        else {
+            std::cerr << "unknown or incomplete option " << arg << std::endl;
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return ::mongo::unittest::runBenchmarks(options);
+}
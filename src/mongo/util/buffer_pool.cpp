@@ -0,0 +1,226 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/buffer_pool.h"
+
+#include <boost/thread/tss.hpp>
+#include <cstdlib>
+#include <cstring>
+
+#include "mongo/util/concurrency/sharded_counter.h"
+
+namespace mongo {
+
+    const size_t BufferPool::kMinSize;
+    const size_t BufferPool::kLargeClassSize;
+    const int BufferPool::kMaxBuffersPerClass;
+
+    AtomicUInt32 BufferPool::_enabled;
+
+namespace {
+
+    // Size classes are the powers of two from BufferPool::kMinSize to
+    // BufferPool::kLargeClassSize, then the multiples of BufferPool::kLargeClassSize up to
+    // BufferMaxSize
+    const int kMinClassShift = 9;
+    const int kLargeClassShift = 20;
+    const size_t kMaxClassSize = size_t(1) << 26;
+    const int kNumPowerOfTwoClasses = kLargeClassShift - kMinClassShift + 1;
+    const int kNumClasses =
+        kNumPowerOfTwoClasses + kMaxClassSize / BufferPool::kLargeClassSize - 1;
+
+    AtomicUInt64 maxBytesPerThread(16 * 1024 * 1024);
+    AtomicUInt64 maxBytes(256 * 1024 * 1024);
+
+    ShardedCounter64 acquiredCounter;
+    ShardedCounter64 reusedCounter;
+    ShardedCounter64 returnedCounter;
+    ShardedCounter64 discardedCounter;
+    ShardedCounter64 cachedBytesCounter;
+
+    /**
+     * Returns the size class of a buffer of exactly 'size' bytes, or -1 if that is not a class
+     * size.
+     */
+    int classFor(size_t size) {
+        if (size < BufferPool::kMinSize || size > kMaxClassSize) {
+            return -1;
+        }
+
+        if (size > BufferPool::kLargeClassSize) {
+            if (size % BufferPool::kLargeClassSize != 0) {
+                return -1;
+            }
+            return kNumPowerOfTwoClasses + size / BufferPool::kLargeClassSize - 2;
+        }
+
+        if ((size & (size - 1)) != 0) {
+            return -1;
+        }
+
+        int shift = kMinClassShift;
+        while ((size_t(1) << shift) < size) {
+            shift++;
+        }
+        return shift - kMinClassShift;
+    }
+
+    /**
+     * The buffers cached by one thread, freed when the thread exits.
+     */
+    struct ThreadBufferCache {
+        ThreadBufferCache() : bytes(0) {
+            memset(counts, 0, sizeof(counts));
+        }
+
+        ~ThreadBufferCache() {
+            for (int i = 0; i < kNumClasses; i++) {
+                for (int j = 0; j < counts[i]; j++) {
+                    free(buffers[i][j]);
+                }
+            }
+            cachedBytesCounter.decrement(bytes);
+        }
+
+        void* buffers[kNumClasses][BufferPool::kMaxBuffersPerClass];
+        int counts[kNumClasses];
+        size_t bytes;
+    };
+
+    /**
+     * Returns whether a buffer of 'capacity' bytes fits in 'cache' without going over either the
+     * per thread or the process wide limit.
+     */
+    bool hasRoom(const ThreadBufferCache& cache, size_t capacity) {
+        if (cache.bytes + capacity > maxBytesPerThread.loadRelaxed()) {
+            return false;
+        }
+
+        // The shards of the counter are read one at a time, so the sum may be a little off.
+        const long long cachedBytes = cachedBytesCounter.get();
+        return cachedBytes < 0 ||
+            static_cast<unsigned long long>(cachedBytes) + capacity <= maxBytes.loadRelaxed();
+    }
+
+    // Not a __thread pointer, because buffers may still be released while the thread exits
+    boost::thread_specific_ptr<ThreadBufferCache> threadBufferCache;
+
+} // namespace
+
+    void BufferPool::setEnabled(bool enabled) {
+        _enabled.store(enabled ? 1 : 0);
+    }
+
+    void BufferPool::setMaxBytesPerThread(size_t bytes) {
+        maxBytesPerThread.store(bytes);
+    }
+
+    void BufferPool::setMaxBytes(size_t bytes) {
+        maxBytes.store(bytes);
+    }
+
+    size_t BufferPool::goodSize(size_t size) {
+        if (!isEnabled() || size > kMaxClassSize) {
+            return size;
+        }
+
+        if (size > kLargeClassSize) {
+            return (size + kLargeClassSize - 1) / kLargeClassSize * kLargeClassSize;
+        }
+
+        size_t classSize = kMinSize;
+        while (classSize < size) {
+            classSize *= 2;
+        }
+        return classSize;
+    }
+
+    void* BufferPool::tryAcquire(size_t size) {
+        if (!isEnabled()) {
+            return NULL;
+        }
+
+        const int sizeClass = classFor(size);
+        if (sizeClass < 0) {
+            return NULL;
+        }
+
+        acquiredCounter.increment();
+
+        ThreadBufferCache* cache = threadBufferCache.get();
+        if (!cache || cache->counts[sizeClass] == 0) {
+            return NULL;
+        }
+
+        void* buffer = cache->buffers[sizeClass][--cache->counts[sizeClass]];
+        cache->bytes -= size;
+        cachedBytesCounter.decrement(size);
+        reusedCounter.increment();
+        return buffer;
+    }
+
+    void BufferPool::release(void* buffer, size_t capacity) {
+        if (!buffer) {
+            return;
+        }
+
+        if (isEnabled()) {
+            const int sizeClass = classFor(capacity);
+            if (sizeClass >= 0) {
+                ThreadBufferCache* cache = threadBufferCache.get();
+                if (!cache) {
+                    cache = new ThreadBufferCache();
+                    threadBufferCache.reset(cache);
+                }
+                if (cache->counts[sizeClass] < kMaxBuffersPerClass && hasRoom(*cache, capacity)) {
+                    cache->buffers[sizeClass][cache->counts[sizeClass]++] = buffer;
+                    cache->bytes += capacity;
+                    cachedBytesCounter.increment(capacity);
+                    returnedCounter.increment();
+                    return;
+                }
+            }
+            discardedCounter.increment();
+        }
+
+        free(buffer);
+    }
+
+    BufferPool::Stats BufferPool::getStats() {
+        Stats stats;
+        stats.acquired = acquiredCounter.get();
+        stats.reused = reusedCounter.get();
+        stats.returned = returnedCounter.get();
+        stats.discarded = discardedCounter.get();
+        stats.cachedBytes = cachedBytesCounter.get();
+        return stats;
+    }
+
+} // namespace mongo
@@ -0,0 +1,116 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * Thread local caches of the buffers BufBuilder allocates, so that building replies and BSON
+     * objects does not go back to malloc for every operation, nor realloc the buffer as it grows.
+     *
+     * Buffers come in size classes from kMinSize to BufferMaxSize: powers of two up to
+     * kLargeClassSize, and multiples of kLargeClassSize above it, so that a large buffer is
+     * never rounded up by more than kLargeClassSize. A buffer is cached when it is released,
+     * that is when its BufBuilder is destroyed without decoupling it, or when a Message built
+     * from it is freed, and only if both its thread's cache and the process wide limit have
+     * room.
+     * Buffers are plain malloc allocations, so a buffer that is decoupled and then freed
+     * elsewhere is simply not reused.
+     *
+     * The pool is off by default. While it is off, BufBuilder allocates exactly as before.
+     */
+    class BufferPool {
+    public:
+        // Smallest size class, which is also the default size of a BufBuilder
+        static const size_t kMinSize = 512;
+
+        // Size classes above this are multiples of it rather than powers of two
+        static const size_t kLargeClassSize = 1024 * 1024;
+
+        // Most buffers a thread keeps of any one size class
+        static const int kMaxBuffersPerClass = 4;
+
+        static bool isEnabled() { return _enabled.loadRelaxed(); }
+
+        static void setEnabled(bool enabled);
+
+        /**
+         * Most bytes of buffers each thread keeps. Buffers larger than this are never cached.
+         */
+        static void setMaxBytesPerThread(size_t bytes);
+
+        /**
+         * Most bytes of buffers all threads keep together. Threads check this against
+         * Stats::cachedBytes without synchronizing with each other, so concurrent releases may
+         * overshoot it by a buffer each.
+         */
+        static void setMaxBytes(size_t bytes);
+
+        /**
+         * Returns the size of the allocation that should be made for a buffer of 'size' bytes,
+         * which is its size class while the pool is enabled and 'size' otherwise.
+         */
+        static size_t goodSize(size_t size);
+
+        /**
+         * Returns a cached buffer of exactly 'size' bytes, or NULL when there is none or the
+         * pool is disabled.
+         */
+        static void* tryAcquire(size_t size);
+
+        /**
+         * Returns a buffer of 'capacity' bytes, which was allocated with malloc, to the calling
+         * thread's cache, or frees it if it cannot be cached.
+         */
+        static void release(void* buffer, size_t capacity);
+
+        struct Stats {
+            // Allocations of a size class made while the pool was enabled
+            long long acquired;
+            // Allocations served from a thread's cache
+            long long reused;
+            // Buffers kept in a thread's cache when released
+            long long returned;
+            // Buffers freed when released, because they did not fit in the cache
+            long long discarded;
+            // Total size of the buffers in all of the caches
+            long long cachedBytes;
+        };
+
+        static Stats getStats();
+
+    private:
+        static AtomicUInt32 _enabled;
+    };
+
+} // namespace mongo
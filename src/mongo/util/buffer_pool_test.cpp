@@ -0,0 +1,178 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/util/buffer_pool.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+
+    /**
+     * Enables the pool for the duration of a test.
+     */
+    class BufferPoolEnabled {
+    public:
+        BufferPoolEnabled() {
+            BufferPool::setEnabled(true);
+        }
+
+        ~BufferPoolEnabled() {
+            BufferPool::setEnabled(false);
+        }
+    };
+
+    TEST(BufferPoolTest, DisabledByDefault) {
+        ASSERT_FALSE(BufferPool::isEnabled());
+        ASSERT_EQUALS(1000U, BufferPool::goodSize(1000));
+        ASSERT(BufferPool::tryAcquire(1024) == NULL);
+    }
+
+    TEST(BufferPoolTest, GoodSizeIsASizeClass) {
+        BufferPoolEnabled enabled;
+        ASSERT_EQUALS(BufferPool::kMinSize, BufferPool::goodSize(1));
+        ASSERT_EQUALS(BufferPool::kMinSize, BufferPool::goodSize(BufferPool::kMinSize));
+        ASSERT_EQUALS(1024U, BufferPool::goodSize(BufferPool::kMinSize + 1));
+        ASSERT_EQUALS(BufferPool::kLargeClassSize, BufferPool::goodSize(700 * 1024));
+    }
+
+    TEST(BufferPoolTest, LargeSizeClassesAreMultiplesOfLargeClassSize) {
+        BufferPoolEnabled enabled;
+        const size_t mb = BufferPool::kLargeClassSize;
+        ASSERT_EQUALS(2 * mb, BufferPool::goodSize(mb + 1));
+        ASSERT_EQUALS(5 * mb, BufferPool::goodSize(4 * mb + 528));
+        ASSERT_EQUALS(5 * mb, BufferPool::goodSize(5 * mb));
+        ASSERT_EQUALS(64 * mb, BufferPool::goodSize(63 * mb + 1));
+        ASSERT_EQUALS(64 * mb + 1, BufferPool::goodSize(64 * mb + 1));
+
+        void* buffer = malloc(5 * mb);
+        BufferPool::release(buffer, 5 * mb);
+        ASSERT(BufferPool::tryAcquire(5 * mb) == buffer);
+        free(buffer);
+    }
+
+    TEST(BufferPoolTest, ReleasedBuffersAreReused) {
+        BufferPoolEnabled enabled;
+        const BufferPool::Stats before = BufferPool::getStats();
+
+        void* buffer = malloc(2048);
+        BufferPool::release(buffer, 2048);
+        ASSERT(BufferPool::tryAcquire(2048) == buffer);
+        ASSERT(BufferPool::tryAcquire(2048) == NULL);
+        free(buffer);
+
+        const BufferPool::Stats after = BufferPool::getStats();
+        ASSERT_EQUALS(before.acquired + 2, after.acquired);
+        ASSERT_EQUALS(before.reused + 1, after.reused);
+        ASSERT_EQUALS(before.returned + 1, after.returned);
+        ASSERT_EQUALS(before.cachedBytes, after.cachedBytes);
+    }
+
+    TEST(BufferPoolTest, OnlySizeClassesAreCached) {
+        BufferPoolEnabled enabled;
+        const BufferPool::Stats before = BufferPool::getStats();
+
+        BufferPool::release(malloc(1000), 1000);
+
+        const BufferPool::Stats after = BufferPool::getStats();
+        ASSERT_EQUALS(before.returned, after.returned);
+        ASSERT_EQUALS(before.discarded + 1, after.discarded);
+    }
+
+    TEST(BufferPoolTest, CacheIsBounded) {
+        BufferPoolEnabled enabled;
+        const BufferPool::Stats before = BufferPool::getStats();
+
+        for (int i = 0; i < BufferPool::kMaxBuffersPerClass + 1; i++) {
+            BufferPool::release(malloc(4096), 4096);
+        }
+
+        const BufferPool::Stats after = BufferPool::getStats();
+        ASSERT_EQUALS(before.returned + BufferPool::kMaxBuffersPerClass, after.returned);
+        ASSERT_EQUALS(before.discarded + 1, after.discarded);
+
+        for (int i = 0; i < BufferPool::kMaxBuffersPerClass; i++) {
+            void* buffer = BufferPool::tryAcquire(4096);
+            ASSERT(buffer != NULL);
+            free(buffer);
+        }
+    }
+
+    TEST(BufferPoolTest, CacheIsBoundedForTheProcess) {
+        BufferPoolEnabled enabled;
+        const BufferPool::Stats before = BufferPool::getStats();
+
+        // Room for one more buffer across all threads, well under the per thread limit.
+        BufferPool::setMaxBytes(before.cachedBytes + 4096);
+        BufferPool::release(malloc(4096), 4096);
+        BufferPool::release(malloc(4096), 4096);
+        BufferPool::setMaxBytes(256 * 1024 * 1024);
+
+        const BufferPool::Stats after = BufferPool::getStats();
+        ASSERT_EQUALS(before.returned + 1, after.returned);
+        ASSERT_EQUALS(before.discarded + 1, after.discarded);
+        ASSERT_EQUALS(before.cachedBytes + 4096, after.cachedBytes);
+
+        free(BufferPool::tryAcquire(4096));
+    }
+
+    TEST(BufferPoolTest, BufBuilderReusesItsBuffer) {
+        BufferPoolEnabled enabled;
+
+        const char* first;
+        {
+            BufBuilder bb(600);
+            ASSERT_EQUALS(1024, bb.getSize());
+            bb.appendStr("pooled");
+            first = bb.buf();
+        }
+
+        BufBuilder bb(1000);
+        ASSERT(bb.buf() == first);
+    }
+
+    TEST(BufferPoolTest, BufBuilderGrowsIntoPooledBuffers) {
+        BufferPoolEnabled enabled;
+
+        const char* big;
+        {
+            BufBuilder bb(BufferPool::kMinSize * 4);
+            big = bb.buf();
+        }
+
+        BufBuilder bb;
+        bb.skip(BufferPool::kMinSize * 2 + 1);
+        bb.appendStr("grown");
+        ASSERT(bb.buf() == big);
+        ASSERT_EQUALS(0, strcmp(bb.buf() + BufferPool::kMinSize * 2 + 1, "grown"));
+    }
+
+} // namespace
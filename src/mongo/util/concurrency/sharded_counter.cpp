@@ -0,0 +1,83 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/sharded_counter.h"
+
+#include <boost/thread/tss.hpp>
+
+#include "mongo/config.h"
+
+namespace mongo {
+
+namespace {
+
+    AtomicUInt32 nextCounterShard;
+
+    size_t assignCounterShard() {
+        return nextCounterShard.fetchAndAdd(1) % kCounterShards;
+    }
+
+#if defined(MONGO_CONFIG_HAVE___THREAD)
+    // Slot plus one, so that zero means not yet assigned.
+    __thread size_t threadCounterShard;
+#elif defined(MONGO_CONFIG_HAVE___DECLSPEC_THREAD)
+    __declspec( thread ) size_t threadCounterShard;
+#endif
+
+} // namespace
+
+#if defined(MONGO_CONFIG_HAVE___THREAD) || defined(MONGO_CONFIG_HAVE___DECLSPEC_THREAD)
+    size_t getCounterShardForThread() {
+        if (MONGO_unlikely(threadCounterShard == 0)) {
+            threadCounterShard = assignCounterShard() + 1;
+        }
+        return threadCounterShard - 1;
+    }
+#else
+    size_t getCounterShardForThread() {
+        static boost::thread_specific_ptr<size_t> shard;
+        size_t* s = shard.get();
+        if (!s) {
+            s = new size_t(assignCounterShard());
+            shard.reset(s);
+        }
+        return *s;
+    }
+#endif
+
+    long long ShardedCounter64::get() const {
+        long long total = 0;
+        for (size_t i = 0; i < kCounterShards; ++i) {
+            total += _shards[i].value.loadRelaxed();
+        }
+        return total;
+    }
+
+} // namespace mongo
@@ -0,0 +1,81 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/compiler.h"
+
+namespace mongo {
+
+    /**
+     * Number of slots a ShardedCounter64 spreads its value over.
+     */
+    const size_t kCounterShards = 64;
+
+    /**
+     * Returns the counter slot of the calling thread, in [0, kCounterShards).  Threads are handed
+     * slots round robin the first time they ask, so up to kCounterShards threads never share one.
+     */
+    size_t getCounterShardForThread();
+
+    /**
+     * A 64bit counter for statistics bumped by many threads at once.
+     *
+     * Each thread increments its own cache line sized slot and readers add up all of the slots,
+     * so increments don't bounce a shared cache line between cores.  Reads are more expensive
+     * than for Counter64 and, when racing with increments, are not a point in time snapshot.
+     */
+    class ShardedCounter64 {
+    public:
+        void increment(long long n = 1) {
+            _shards[getCounterShardForThread()].value.fetchAndAdd(n);
+        }
+
+        void decrement(long long n = 1) {
+            _shards[getCounterShardForThread()].value.fetchAndSubtract(n);
+        }
+
+        /**
+         * Sum of all of the slots.
+         */
+        long long get() const;
+
+        operator long long() const { return get(); }
+
+    private:
+        struct MONGO_COMPILER_ALIGN_TYPE(64) Shard {
+            AtomicInt64 value;
+        };
+
+        Shard _shards[kCounterShards];
+    };
+
+} // namespace mongo
@@ -0,0 +1,103 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+#include <set>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/sharded_counter.h"
+
+namespace {
+
+    using mongo::ShardedCounter64;
+    using mongo::kCounterShards;
+
+    TEST(ShardedCounter64, StartsAtZero) {
+        ShardedCounter64 counter;
+        ASSERT_EQUALS(0, counter.get());
+    }
+
+    TEST(ShardedCounter64, IncrementAndDecrement) {
+        ShardedCounter64 counter;
+        counter.increment();
+        counter.increment(10);
+        counter.decrement(3);
+        ASSERT_EQUALS(8, counter.get());
+        ASSERT_EQUALS(8, static_cast<long long>(counter));
+    }
+
+    TEST(ShardedCounter64, ShardIsStablePerThread) {
+        const size_t shard = mongo::getCounterShardForThread();
+        ASSERT_LESS_THAN(shard, kCounterShards);
+        ASSERT_EQUALS(shard, mongo::getCounterShardForThread());
+    }
+
+    void incrementMany(ShardedCounter64* counter, int increments) {
+        for (int i = 0; i < increments; ++i) {
+            counter->increment();
+        }
+    }
+
+    TEST(ShardedCounter64, ConcurrentIncrements) {
+        ShardedCounter64 counter;
+
+        const int threads = 2 * kCounterShards;
+        const int increments = 10000;
+        boost::thread* workers[threads];
+        for (int i = 0; i < threads; i++) {
+            workers[i] = new boost::thread(mongo::stdx::bind(&incrementMany, &counter, increments));
+        }
+        for (int i = 0; i < threads; i++) {
+            workers[i]->join();
+            delete workers[i];
+        }
+
+        ASSERT_EQUALS(static_cast<long long>(threads) * increments, counter.get());
+    }
+
+    void recordShard(mongo::stdx::mutex* mutex, std::set<size_t>* shards) {
+        const size_t shard = mongo::getCounterShardForThread();
+        mongo::stdx::lock_guard<mongo::stdx::mutex> lk(*mutex);
+        shards->insert(shard);
+    }
+
+    TEST(ShardedCounter64, ThreadsGetDifferentShards) {
+        mongo::stdx::mutex mutex;
+        std::set<size_t> shards;
+        boost::thread a(mongo::stdx::bind(&recordShard, &mutex, &shards));
+        a.join();
+        boost::thread b(mongo::stdx::bind(&recordShard, &mutex, &shards));
+        b.join();
+        ASSERT_EQUALS(2U, shards.size());
+    }
+
+} // namespace
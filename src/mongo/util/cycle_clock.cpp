@@ -0,0 +1,72 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/cycle_clock.h"
+
+#include "mongo/base/init.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+#if defined(MONGO_CYCLE_CLOCK_RDTSC)
+    // Zero until calibrated, so nothing is reported rather than something wrong.
+    double CycleClock::_microsPerTick = 0;
+#else
+    double CycleClock::_microsPerTick = 1;
+#endif
+
+    int64_t CycleClock::_nowFallback() {
+        static const Timer sinceFirstUse;
+        return sinceFirstUse.micros();
+    }
+
+    void CycleClock::calibrate() {
+#if defined(MONGO_CYCLE_CLOCK_RDTSC)
+        const long long kCalibrationMicros = 5000;
+
+        Timer timer;
+        const int64_t startTicks = now();
+        long long elapsedMicros;
+        while ((elapsedMicros = timer.micros()) < kCalibrationMicros) {
+        }
+        const int64_t ticks = now() - startTicks;
+
+        if (ticks > 0) {
+            _microsPerTick = static_cast<double>(elapsedMicros) / ticks;
+        }
+#endif
+    }
+
+    MONGO_INITIALIZER(CycleClockCalibration)(InitializerContext* context) {
+        CycleClock::calibrate();
+        return Status::OK();
+    }
+
+} // namespace mongo
@@ -0,0 +1,77 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include "mongo/platform/cstdint.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MONGO_CYCLE_CLOCK_RDTSC
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define MONGO_CYCLE_CLOCK_RDTSC
+#endif
+
+namespace mongo {
+
+    /**
+     * A cheap monotonic tick source for timing short stretches of an operation, such as time
+     * spent in the storage engine, on paths where Timer and curTimeMicros64() cost too much to
+     * call several times per operation.
+     *
+     * On x86 this reads the time stamp counter, whose rate is calibrated against Timer at
+     * startup.  Elsewhere ticks are microseconds from Timer.  Ticks only mean something as the
+     * difference between two readings.
+     */
+    class CycleClock {
+    public:
+        static int64_t now() {
+#if defined(MONGO_CYCLE_CLOCK_RDTSC)
+            return static_cast<int64_t>(__rdtsc());
+#else
+            return _nowFallback();
+#endif
+        }
+
+        static int64_t toMicros(int64_t ticks) {
+            return static_cast<int64_t>(ticks * _microsPerTick);
+        }
+
+        /**
+         * Measures the tick rate.  Runs once at startup, from an initializer.
+         */
+        static void calibrate();
+
+    private:
+        static int64_t _nowFallback();
+
+        static double _microsPerTick;
+    };
+
+} // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/base/data_type_endian.h"
 #include "mongo/base/data_view.h"
 #include "mongo/base/encoded_value_storage.h"
+#include "mongo/util/buffer_pool.h"
 #include "mongo/util/allocator.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/hostandport.h"
@@ -329,12 +330,12 @@ namespace mongo {
     class Message {
     public:
         // we assume here that a vector with initial size 0 does no allocation (0 is the default, but wanted to make it explicit).
-        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ) {}
+        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ), _bufCapacity( 0 ) {}
         Message( void * data , bool freeIt ) :
-            _buf( 0 ), _data( 0 ), _freeIt( false ) {
+            _buf( 0 ), _data( 0 ), _freeIt( false ), _bufCapacity( 0 ) {
             _setData( reinterpret_cast< char* >( data ), freeIt );
         };
-        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ) {
+        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ), _bufCapacity( 0 ) {
             *this = r;
         }
         ~Message() {
@@ -402,6 +403,8 @@ namespace mongo {
             verify( r._freeIt );
             _buf = r._buf;
             r._buf = 0;
+            _bufCapacity = r._bufCapacity;
+            r._bufCapacity = 0;
             if ( r._data.size() > 0 ) {
                 _data.swap( r._data );
             }
@@ -413,7 +416,12 @@ namespace mongo {
         void reset() {
             if ( _freeIt ) {
                 if ( _buf ) {
-                    free( _buf );
+                    if ( _bufCapacity ) {
+                        BufferPool::release( _buf, _bufCapacity );
+                    }
+                    else {
+                        free( _buf );
+                    }
                 }
                 for (std::vector< std::pair< char *, int > >::const_iterator i = _data.begin();
                      i != _data.end(); ++i) {
@@ -421,6 +429,7 @@ namespace mongo {
                 }
             }
             _buf = 0;
+            _bufCapacity = 0;
             _data.clear();
             _freeIt = false;
         }
@@ -441,6 +450,8 @@ namespace mongo {
             if ( _buf ) {
                 _data.push_back(std::make_pair(_buf, MsgData::ConstView(_buf).getLen()));
                 _buf = 0;
+                // The buffers in _data are freed with free()
+                _bufCapacity = 0;
             }
             _data.push_back(std::make_pair(d, size));
             header().setLen(header().getLen() + size);
@@ -451,6 +462,15 @@ namespace mongo {
             verify( empty() );
             _setData( d, freeIt );
         }
+        /**
+         * Like setData(d, true), for a buffer of 'capacity' bytes that was decoupled from a
+         * BufBuilder. The buffer goes back to the thread's BufferPool when the message is freed.
+         */
+        void setPooledData(char* d, int capacity) {
+            verify( empty() );
+            _setData( d, true );
+            _bufCapacity = capacity;
+        }
         void setData(int operation, const char *msgtxt) {
             setData(operation, msgtxt, strlen(msgtxt)+1);
         }
@@ -483,6 +503,8 @@ namespace mongo {
         typedef std::vector< std::pair< char*, int > > MsgVec;
         MsgVec _data;
         bool _freeIt;
+        // Size of _buf if it may be returned to the BufferPool, zero to free() it
+        size_t _bufCapacity;
     };
 
 
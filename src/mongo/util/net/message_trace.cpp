@@ -0,0 +1,259 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_trace.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <cstring>
+
+#include "mongo/base/data_view.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+namespace {
+
+    const char kTraceMagic[] = "MDBTRACE";
+    const size_t kTraceMagicSize = sizeof(kTraceMagic) - 1;
+    const int kTraceVersion = 1;
+
+    // Timestamp and connection id.
+    const size_t kRecordHeaderSize = 16;
+
+    // Messages are never larger than this, so anything bigger means the trace is corrupt.
+    const int kMaxTracedMessageSize = 2 * MaxMessageSizeBytes;
+
+}  // namespace
+
+    void MessageTraceRecord::toMessage(Message* m) const {
+        char* buf = static_cast<char*>(mongoMalloc(data.size()));
+        memcpy(buf, data.data(), data.size());
+        m->setData(buf, true);
+    }
+
+    MessageTraceWriter::MessageTraceWriter(size_t maxQueuedBytes)
+        : _maxQueuedBytes(maxQueuedBytes),
+          _closing(false),
+          _queuedBytes(0),
+          _dropped(0) {
+    }
+
+    MessageTraceWriter::~MessageTraceWriter() {
+        close();
+    }
+
+    Status MessageTraceWriter::open(const std::string& path) {
+        stdx::lock_guard<stdx::mutex> openCloseLk(_openCloseMutex);
+        if (boost::filesystem::exists(path)) {
+            return Status(ErrorCodes::IllegalOperation,
+                          str::stream() << "message trace " << path << " already exists");
+        }
+
+        std::ofstream out(path.c_str(), std::ios::out | std::ios::binary);
+        if (!out.is_open()) {
+            return Status(ErrorCodes::FileNotOpen,
+                          str::stream() << "couldn't open message trace " << path);
+        }
+
+        char header[kTraceMagicSize + sizeof(int)];
+        memcpy(header, kTraceMagic, kTraceMagicSize);
+        DataView(header).write(LittleEndian<int>(kTraceVersion), kTraceMagicSize);
+        out.write(header, sizeof(header));
+        if (!out.good()) {
+            return Status(ErrorCodes::FileStreamFailed,
+                          str::stream() << "couldn't write message trace " << path);
+        }
+
+        // Replace the previous trace only once the new one is ready
+        _close();
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _out.swap(out);
+        _path = path;
+        _closing = false;
+        _dropped = 0;
+        _writer.reset(new stdx::thread(stdx::bind(&MessageTraceWriter::_writeQueued, this)));
+        _isOpen.store(1);
+        return Status::OK();
+    }
+
+    void MessageTraceWriter::close() {
+        stdx::lock_guard<stdx::mutex> openCloseLk(_openCloseMutex);
+        _close();
+    }
+
+    void MessageTraceWriter::_close() {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (!_writer)
+                return;
+            _isOpen.store(0);
+            _closing = true;
+            _queueChanged.notify_one();
+        }
+
+        // The writer drains the queue before it exits
+        _writer->join();
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _writer.reset();
+        _out.close();
+        _path.clear();
+    }
+
+    std::string MessageTraceWriter::getPath() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _path;
+    }
+
+    long long MessageTraceWriter::getDroppedCount() const {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _dropped;
+    }
+
+    void MessageTraceWriter::append(long long connectionId,
+                                    unsigned long long timestampMicros,
+                                    const Message& m) {
+        MsgData::View data = m.singleData();
+
+        std::string record(kRecordHeaderSize + data.getLen(), '\0');
+        DataView(&record[0])
+            .write(LittleEndian<unsigned long long>(timestampMicros))
+            .write(LittleEndian<long long>(connectionId), sizeof(long long));
+        memcpy(&record[kRecordHeaderSize], data.view2ptr(), data.getLen());
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_isOpen.loadRelaxed())
+            return;
+
+        if (_queuedBytes + record.size() > _maxQueuedBytes) {
+            ++_dropped;
+            return;
+        }
+
+        _queuedBytes += record.size();
+        _queue.push_back(std::string());
+        _queue.back().swap(record);
+        _queueChanged.notify_one();
+    }
+
+    void MessageTraceWriter::_writeQueued() {
+        std::deque<std::string> writing;
+
+        while (true) {
+            {
+                stdx::unique_lock<stdx::mutex> lk(_mutex);
+                while (_queue.empty() && !_closing) {
+                    _queueChanged.wait(lk);
+                }
+
+                if (_queue.empty())
+                    return;
+
+                writing.swap(_queue);
+                _queuedBytes = 0;
+            }
+
+            // Only this thread touches the stream while the trace is open
+            for (std::deque<std::string>::const_iterator it = writing.begin();
+                 it != writing.end() && _out.good(); ++it) {
+                _out.write(it->data(), it->size());
+            }
+            writing.clear();
+            _out.flush();
+
+            if (!_out.good()) {
+                // Stop tracing rather than leave a torn record at the end of the file.
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _isOpen.store(0);
+                _queue.clear();
+                _queuedBytes = 0;
+                return;
+            }
+        }
+    }
+
+    Status MessageTraceReader::open(const std::string& path) {
+        _in.open(path.c_str(), std::ios::in | std::ios::binary);
+        if (!_in.is_open()) {
+            return Status(ErrorCodes::FileNotOpen,
+                          str::stream() << "couldn't open message trace " << path);
+        }
+
+        char header[kTraceMagicSize + sizeof(int)];
+        _in.read(header, sizeof(header));
+        if (!_in.good() || memcmp(header, kTraceMagic, kTraceMagicSize) != 0) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << path << " is not a message trace");
+        }
+
+        const int version = ConstDataView(header).read<LittleEndian<int>>(kTraceMagicSize);
+        if (version != kTraceVersion) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << "unsupported message trace version " << version
+                                        << " in " << path);
+        }
+        return Status::OK();
+    }
+
+    bool MessageTraceReader::more() {
+        return _in.good() && _in.peek() != std::ifstream::traits_type::eof();
+    }
+
+    Status MessageTraceReader::next(MessageTraceRecord* record) {
+        char header[kRecordHeaderSize + sizeof(int)];
+        _in.read(header, sizeof(header));
+        if (!_in.good()) {
+            return Status(ErrorCodes::FailedToParse, "truncated message trace record");
+        }
+
+        ConstDataView headerView(header);
+        record->timestampMicros = headerView.read<LittleEndian<unsigned long long>>();
+        record->connectionId = headerView.read<LittleEndian<long long>>(sizeof(long long));
+
+        const int len = headerView.read<LittleEndian<int>>(kRecordHeaderSize);
+        if (len < static_cast<int>(sizeof(MSGHEADER::Value)) || len > kMaxTracedMessageSize) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << "invalid message length " << len
+                                        << " in message trace");
+        }
+
+        record->data.resize(len);
+        memcpy(&record->data[0], header + kRecordHeaderSize, sizeof(int));
+        _in.read(&record->data[sizeof(int)], len - sizeof(int));
+        if (!_in.good()) {
+            return Status(ErrorCodes::FailedToParse, "truncated message in message trace");
+        }
+        return Status::OK();
+    }
+
+} // namespace mongo
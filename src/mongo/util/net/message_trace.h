@@ -0,0 +1,179 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <deque>
+#include <fstream>
+#include <string>
+
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+
+namespace mongo {
+
+    class Message;
+
+    /**
+     * A message trace is a binary file of wire protocol messages, each tagged with the id of the
+     * connection it came in on and the time it arrived.  Traces are recorded by mongod (see the
+     * trafficTrace command) or by mongosniff, and played back against a server by mongoreplay.
+     *
+     * The file starts with the 8 byte magic string "MDBTRACE" and a 4 byte little endian format
+     * version.  Each record after that is a little endian 8 byte timestamp in microseconds since
+     * the epoch, a little endian 8 byte connection id and the message itself, whose first 4 bytes
+     * hold its length.
+     */
+    struct MessageTraceRecord {
+        MessageTraceRecord() : timestampMicros(0), connectionId(0) {}
+
+        /**
+         * Copies the recorded message into "m", which must be empty.
+         */
+        void toMessage(Message* m) const;
+
+        unsigned long long timestampMicros;
+        long long connectionId;
+        std::string data;
+    };
+
+    /**
+     * Appends messages to a trace file.  All methods are thread safe.
+     *
+     * Messages are queued in memory and written out by a background thread, so recording never
+     * waits on the disk.  If the disk can't keep up and the queue fills up, further messages are
+     * dropped and counted until there is room again.
+     */
+    class MessageTraceWriter : private boost::noncopyable {
+    public:
+        // Default limit on the bytes of messages waiting to be written
+        static const size_t kDefaultMaxQueuedBytes = 64 * 1024 * 1024;
+
+        explicit MessageTraceWriter(size_t maxQueuedBytes = kDefaultMaxQueuedBytes);
+        ~MessageTraceWriter();
+
+        /**
+         * Starts a new trace at "path", closing the trace which was open before, if any.  Fails
+         * if a file already exists at "path".
+         */
+        Status open(const std::string& path);
+
+        /**
+         * Writes out the queued messages and closes the trace.  No-op if no trace is open.
+         */
+        void close();
+
+        /**
+         * Cheap check for whether messages should be appended at all.
+         */
+        bool isOpen() const { return _isOpen.loadRelaxed() != 0; }
+
+        /**
+         * Returns the path of the open trace, or an empty string.
+         */
+        std::string getPath() const;
+
+        /**
+         * Returns how many messages were dropped from the current or last trace because the
+         * queue was full.
+         */
+        long long getDroppedCount() const;
+
+        /**
+         * Queues "m", as received on "connectionId" at "timestampMicros", to be written to the
+         * trace.  Ignored if no trace is open, and dropped if the queue is full.  The trace is
+         * closed if writing fails.
+         */
+        void append(long long connectionId, unsigned long long timestampMicros, const Message& m);
+
+    private:
+        /**
+         * Stops the background thread once it has written the queue, and closes the trace.
+         * Caller must hold _openCloseMutex.
+         */
+        void _close();
+
+        /**
+         * Body of the background thread, writes queued records until the trace is closed.
+         */
+        void _writeQueued();
+
+        const size_t _maxQueuedBytes;
+
+        // Serializes open and close
+        stdx::mutex _openCloseMutex;
+
+        // Protects everything below
+        mutable stdx::mutex _mutex;
+
+        // Signalled when records are queued or the trace is closing
+        stdx::condition_variable _queueChanged;
+
+        AtomicUInt32 _isOpen;
+        bool _closing;
+        std::ofstream _out;
+        std::string _path;
+
+        // Records waiting to be written, and their total size
+        std::deque<std::string> _queue;
+        size_t _queuedBytes;
+        long long _dropped;
+
+        boost::scoped_ptr<stdx::thread> _writer;
+    };
+
+    /**
+     * Reads the records of a trace file in order.
+     */
+    class MessageTraceReader : private boost::noncopyable {
+    public:
+        /**
+         * Opens the trace at "path" and checks its header.
+         */
+        Status open(const std::string& path);
+
+        /**
+         * Returns whether any records are left to read.
+         */
+        bool more();
+
+        /**
+         * Reads the next record into "record".  Fails if the trace is truncated or corrupt.
+         */
+        Status next(MessageTraceRecord* record);
+
+    private:
+        std::ifstream _in;
+    };
+
+} // namespace mongo
@@ -0,0 +1,136 @@
+/*    Copyright 2015 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_trace.h"
+
+#include <fstream>
+#include <iterator>
+
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+
+namespace {
+
+    using mongo::Message;
+    using mongo::MessageTraceReader;
+    using mongo::MessageTraceRecord;
+    using mongo::MessageTraceWriter;
+    using mongo::unittest::TempDir;
+
+    TEST(MessageTrace, RoundTrip) {
+        TempDir tempDir("messageTraceTests");
+        const std::string path = tempDir.path() + "/trace";
+
+        MessageTraceWriter writer;
+        ASSERT_FALSE(writer.isOpen());
+        ASSERT_OK(writer.open(path));
+        ASSERT_TRUE(writer.isOpen());
+        ASSERT_EQUALS(path, writer.getPath());
+
+        Message first;
+        first.setData(mongo::dbQuery, "first");
+        Message second;
+        second.setData(mongo::dbInsert, "second message");
+        writer.append(7, 1000, first);
+        writer.append(9, 2500, second);
+        writer.close();
+        ASSERT_FALSE(writer.isOpen());
+
+        // Appending to a closed trace is a no-op.
+        writer.append(11, 3000, first);
+
+        MessageTraceReader reader;
+        ASSERT_OK(reader.open(path));
+
+        MessageTraceRecord record;
+        ASSERT_TRUE(reader.more());
+        ASSERT_OK(reader.next(&record));
+        ASSERT_EQUALS(1000ULL, record.timestampMicros);
+        ASSERT_EQUALS(7LL, record.connectionId);
+        ASSERT_EQUALS(static_cast<size_t>(first.size()), record.data.size());
+
+        Message replayed;
+        record.toMessage(&replayed);
+        ASSERT_EQUALS(mongo::dbQuery, replayed.operation());
+        ASSERT_EQUALS(std::string("first"), std::string(replayed.singleData().data()));
+
+        ASSERT_TRUE(reader.more());
+        ASSERT_OK(reader.next(&record));
+        ASSERT_EQUALS(2500ULL, record.timestampMicros);
+        ASSERT_EQUALS(9LL, record.connectionId);
+        ASSERT_EQUALS(static_cast<size_t>(second.size()), record.data.size());
+
+        ASSERT_FALSE(reader.more());
+    }
+
+    TEST(MessageTrace, RejectsOtherFiles) {
+        TempDir tempDir("messageTraceTests");
+        const std::string path = tempDir.path() + "/notATrace";
+        {
+            std::ofstream out(path.c_str());
+            out << "this is not a message trace";
+        }
+
+        MessageTraceReader reader;
+        ASSERT_NOT_OK(reader.open(path));
+    }
+
+    TEST(MessageTrace, DetectsTruncatedRecord) {
+        TempDir tempDir("messageTraceTests");
+        const std::string path = tempDir.path() + "/trace";
+
+        MessageTraceWriter writer;
+        ASSERT_OK(writer.open(path));
+        Message m;
+        m.setData(mongo::dbQuery, "a message which will be cut short");
+        writer.append(1, 1, m);
+        writer.close();
+
+        // Copy all but the last few bytes of the trace.
+        std::string contents;
+        {
+            std::ifstream in(path.c_str(), std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        const std::string truncatedPath = path + ".truncated";
+        {
+            std::ofstream out(truncatedPath.c_str(), std::ios::binary);
+            out.write(contents.data(), contents.size() - 4);
+        }
+
+        MessageTraceReader reader;
+        ASSERT_OK(reader.open(truncatedPath));
+        ASSERT_TRUE(reader.more());
+        MessageTraceRecord record;
+        ASSERT_NOT_OK(reader.next(&record));
+    }
+
+} // namespace
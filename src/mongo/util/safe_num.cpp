@@ -57,6 +57,22 @@ namespace mongo {
         }
     }
 
+    bool SafeNum::appendTo(StringData fieldName, BSONObjBuilder* builder) const {
+        switch (_type) {
+        case NumberInt:
+            builder->append(fieldName, _value.int32Val);
+            return true;
+        case NumberLong:
+            builder->append(fieldName, _value.int64Val);
+            return true;
+        case NumberDouble:
+            builder->append(fieldName, _value.doubleVal);
+            return true;
+        default:
+            return false;
+        }
+    }
+
     std::string SafeNum::debugString() const {
         ostringstream os;
         switch (_type) {
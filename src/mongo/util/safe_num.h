@@ -151,7 +151,11 @@ namespace mutablebson {
         friend class mutablebson::Element;
         friend class mutablebson::Document;
 
-        // TODO: output to builder
+        /**
+         * Appends the value to 'builder' as 'fieldName'. Returns false, and appends nothing,
+         * if this is an EOO-typed instance.
+         */
+        bool appendTo(StringData fieldName, BSONObjBuilder* builder) const;
 
         //
         // accessors
@@ -49,6 +49,18 @@ namespace {
         ASSERT_EQUALS(numDouble.type(), mongo::NumberDouble);
     }
 
+    TEST(Basics, AppendTo) {
+        mongo::BSONObjBuilder bob;
+        ASSERT_TRUE(SafeNum(1).appendTo("a", &bob));
+        ASSERT_TRUE(SafeNum(2LL).appendTo("b", &bob));
+        ASSERT_TRUE(SafeNum(3.5).appendTo("c", &bob));
+        ASSERT_FALSE(SafeNum().appendTo("d", &bob));
+        const mongo::BSONObj obj = bob.obj();
+        ASSERT_EQUALS(BSON("a" << 1 << "b" << 2LL << "c" << 3.5), obj);
+        ASSERT_EQUALS(mongo::NumberInt, obj["a"].type());
+        ASSERT_EQUALS(mongo::NumberLong, obj["b"].type());
+    }
+
     TEST(Comparison, EOO) {
         const SafeNum safeNumA;
         const SafeNum safeNumB;